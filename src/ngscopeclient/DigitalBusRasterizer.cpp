@@ -0,0 +1,148 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of DigitalBusRasterizer
+ */
+#include "DigitalBusRasterizer.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+DigitalBusRasterizer::DigitalBusRasterizer()
+	: m_packed("DigitalBusRasterizer.m_packed")
+	, m_wordsPerSample(0)
+	, m_nextStrip(0)
+{
+	//Packed on the CPU, read by the shader
+	m_packed.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_packed.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Rendering
+
+/**
+	@brief Bit packs a set of waveforms, unless they're the same ones that were packed last time
+
+	@param waveforms	Waveforms to pack. All must have the same length.
+ */
+void DigitalBusRasterizer::Pack(const vector<UniformDigitalWaveform*>& waveforms)
+{
+	vector<WaveformCacheKey> keys;
+	for(auto w : waveforms)
+		keys.push_back(WaveformCacheKey(w));
+
+	bool same = (keys.size() == m_keys.size());
+	for(size_t i=0; same && (i<keys.size()); i++)
+		same = (keys[i] == m_keys[i]);
+	if(same)
+		return;
+	m_keys = keys;
+
+	size_t nchans = waveforms.size();
+	if(nchans == 0)
+		return;
+	size_t len = waveforms[0]->size();
+
+	vector<const bool*> samples;
+	for(auto w : waveforms)
+	{
+		w->m_samples.PrepareForCpuAccess();
+		samples.push_back(w->m_samples.GetCpuPointer());
+	}
+
+	m_wordsPerSample = (nchans + 31) / 32;
+	m_packed.resize(len * m_wordsPerSample);
+	m_packed.PrepareForCpuAccess();
+	uint32_t* out = m_packed.GetCpuPointer();
+
+	#pragma omp parallel for
+	for(int64_t i=0; i<static_cast<int64_t>(len); i++)
+	{
+		for(size_t word=0; word<m_wordsPerSample; word++)
+		{
+			uint32_t v = 0;
+			size_t end = min(nchans, (word+1) * 32);
+			for(size_t chan=word*32; chan<end; chan++)
+			{
+				if(samples[chan][i])
+					v |= (1U << (chan % 32));
+			}
+			out[i*m_wordsPerSample + word] = v;
+		}
+	}
+
+	m_packed.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Rasterizes every packed channel
+
+	@param cmdbuf	Command buffer to record into
+	@param config	Rendering configuration for one channel, as would be pushed to the digital waveform shader
+
+	@return Output buffer. Channel i is at offset i * windowWidth * windowHeight.
+ */
+shared_ptr< AcceleratorBuffer<float> > DigitalBusRasterizer::Rasterize(
+	vk::raii::CommandBuffer& cmdbuf,
+	const ConfigPushConstants& config)
+{
+	if(m_pipeline == nullptr)
+	{
+		m_pipeline = make_shared<ComputePipeline>(
+			"shaders/WaveformDigitalBus.spv", 2, sizeof(DigitalBusArgs));
+	}
+
+	//Don't overwrite a buffer that is still being displayed
+	auto& strip = m_strips[m_nextStrip];
+	m_nextStrip ^= 1;
+	if( (strip == nullptr) || (strip.use_count() > 1) )
+	{
+		strip = make_shared< AcceleratorBuffer<float> >("DigitalBusRasterizer.m_strips");
+		strip->SetCpuAccessHint(AcceleratorBuffer<float>::HINT_UNLIKELY);
+		strip->SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	}
+
+	size_t nchans = m_keys.size();
+	strip->resize(nchans * config.windowWidth * config.windowHeight);
+
+	m_pipeline->BindBufferNonblocking(0, m_packed, cmdbuf);
+	m_pipeline->BindBufferNonblocking(1, *strip, cmdbuf, true);
+	DigitalBusArgs args(config, nchans, m_wordsPerSample);
+	m_pipeline->Dispatch(cmdbuf, args, GetComputeBlockCount(config.windowWidth, 64), nchans);
+	m_pipeline->AddComputeMemoryBarrier(cmdbuf);
+	strip->MarkModifiedFromGpu();
+
+	return strip;
+}
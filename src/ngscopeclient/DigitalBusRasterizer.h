@@ -0,0 +1,121 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of DigitalBusRasterizer
+ */
+#ifndef DigitalBusRasterizer_h
+#define DigitalBusRasterizer_h
+
+#include "../scopehal/scopehal.h"
+#include "WaveformRasterizer.h"
+
+/**
+	@brief Push constants for WaveformDigitalBus.glsl
+ */
+class DigitalBusArgs
+{
+public:
+	DigitalBusArgs(const ConfigPushConstants& config, uint32_t numChannels, uint32_t wordsPerSample)
+	: m_memDepth(config.memDepth)
+	, m_offsetSamples(config.offset_samples)
+	, m_windowWidth(config.windowWidth)
+	, m_windowHeight(config.windowHeight)
+	, m_numChannels(numChannels)
+	, m_wordsPerSample(wordsPerSample)
+	, m_xoff(config.xoff)
+	, m_xscale(config.xscale)
+
+	//offset_samples may have wrapped, but its sum with innerXoff is always small
+	, m_sampleBias(static_cast<int32_t>(static_cast<uint32_t>(config.offset_samples + config.innerXoff)))
+	{}
+
+	uint32_t m_memDepth;
+	uint32_t m_offsetSamples;
+	uint32_t m_windowWidth;
+	uint32_t m_windowHeight;
+	uint32_t m_numChannels;
+	uint32_t m_wordsPerSample;
+	float m_xoff;
+	float m_xscale;
+	float m_sampleBias;
+};
+
+/**
+	@brief Rasterizes many uniform digital waveforms sharing a timebase with a single dispatch
+
+	Wide logic analyzer captures would otherwise need one dispatch and one raster buffer per channel. Here all of the
+	channels are bit packed into a single buffer (only when their data changes) and drawn into consecutive strips of a
+	single raster buffer, which each channel then tone maps its own strip from.
+
+	Two output buffers are used alternately, so one can be displayed while the other is drawn into. If a channel is
+	still displaying an old buffer when it's due to be reused, a new one is allocated instead.
+ */
+class DigitalBusRasterizer
+{
+public:
+	DigitalBusRasterizer();
+
+	void Pack(const std::vector<UniformDigitalWaveform*>& waveforms);
+
+	std::shared_ptr< AcceleratorBuffer<float> > Rasterize(
+		vk::raii::CommandBuffer& cmdbuf,
+		const ConfigPushConstants& config);
+
+	///@brief Gets the number of channels in the most recently packed bus
+	size_t GetChannelCount()
+	{ return m_keys.size(); }
+
+	///@brief Smallest number of channels worth drawing as a bus rather than one at a time
+	static const size_t MIN_CHANNELS = 4;
+
+protected:
+
+	///@brief Identifies the waveforms currently in m_packed
+	std::vector<WaveformCacheKey> m_keys;
+
+	///@brief Bit packed samples, m_wordsPerSample words per sample
+	AcceleratorBuffer<uint32_t> m_packed;
+
+	///@brief Number of 32-bit words per sample in m_packed
+	uint32_t m_wordsPerSample;
+
+	///@brief Output buffers, used alternately
+	std::shared_ptr< AcceleratorBuffer<float> > m_strips[2];
+
+	///@brief Index of the output buffer to draw into next
+	size_t m_nextStrip;
+
+	///@brief Compute pipeline for WaveformDigitalBus.glsl
+	std::shared_ptr<ComputePipeline> m_pipeline;
+};
+
+#endif
@@ -0,0 +1,345 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FilterGraphBenchmark
+ */
+#include "ngscopeclient.h"
+#include "FilterGraphBenchmark.h"
+#include "FilterGraphTimeline.h"
+
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+FilterGraphBenchmark::FilterGraphBenchmark()
+	: m_samplesPerIteration(0)
+	, m_pointsPerIteration(0)
+	, m_warmup(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Processing
+
+/**
+	@brief Runs the benchmark
+
+	@param iterations	Number of iterations to measure
+	@param warmup		Number of iterations to run first and discard
+ */
+void FilterGraphBenchmark::Run(size_t iterations, size_t warmup)
+{
+	m_results.clear();
+	m_totalTimes.clear();
+	m_warmup = warmup;
+
+	LogNotice("Running %zu warmup and %zu measured iterations\n", warmup, iterations);
+	LogIndenter li;
+
+	for(size_t i=0; i<warmup; i++)
+	{
+		LogDebug("Warmup iteration %zu/%zu\n", i+1, warmup);
+		RunIteration(false);
+	}
+
+	for(size_t i=0; i<iterations; i++)
+	{
+		LogDebug("Iteration %zu/%zu\n", i+1, iterations);
+		RunIteration(true);
+	}
+}
+
+/**
+	@brief Runs the filter graph once for every waveform in the history (or once, if there is no history)
+
+	@param record	True to save timing results, false to discard them
+ */
+void FilterGraphBenchmark::RunIteration(bool record)
+{
+	//Take a copy of the list, since nothing should be added while we're iterating but be safe.
+	//Copy into a vector so we can index it alongside the iteration count
+	auto& history = m_session.GetHistory().m_history;
+	vector<shared_ptr<HistoryPoint>> points(history.begin(), history.end());
+	m_pointsPerIteration = max(points.size(), (size_t)1);
+
+	//Only count samples on the first measured iteration, they're the same every time
+	bool countSamples = record && m_totalTimes.empty();
+	if(countSamples)
+		m_samplesPerIteration = 0;
+
+	int64_t total = 0;
+	map<Filter*, int64_t> runtimes;
+	for(size_t i=0; i<m_pointsPerIteration; i++)
+	{
+		if(!points.empty())
+			points[i]->LoadHistoryToSession(m_session);
+
+		double start = GetTime();
+		m_session.RefreshAllFilters();
+		total += (GetTime() - start) * FS_PER_SECOND;
+
+		if(!record)
+			continue;
+
+		//Executor stats only cover the most recent run, so accumulate them across history points
+		auto stats = m_session.GetFilterGraphRuntime();
+		for(auto it : stats)
+		{
+			auto f = dynamic_cast<Filter*>(it.first);
+			if(f)
+				runtimes[f] += it.second;
+		}
+
+		if(!countSamples)
+			continue;
+
+		//Count samples coming in from instruments, and in/out of each filter
+		auto nodes = m_session.GetAllGraphNodes();
+		for(auto node : nodes)
+		{
+			auto f = dynamic_cast<Filter*>(node);
+			if(f)
+			{
+				auto& result = m_results[f];
+				result.m_samplesIn += CountInputSamples(f);
+				result.m_samplesOut += CountOutputSamples(f);
+				continue;
+			}
+
+			auto chan = dynamic_cast<InstrumentChannel*>(node);
+			if(!chan)
+				continue;
+			for(size_t j=0; j<chan->GetStreamCount(); j++)
+			{
+				auto data = chan->GetData(j);
+				if(data)
+					m_samplesPerIteration += data->size();
+			}
+		}
+	}
+
+	if(!record)
+		return;
+
+	m_totalTimes.push_back(total);
+	for(auto it : runtimes)
+	{
+		auto& result = m_results[it.first];
+		if(result.m_name.empty())
+		{
+			result.m_name = it.first->GetDisplayName();
+			result.m_protocol = it.first->GetProtocolDisplayName();
+		}
+		result.m_runtimes.push_back(it.second);
+	}
+}
+
+/**
+	@brief Counts the total number of samples in all of a filter's input waveforms
+ */
+size_t FilterGraphBenchmark::CountInputSamples(Filter* f)
+{
+	size_t count = 0;
+	for(size_t i=0; i<f->GetInputCount(); i++)
+	{
+		auto data = f->GetInput(i).GetData();
+		if(data)
+			count += data->size();
+	}
+	return count;
+}
+
+/**
+	@brief Counts the total number of samples in all of a filter's output waveforms
+ */
+size_t FilterGraphBenchmark::CountOutputSamples(Filter* f)
+{
+	size_t count = 0;
+	for(size_t i=0; i<f->GetStreamCount(); i++)
+	{
+		auto data = f->GetData(i);
+		if(data)
+			count += data->size();
+	}
+	return count;
+}
+
+/**
+	@brief Gets the peak resident memory usage of the process, in bytes
+
+	Returns zero if unavailable.
+ */
+size_t FilterGraphBenchmark::GetPeakMemoryUsage()
+{
+	#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return 0;
+		return counters.PeakWorkingSetSize;
+	#else
+		struct rusage usage;
+		if(0 != getrusage(RUSAGE_SELF, &usage))
+			return 0;
+
+		//Linux reports kB, macOS reports bytes
+		#ifdef __APPLE__
+			return usage.ru_maxrss;
+		#else
+			return usage.ru_maxrss * 1024;
+		#endif
+	#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Output
+
+/**
+	@brief Formats mean/median/min/max of a set of run times (fs) as JSON fields, in microseconds
+ */
+string FilterGraphBenchmark::FormatStatistics(vector<int64_t> times)
+{
+	if(times.empty())
+		return "\"mean_us\":0,\"median_us\":0,\"min_us\":0,\"max_us\":0";
+
+	sort(times.begin(), times.end());
+	double sum = 0;
+	for(auto t : times)
+		sum += t;
+
+	double scale = 1e-9;
+	char tmp[256];
+	snprintf(tmp, sizeof(tmp), "\"mean_us\":%.3f,\"median_us\":%.3f,\"min_us\":%.3f,\"max_us\":%.3f",
+		sum * scale / times.size(),
+		times[times.size() / 2] * scale,
+		times[0] * scale,
+		times[times.size() - 1] * scale);
+	return tmp;
+}
+
+/**
+	@brief Writes the results as JSON
+
+	@param path			Output file path, or "-" for stdout
+	@param sessionPath	Path to the session file (for reference only)
+
+	@return True on success, false on failure
+ */
+bool FilterGraphBenchmark::WriteJSON(const string& path, const string& sessionPath)
+{
+	//Sort filters by mean run time, slowest first
+	vector<FilterBenchmarkResult*> filters;
+	for(auto& it : m_results)
+	{
+		if(!it.second.m_runtimes.empty())
+			filters.push_back(&it.second);
+	}
+	auto mean = [](FilterBenchmarkResult* r)
+	{
+		double sum = 0;
+		for(auto t : r->m_runtimes)
+			sum += t;
+		return sum / r->m_runtimes.size();
+	};
+	sort(filters.begin(), filters.end(),
+		[&](FilterBenchmarkResult* a, FilterBenchmarkResult* b)
+		{ return mean(a) > mean(b); });
+
+	//Total throughput is instrument samples through the whole graph per unit wall time
+	double totalMean = 0;
+	for(auto t : m_totalTimes)
+		totalMean += t;
+	if(!m_totalTimes.empty())
+		totalMean /= m_totalTimes.size();
+	double totalRate = (totalMean > 0) ? (m_samplesPerIteration * FS_PER_SECOND / totalMean) : 0;
+
+	stringstream out;
+	out.precision(15);
+	out << "{\n";
+	out << "\t\"session\": \"" << FilterGraphTimeline::JSONEscape(sessionPath) << "\",\n";
+	out << "\t\"iterations\": " << m_totalTimes.size() << ",\n";
+	out << "\t\"warmup\": " << m_warmup << ",\n";
+	out << "\t\"waveforms_per_iteration\": " << m_pointsPerIteration << ",\n";
+	out << "\t\"peak_memory_bytes\": " << GetPeakMemoryUsage() << ",\n";
+	out << "\t\"total\": {" << FormatStatistics(m_totalTimes)
+		<< ",\"samples\":" << m_samplesPerIteration
+		<< ",\"samples_per_sec\":" << totalRate << "},\n";
+	out << "\t\"filters\": [";
+	for(size_t i=0; i<filters.size(); i++)
+	{
+		auto r = filters[i];
+		double m = mean(r);
+		double rate = (m > 0) ? (r->m_samplesIn * FS_PER_SECOND / m) : 0;
+
+		if(i > 0)
+			out << ",";
+		out << "\n\t\t{\"name\":\"" << FilterGraphTimeline::JSONEscape(r->m_name) << "\""
+			<< ",\"protocol\":\"" << FilterGraphTimeline::JSONEscape(r->m_protocol) << "\","
+			<< FormatStatistics(r->m_runtimes)
+			<< ",\"samples_in\":" << r->m_samplesIn
+			<< ",\"samples_out\":" << r->m_samplesOut
+			<< ",\"samples_per_sec\":" << rate << "}";
+	}
+	out << "\n\t]\n}\n";
+
+	if(path == "-")
+	{
+		fputs(out.str().c_str(), stdout);
+		return true;
+	}
+
+	ofstream outfs(path);
+	if(!outfs)
+	{
+		LogError("Failed to open \"%s\" for writing\n", path.c_str());
+		return false;
+	}
+	outfs << out.str();
+	outfs.close();
+	if(!outfs)
+	{
+		LogError("Failed to write \"%s\"\n", path.c_str());
+		return false;
+	}
+
+	LogNotice("Wrote benchmark results to %s\n", path.c_str());
+	return true;
+}
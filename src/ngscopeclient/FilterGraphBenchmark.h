@@ -0,0 +1,106 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FilterGraphBenchmark
+ */
+#ifndef FilterGraphBenchmark_h
+#define FilterGraphBenchmark_h
+
+#include "HeadlessRunner.h"
+
+/**
+	@brief Timing results for one filter across all measured benchmark iterations
+ */
+class FilterBenchmarkResult
+{
+public:
+	FilterBenchmarkResult()
+		: m_samplesIn(0)
+		, m_samplesOut(0)
+	{}
+
+	///@brief Display name of the filter
+	std::string m_name;
+
+	///@brief Protocol name of the filter
+	std::string m_protocol;
+
+	///@brief Time spent in the filter during each iteration, summed over all history points (fs)
+	std::vector<int64_t> m_runtimes;
+
+	///@brief Number of input samples processed per iteration
+	size_t m_samplesIn;
+
+	///@brief Number of output samples generated per iteration
+	size_t m_samplesOut;
+};
+
+/**
+	@brief Runs a saved session's filter graph repeatedly and reports how long it takes
+
+	Each iteration runs the whole graph once for every waveform in the session's history. The first few iterations
+	are discarded as warmup (shader compilation, buffer allocation, etc).
+ */
+class FilterGraphBenchmark : public HeadlessRunner
+{
+public:
+	FilterGraphBenchmark();
+
+	void Run(size_t iterations, size_t warmup);
+	bool WriteJSON(const std::string& path, const std::string& sessionPath);
+
+	static std::string FormatStatistics(std::vector<int64_t> times);
+
+protected:
+	void RunIteration(bool record);
+	size_t CountInputSamples(Filter* f);
+	size_t CountOutputSamples(Filter* f);
+
+	static size_t GetPeakMemoryUsage();
+
+	///@brief Results for each filter
+	std::map<Filter*, FilterBenchmarkResult> m_results;
+
+	///@brief Wall clock time of each measured iteration (fs)
+	std::vector<int64_t> m_totalTimes;
+
+	///@brief Number of instrument samples fed into the graph per iteration
+	size_t m_samplesPerIteration;
+
+	///@brief Number of history points run per iteration
+	size_t m_pointsPerIteration;
+
+	///@brief Number of warmup iterations that were discarded
+	size_t m_warmup;
+};
+
+#endif
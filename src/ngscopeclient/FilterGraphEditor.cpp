@@ -199,6 +199,9 @@ FilterGraphEditor::FilterGraphEditor(Session& session, MainWindow* parent)
 	, m_session(session)
 	, m_parent(parent)
 	, m_nextID(1)
+	, m_perfOverlay(false)
+	, m_totalRuntime(0)
+	, m_maxRuntime(0)
 {
 	m_config.SaveSettings = &FilterGraphEditor::SaveSettingsCallback;
 	m_config.LoadSettings = &FilterGraphEditor::LoadSettingsCallback;
@@ -429,6 +432,12 @@ bool FilterGraphEditor::DoRender()
 {
 	bool windowHovered = ImGui::IsWindowHovered();
 
+	//Toolbar
+	ImGui::Checkbox("Performance overlay", &m_perfOverlay);
+	HelpMarker(
+		"Color each filter by its share of filter graph execution time, show output sample counts,\n"
+		"and highlight the critical path (the slowest chain of dependent filters)");
+
 	ax::NodeEditor::SetCurrentEditor(m_context);
 	ax::NodeEditor::Begin("Filter Graph", ImVec2(0, 0));
 
@@ -494,7 +503,7 @@ bool FilterGraphEditor::DoRender()
 	for(auto it : chans)
 	{
 		for(auto chan : it.second)
-			DoNodeForChannel(chan, it.first, multiInst, 0);	//TODO: acquisition time etc?
+			DoNodeForChannel(chan, it.first, multiInst, 0, 0);	//TODO: acquisition time etc?
 	}
 
 	//Make a newly dragged node spawn at the mouse position
@@ -519,9 +528,18 @@ bool FilterGraphEditor::DoRender()
 	//Filters
 	auto filters = Filter::GetAllInstances();
 	auto filterperf = m_session.GetFilterGraphRuntime();
+	map<FlowGraphNode*, size_t> filtersamples;
+	if(!m_perfOverlay)
+		m_criticalPathRuntimes.clear();
+	else
+	{
+		filtersamples = m_session.GetFilterGraphSampleCounts();
+		if(filterperf != m_criticalPathRuntimes)
+			UpdateCriticalPath(filterperf);
+	}
 	for(auto f : filters)
 	{
-		DoNodeForChannel(f, nullptr, false, filterperf[f]);
+		DoNodeForChannel(f, nullptr, false, filterperf[f], filtersamples[f]);
 
 		//Add a reference to the channel so even if we remove the last user of it this frame, it won't be deleted until we're ready
 		f->AddRef();
@@ -548,7 +566,17 @@ bool FilterGraphEditor::DoRender()
 				auto dstid = GetSinkPinForLink(stream, pair<FlowGraphNode*, size_t>(f, i));
 				auto linkid = GetID(pair<ax::NodeEditor::PinId, ax::NodeEditor::PinId>(srcid, dstid));
 				freshLinks.emplace(linkid);
-				ax::NodeEditor::Link(linkid, srcid, dstid);
+
+				//Highlight links along the critical path
+				pair<FlowGraphNode*, FlowGraphNode*> edge(stream.m_channel, f);
+				if(m_perfOverlay && (m_criticalEdges.find(edge) != m_criticalEdges.end()) )
+				{
+					auto critcolor = ImGui::ColorConvertU32ToFloat4(
+						m_session.GetPreferences().GetColor("Appearance.Filter Graph.critical_path_color"));
+					ax::NodeEditor::Link(linkid, srcid, dstid, critcolor, 4);
+				}
+				else
+					ax::NodeEditor::Link(linkid, srcid, dstid);
 			}
 		}
 	}
@@ -1949,7 +1977,8 @@ void FilterGraphEditor::DoNodeForChannel(
 	InstrumentChannel* channel,
 	shared_ptr<Instrument> inst,
 	bool multiInst,
-	int64_t runtime)
+	int64_t runtime,
+	size_t samples)
 {
 	Unit fs(Unit::UNIT_FS);
 
@@ -2145,12 +2174,44 @@ void FilterGraphEditor::DoNodeForChannel(
 		headercolor,
 		headerText.c_str());
 
-	//TODO: add an option for toggling this
+	//Performance overlay: tint the body by share of total runtime, and outline nodes on the critical path
+	if(m_perfOverlay && f && (m_maxRuntime > 0) )
+	{
+		auto heat = HeatColor(runtime * 1.0f / m_maxRuntime);
+		bgList->AddRectFilled(
+			ImVec2(pos.x + 1, pos.y + headerheight),
+			ImVec2(pos.x + size.x - 1, pos.y + size.y - 1),
+			(heat & ~IM_COL32_A_MASK) | (0x60 << IM_COL32_A_SHIFT),
+			rounding,
+			ImDrawFlags_RoundCornersBottom);
+
+		if(m_criticalPath.find(f) != m_criticalPath.end())
+		{
+			bgList->AddRect(
+				pos,
+				pos + size,
+				prefs.GetColor("Appearance.Filter Graph.critical_path_color"),
+				rounding,
+				ImDrawFlags_RoundCornersAll,
+				4);
+		}
+	}
+
 	//TODO: add preference for colors
 	//Draw a bubble above the text with the runtime stats
 	if(runtime > 0)
 	{
 		auto runtimeText = fs.PrettyPrint(runtime, 3);
+
+		//Add share of total runtime and output size if the overlay is on
+		if(m_perfOverlay && (m_totalRuntime > 0) )
+		{
+			Unit pct(Unit::UNIT_PERCENT);
+			Unit sa(Unit::UNIT_SAMPLEDEPTH);
+
+			runtimeText += " (" + pct.PrettyPrint(runtime * 1.0 / m_totalRuntime, 3) + "), " +
+				sa.PrettyPrint(samples);
+		}
 		auto runtimeSize = headerfont->CalcTextSizeA(headerfontsize, FLT_MAX, 0, runtimeText.c_str());
 
 		auto timebgColor = ColorFromString("#404040");
@@ -2462,6 +2523,135 @@ void FilterGraphEditor::HandleBackgroundContextMenu()
 	ax::NodeEditor::Resume();
 }
 
+/**
+	@brief Finds the longest runtime-weighted dependency chain through the filter graph
+
+	This is the lower bound on graph execution time no matter how many threads are available, so it's the place to
+	look first when deciding which filter to optimize.
+
+	Only called when the runtime stats change, since the graph is re-run whenever its topology does.
+ */
+void FilterGraphEditor::UpdateCriticalPath(const map<FlowGraphNode*, int64_t>& runtimes)
+{
+	m_criticalPathRuntimes = runtimes;
+	m_criticalPath.clear();
+	m_criticalEdges.clear();
+	m_totalRuntime = 0;
+	m_maxRuntime = 0;
+
+	auto filters = Filter::GetAllInstances();
+	for(auto f : filters)
+	{
+		auto it = runtimes.find(f);
+		if(it == runtimes.end())
+			continue;
+		m_totalRuntime += it->second;
+		m_maxRuntime = max(m_maxRuntime, it->second);
+	}
+
+	//Latest finish time of each filter assuming unlimited threads, and which input determined it
+	map<Filter*, int64_t> finish;
+	map<Filter*, Filter*> pred;
+
+	//Evaluate in dependency order: keep going until every filter has all of its upstream filters done
+	vector<Filter*> pending(filters.begin(), filters.end());
+	while(!pending.empty())
+	{
+		bool progress = false;
+		for(size_t i=0; i<pending.size(); )
+		{
+			auto f = pending[i];
+
+			int64_t start = 0;
+			Filter* from = nullptr;
+			bool ready = true;
+			for(size_t j=0; j<f->GetInputCount(); j++)
+			{
+				auto upstream = dynamic_cast<Filter*>(f->GetInput(j).m_channel);
+				if(!upstream || (upstream == f) || (filters.find(upstream) == filters.end()) )
+					continue;
+
+				auto it = finish.find(upstream);
+				if(it == finish.end())
+				{
+					ready = false;
+					break;
+				}
+				if(it->second > start)
+				{
+					start = it->second;
+					from = upstream;
+				}
+			}
+
+			if(!ready)
+			{
+				i++;
+				continue;
+			}
+
+			auto rt = runtimes.find(f);
+			finish[f] = start + ( (rt != runtimes.end()) ? rt->second : 0 );
+			pred[f] = from;
+			pending.erase(pending.begin() + i);
+			progress = true;
+		}
+
+		//Should never happen (the graph is acyclic) but don't hang if it does
+		if(!progress)
+			break;
+	}
+
+	//Walk back from whichever filter finished last
+	Filter* last = nullptr;
+	int64_t lastFinish = 0;
+	for(auto it : finish)
+	{
+		if(it.second > lastFinish)
+		{
+			lastFinish = it.second;
+			last = it.first;
+		}
+	}
+	while(last)
+	{
+		m_criticalPath.emplace(last);
+		auto from = pred[last];
+		if(from)
+			m_criticalEdges.emplace(from, last);
+		last = from;
+	}
+}
+
+/**
+	@brief Maps a fraction (0-1) of the slowest filter's runtime to a cold-to-hot color
+ */
+ImU32 FilterGraphEditor::HeatColor(float frac)
+{
+	frac = max(0.0f, min(1.0f, frac));
+
+	//Blue at 0, yellow at 0.5, red at 1
+	ImVec4 cold(0.2, 0.3, 1.0, 1);
+	ImVec4 warm(1.0, 0.8, 0.0, 1);
+	ImVec4 hot(1.0, 0.1, 0.0, 1);
+
+	ImVec4 a = cold;
+	ImVec4 b = warm;
+	float t = frac * 2;
+	if(frac > 0.5)
+	{
+		a = warm;
+		b = hot;
+		t = (frac - 0.5) * 2;
+	}
+
+	return ImGui::ColorConvertFloat4ToU32(ImVec4(
+		a.x + (b.x - a.x)*t,
+		a.y + (b.y - a.y)*t,
+		a.z + (b.z - a.z)*t,
+		1));
+}
+
 /**
 	@brief Implement the add menu
  */
@@ -2533,6 +2723,7 @@ void FilterGraphEditor::DoAddMenu()
 
 		m_groups.emplace(group, id);
 	}
+
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -181,7 +181,8 @@ protected:
 		InstrumentChannel* channel,
 		std::shared_ptr<Instrument> inst,
 		bool multiInst,
-		int64_t runtime);
+		int64_t runtime,
+		size_t samples);
 	void DoNodeForTrigger(Trigger* trig);
 	bool HandleNodeProperties();
 	void HandleDoubleClicks();
@@ -298,6 +299,30 @@ protected:
 		lessID<ax::NodeEditor::NodeId>
 		 > m_groups;
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Performance overlay
+
+	void UpdateCriticalPath(const std::map<FlowGraphNode*, int64_t>& runtimes);
+	static ImU32 HeatColor(float frac);
+
+	///@brief True to color filter nodes by their share of filter graph execution time
+	bool m_perfOverlay;
+
+	///@brief Total runtime of all filters in the last filter graph run
+	int64_t m_totalRuntime;
+
+	///@brief Runtime of the slowest filter in the last filter graph run
+	int64_t m_maxRuntime;
+
+	///@brief Filters on the longest runtime-weighted dependency chain through the graph
+	std::set<FlowGraphNode*> m_criticalPath;
+
+	///@brief Links (source, sink) along the critical path
+	std::set<std::pair<FlowGraphNode*, FlowGraphNode*> > m_criticalEdges;
+
+	///@brief Runtime stats the critical path was last computed from
+	std::map<FlowGraphNode*, int64_t> m_criticalPathRuntimes;
+
 	//DEBUG: forces for display
 	std::map<
 		ax::NodeEditor::NodeId,
@@ -0,0 +1,311 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FilterGraphTimeline
+ */
+#include "ngscopeclient.h"
+#include "FilterGraphTimeline.h"
+
+#include <fstream>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FilterGraphTimelineRun
+
+/**
+	@brief Gets the time from the start of the run until the last filter completed, in femtoseconds
+ */
+int64_t FilterGraphTimelineRun::GetSpan() const
+{
+	int64_t span = 0;
+	for(auto& e : m_events)
+		span = max(span, e.m_end);
+	return span;
+}
+
+/**
+	@brief Gets the total time a given executor thread spent running filters, in femtoseconds
+ */
+int64_t FilterGraphTimelineRun::GetBusyTime(size_t worker) const
+{
+	int64_t busy = 0;
+	for(auto& e : m_events)
+	{
+		if(e.m_worker == worker)
+			busy += e.m_end - e.m_start;
+	}
+	return busy;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+FilterGraphTimeline::FilterGraphTimeline()
+	: m_depth(32)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Recording
+
+/**
+	@brief Adds a run of the filter graph to the timeline
+
+	@param nodes		The set of nodes that was passed to the executor
+	@param runtimes		Per-node runtimes reported by the executor, in femtoseconds
+	@param startTime	Wall clock time the run started
+	@param wallTime		Total time for the run, in femtoseconds
+	@param workerCount	Number of threads used by the executor
+ */
+void FilterGraphTimeline::RecordRun(
+	const set<FlowGraphNode*>& nodes,
+	const map<FlowGraphNode*, int64_t>& runtimes,
+	double startTime,
+	int64_t wallTime,
+	size_t workerCount)
+{
+	FilterGraphTimelineRun run;
+	run.m_startTime = startTime;
+	run.m_wallTime = wallTime;
+	run.m_workerCount = max(workerCount, (size_t)1);
+
+	//Only filters are actually executed, instrument channels are just sources
+	vector<Filter*> pending;
+	for(auto n : nodes)
+	{
+		auto f = dynamic_cast<Filter*>(n);
+		if(f)
+			pending.push_back(f);
+	}
+
+	//Replay the executor's scheduling: each round, pick the filter whose inputs completed earliest
+	//and put it on whichever thread frees up first
+	map<FlowGraphNode*, int64_t> endTimes;
+	vector<int64_t> workerFree(run.m_workerCount, 0);
+	while(!pending.empty())
+	{
+		size_t best = SIZE_MAX;
+		int64_t bestReady = INT64_MAX;
+		for(size_t i=0; i<pending.size(); i++)
+		{
+			auto f = pending[i];
+
+			//Ready once every input that's also being refreshed this run is done
+			int64_t ready = 0;
+			bool blocked = false;
+			for(size_t j=0; j<f->GetInputCount(); j++)
+			{
+				auto upstream = dynamic_cast<Filter*>(f->GetInput(j).m_channel);
+				if(!upstream || (upstream == f) || (nodes.find(upstream) == nodes.end()) )
+					continue;
+
+				auto it = endTimes.find(upstream);
+				if(it == endTimes.end())
+				{
+					blocked = true;
+					break;
+				}
+				ready = max(ready, it->second);
+			}
+
+			if(!blocked && (ready < bestReady) )
+			{
+				best = i;
+				bestReady = ready;
+			}
+		}
+
+		//Should never happen (the graph is acyclic) but don't hang if it does
+		if(best == SIZE_MAX)
+			break;
+
+		auto f = pending[best];
+		pending.erase(pending.begin() + best);
+
+		size_t worker = 0;
+		for(size_t i=1; i<workerFree.size(); i++)
+		{
+			if(workerFree[i] < workerFree[worker])
+				worker = i;
+		}
+
+		int64_t runtime = 0;
+		auto it = runtimes.find(f);
+		if(it != runtimes.end())
+			runtime = it->second;
+
+		FilterGraphTimelineEvent e;
+		e.m_node = f;
+		e.m_name = f->GetDisplayName();
+		e.m_color = f->m_displaycolor;
+		e.m_worker = worker;
+		e.m_start = max(bestReady, workerFree[worker]);
+		e.m_end = e.m_start + runtime;
+		run.m_events.push_back(e);
+
+		workerFree[worker] = e.m_end;
+		endTimes[f] = e.m_end;
+	}
+
+	//Feed the always-on event recorder too, so filters line up with everything else in a stall dump.
+	//Per-filter spans go on their own "estimated" tracks since the times are reconstructed, not measured.
+	g_perfRecorder.RecordAt(
+		PERF_FILTER_GRAPH, PerfEventRecorder::PHASE_BEGIN, startTime, g_perfRecorder.GetCurrentTrack());
+	g_perfRecorder.RecordAt(
+		PERF_FILTER_GRAPH,
+		PerfEventRecorder::PHASE_END,
+		startTime + wallTime / FS_PER_SECOND,
+		g_perfRecorder.GetCurrentTrack());
+	for(auto& e : run.m_events)
+	{
+		auto track = g_perfRecorder.GetTrack("Filter executor " + to_string(e.m_worker) + " (estimated)");
+		auto name = g_perfRecorder.Intern(e.m_name);
+		g_perfRecorder.RecordAt(
+			PERF_FILTER, PerfEventRecorder::PHASE_BEGIN, startTime + e.m_start / FS_PER_SECOND, track, name);
+		g_perfRecorder.RecordAt(
+			PERF_FILTER, PerfEventRecorder::PHASE_END, startTime + e.m_end / FS_PER_SECOND, track, name);
+	}
+
+	lock_guard<mutex> lock(m_mutex);
+	m_runs.push_back(std::move(run));
+	while(m_runs.size() > m_depth)
+		m_runs.pop_front();
+}
+
+/**
+	@brief Returns a copy of all runs currently in the timeline, oldest first
+ */
+vector<FilterGraphTimelineRun> FilterGraphTimeline::GetRuns()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return vector<FilterGraphTimelineRun>(m_runs.begin(), m_runs.end());
+}
+
+/**
+	@brief Sets the maximum number of runs to keep
+ */
+void FilterGraphTimeline::SetDepth(size_t depth)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_depth = max(depth, (size_t)1);
+	while(m_runs.size() > m_depth)
+		m_runs.pop_front();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Export
+
+/**
+	@brief Writes the timeline in Chrome trace event format (for chrome://tracing, Perfetto, etc)
+
+	Each executor thread is one track. Each run of the graph also gets a span on a separate track covering its full
+	wall clock time, so gaps between the last filter and the end of the run (overhead outside the filters) are visible.
+
+	Run spans are measured. Filter spans are reconstructed (see FilterGraphTimeline) so their tracks are labeled as
+	estimated and each one carries an "estimated" arg.
+
+	@return True on success, false on failure
+ */
+bool FilterGraphTimeline::ExportChromeTrace(const string& path)
+{
+	auto runs = GetRuns();
+
+	ofstream outfs(path);
+	if(!outfs)
+		return false;
+
+	//Track names
+	size_t maxWorkers = 0;
+	for(auto& r : runs)
+		maxWorkers = max(maxWorkers, r.m_workerCount);
+
+	outfs << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	outfs << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Filter graph\"}}";
+	outfs << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Graph runs\"}}";
+	for(size_t i=0; i<maxWorkers; i++)
+	{
+		outfs << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << (i+1)
+			<< ",\"args\":{\"name\":\"Executor thread " << i << " (estimated)\"}}";
+	}
+
+	//Timestamps are in microseconds, relative to the oldest run
+	double base = runs.empty() ? 0 : runs[0].m_startTime;
+	outfs.precision(15);
+	for(size_t i=0; i<runs.size(); i++)
+	{
+		auto& r = runs[i];
+		double runStart = (r.m_startTime - base) * 1e6;
+
+		outfs << ",\n{\"name\":\"Run " << i << "\",\"cat\":\"graph\",\"ph\":\"X\",\"pid\":1,\"tid\":0"
+			<< ",\"ts\":" << runStart
+			<< ",\"dur\":" << (r.m_wallTime * 1e-9) << "}";
+
+		for(auto& e : r.m_events)
+		{
+			outfs << ",\n{\"name\":\"" << JSONEscape(e.m_name) << "\",\"cat\":\"filter\",\"ph\":\"X\",\"pid\":1"
+				<< ",\"tid\":" << (e.m_worker + 1)
+				<< ",\"ts\":" << (runStart + e.m_start * 1e-9)
+				<< ",\"dur\":" << ((e.m_end - e.m_start) * 1e-9)
+				<< ",\"args\":{\"estimated\":true}}";
+		}
+	}
+	outfs << "\n]}\n";
+
+	outfs.close();
+	return !outfs.fail();
+}
+
+/**
+	@brief Escapes a string for use inside a JSON string literal
+ */
+string FilterGraphTimeline::JSONEscape(const string& str)
+{
+	string ret;
+	for(auto c : str)
+	{
+		if( (c == '"') || (c == '\\') )
+		{
+			ret += '\\';
+			ret += c;
+		}
+		else if(static_cast<unsigned char>(c) < 0x20)
+		{
+			char tmp[8];
+			snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+			ret += tmp;
+		}
+		else
+			ret += c;
+	}
+	return ret;
+}
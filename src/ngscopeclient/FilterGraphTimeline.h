@@ -0,0 +1,130 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FilterGraphTimeline
+ */
+#ifndef FilterGraphTimeline_h
+#define FilterGraphTimeline_h
+
+#include <deque>
+
+/**
+	@brief A single filter's execution within one run of the filter graph
+ */
+class FilterGraphTimelineEvent
+{
+public:
+	///@brief The node that ran (may have since been deleted, do not dereference)
+	FlowGraphNode* m_node;
+
+	///@brief Display name of the node at the time it ran
+	std::string m_name;
+
+	///@brief Display color of the node at the time it ran
+	std::string m_color;
+
+	///@brief Index of the executor thread the node ran on
+	size_t m_worker;
+
+	///@brief Start time, in femtoseconds relative to the start of the run
+	int64_t m_start;
+
+	///@brief End time, in femtoseconds relative to the start of the run
+	int64_t m_end;
+};
+
+/**
+	@brief Timing for a single run of the filter graph
+ */
+class FilterGraphTimelineRun
+{
+public:
+	///@brief Wall clock time (from GetTime()) the run started at
+	double m_startTime;
+
+	///@brief Total wall clock time for the run, in femtoseconds
+	int64_t m_wallTime;
+
+	///@brief Number of executor threads
+	size_t m_workerCount;
+
+	///@brief Every filter that ran
+	std::vector<FilterGraphTimelineEvent> m_events;
+
+	int64_t GetSpan() const;
+	int64_t GetBusyTime(size_t worker) const;
+};
+
+/**
+	@brief Keeps per-filter, per-thread timing for the last few runs of the filter graph
+
+	FilterGraphExecutor only reports total runtime per node, so start times and thread assignments are reconstructed
+	by replaying the executor's scheduling policy (run any filter whose inputs are complete on the first idle thread)
+	over the graph's dependencies. This is exact for serial chains and a close approximation elsewhere, which is
+	enough to see serialization points and idle threads.
+ */
+class FilterGraphTimeline
+{
+public:
+	FilterGraphTimeline();
+
+	void RecordRun(
+		const std::set<FlowGraphNode*>& nodes,
+		const std::map<FlowGraphNode*, int64_t>& runtimes,
+		double startTime,
+		int64_t wallTime,
+		size_t workerCount);
+
+	std::vector<FilterGraphTimelineRun> GetRuns();
+
+	void SetDepth(size_t depth);
+
+	///@brief Gets the maximum number of runs to keep
+	size_t GetDepth()
+	{ return m_depth; }
+
+	bool ExportChromeTrace(const std::string& path);
+
+	static std::string JSONEscape(const std::string& str);
+
+protected:
+	///@brief Mutex controlling access to m_runs
+	std::mutex m_mutex;
+
+	///@brief Most recent runs, oldest first
+	std::deque<FilterGraphTimelineRun> m_runs;
+
+	///@brief Maximum number of runs to keep
+	size_t m_depth;
+};
+
+#endif
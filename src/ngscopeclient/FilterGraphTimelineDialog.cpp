@@ -0,0 +1,228 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FilterGraphTimelineDialog
+ */
+#include "ngscopeclient.h"
+#include "FilterGraphTimelineDialog.h"
+#include "MainWindow.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+FilterGraphTimelineDialog::FilterGraphTimelineDialog(Session& session, MainWindow* parent)
+	: Dialog("Filter Graph Timeline", "Filter Graph Timeline", ImVec2(700, 300))
+	, m_session(session)
+	, m_parent(parent)
+	, m_selectedRun(0)
+	, m_followLatest(true)
+	, m_depth(session.GetFilterGraphTimeline().GetDepth())
+{
+}
+
+FilterGraphTimelineDialog::~FilterGraphTimelineDialog()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Rendering
+
+/**
+	@brief Renders the dialog and handles UI events
+
+	@return		True if we should continue showing the dialog
+				False if it's been closed
+ */
+bool FilterGraphTimelineDialog::DoRender()
+{
+	auto& timeline = m_session.GetFilterGraphTimeline();
+	float width = ImGui::GetFontSize() * 7;
+
+	ImGui::SetNextItemWidth(width);
+	if(ImGui::InputInt("Runs kept", &m_depth, 1, 10))
+	{
+		m_depth = max(m_depth, 1);
+		timeline.SetDepth(m_depth);
+	}
+	HelpMarker("Number of filter graph runs to keep in the timeline");
+
+	ImGui::SameLine();
+	if(ImGui::Button("Export..."))
+	{
+		m_fileDialog = MakeFileBrowser(
+			m_parent,
+			".",
+			"Export Chrome Trace",
+			"Chrome trace files (*.json)",
+			"*.json",
+			true);
+	}
+	Tooltip("Save all runs in Chrome trace event format, for viewing in chrome://tracing or Perfetto");
+
+	auto runs = timeline.GetRuns();
+	if(runs.empty())
+	{
+		ImGui::TextUnformatted("No filter graph runs recorded yet");
+	}
+	else
+	{
+		//Run selection
+		int nmax = runs.size() - 1;
+		if(m_followLatest)
+			m_selectedRun = nmax;
+		m_selectedRun = min(m_selectedRun, nmax);
+
+		ImGui::SetNextItemWidth(width);
+		if(ImGui::SliderInt("Run", &m_selectedRun, 0, nmax))
+			m_followLatest = (m_selectedRun == nmax);
+		ImGui::SameLine();
+		ImGui::Checkbox("Follow latest", &m_followLatest);
+
+		auto& run = runs[m_selectedRun];
+
+		//Summary
+		Unit fs(Unit::UNIT_FS);
+		Unit pct(Unit::UNIT_PERCENT);
+		int64_t span = run.GetSpan();
+		int64_t busy = 0;
+		for(size_t i=0; i<run.m_workerCount; i++)
+			busy += run.GetBusyTime(i);
+		float util = 0;
+		if(span > 0)
+			util = busy * 1.0f / (span * run.m_workerCount);
+
+		ImGui::Text("Wall time: %s    Filters: %s    Thread utilization: %s",
+			fs.PrettyPrint(run.m_wallTime).c_str(),
+			fs.PrettyPrint(span).c_str(),
+			pct.PrettyPrint(util).c_str());
+		HelpMarker(
+			"Wall time is the total time for the run, including overhead outside the filters.\n"
+			"Filters is the time from the start of the run until the last filter completed.\n"
+			"Thread utilization is the fraction of that time the executor threads spent running filters.\n\n"
+			"Start times and thread assignments are reconstructed from per-filter run times and graph dependencies.");
+
+		RenderTimeline(run);
+	}
+
+	//Run the export dialog
+	if(m_fileDialog)
+	{
+		m_fileDialog->Render();
+
+		if(m_fileDialog->IsClosedOK())
+		{
+			auto fname = m_fileDialog->GetFileName();
+			if(!timeline.ExportChromeTrace(fname))
+				ShowErrorPopup("Export failed", string("Could not write to ") + fname);
+		}
+
+		if(m_fileDialog->IsClosed())
+			m_fileDialog = nullptr;
+	}
+
+	RenderErrorPopup();
+	return true;
+}
+
+/**
+	@brief Draws one row per executor thread, with a bar for each filter that ran on it
+ */
+void FilterGraphTimelineDialog::RenderTimeline(const FilterGraphTimelineRun& run)
+{
+	float rowHeight = ImGui::GetFontSize() * 1.5;
+	float labelWidth = ImGui::CalcTextSize("Thread 00").x + ImGui::GetStyle().ItemSpacing.x;
+
+	auto origin = ImGui::GetCursorScreenPos();
+	float plotWidth = ImGui::GetContentRegionAvail().x - labelWidth;
+	float plotHeight = rowHeight * run.m_workerCount;
+	if(plotWidth <= 0)
+		return;
+	ImGui::Dummy(ImVec2(labelWidth + plotWidth, plotHeight));
+
+	//Scale to whichever is longer, the wall time or the filters (reconstructed span can overshoot slightly)
+	int64_t span = max(run.GetSpan(), run.m_wallTime);
+	if(span <= 0)
+		return;
+	float xscale = plotWidth / span;
+
+	auto list = ImGui::GetWindowDrawList();
+	auto& style = ImGui::GetStyle();
+	auto bgColor = ImGui::ColorConvertFloat4ToU32(style.Colors[ImGuiCol_FrameBg]);
+	auto textColor = ImGui::ColorConvertFloat4ToU32(style.Colors[ImGuiCol_Text]);
+	float plotLeft = origin.x + labelWidth;
+
+	//Row labels and backgrounds
+	for(size_t i=0; i<run.m_workerCount; i++)
+	{
+		float y = origin.y + i*rowHeight;
+		list->AddText(ImVec2(origin.x, y + style.FramePadding.y), textColor, ("Thread " + to_string(i)).c_str());
+		list->AddRectFilled(ImVec2(plotLeft, y + 1), ImVec2(plotLeft + plotWidth, y + rowHeight - 1), bgColor);
+	}
+
+	//Filter bars
+	Unit fs(Unit::UNIT_FS);
+	auto mouse = ImGui::GetMousePos();
+	for(auto& e : run.m_events)
+	{
+		float y = origin.y + e.m_worker*rowHeight;
+		ImVec2 tl(plotLeft + e.m_start*xscale, y + 1);
+		ImVec2 br(max(tl.x + 1, plotLeft + e.m_end*xscale), y + rowHeight - 1);
+
+		auto color = ColorFromString(e.m_color);
+		list->AddRectFilled(tl, br, color);
+		list->AddRect(tl, br, IM_COL32(0, 0, 0, 255));
+
+		//Label if it fits
+		auto textSize = ImGui::CalcTextSize(e.m_name.c_str());
+		if(textSize.x + 2*style.FramePadding.x < (br.x - tl.x))
+		{
+			list->AddText(
+				ImVec2(tl.x + style.FramePadding.x, y + style.FramePadding.y),
+				IM_COL32(0, 0, 0, 255),
+				e.m_name.c_str());
+		}
+
+		if( (mouse.x >= tl.x) && (mouse.x < br.x) && (mouse.y >= tl.y) && (mouse.y < br.y) && ImGui::IsWindowHovered())
+		{
+			ImGui::SetTooltip("%s\nStart: %s\nRuntime: %s",
+				e.m_name.c_str(),
+				fs.PrettyPrint(e.m_start).c_str(),
+				fs.PrettyPrint(e.m_end - e.m_start).c_str());
+		}
+	}
+
+	//End of run marker
+	float xend = plotLeft + run.m_wallTime*xscale;
+	list->AddLine(ImVec2(xend, origin.y), ImVec2(xend, origin.y + plotHeight), textColor);
+}
@@ -0,0 +1,74 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FilterGraphTimelineDialog
+ */
+#ifndef FilterGraphTimelineDialog_h
+#define FilterGraphTimelineDialog_h
+
+#include "Dialog.h"
+#include "Session.h"
+#include "FileBrowser.h"
+
+class MainWindow;
+
+/**
+	@brief Gantt chart of which filters ran on which executor thread during recent filter graph runs
+ */
+class FilterGraphTimelineDialog : public Dialog
+{
+public:
+	FilterGraphTimelineDialog(Session& session, MainWindow* parent);
+	virtual ~FilterGraphTimelineDialog();
+
+	virtual bool DoRender();
+
+protected:
+	void RenderTimeline(const FilterGraphTimelineRun& run);
+
+	Session& m_session;
+	MainWindow* m_parent;
+
+	///@brief Index of the run being displayed (0 = oldest)
+	int m_selectedRun;
+
+	///@brief True to always show the most recent run
+	bool m_followLatest;
+
+	///@brief Number of runs to keep (int for imgui compatibility)
+	int m_depth;
+
+	///@brief Browser for exporting the timeline
+	std::shared_ptr<FileBrowser> m_fileDialog;
+};
+
+#endif
@@ -0,0 +1,329 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of GpuProfiler and GpuTimestampQueries
+ */
+#include "ngscopeclient.h"
+#include "GpuProfiler.h"
+
+using namespace std;
+
+GpuProfiler g_gpuProfiler;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GpuStageHistory
+
+GpuStageHistory::GpuStageHistory()
+	: m_next(0)
+	, m_count(0)
+	, m_last(0)
+{
+	for(auto& t : m_times)
+		t = 0;
+}
+
+/**
+	@brief Adds a new execution time to the history, overwriting the oldest one if full
+ */
+void GpuStageHistory::AddSample(int64_t fs)
+{
+	m_last = fs;
+	m_times[m_next] = fs * 1e-9;
+	m_next = (m_next + 1) % HISTORY_DEPTH;
+	if(m_count < HISTORY_DEPTH)
+		m_count ++;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GpuProfiler
+
+GpuProfiler::GpuProfiler()
+	: m_supported(false)
+{
+}
+
+/**
+	@brief Records an execution time for a stage
+ */
+void GpuProfiler::AddSample(const string& path, int64_t fs)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_stages[path].AddSample(fs);
+}
+
+/**
+	@brief Returns a snapshot of the history of every stage, sorted by path (so parents precede their children)
+ */
+map<string, GpuStageHistory> GpuProfiler::GetStages()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_stages;
+}
+
+/**
+	@brief Discards all history, e.g. after closing waveform areas whose stages would otherwise linger
+ */
+void GpuProfiler::Clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_stages.clear();
+}
+
+/**
+	@brief Makes a channel or area name safe to use as a path component
+ */
+string GpuProfiler::EscapeName(const string& name)
+{
+	string ret = name;
+	for(auto& c : ret)
+	{
+		if(c == '/')
+			c = '|';
+	}
+	return ret;
+}
+
+/**
+	@brief Associates a query pool with a command buffer
+ */
+void GpuProfiler::Register(VkCommandBuffer cmdbuf, GpuTimestampQueries* queries)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_queries[cmdbuf] = queries;
+	m_supported = true;
+}
+
+/**
+	@brief Removes the query pool associated with a command buffer
+ */
+void GpuProfiler::Unregister(VkCommandBuffer cmdbuf)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_queries.erase(cmdbuf);
+}
+
+/**
+	@brief Finds the query pool associated with a command buffer
+
+	@return The query pool, or nullptr if the command buffer isn't being profiled
+ */
+GpuTimestampQueries* GpuProfiler::Lookup(VkCommandBuffer cmdbuf)
+{
+	lock_guard<mutex> lock(m_mutex);
+	auto it = m_queries.find(cmdbuf);
+	if(it == m_queries.end())
+		return nullptr;
+	return it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GpuTimestampQueries
+
+/**
+	@brief Creates a query pool for a command buffer and registers it with the profiler
+
+	If the queue family does not support timestamps, no pool is created and all calls are no-ops.
+
+	@param cmdbuf		Command buffer the queries will be recorded into
+	@param queueFamily	Family of the queue the command buffer is submitted to
+	@param maxStages	Maximum number of stages that can be timed per submission
+ */
+GpuTimestampQueries::GpuTimestampQueries(vk::raii::CommandBuffer& cmdbuf, size_t queueFamily, uint32_t maxStages)
+	: m_cmdbuf(cmdbuf)
+	, m_maxStages(maxStages)
+	, m_reset(false)
+	, m_period(0)
+	, m_validMask(0)
+{
+	auto families = g_vkComputePhysicalDevice->getQueueFamilyProperties();
+	if(queueFamily >= families.size())
+		return;
+	auto bits = families[queueFamily].timestampValidBits;
+	if(bits == 0)
+	{
+		LogDebug("Queue family %zu does not support timestamps, GPU profiling disabled\n", queueFamily);
+		return;
+	}
+
+	m_period = g_vkComputePhysicalDevice->getProperties().limits.timestampPeriod;
+	if(bits >= 64)
+		m_validMask = ~0ULL;
+	else
+		m_validMask = (1ULL << bits) - 1;
+
+	vk::QueryPoolCreateInfo info({}, vk::QueryType::eTimestamp, 2*maxStages);
+	m_pool = make_unique<vk::raii::QueryPool>(*g_vkComputeDevice, info);
+
+	g_gpuProfiler.Register(static_cast<VkCommandBuffer>(*m_cmdbuf), this);
+}
+
+GpuTimestampQueries::~GpuTimestampQueries()
+{
+	if(m_pool)
+		g_gpuProfiler.Unregister(static_cast<VkCommandBuffer>(*m_cmdbuf));
+}
+
+/**
+	@brief Resets the query pool
+
+	Must be called after the command buffer is begun and before any timestamps are written. Any results from the
+	previous submission which have not been collected are discarded.
+ */
+void GpuTimestampQueries::Reset()
+{
+	m_names.clear();
+	m_ended.clear();
+	if(!m_pool)
+		return;
+
+	m_cmdbuf.resetQueryPool(**m_pool, 0, 2*m_maxStages);
+	m_reset = true;
+}
+
+/**
+	@brief Writes the starting timestamp of a stage
+
+	@param path		Name of the stage
+
+	@return ID of the stage to pass to End(), or NO_QUERY if nothing was written
+ */
+uint32_t GpuTimestampQueries::Begin(const string& path)
+{
+	if(!m_reset || (m_names.size() >= m_maxStages) )
+		return NO_QUERY;
+
+	uint32_t id = m_names.size();
+	m_cmdbuf.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, **m_pool, 2*id);
+	m_names.push_back(path);
+	m_ended.push_back(false);
+	return id;
+}
+
+/**
+	@brief Writes the ending timestamp of a stage
+ */
+void GpuTimestampQueries::End(uint32_t id)
+{
+	if(id >= m_names.size())
+		return;
+
+	m_cmdbuf.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, **m_pool, 2*id + 1);
+	m_ended[id] = true;
+}
+
+/**
+	@brief Reads back the timestamps and adds them to the profiler history
+
+	Must only be called once the command buffer has completed execution.
+ */
+void GpuTimestampQueries::Collect()
+{
+	if(!m_reset || m_names.empty())
+	{
+		m_reset = false;
+		return;
+	}
+	m_reset = false;
+
+	uint32_t count = 2 * m_names.size();
+	auto results = m_pool->getResults<uint64_t>(
+		0,
+		count,
+		count * sizeof(uint64_t),
+		sizeof(uint64_t),
+		vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+	if(results.first != vk::Result::eSuccess)
+	{
+		m_names.clear();
+		m_ended.clear();
+		return;
+	}
+	auto& ticks = results.second;
+
+	//Measured stages
+	map<string, int64_t> measured;
+	for(size_t i=0; i<m_names.size(); i++)
+	{
+		if(!m_ended[i])
+			continue;
+
+		uint64_t delta = (ticks[2*i + 1] - ticks[2*i]) & m_validMask;
+		measured[m_names[i]] += static_cast<int64_t>(delta * m_period * 1e6);
+	}
+
+	//Totals for any parent stage which was not measured directly
+	map<string, int64_t> totals;
+	for(auto& it : measured)
+	{
+		auto& path = it.first;
+		for(size_t pos = path.find('/'); pos != string::npos; pos = path.find('/', pos+1))
+		{
+			auto parent = path.substr(0, pos);
+			if(measured.find(parent) == measured.end())
+				totals[parent] += it.second;
+		}
+	}
+
+	for(auto& it : measured)
+		g_gpuProfiler.AddSample(it.first, it.second);
+	for(auto& it : totals)
+		g_gpuProfiler.AddSample(it.first, it.second);
+
+	m_names.clear();
+	m_ended.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GpuTimestampScope
+
+/**
+	@brief Writes the starting timestamp of a stage, if the command buffer is being profiled
+
+	@param cmdbuf	Command buffer being recorded
+	@param path		Name of the stage
+ */
+GpuTimestampScope::GpuTimestampScope(vk::raii::CommandBuffer& cmdbuf, const string& path)
+	: m_queries(g_gpuProfiler.Lookup(static_cast<VkCommandBuffer>(*cmdbuf)))
+	, m_id(GpuTimestampQueries::NO_QUERY)
+{
+	if(m_queries)
+		m_id = m_queries->Begin(path);
+}
+
+/**
+	@brief Writes the ending timestamp of the stage
+ */
+GpuTimestampScope::~GpuTimestampScope()
+{
+	if(m_queries)
+		m_queries->End(m_id);
+}
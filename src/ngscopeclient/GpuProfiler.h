@@ -0,0 +1,183 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of GpuProfiler and GpuTimestampQueries
+ */
+#ifndef GpuProfiler_h
+#define GpuProfiler_h
+
+#include "../scopehal/scopehal.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+/**
+	@brief Rolling history of GPU execution time for a single stage
+ */
+class GpuStageHistory
+{
+public:
+	GpuStageHistory();
+
+	void AddSample(int64_t fs);
+
+	///@brief Number of samples kept in the history
+	static const size_t HISTORY_DEPTH = 256;
+
+	///@brief Execution times, in microseconds, as a ring buffer suitable for ImGui::PlotLines()
+	float m_times[HISTORY_DEPTH];
+
+	///@brief Index of the oldest sample (the next one to be overwritten)
+	size_t m_next;
+
+	///@brief Number of valid samples
+	size_t m_count;
+
+	///@brief Most recent execution time, in femtoseconds
+	int64_t m_last;
+};
+
+class GpuTimestampQueries;
+
+/**
+	@brief Collects per-stage GPU execution times measured by timestamp queries
+
+	Stages are named by slash separated paths, for example "Rasterize/Group 1 area 1/CH1". Every ancestor of a stage
+	that was not timed itself in the same command buffer gets the sum of its children, so "Rasterize" always has a
+	total even if only individual channels were measured.
+
+	Instrumented code does not need a reference to the query pool: each GpuTimestampQueries registers the command
+	buffer it belongs to, and GpuTimestampScope looks it up. Nothing is recorded into unregistered command buffers.
+ */
+class GpuProfiler
+{
+public:
+	GpuProfiler();
+
+	void AddSample(const std::string& path, int64_t fs);
+	std::map<std::string, GpuStageHistory> GetStages();
+	void Clear();
+
+	static std::string EscapeName(const std::string& name);
+
+	void Register(VkCommandBuffer cmdbuf, GpuTimestampQueries* queries);
+	void Unregister(VkCommandBuffer cmdbuf);
+	GpuTimestampQueries* Lookup(VkCommandBuffer cmdbuf);
+
+	/**
+		@brief Returns true if at least one command buffer has been set up for timestamp queries
+
+		False if the device does not support timestamps on any queue we use.
+	 */
+	bool IsSupported()
+	{ return m_supported; }
+
+protected:
+
+	///@brief Mutex protecting m_stages and m_queries
+	std::mutex m_mutex;
+
+	///@brief History of each stage, by path
+	std::map<std::string, GpuStageHistory> m_stages;
+
+	///@brief Query pools for each command buffer being profiled
+	std::map<VkCommandBuffer, GpuTimestampQueries*> m_queries;
+
+	///@brief True if any query pool supports timestamps
+	std::atomic<bool> m_supported;
+};
+
+/**
+	@brief A pool of timestamp queries recorded into a single command buffer
+
+	Usage is: Reset() after beginning the command buffer (outside of a render pass), any number of Begin() / End()
+	pairs, then Collect() once the command buffer has completed execution.
+ */
+class GpuTimestampQueries
+{
+public:
+	GpuTimestampQueries(vk::raii::CommandBuffer& cmdbuf, size_t queueFamily, uint32_t maxStages = 256);
+	~GpuTimestampQueries();
+
+	void Reset();
+	uint32_t Begin(const std::string& path);
+	void End(uint32_t id);
+	void Collect();
+
+	///@brief Sentinel returned by Begin() if no query was recorded
+	static const uint32_t NO_QUERY = 0xffffffff;
+
+protected:
+
+	///@brief The command buffer we record into
+	vk::raii::CommandBuffer& m_cmdbuf;
+
+	///@brief The query pool (null if timestamps are not supported on this queue)
+	std::unique_ptr<vk::raii::QueryPool> m_pool;
+
+	///@brief Maximum number of stages (each uses two queries)
+	uint32_t m_maxStages;
+
+	///@brief Name of each stage begun since the last reset
+	std::vector<std::string> m_names;
+
+	///@brief True if End() was called for each stage begun since the last reset
+	std::vector<bool> m_ended;
+
+	///@brief True if the pool was reset in the command buffer currently being recorded
+	bool m_reset;
+
+	///@brief Nanoseconds per timestamp tick
+	double m_period;
+
+	///@brief Mask of valid timestamp bits
+	uint64_t m_validMask;
+};
+
+/**
+	@brief Times everything recorded into a command buffer during the lifetime of this object
+ */
+class GpuTimestampScope
+{
+public:
+	GpuTimestampScope(vk::raii::CommandBuffer& cmdbuf, const std::string& path);
+	~GpuTimestampScope();
+
+protected:
+	GpuTimestampQueries* m_queries;
+	uint32_t m_id;
+};
+
+extern GpuProfiler g_gpuProfiler;
+
+#endif
@@ -37,11 +37,39 @@
 
 using namespace std;
 
+/**
+	@brief Per-thread handle to a staging buffer
+
+	Marks the buffer as orphaned when the thread exits. The buffer itself is kept alive by whichever of this and the
+	sink goes away last.
+ */
+class LogStagingBufferHandle
+{
+public:
+	LogStagingBufferHandle()
+		: m_sink(nullptr)
+	{}
+
+	~LogStagingBufferHandle()
+	{
+		if(m_buffer)
+			m_buffer->m_orphaned = true;
+	}
+
+	GuiLogSink* m_sink;
+	shared_ptr<LogStagingBuffer> m_buffer;
+};
+
+static thread_local LogStagingBufferHandle g_stagingBuffer;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
-GuiLogSink::GuiLogSink(Severity min_severity)
+GuiLogSink::GuiLogSink(Severity min_severity, size_t capacity)
 	: LogSink(min_severity)
+	, m_capacity(max<size_t>(capacity, 1))
+	, m_head(0)
+	, m_firstLine(0)
 {
 
 }
@@ -53,36 +81,144 @@ GuiLogSink::~GuiLogSink()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Logging
 
+/**
+	@brief Discards all lines
+
+	Sequence numbers are not reused, so lines logged afterwards never alias ones a viewer indexed before clearing.
+ */
 void GuiLogSink::Clear()
 {
+	lock_guard<mutex> lock(m_mutex);
+	FlushStagedMessages();
+	m_firstLine += m_lines.size();
 	m_lines.clear();
+	m_head = 0;
 }
 
-void GuiLogSink::Log(Severity severity, const string &msg)
+/**
+	@brief Moves all messages logged by other threads into the log
+
+	Called by the GUI thread once per frame.
+ */
+void GuiLogSink::Flush()
 {
-	if(severity > m_min_severity)
+	lock_guard<mutex> lock(m_mutex);
+	FlushStagedMessages();
+}
+
+/**
+	@brief Gets the staging buffer for the calling thread, creating it the first time the thread logs
+ */
+LogStagingBuffer& GuiLogSink::GetStagingBuffer()
+{
+	auto& handle = g_stagingBuffer;
+	if(handle.m_sink != this)
+	{
+		if(handle.m_buffer)
+			handle.m_buffer->m_orphaned = true;
+
+		handle.m_buffer = make_shared<LogStagingBuffer>();
+		handle.m_sink = this;
+
+		lock_guard<mutex> lock(m_stagingMutex);
+		m_stagingBuffers.push_back(handle.m_buffer);
+	}
+	return *handle.m_buffer;
+}
+
+/**
+	@brief Moves messages from every staging buffer into the log, in the order they were logged
+
+	Must be called with m_mutex held.
+ */
+void GuiLogSink::FlushStagedMessages()
+{
+	vector< shared_ptr<LogStagingBuffer> > buffers;
+	{
+		lock_guard<mutex> lock(m_stagingMutex);
+		buffers = m_stagingBuffers;
+	}
+
+	//Interleave messages from different threads by timestamp.
+	//Each thread's messages are already in order, and the sort is stable, so partial lines stay in sequence.
+	m_flushBatch.clear();
+	for(auto& buf : buffers)
+	{
+		StagedLogMessage msg;
+		while(buf->Pop(msg))
+			m_flushBatch.push_back(pair<LogStagingBuffer*, StagedLogMessage>(buf.get(), std::move(msg)));
+	}
+	stable_sort(m_flushBatch.begin(), m_flushBatch.end(),
+		[](const pair<LogStagingBuffer*, StagedLogMessage>& a, const pair<LogStagingBuffer*, StagedLogMessage>& b)
+		{ return a.second.m_time < b.second.m_time; });
+	for(auto& it : m_flushBatch)
+		ProcessMessage(*it.first, it.second);
+	m_flushBatch.clear();
+
+	//Free buffers of threads which have exited, once we've seen everything they logged
+	lock_guard<mutex> lock(m_stagingMutex);
+	for(size_t i=0; i<m_stagingBuffers.size(); )
+	{
+		auto& buf = m_stagingBuffers[i];
+		if(buf->m_orphaned && buf->IsEmpty())
+		{
+			if(!buf->m_unbufferedLine.empty())
+				AppendLine(Severity::NOTICE, buf->m_unbufferedLine, GetTime());
+			m_stagingBuffers.erase(m_stagingBuffers.begin() + i);
+		}
+		else
+			i++;
+	}
+}
+
+/**
+	@brief Adds a complete line to the ring buffer, overwriting the oldest line if full
+
+	Must be called with m_mutex held.
+ */
+void GuiLogSink::AppendLine(Severity severity, const string& msg, double time)
+{
+	if(m_lines.size() < m_capacity)
+	{
+		m_lines.push_back(LogLine(severity, msg, time));
 		return;
+	}
+
+	m_lines[m_head] = LogLine(severity, msg, time);
+	m_head = (m_head + 1) % m_capacity;
+	m_firstLine ++;
+}
+
+/**
+	@brief Splits a staged message into lines and appends them to the log
+
+	Must be called with m_mutex held.
+
+	@param buf	Staging buffer the message came from, which holds any partial line from the same thread
+	@param msg	The message
+ */
+void GuiLogSink::ProcessMessage(LogStagingBuffer& buf, const StagedLogMessage& msg)
+{
+	auto severity = msg.m_sev;
 
 	//Blank lines get special handling
-	if(msg == "\n")
+	if(msg.m_msg == "\n")
 	{
-		m_lines.push_back(LogLine(severity, ""));
+		AppendLine(severity, "", msg.m_time);
 		return;
 	}
 
-	auto indent = GetIndentString();
-
 	//No newline? Append to existing buffer
-	if(msg.find('\n') == string::npos)
+	if(msg.m_msg.find('\n') == string::npos)
 	{
-		if(m_unbufferedLine.empty())
-			m_unbufferedLine += indent;
-		m_unbufferedLine += msg;
+		if(buf.m_unbufferedLine.empty())
+			buf.m_unbufferedLine += msg.m_indent;
+		buf.m_unbufferedLine += msg.m_msg;
 		return;
 	}
 
 	//One or more newlines? Split and process it
-	auto vec = explode(msg, '\n');
+	auto vec = explode(msg.m_msg, '\n');
 	auto len = vec.size();
 	for(size_t i=0; i<len; i++)
 	{
@@ -99,22 +235,50 @@ void GuiLogSink::Log(Severity severity, const string &msg)
 			break;
 
 		//If unbuffered line is present, append to it
-		if(!m_unbufferedLine.empty())
+		if(!buf.m_unbufferedLine.empty())
 		{
-			m_lines.push_back(LogLine(severity, m_unbufferedLine + line));
-			m_unbufferedLine = "";
+			AppendLine(severity, buf.m_unbufferedLine + line, msg.m_time);
+			buf.m_unbufferedLine = "";
 		}
 
 		//Otherwise append it
 		else
-			m_lines.push_back(LogLine(severity, indent + line));
+			AppendLine(severity, msg.m_indent + line, msg.m_time);
 	}
 }
 
+void GuiLogSink::Log(Severity severity, const string &msg)
+{
+	if(severity > m_min_severity)
+		return;
+
+	Stage(severity, string(msg));
+}
+
 void GuiLogSink::Log(Severity severity, const char *format, va_list va)
 {
 	if(severity > m_min_severity)
 		return;
 
-	Log(severity, vstrprintf(format, va));
+	Stage(severity, vstrprintf(format, va));
+}
+
+/**
+	@brief Queues a message on the calling thread's staging buffer, for the GUI thread to add to the log
+ */
+void GuiLogSink::Stage(Severity severity, string&& msg)
+{
+	StagedLogMessage staged;
+	staged.m_sev = severity;
+	staged.m_time = GetTime();
+	staged.m_msg = std::move(msg);
+	staged.m_indent = GetIndentString();
+
+	auto& buf = GetStagingBuffer();
+	while(!buf.Push(staged))
+	{
+		//The GUI thread isn't keeping up (or isn't running yet), drain the buffers ourselves
+		lock_guard<mutex> lock(m_mutex);
+		FlushStagedMessages();
+	}
 }
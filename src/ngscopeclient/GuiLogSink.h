@@ -37,45 +37,181 @@
 
 #include "Marker.h"
 
+#include <mutex>
+
 /**
 	@brief A single line of the log
  */
 class LogLine
 {
 public:
-	LogLine(Severity sev, const std::string& str)
+	LogLine(Severity sev, const std::string& str, double time)
 		: m_sev(sev)
 		, m_msg(str)
-		, m_timestamp(GetTime())
+		, m_timestamp(time)
+		, m_timestampText(m_timestamp.PrettyPrint())
 	{
 	}
 
 	Severity m_sev;
 	std::string m_msg;
 	TimePoint m_timestamp;
+
+	///@brief Timestamp formatted once at creation, so the viewer doesn't have to every frame
+	std::string m_timestampText;
+};
+
+/**
+	@brief A message logged by some thread, not yet split into lines
+ */
+class StagedLogMessage
+{
+public:
+	Severity m_sev;
+	double m_time;
+	std::string m_msg;
+	std::string m_indent;
+};
+
+/**
+	@brief Fixed size single producer, single consumer queue of messages logged by one thread
+
+	The producer is the owning thread, the consumer is whichever thread holds the GuiLogSink mutex.
+ */
+class LogStagingBuffer
+{
+public:
+	LogStagingBuffer()
+		: m_writePtr(0)
+		, m_readPtr(0)
+		, m_orphaned(false)
+	{}
+
+	/**
+		@brief Adds a message to the queue (producer only)
+
+		@return False if the queue is full, in which case msg is left untouched
+	 */
+	bool Push(StagedLogMessage& msg)
+	{
+		size_t w = m_writePtr.load(std::memory_order_relaxed);
+		if(w - m_readPtr.load(std::memory_order_acquire) >= CAPACITY)
+			return false;
+		m_messages[w % CAPACITY] = std::move(msg);
+		m_writePtr.store(w + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+		@brief Removes the oldest message from the queue (consumer only)
+
+		@return False if the queue is empty
+	 */
+	bool Pop(StagedLogMessage& msg)
+	{
+		size_t r = m_readPtr.load(std::memory_order_relaxed);
+		if(r == m_writePtr.load(std::memory_order_acquire))
+			return false;
+		msg = std::move(m_messages[r % CAPACITY]);
+		m_readPtr.store(r + 1, std::memory_order_release);
+		return true;
+	}
+
+	///@brief Returns true if there are no messages in the queue (consumer only)
+	bool IsEmpty()
+	{ return m_readPtr.load(std::memory_order_relaxed) == m_writePtr.load(std::memory_order_acquire); }
+
+	///@brief Number of messages the queue can hold
+	static const size_t CAPACITY = 1024;
+
+	///@brief Total number of messages pushed
+	std::atomic<size_t> m_writePtr;
+
+	///@brief Total number of messages popped
+	std::atomic<size_t> m_readPtr;
+
+	///@brief Set when the owning thread exits, so the buffer can be freed once drained
+	std::atomic<bool> m_orphaned;
+
+	///@brief Partial line (logged without a trailing newline) awaiting the rest of its text (consumer only)
+	std::string m_unbufferedLine;
+
+protected:
+	StagedLogMessage m_messages[CAPACITY];
 };
 
 /**
 	@brief Log sink for displaying logs in the GUI
+
+	Logging threads only format their message and push it onto a per-thread lock-free staging queue. The GUI thread
+	calls Flush() once per frame to split the messages into lines and move them into the log. If a thread fills its
+	staging queue before then, it flushes all of the queues itself.
+
+	Lines are kept in a fixed capacity ring buffer, discarding the oldest once full. Each line is identified by a
+	sequence number which increases monotonically for the lifetime of the sink (including across Clear()), so viewers
+	can keep their own indexes of lines and tell which have since been discarded.
+
+	All accessors require GetMutex() to be held. Nothing may be logged while holding it.
  */
 class GuiLogSink : public LogSink
 {
 public:
-	GuiLogSink(Severity min_severity = Severity::DEBUG);
+	GuiLogSink(Severity min_severity = Severity::DEBUG, size_t capacity = 100000);
 	virtual ~GuiLogSink() override;
 
 	void Clear();
+	void Flush();
 
 	void Log(Severity severity, const std::string &msg) override;
 	void Log(Severity severity, const char *format, va_list va) override;
 
-	const std::vector<LogLine>& GetLines()
-	{ return m_lines; }
+	std::mutex& GetMutex()
+	{ return m_mutex; }
+
+	///@brief Gets the sequence number of the oldest line still retained
+	uint64_t GetFirstLine()
+	{ return m_firstLine; }
+
+	///@brief Gets the sequence number the next line will have (one past the newest line)
+	uint64_t GetEndLine()
+	{ return m_firstLine + m_lines.size(); }
+
+	/**
+		@brief Gets a line by sequence number, which must be in [GetFirstLine(), GetEndLine())
+	 */
+	const LogLine& GetLine(uint64_t seq)
+	{ return m_lines[(m_head + (seq - m_firstLine)) % m_lines.size()]; }
 
 protected:
+	void Stage(Severity severity, std::string&& msg);
+	LogStagingBuffer& GetStagingBuffer();
+	void FlushStagedMessages();
+	void ProcessMessage(LogStagingBuffer& buf, const StagedLogMessage& msg);
+	void AppendLine(Severity severity, const std::string& msg, double time);
+
+	///@brief Mutex protecting the ring buffer, and for consuming from the staging buffers
+	std::mutex m_mutex;
+
+	///@brief Ring buffer of lines
 	std::vector<LogLine> m_lines;
 
-	std::string m_unbufferedLine;
+	///@brief Maximum number of lines retained
+	size_t m_capacity;
+
+	///@brief Index in m_lines of the oldest line (only nonzero once the buffer has wrapped)
+	size_t m_head;
+
+	///@brief Sequence number of the oldest line
+	uint64_t m_firstLine;
+
+	///@brief Mutex protecting m_stagingBuffers
+	std::mutex m_stagingMutex;
+
+	///@brief Staging buffers for every thread which has logged to us
+	std::vector< std::shared_ptr<LogStagingBuffer> > m_stagingBuffers;
+
+	///@brief Messages drained from the staging buffers in the current flush, with the buffer each came from
+	std::vector< std::pair<LogStagingBuffer*, StagedLogMessage> > m_flushBatch;
 };
 
 #endif
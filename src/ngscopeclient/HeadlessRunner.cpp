@@ -0,0 +1,441 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of HeadlessRunner
+ */
+#include "ngscopeclient.h"
+#include "HeadlessRunner.h"
+#include "OffscreenRenderer.h"
+
+#include <fstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+HeadlessRunner::HeadlessRunner()
+	: m_session(nullptr)
+{
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+	m_session.ClearBackgroundThreads();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Session loading
+
+/**
+	@brief Loads a .scopesession file
+
+	Unlike the GUI, there is nobody to confirm potentially dangerous configuration changes. If the preload step
+	produces any warnings when reconnecting to live hardware, they are logged and loading is aborted.
+
+	@param sessionPath	Path to the .scopesession file
+	@param online		True to reconnect to the instruments, false to load saved waveforms only
+
+	@return True on success, false on failure
+ */
+bool HeadlessRunner::LoadSession(const string& sessionPath, bool online)
+{
+	//Waveform data lives next to the session file, named after it minus the extension
+	const string ext = ".scopesession";
+	string base = sessionPath;
+	if( (base.length() >= ext.length()) && (base.compare(base.length() - ext.length(), ext.length(), ext) == 0) )
+		base.resize(base.length() - ext.length());
+	string datadir = base + "_data";
+
+	LogNotice("Loading session \"%s\" (%s)\n", sessionPath.c_str(), online ? "online" : "offline");
+	LogIndenter li;
+
+	try
+	{
+		auto docs = YAML::LoadAllFromFile(sessionPath);
+		if(docs.size() != 1)
+		{
+			LogError("Expected one YAML document in \"%s\", found %zu\n", sessionPath.c_str(), docs.size());
+			return false;
+		}
+
+		if(!m_session.PreLoadFromYaml(docs[0], datadir, online))
+			return false;
+
+		auto& warnings = m_session.GetWarnings();
+		if(online && !warnings.m_warnings.empty())
+		{
+			LogError("Session configuration does not match current hardware state, refusing to load online:\n");
+			LogIndenter li2;
+			for(auto it : warnings.m_warnings)
+			{
+				for(auto w : it.second.m_messages)
+				{
+					LogError("%s: %s (hardware %s, session %s) %s\n",
+						it.first->m_nickname.c_str(),
+						w.m_object.c_str(),
+						w.m_existingValue.c_str(),
+						w.m_proposedValue.c_str(),
+						w.m_messageText.c_str());
+				}
+			}
+			return false;
+		}
+
+		if(!m_session.LoadFromYaml(docs[0], datadir, online))
+			return false;
+		if(!m_session.LoadWaveformData(datadir))
+			return false;
+		m_uiConfig = docs[0]["ui_config"];
+	}
+	catch(const YAML::Exception& ex)
+	{
+		LogError("Failed to load \"%s\": %s\n", sessionPath.c_str(), ex.what());
+		return false;
+	}
+
+	FindMeasurementStreams();
+	return true;
+}
+
+/**
+	@brief Makes a list of all scalar streams in the session (filter measurements and instrument readings)
+ */
+void HeadlessRunner::FindMeasurementStreams()
+{
+	m_measurementStreams.clear();
+
+	auto nodes = m_session.GetAllGraphNodes();
+	for(auto node : nodes)
+	{
+		auto chan = dynamic_cast<InstrumentChannel*>(node);
+		if(!chan)
+			continue;
+
+		for(size_t i=0; i<chan->GetStreamCount(); i++)
+		{
+			if(chan->GetType(i) == Stream::STREAM_TYPE_ANALOG_SCALAR)
+				m_measurementStreams.push_back(StreamDescriptor(chan, i));
+		}
+	}
+
+	//Sort by name so output column order is stable from run to run
+	sort(m_measurementStreams.begin(), m_measurementStreams.end(),
+		[](const StreamDescriptor& a, const StreamDescriptor& b)
+		{ return a.GetName() < b.GetName(); });
+
+	LogDebug("Found %zu scalar measurement streams\n", m_measurementStreams.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Processing
+
+/**
+	@brief Runs the filter graph over every waveform in the session's history, oldest first
+
+	If the session has no history (filter-only session) the graph is run once.
+ */
+void HeadlessRunner::RunOffline()
+{
+	auto& history = m_session.GetHistory();
+	if(history.empty())
+	{
+		LogDebug("No waveform history, running filter graph once\n");
+		m_session.RefreshAllFilters();
+		RecordMeasurements(TimePoint(0, 0));
+		return;
+	}
+
+	//Take a copy of the list, since nothing should be added while we're iterating but be safe
+	auto points = history.m_history;
+	size_t i = 0;
+	for(auto point : points)
+	{
+		LogDebug("Processing waveform %zu/%zu (%s)\n", ++i, points.size(), point->m_time.PrettyPrint().c_str());
+
+		point->LoadHistoryToSession(m_session);
+		m_session.RefreshAllFilters();
+		RecordMeasurements(point->m_time);
+	}
+}
+
+/**
+	@brief Arms the trigger and processes waveforms from live instruments as fast as they arrive
+
+	@param count	Number of acquisitions to process before stopping
+
+	@return True if all acquisitions were processed, false if the trigger failed to arm
+ */
+bool HeadlessRunner::RunOnline(size_t count)
+{
+	if(!m_session.ArmTrigger(TriggerGroup::TRIGGER_TYPE_NORMAL))
+		return false;
+
+	size_t nwaveforms = 0;
+	while(nwaveforms < count)
+	{
+		if(!m_session.ProcessPendingWaveforms())
+		{
+			//Give up if a multi-scope group failed to re-arm
+			if(!m_session.IsTriggerArmed())
+			{
+				LogError("Trigger is no longer armed after %zu/%zu acquisitions\n", nwaveforms, count);
+				return false;
+			}
+
+			this_thread::sleep_for(chrono::milliseconds(1));
+			continue;
+		}
+
+		nwaveforms ++;
+		LogDebug("Processed waveform %zu/%zu\n", nwaveforms, count);
+		RecordMeasurements(m_session.GetHistory().GetMostRecentPoint());
+	}
+
+	m_session.StopTrigger();
+	return true;
+}
+
+/**
+	@brief Saves the current value of every measurement stream
+ */
+void HeadlessRunner::RecordMeasurements(TimePoint t)
+{
+	if(m_measurementStreams.empty())
+		return;
+
+	vector<float> values;
+	for(auto& s : m_measurementStreams)
+		values.push_back(s.GetScalarValue());
+	m_measurements.push_back(pair<TimePoint, vector<float>>(t, values));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Output
+
+/**
+	@brief Writes all protocol decoder packets and measurements to CSV files in the specified directory
+
+	@return True on success, false on failure
+ */
+bool HeadlessRunner::WriteResults(const string& outdir)
+{
+	#ifdef _WIN32
+		_mkdir(outdir.c_str());
+	#else
+		mkdir(outdir.c_str(), 0755);
+	#endif
+
+	bool ok = WritePackets(outdir);
+	if(!WriteMeasurements(outdir))
+		ok = false;
+	return ok;
+}
+
+/**
+	@brief Runs the filter graph on the most recent waveform and draws every waveform group to a PNG file
+
+	@param outdir		Directory to write images to
+	@param prefix		Prefix for image file names
+	@param width		Width of each image, in pixels
+	@param areaHeight	Height of each waveform area, in pixels
+
+	@return True on success, false on failure
+ */
+bool HeadlessRunner::RenderGroups(const string& outdir, const string& prefix, size_t width, size_t areaHeight)
+{
+	#ifdef _WIN32
+		_mkdir(outdir.c_str());
+	#else
+		mkdir(outdir.c_str(), 0755);
+	#endif
+
+	if(!m_uiConfig)
+	{
+		LogError("Session has no UI configuration, nothing to render\n");
+		return false;
+	}
+
+	m_session.RefreshAllFilters();
+
+	OffscreenRenderer renderer(m_session, width, areaHeight);
+	return renderer.RenderGroups(m_uiConfig, outdir, prefix);
+}
+
+/**
+	@brief Writes one CSV file per protocol decoder, containing the packets from every processed waveform
+
+	Merged summary rows are skipped, and the individual packets that make them up are written instead.
+ */
+bool HeadlessRunner::WritePackets(const string& outdir)
+{
+	auto managers = m_session.GetPacketManagers();
+	for(auto it : managers)
+	{
+		auto pd = it.first;
+		auto mgr = it.second;
+
+		//Make a filesystem-safe name for the decoder
+		string name = pd->GetDisplayName();
+		for(auto& c : name)
+		{
+			if(!isalnum(c) && (c != '-') && (c != '_') )
+				c = '_';
+		}
+		string fname = outdir + "/packets_" + name + ".csv";
+
+		ofstream outfs(fname);
+		if(!outfs)
+		{
+			LogError("Failed to open \"%s\" for writing\n", fname.c_str());
+			return false;
+		}
+
+		//Header row
+		auto cols = pd->GetHeaders();
+		outfs << "Waveform,Offset (fs),Length (fs)";
+		for(auto& c : cols)
+			outfs << "," << CSVEscape(c);
+		outfs << ",Data\n";
+
+		lock_guard<recursive_mutex> lock(mgr->GetMutex());
+		size_t npackets = 0;
+		for(auto& jt : mgr->GetPackets())
+		{
+			auto wavetime = jt.first.PrettyPrint();
+			for(auto p : jt.second)
+			{
+				auto& children = mgr->GetChildPackets(p);
+				vector<Packet*> rows;
+				if(children.empty())
+					rows.push_back(p);
+				else
+					rows = children;
+
+				for(auto row : rows)
+				{
+					outfs << CSVEscape(wavetime) << "," << row->m_offset << "," << row->m_len;
+					for(auto& c : cols)
+						outfs << "," << CSVEscape(row->m_headers[c]);
+
+					outfs << ",";
+					char tmp[4];
+					for(auto b : row->m_data)
+					{
+						snprintf(tmp, sizeof(tmp), "%02x", b);
+						outfs << tmp;
+					}
+					outfs << "\n";
+
+					npackets ++;
+				}
+			}
+		}
+
+		outfs.close();
+		if(!outfs)
+		{
+			LogError("Failed to write \"%s\"\n", fname.c_str());
+			return false;
+		}
+
+		LogNotice("Wrote %zu packets to %s\n", npackets, fname.c_str());
+	}
+
+	return true;
+}
+
+/**
+	@brief Writes a CSV file containing the value of every scalar stream after each filter graph run
+ */
+bool HeadlessRunner::WriteMeasurements(const string& outdir)
+{
+	if(m_measurementStreams.empty())
+		return true;
+
+	string fname = outdir + "/measurements.csv";
+	ofstream outfs(fname);
+	if(!outfs)
+	{
+		LogError("Failed to open \"%s\" for writing\n", fname.c_str());
+		return false;
+	}
+
+	outfs << "Waveform";
+	for(auto& s : m_measurementStreams)
+		outfs << "," << CSVEscape(s.GetName() + " (" + s.GetYAxisUnits().ToString() + ")");
+	outfs << "\n";
+
+	for(auto& it : m_measurements)
+	{
+		outfs << CSVEscape(it.first.PrettyPrint());
+		for(auto v : it.second)
+			outfs << "," << v;
+		outfs << "\n";
+	}
+
+	outfs.close();
+	if(!outfs)
+	{
+		LogError("Failed to write \"%s\"\n", fname.c_str());
+		return false;
+	}
+
+	LogNotice("Wrote %zu measurement rows to %s\n", m_measurements.size(), fname.c_str());
+	return true;
+}
+
+/**
+	@brief Quotes a string for use as a CSV field, if needed
+ */
+string HeadlessRunner::CSVEscape(const string& str)
+{
+	if(str.find_first_of(",\"\n") == string::npos)
+		return str;
+
+	string ret = "\"";
+	for(auto c : str)
+	{
+		if(c == '"')
+			ret += "\"\"";
+		else
+			ret += c;
+	}
+	ret += "\"";
+	return ret;
+}
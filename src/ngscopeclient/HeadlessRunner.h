@@ -0,0 +1,82 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of HeadlessRunner
+ */
+#ifndef HeadlessRunner_h
+#define HeadlessRunner_h
+
+#include "Session.h"
+
+/**
+	@brief Runs a session's acquisition and filter graph with no GUI, for batch processing on render-less machines
+
+	Filter graph execution is not throttled to any display rate; it runs as fast as the graph (and instruments, if
+	online) allow. Protocol decoder packets and scalar measurement values are written to CSV files.
+ */
+class HeadlessRunner
+{
+public:
+	HeadlessRunner();
+	virtual ~HeadlessRunner();
+
+	bool LoadSession(const std::string& sessionPath, bool online);
+	void RunOffline();
+	bool RunOnline(size_t count);
+	bool WriteResults(const std::string& outdir);
+	bool RenderGroups(const std::string& outdir, const std::string& prefix, size_t width, size_t areaHeight);
+
+	Session& GetSession()
+	{ return m_session; }
+
+protected:
+	void FindMeasurementStreams();
+	void RecordMeasurements(TimePoint t);
+	bool WritePackets(const std::string& outdir);
+	bool WriteMeasurements(const std::string& outdir);
+
+	static std::string CSVEscape(const std::string& str);
+
+	///@brief The session being processed (has no MainWindow)
+	Session m_session;
+
+	///@brief UI configuration from the session file (waveform groups and areas)
+	YAML::Node m_uiConfig;
+
+	///@brief Scalar streams we log values from after each filter graph run
+	std::vector<StreamDescriptor> m_measurementStreams;
+
+	///@brief Values of each stream in m_measurementStreams, for each filter graph run
+	std::vector< std::pair<TimePoint, std::vector<float> > > m_measurements;
+};
+
+#endif
@@ -115,6 +115,13 @@ bool HistoryDialog::DoRender()
 		"Adjust the cap on total history depth, in waveforms.\n"
 		"Large history depths can use significant amounts of RAM with deep memory.");
 
+	//Summary is computed in the background, so it may lag a frame or two behind the table
+	m_mgr.UpdateSummary();
+	auto summary = m_mgr.GetSummary();
+	Unit sa(Unit::UNIT_SAMPLEDEPTH);
+	ImGui::Text("%zu points, %zu waveforms, %s total",
+		summary.m_points, summary.m_waveforms, sa.PrettyPrint(summary.m_samples).c_str());
+
 	if(ImGui::BeginTable("history", 3, flags))
 	{
 		ImGui::TableSetupScrollFreeze(0, 1); //Header row does not scroll
@@ -303,18 +310,21 @@ bool HistoryDialog::DoRender()
 
 	This is done at the very end of the frame following the actual selection change, to avoid inconsistent UI state
 	from making the change mid-frame.
+
+	@return True if filter outputs were restored from cache and the filter graph does not need to be re-run
  */
-void HistoryDialog::LoadHistoryFromSelection(Session& session)
+bool HistoryDialog::LoadHistoryFromSelection(Session& session)
 {
 	if(m_selectedPoint)
 	{
 		LogTrace("Valid point selected\n");
-		m_selectedPoint->LoadHistoryToSession(session);
+		return m_selectedPoint->LoadHistoryToSession(session);
 	}
 	else
 	{
 		LogTrace("Empty point selected\n");
 		m_mgr.LoadEmptyHistoryToSession(session);
+		return false;
 	}
 }
 
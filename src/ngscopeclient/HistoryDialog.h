@@ -58,7 +58,7 @@ public:
 		return changed;
 	}
 
-	void LoadHistoryFromSelection(Session& session);
+	bool LoadHistoryFromSelection(Session& session);
 	void UpdateSelectionToLatest();
 	void SelectTimestamp(TimePoint t);
 
@@ -38,6 +38,49 @@
 
 using namespace std;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FilterOutputCacheEntry
+
+/**
+	@brief Frees all saved waveforms and empties the entry
+ */
+void FilterOutputCacheEntry::Clear()
+{
+	for(auto it : m_waveforms)
+		delete it.second;
+
+	m_waveforms.clear();
+	m_scalars.clear();
+	m_filters.clear();
+	m_bytes = 0;
+}
+
+/**
+	@brief Gets the approximate memory footprint of a waveform
+
+	There's no generic way to ask a waveform how big it is, so this is only exact for the common sample types.
+ */
+static size_t EstimateWaveformSize(WaveformBase* wfm)
+{
+	if(!wfm)
+		return 0;
+
+	size_t len = wfm->size();
+	if(dynamic_cast<UniformAnalogWaveform*>(wfm) != nullptr)
+		return len * sizeof(float);
+	if(dynamic_cast<UniformDigitalWaveform*>(wfm) != nullptr)
+		return len * sizeof(bool);
+
+	//Sparse waveforms carry a 64-bit offset and duration for each sample
+	if(dynamic_cast<SparseAnalogWaveform*>(wfm) != nullptr)
+		return len * (sizeof(float) + 2*sizeof(int64_t));
+	if(dynamic_cast<SparseDigitalWaveform*>(wfm) != nullptr)
+		return len * (sizeof(bool) + 2*sizeof(int64_t));
+
+	//Protocol decodes etc: assume a small symbol plus offset and duration
+	return len * 32;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // HistoryPoint
 
@@ -95,8 +138,11 @@ bool HistoryPoint::IsInUse()
 
 /**
 	@brief Update all instruments in the specified session with our saved historical data
+
+	@return True if the filter graph outputs for this point were restored from cache, and the graph does not need
+			to be re-run. False if a refresh is needed.
  */
-void HistoryPoint::LoadHistoryToSession(Session& session)
+bool HistoryPoint::LoadHistoryToSession(Session& session)
 {
 	LogTrace("Loading history from time %s to session\n", m_time.PrettyPrint().c_str());
 	LogIndenter li;
@@ -149,6 +195,8 @@ void HistoryPoint::LoadHistoryToSession(Session& session)
 			}
 		}
 	}
+
+	return session.GetHistory().SwapFilterOutputs(shared_from_this());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -157,11 +205,21 @@ void HistoryPoint::LoadHistoryToSession(Session& session)
 HistoryManager::HistoryManager(Session& session)
 	: m_maxDepth(10)
 	, m_session(session)
+	, m_summaryKey(TimePoint(0, 0), TimePoint(0, 0), 0)
+	, m_filterOutputsValid(false)
+	, m_filterCacheGeneration(1)
+	, m_filterCacheClock(0)
+	, m_filterCacheEntries(0)
+	, m_filterCacheBytes(0)
+	, m_filterCacheHits(0)
+	, m_filterCacheMisses(0)
 {
 }
 
 HistoryManager::~HistoryManager()
 {
+	if(m_summaryDone.valid())
+		m_session.GetTaskScheduler().WaitFor(m_summaryDone);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -196,6 +254,13 @@ void HistoryManager::LoadEmptyHistoryToSession(Session& session)
 	//We don't want to keep capturing if we're trying to look at a historical waveform. That would be a bit silly.
 	session.StopTrigger();
 
+	//Filter outputs won't correspond to any history point once they're re-run
+	{
+		lock_guard<shared_mutex> lock(session.GetWaveformDataMutex());
+		m_activePoint.reset();
+		m_filterOutputsValid = false;
+	}
+
 	//Set all channels' data to null
 	auto scopes = session.GetScopes();
 	for(auto scope : scopes)
@@ -271,6 +336,7 @@ void HistoryManager::AddHistory(
 	pt->m_time = tp;
 	pt->m_pinned = pin;
 	pt->m_nickname = nick;
+	m_activePoint = pt;
 
 	//Add waveforms
 	for(auto scope : scopes)
@@ -364,6 +430,56 @@ bool HistoryManager::HasHistory(TimePoint t)
 	return false;
 }
 
+/**
+	@brief Recomputes the history summary in the background if the history has changed since the last update
+
+	Must be called from the same thread that modifies m_history. The result is available from GetSummary() once the
+	background task completes.
+ */
+void HistoryManager::UpdateSummary()
+{
+	//Still busy with the last one
+	if(m_summaryDone.valid() && (m_summaryDone.wait_for(0s) != future_status::ready) )
+		return;
+
+	//Nothing changed? Don't bother
+	tuple<TimePoint, TimePoint, size_t> key(TimePoint(0, 0), TimePoint(0, 0), m_history.size());
+	if(!m_history.empty())
+	{
+		get<0>(key) = m_history.front()->m_time;
+		get<1>(key) = m_history.back()->m_time;
+	}
+	if(m_summaryDone.valid() && (key == m_summaryKey) )
+		return;
+	m_summaryKey = key;
+
+	//Walk a snapshot of the list, so points being deleted by the UI in the meantime stay alive until we're done
+	vector<shared_ptr<HistoryPoint>> points(m_history.begin(), m_history.end());
+	m_summaryDone = m_session.GetTaskScheduler().Submit(TaskScheduler::PRIORITY_BACKGROUND, [this, points]
+		{
+			shared_lock<shared_mutex> lock(m_session.GetWaveformDataMutex());
+
+			HistorySummary summary;
+			summary.m_points = points.size();
+			for(auto& pt : points)
+			{
+				for(auto& it : pt->m_history)
+				{
+					for(auto& jt : it.second)
+					{
+						if(!jt.second)
+							continue;
+						summary.m_waveforms ++;
+						summary.m_samples += jt.second->size();
+					}
+				}
+			}
+
+			lock_guard<mutex> lock2(m_summaryMutex);
+			m_summary = summary;
+		});
+}
+
 /**
 	@brief Called when we run out of memory
  */
@@ -419,9 +535,210 @@ bool HistoryManager::OnMemoryPressure(
 				}
 			}
 		}
+
+		for(auto it : pt->m_filterCache.m_waveforms)
+		{
+			if(it.second && it.second->HasGpuBuffer())
+			{
+				memFreed = true;
+				it.second->FreeGpuMemory();
+			}
+		}
 	}
 
 	//Done
 	mutex.unlock();
 	return memFreed;
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Filter output cache
+
+/**
+	@brief Saves the current filter outputs, then restores cached outputs for a history point if we have them
+
+	Called when a history point is about to be displayed. The outputs for the point we're leaving are detached from
+	the filters and moved into its cache entry (so no copying is done), then the entry for the new point (if present
+	and still valid) is moved back into the filters.
+
+	@param next		The point being loaded
+
+	@return True if the outputs were restored and the filter graph does not need to be re-run
+ */
+bool HistoryManager::SwapFilterOutputs(shared_ptr<HistoryPoint> next)
+{
+	lock_guard<shared_mutex> lock(m_session.GetWaveformDataMutex());
+
+	//Save outputs for the point we're leaving
+	auto prev = m_activePoint.lock();
+	if(m_filterOutputsValid && prev && (prev != next))
+		StashFilterOutputs(prev);
+
+	m_activePoint = next;
+	m_filterOutputsValid = false;
+
+	auto& entry = next->m_filterCache;
+	if(entry.empty())
+	{
+		m_filterCacheMisses ++;
+		return false;
+	}
+
+	//Discard if the graph was reconfigured since the outputs were saved
+	auto filters = Filter::GetAllInstances();
+	if( (entry.m_generation != m_filterCacheGeneration) || (entry.m_filters != filters) )
+	{
+		LogTrace("Cached filter outputs for %s are stale\n", next->m_time.PrettyPrint().c_str());
+		entry.Clear();
+		EnforceFilterCacheBudget();
+		m_filterCacheMisses ++;
+		return false;
+	}
+
+	//Hand the saved waveforms back to the filters (SetData frees whatever output they had before)
+	LogTrace("Restoring cached filter outputs for %s\n", next->m_time.PrettyPrint().c_str());
+	for(auto it : entry.m_waveforms)
+		it.first.m_channel->SetData(it.second, it.first.m_stream);
+	for(auto it : entry.m_scalars)
+		it.first.m_channel->SetScalarValue(it.first.m_stream, it.second);
+
+	//Ownership moved back to the filters, so don't free them
+	entry.m_waveforms.clear();
+	entry.Clear();
+	EnforceFilterCacheBudget();
+
+	m_filterOutputsValid = true;
+	m_filterCacheHits ++;
+	return true;
+}
+
+/**
+	@brief Detaches all filter outputs and moves them into the cache entry for a history point
+
+	The caller must hold the waveform data mutex exclusively.
+ */
+void HistoryManager::StashFilterOutputs(shared_ptr<HistoryPoint> point)
+{
+	//Caching disabled?
+	auto budget = m_session.GetPreferences().GetInt("Miscellaneous.History.filter_cache_size");
+	if(budget <= 0)
+		return;
+
+	//Headless runs walk the history once and never go back, so there's nothing to gain.
+	//(And benchmarks must measure the filters, not the cache)
+	if(m_session.IsHeadless())
+		return;
+
+	auto& entry = point->m_filterCache;
+	entry.Clear();
+
+	entry.m_filters = Filter::GetAllInstances();
+	for(auto f : entry.m_filters)
+	{
+		for(size_t i=0; i<f->GetStreamCount(); i++)
+		{
+			StreamDescriptor stream(f, i);
+			if(f->GetType(i) == Stream::STREAM_TYPE_ANALOG_SCALAR)
+				entry.m_scalars[stream] = f->GetScalarValue(i);
+			else
+			{
+				auto wfm = f->Detach(i);
+				entry.m_waveforms[stream] = wfm;
+				entry.m_bytes += EstimateWaveformSize(wfm);
+			}
+		}
+	}
+
+	entry.m_generation = m_filterCacheGeneration;
+	entry.m_lastUsed = ++m_filterCacheClock;
+
+	LogTrace("Cached filter outputs for %s (%zu waveforms, %zu bytes)\n",
+		point->m_time.PrettyPrint().c_str(), entry.m_waveforms.size(), entry.m_bytes);
+
+	EnforceFilterCacheBudget();
+}
+
+/**
+	@brief Evicts least recently used cache entries until we're within the memory budget
+
+	The caller must hold the waveform data mutex exclusively.
+ */
+void HistoryManager::EnforceFilterCacheBudget()
+{
+	size_t budget = max(m_session.GetPreferences().GetInt("Miscellaneous.History.filter_cache_size"), (int64_t)0);
+
+	while(true)
+	{
+		//Total up the cache (points deleted from history don't count, they'll free their entry when destroyed)
+		size_t total = 0;
+		size_t entries = 0;
+		shared_ptr<HistoryPoint> oldest;
+		for(auto& pt : m_history)
+		{
+			auto& entry = pt->m_filterCache;
+			if(entry.empty())
+				continue;
+
+			total += entry.m_bytes;
+			entries ++;
+			if(!oldest || (entry.m_lastUsed < oldest->m_filterCache.m_lastUsed) )
+				oldest = pt;
+		}
+
+		m_filterCacheBytes = total;
+		m_filterCacheEntries = entries;
+
+		if( (total <= budget) || !oldest)
+			break;
+
+		LogTrace("Evicting cached filter outputs for %s\n", oldest->m_time.PrettyPrint().c_str());
+		oldest->m_filterCache.Clear();
+	}
+}
+
+/**
+	@brief Called right before freshly acquired waveforms are loaded into the session
+
+	The filter outputs are about to be recomputed from data that isn't in history yet, so they no longer correspond
+	to any history point. They're not saved here since that would force every filter to reallocate its output
+	buffers on every trigger, and break accumulating filters like eye patterns.
+
+	The caller must hold the waveform data mutex exclusively.
+ */
+void HistoryManager::OnNewWaveformsDownloaded()
+{
+	m_activePoint.reset();
+	m_filterOutputsValid = false;
+}
+
+/**
+	@brief Called after the filter graph has been run on the waveforms currently loaded into the session
+
+	@param complete	True if every filter output was computed over its entire input, false if some were only
+					partially computed or skipped entirely (in which case they're not worth caching)
+
+	The caller must hold the waveform data mutex exclusively.
+ */
+void HistoryManager::OnFiltersRefreshed(bool complete)
+{
+	m_filterOutputsValid = complete;
+}
+
+/**
+	@brief Discards all cached filter outputs
+
+	Must be called whenever filter parameters or graph topology change, since outputs computed with the old
+	configuration are no longer valid.
+
+	The caller must hold the waveform data mutex exclusively.
+ */
+void HistoryManager::InvalidateFilterCache()
+{
+	m_filterCacheGeneration ++;
+	m_filterOutputsValid = false;
+
+	for(auto& pt : m_history)
+		pt->m_filterCache.Clear();
+	m_filterCacheBytes = 0;
+	m_filterCacheEntries = 0;
+}
@@ -40,10 +40,49 @@
 //Waveform history for a single instrument
 typedef std::map<StreamDescriptor, WaveformBase*> WaveformHistory;
 
+/**
+	@brief Saved filter graph outputs for a single point of waveform history
+ */
+class FilterOutputCacheEntry
+{
+public:
+	FilterOutputCacheEntry()
+	: m_generation(0)
+	, m_bytes(0)
+	, m_lastUsed(0)
+	{}
+
+	~FilterOutputCacheEntry()
+	{ Clear(); }
+
+	void Clear();
+
+	bool empty()
+	{ return m_filters.empty(); }
+
+	///@brief Waveform outputs of each filter stream (owned by the cache entry)
+	std::map<StreamDescriptor, WaveformBase*> m_waveforms;
+
+	///@brief Values of each scalar filter stream
+	std::map<StreamDescriptor, float> m_scalars;
+
+	///@brief The set of filters that existed when the outputs were saved
+	std::set<Filter*> m_filters;
+
+	///@brief Cache generation the outputs were saved in (stale if it doesn't match the HistoryManager's)
+	uint64_t m_generation;
+
+	///@brief Approximate memory footprint of m_waveforms
+	size_t m_bytes;
+
+	///@brief Value of the HistoryManager's access clock when this entry was last saved (for LRU eviction)
+	uint64_t m_lastUsed;
+};
+
 /**
 	@brief A single point of waveform history
  */
-class HistoryPoint
+class HistoryPoint : public std::enable_shared_from_this<HistoryPoint>
 {
 public:
 	HistoryPoint();
@@ -63,7 +102,32 @@ public:
 	///@brief Waveform data
 	std::map<std::shared_ptr<Oscilloscope>, WaveformHistory> m_history;
 
-	void LoadHistoryToSession(Session& session);
+	///@brief Filter graph outputs computed from this point's waveforms, if cached
+	FilterOutputCacheEntry m_filterCache;
+
+	bool LoadHistoryToSession(Session& session);
+};
+
+/**
+	@brief Summary statistics for the whole history buffer
+ */
+class HistorySummary
+{
+public:
+	HistorySummary()
+	: m_points(0)
+	, m_waveforms(0)
+	, m_samples(0)
+	{}
+
+	///@brief Number of history points
+	size_t m_points;
+
+	///@brief Total number of waveforms across all points and instruments
+	size_t m_waveforms;
+
+	///@brief Total number of samples across all waveforms
+	size_t m_samples;
 };
 
 /**
@@ -98,7 +162,41 @@ public:
 	TimePoint GetMostRecentPoint();
 
 	void clear()
-	{ m_history.clear(); }
+	{
+		m_history.clear();
+		m_activePoint.reset();
+		m_filterOutputsValid = false;
+	}
+
+	void UpdateSummary();
+
+	///@brief Gets the most recently computed summary of the history buffer
+	HistorySummary GetSummary()
+	{
+		std::lock_guard<std::mutex> lock(m_summaryMutex);
+		return m_summary;
+	}
+
+	bool SwapFilterOutputs(std::shared_ptr<HistoryPoint> next);
+	void OnNewWaveformsDownloaded();
+	void OnFiltersRefreshed(bool complete = true);
+	void InvalidateFilterCache();
+
+	///@brief Gets the number of history points whose filter outputs are currently cached
+	size_t GetFilterCacheEntries()
+	{ return m_filterCacheEntries; }
+
+	///@brief Gets the approximate memory footprint of all cached filter outputs, in bytes
+	size_t GetFilterCacheSize()
+	{ return m_filterCacheBytes; }
+
+	///@brief Gets the number of history points loaded with filter outputs restored from the cache
+	uint64_t GetFilterCacheHits()
+	{ return m_filterCacheHits; }
+
+	///@brief Gets the number of history points loaded which required the filter graph to be re-run
+	uint64_t GetFilterCacheMisses()
+	{ return m_filterCacheMisses; }
 
 	std::list<std::shared_ptr<HistoryPoint>> m_history;
 
@@ -107,6 +205,45 @@ public:
 
 protected:
 	Session& m_session;
+
+	///@brief Mutex controlling access to m_summary
+	std::mutex m_summaryMutex;
+
+	///@brief Summary of the history buffer as of the last completed update
+	HistorySummary m_summary;
+
+	///@brief Pending summary computation, if any
+	std::future<void> m_summaryDone;
+
+	///@brief Timestamps of the first and last points, and point count, when the last summary was started
+	std::tuple<TimePoint, TimePoint, size_t> m_summaryKey;
+
+	void StashFilterOutputs(std::shared_ptr<HistoryPoint> point);
+	void EnforceFilterCacheBudget();
+
+	///@brief The history point whose waveforms are currently loaded into the session
+	std::weak_ptr<HistoryPoint> m_activePoint;
+
+	///@brief True if the filter outputs currently attached to the graph were computed from m_activePoint
+	bool m_filterOutputsValid;
+
+	///@brief Incremented every time the filter graph is reconfigured, making all cached outputs stale
+	uint64_t m_filterCacheGeneration;
+
+	///@brief Monotonic counter used to timestamp cache entries for LRU eviction
+	uint64_t m_filterCacheClock;
+
+	///@brief Number of history points with cached filter outputs
+	std::atomic<size_t> m_filterCacheEntries;
+
+	///@brief Approximate total size of all cached filter outputs
+	std::atomic<size_t> m_filterCacheBytes;
+
+	///@brief Number of cache hits
+	std::atomic<uint64_t> m_filterCacheHits;
+
+	///@brief Number of cache misses
+	std::atomic<uint64_t> m_filterCacheMisses;
 };
 
 #endif
@@ -0,0 +1,120 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of InstrumentPollSchedule
+ */
+#include "ngscopeclient.h"
+#include "InstrumentPollSchedule.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+InstrumentPollSchedule::InstrumentPollSchedule()
+	: m_windowStart(0)
+	, m_windowIssued(0)
+	, m_windowCoalesced(0)
+	, m_queryRate(0)
+	, m_coalescedQueryRate(0)
+{
+	//Default to polling every pass through the instrument thread
+	for(size_t i=0; i<POLL_COUNT; i++)
+	{
+		m_interval[i] = 0;
+		m_lastPoll[i] = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Scheduling
+
+/**
+	@brief Sets the minimum interval between polls of a given quantity
+
+	@param q		The quantity to configure
+	@param seconds	Interval, in seconds. Zero means poll on every pass through the instrument thread.
+ */
+void InstrumentPollSchedule::SetInterval(PollQuantity q, double seconds)
+{
+	m_interval[q] = max(0.0, seconds);
+}
+
+/**
+	@brief Checks whether a quantity is due to be polled, and if so, marks it as polled at the current time
+
+	@param q		The quantity to check
+	@param now		Current timestamp, as returned by GetTime()
+
+	@return True if the caller should query the instrument now
+ */
+bool InstrumentPollSchedule::IsDue(PollQuantity q, double now)
+{
+	if( (now - m_lastPoll[q]) < m_interval[q])
+		return false;
+
+	m_lastPoll[q] = now;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Statistics
+
+/**
+	@brief Records the number of queries made in one pass through the instrument thread
+
+	Only called from the instrument thread, so the window state doesn't need to be synchronized.
+
+	@param issued		Number of queries sent to the instrument
+	@param coalesced	Number of values obtained without a query of their own
+	@param now			Current timestamp, as returned by GetTime()
+ */
+void InstrumentPollSchedule::RecordQueries(size_t issued, size_t coalesced, double now)
+{
+	if(m_windowStart == 0)
+		m_windowStart = now;
+
+	m_windowIssued += issued;
+	m_windowCoalesced += coalesced;
+
+	//Update rates once a second
+	double dt = now - m_windowStart;
+	if(dt >= 1)
+	{
+		m_queryRate = m_windowIssued / dt;
+		m_coalescedQueryRate = m_windowCoalesced / dt;
+
+		m_windowStart = now;
+		m_windowIssued = 0;
+		m_windowCoalesced = 0;
+	}
+}
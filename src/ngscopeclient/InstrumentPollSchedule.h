@@ -0,0 +1,106 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of InstrumentPollSchedule
+ */
+#ifndef InstrumentPollSchedule_h
+#define InstrumentPollSchedule_h
+
+/**
+	@brief Per-instrument timing for periodic status queries
+
+	Each class of polled quantity has its own interval, so slowly changing state (CC/CV mode, overcurrent trip,
+	output enable) doesn't cost a round trip to the instrument on every pass through the instrument thread.
+
+	Also keeps count of how many queries were actually issued, and how many values were obtained without a query of
+	their own (delivered by the instrument's bulk AcquireData() refresh, or implied by another reply), so the round
+	trips saved by batching can be displayed.
+ */
+class InstrumentPollSchedule
+{
+public:
+	InstrumentPollSchedule();
+
+	enum PollQuantity
+	{
+		///@brief Measured values (voltage, current, meter readings)
+		POLL_MEASUREMENT,
+
+		///@brief Status bits (CC/CV mode, overcurrent trip, output enable)
+		POLL_STATUS,
+
+		POLL_COUNT
+	};
+
+	void SetInterval(PollQuantity q, double seconds);
+
+	///@brief Get the polling interval for a quantity, in seconds
+	double GetInterval(PollQuantity q)
+	{ return m_interval[q]; }
+
+	bool IsDue(PollQuantity q, double now);
+
+	void RecordQueries(size_t issued, size_t coalesced, double now);
+
+	///@brief Get the rate at which we're sending status queries to the instrument, in Hz
+	double GetQueryRate()
+	{ return m_queryRate.load(); }
+
+	///@brief Get the rate at which values are obtained without a round trip of their own, in Hz
+	double GetCoalescedQueryRate()
+	{ return m_coalescedQueryRate.load(); }
+
+protected:
+
+	///@brief Interval between polls of each quantity, in seconds
+	std::atomic<double> m_interval[POLL_COUNT];
+
+	///@brief Timestamp of the most recent poll of each quantity
+	double m_lastPoll[POLL_COUNT];
+
+	///@brief Start of the current rate measurement window
+	double m_windowStart;
+
+	///@brief Number of queries issued in the current window
+	size_t m_windowIssued;
+
+	///@brief Number of values obtained without a query of their own in the current window
+	size_t m_windowCoalesced;
+
+	///@brief Query rate as of the end of the last window
+	std::atomic<double> m_queryRate;
+
+	///@brief Coalesced query rate as of the end of the last window
+	std::atomic<double> m_coalescedQueryRate;
+};
+
+#endif
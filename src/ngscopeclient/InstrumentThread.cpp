@@ -52,6 +52,9 @@ void InstrumentThread(InstrumentThreadArgs args)
 
 	auto session = args.session;
 
+	g_perfRecorder.NameThread("InstrumentThread: " + inst->m_nickname);
+	auto perfName = g_perfRecorder.Intern(inst->m_nickname);
+
 	//Extract type-specified fields
 	auto load = dynamic_pointer_cast<Load>(inst);
 	auto scope = dynamic_pointer_cast<Oscilloscope>(inst);
@@ -66,6 +69,13 @@ void InstrumentThread(InstrumentThreadArgs args)
 	auto bertstate = args.bertstate;
 	auto psustate = args.psustate;
 	auto awgstate = args.awgstate;
+	auto schedule = args.schedule;
+
+	//Only rate limit AcquireData() on instruments that are nothing but polled meters.
+	//Anything else (BERT, RF generator, misc) may rely on AcquireData() being called every pass.
+	auto types = inst->GetInstrumentTypes();
+	const unsigned int polledTypes = Instrument::INST_PSU | Instrument::INST_DMM | Instrument::INST_LOAD;
+	bool rateLimitAcquire = (types & polledTypes) && !(types & ~polledTypes);
 
 	bool triggerUpToDate = false;
 
@@ -74,6 +84,13 @@ void InstrumentThread(InstrumentThreadArgs args)
 		//Flush any pending commands
 		inst->GetTransport()->FlushCommandQueue();
 
+		//Figure out which quantities we need to poll this time around
+		double now = GetTime();
+		bool pollMeasurements = schedule->IsDue(InstrumentPollSchedule::POLL_MEASUREMENT, now);
+		bool pollStatus = schedule->IsDue(InstrumentPollSchedule::POLL_STATUS, now);
+		size_t queriesIssued = 0;
+		size_t queriesCoalesced = 0;
+
 		//Scope processing
 		if(scope)
 		{
@@ -93,6 +110,7 @@ void InstrumentThread(InstrumentThreadArgs args)
 				if(!triggerUpToDate)
 				{	// Check for trigger state change
 					auto stat = scope->PollTrigger();
+					queriesIssued ++;
 					session->GetInstrumentConnectionState(inst)->m_lastTriggerState = stat;
 					if(stat == Oscilloscope::TRIGGER_MODE_STOP || stat == Oscilloscope::TRIGGER_MODE_RUN || stat == Oscilloscope::TRIGGER_MODE_TRIGGERED)
 					{	// Final state
@@ -105,23 +123,35 @@ void InstrumentThread(InstrumentThreadArgs args)
 			//TODO: how is this going to play with reading realtime BER from BERT+scope deviecs?
 			else
 			{
-				auto stat = scope->PollTrigger();
+				Oscilloscope::TriggerMode stat;
+				{
+					PerfEventScope perf(PERF_POLL, perfName);
+					stat = scope->PollTrigger();
+				}
+				queriesIssued ++;
 				session->GetInstrumentConnectionState(inst)->m_lastTriggerState = stat;
 				if(stat == Oscilloscope::TRIGGER_MODE_TRIGGERED)
 				{
+					g_perfRecorder.Record(PERF_TRIGGER, PerfEventRecorder::PHASE_INSTANT, perfName);
+
 					//Hold this lock because some scopes use vulkan for sample processing internally
 					//and we need to block in case a swapchain recreation comes in
 					shared_lock<shared_mutex> vlock(g_vulkanActivityMutex);
 
+					PerfEventScope perf(PERF_ACQUIRE, perfName);
 					scope->AcquireData();
 				}
 				triggerUpToDate = false;
 			}
 		}
 
-		//Always acquire data from non-scope instruments
-		else
+		//Acquire data from non-scope instruments (only when measurements are due, for pure meters)
+		else if(!rateLimitAcquire || pollMeasurements)
+		{
+			PerfEventScope perf(PERF_ACQUIRE, perfName);
 			inst->AcquireData();
+			queriesIssued ++;
+		}
 
 		//Populate scalar channel and do other instrument-specific processing
 		if(psu && psustate)
@@ -134,21 +164,50 @@ void InstrumentThread(InstrumentThreadArgs args)
 				if(!pchan)
 					continue;
 
-				psustate->m_channelVoltage[i] = pchan->GetVoltageMeasured();
-				psustate->m_channelCurrent[i] = pchan->GetCurrentMeasured();
-				psustate->m_channelConstantCurrent[i] = psu->IsPowerConstantCurrent(i);
-				psustate->m_channelFuseTripped[i] = psu->GetPowerOvercurrentShutdownTripped(i);
-				psustate->m_channelOn[i] = psu->GetPowerChannelActive(i);
+				//Measured values were fetched for all channels at once by AcquireData() and cached in the channel
+				if(pollMeasurements)
+				{
+					psustate->m_channelVoltage[i] = pchan->GetVoltageMeasured();
+					psustate->m_channelCurrent[i] = pchan->GetCurrentMeasured();
+					queriesCoalesced += 2;
+				}
+
+				if(pollStatus)
+				{
+					bool on = psu->GetPowerChannelActive(i);
+					psustate->m_channelOn[i] = on;
+					psustate->m_channelFuseTripped[i] = psu->GetPowerOvercurrentShutdownTripped(i);
+					queriesIssued += 2;
+
+					//CC/CV mode is meaningless for a disabled output, don't bother asking
+					if(on)
+					{
+						psustate->m_channelConstantCurrent[i] = psu->IsPowerConstantCurrent(i);
+						queriesIssued ++;
+					}
+					else
+					{
+						psustate->m_channelConstantCurrent[i] = false;
+						queriesCoalesced ++;
+					}
+				}
 
-				session->MarkChannelDirty(pchan);
+				if(pollMeasurements || pollStatus)
+					session->MarkChannelDirty(pchan);
 			}
 
 			if(psu->SupportsMasterOutputSwitching())
-				psustate->m_masterEnable = psu->GetMasterPowerEnable();
+			{
+				if(pollStatus)
+				{
+					psustate->m_masterEnable = psu->GetMasterPowerEnable();
+					queriesIssued ++;
+				}
+			}
 
 			psustate->m_firstUpdateDone = true;
 		}
-		if(load && loadstate)
+		if(load && loadstate && pollMeasurements)
 		{
 			for(size_t i=0; i<load->GetChannelCount(); i++)
 			{
@@ -156,18 +215,20 @@ void InstrumentThread(InstrumentThreadArgs args)
 
 				loadstate->m_channelVoltage[i] = lchan->GetScalarValue(LoadChannel::STREAM_VOLTAGE_MEASURED);
 				loadstate->m_channelCurrent[i] = lchan->GetScalarValue(LoadChannel::STREAM_CURRENT_MEASURED);
+				queriesCoalesced += 2;
 
 				session->MarkChannelDirty(lchan);
 			}
 			loadstate->m_firstUpdateDone = true;
 		}
-		if(meter && meterstate)
+		if(meter && meterstate && pollMeasurements)
 		{
 			auto chan = dynamic_cast<MultimeterChannel*>(meter->GetChannel(meter->GetCurrentMeterChannel()));
 			if(chan)
 			{
 				meterstate->m_primaryMeasurement = chan->GetPrimaryValue();
 				meterstate->m_secondaryMeasurement = chan->GetSecondaryValue();
+				queriesCoalesced += 2;
 				meterstate->m_firstUpdateDone = true;
 
 				session->MarkChannelDirty(chan);
@@ -244,6 +305,8 @@ void InstrumentThread(InstrumentThreadArgs args)
 			}
 		}
 
+		schedule->RecordQueries(queriesIssued, queriesCoalesced, now);
+
 		//TODO: does this make sense to do in the instrument thread?
 		session->RefreshDirtyFiltersNonblocking();
 
@@ -41,12 +41,33 @@ using namespace std;
 
 extern GuiLogSink* g_guiLog;
 
+//Severity levels selectable in the filter dropdown, most severe first
+static const Severity g_filterSeverities[] =
+{
+	Severity::ERROR,
+	Severity::WARNING,
+	Severity::NOTICE,
+	Severity::VERBOSE,
+	Severity::DEBUG
+};
+
+static const char* g_filterSeverityNames[] =
+{
+	"Error",
+	"Warning",
+	"Notice",
+	"Verbose",
+	"Debug"
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 LogViewerDialog::LogViewerDialog(MainWindow* parent)
 	: Dialog("Log Viewer", "Log Viewer", ImVec2(500, 300))
 	, m_parent(parent)
+	, m_severityIndex(IM_ARRAYSIZE(g_filterSeverities) - 1)
+	, m_nextUnindexed(0)
 {
 }
 
@@ -54,6 +75,50 @@ LogViewerDialog::~LogViewerDialog()
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Filtering
+
+/**
+	@brief Checks if a line should be displayed with the current filter settings
+ */
+bool LogViewerDialog::PassesFilter(const LogLine& line)
+{
+	if(line.m_sev > g_filterSeverities[m_severityIndex])
+		return false;
+	return m_textFilter.PassFilter(line.m_msg.c_str());
+}
+
+/**
+	@brief Brings the list of lines passing the filter up to date with the log
+
+	Only lines logged since the last call are checked, unless the filter has changed. Must be called with the log
+	mutex held.
+
+	@param rebuild	True to discard the existing index and check every line again
+ */
+void LogViewerDialog::UpdateIndex(bool rebuild)
+{
+	auto first = g_guiLog->GetFirstLine();
+	auto end = g_guiLog->GetEndLine();
+
+	if(rebuild)
+	{
+		m_index.clear();
+		m_nextUnindexed = first;
+	}
+
+	//Forget about lines which have been discarded from the log since we last looked
+	while(!m_index.empty() && (m_index.front() < first) )
+		m_index.pop_front();
+	m_nextUnindexed = max(m_nextUnindexed, first);
+
+	for(; m_nextUnindexed < end; m_nextUnindexed++)
+	{
+		if(PassesFilter(g_guiLog->GetLine(m_nextUnindexed)))
+			m_index.push_back(m_nextUnindexed);
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Rendering
 
@@ -63,12 +128,33 @@ bool LogViewerDialog::DoRender()
 	auto warningColor = m_parent->GetColorPref("Appearance.Log Viewer.warning_color");
 	auto baseColor = m_parent->GetColorPref("Appearance.Graphs.bottom_color");
 
+	float width = ImGui::GetFontSize();
+
+	//Filter settings
+	bool filterChanged = false;
+	ImGui::SetNextItemWidth(7 * width);
+	if(ImGui::Combo("Severity", &m_severityIndex, g_filterSeverityNames, IM_ARRAYSIZE(g_filterSeverityNames)))
+		filterChanged = true;
+	HelpMarker("Least severe level of message to display");
+
+	ImGui::SameLine();
+	if(m_textFilter.Draw("Filter", 15 * width))
+		filterChanged = true;
+	HelpMarker(
+		"Only display messages containing this text.\n\n"
+		"Separate multiple terms with commas, prefix a term with - to exclude messages containing it.");
+
+	ImGui::SameLine();
+	if(ImGui::Button("Clear"))
+		g_guiLog->Clear();
+
 	ImGui::BeginChild("scrollview", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
 
 	ImGui::PushFont(m_parent->GetFontPref("Appearance.General.console_font"));
-	auto& lines = g_guiLog->GetLines();
 
-	float width = ImGui::GetFontSize();
+	lock_guard<mutex> lock(g_guiLog->GetMutex());
+	UpdateIndex(filterChanged);
+
 	static ImGuiTableFlags flags =
 		ImGuiTableFlags_Resizable |
 		ImGuiTableFlags_BordersOuter |
@@ -78,75 +164,82 @@ bool LogViewerDialog::DoRender()
 		ImGuiTableFlags_SizingFixedFit;
 	if(ImGui::BeginTable("table", 3, flags))
 	{
-		//TODO: use ImGuiListClipper
-
 		ImGui::TableSetupScrollFreeze(0, 1); //Header row does not scroll
 		ImGui::TableSetupColumn("Timestamp", ImGuiTableColumnFlags_WidthFixed, 10*width);
 		ImGui::TableSetupColumn("Severity", ImGuiTableColumnFlags_WidthFixed, 0.0f);
 		ImGui::TableSetupColumn("Message", ImGuiTableColumnFlags_WidthStretch, 0.0f);
 		ImGui::TableHeadersRow();
 
-		for(auto& line : lines)
+		//Only submit the rows which are actually visible
+		ImGuiListClipper clipper;
+		clipper.Begin(m_index.size());
+		while(clipper.Step())
 		{
-			ImGui::TableNextRow(ImGuiTableRowFlags_None);
-
-			switch(line.m_sev)
+			for(int i=clipper.DisplayStart; i<clipper.DisplayEnd; i++)
 			{
-				case Severity::ERROR:
-					ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, errColor);
-					break;
+				auto& line = g_guiLog->GetLine(m_index[i]);
 
-				case Severity::WARNING:
-					ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, warningColor);
-					break;
+				ImGui::TableNextRow(ImGuiTableRowFlags_None);
 
-				default:
-					ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, baseColor);
-					break;
-			}
+				switch(line.m_sev)
+				{
+					case Severity::ERROR:
+						ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, errColor);
+						break;
 
-			ImGui::TableSetColumnIndex(0);
-			ImGui::TextUnformatted(line.m_timestamp.PrettyPrint().c_str());
+					case Severity::WARNING:
+						ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, warningColor);
+						break;
 
-			ImGui::TableSetColumnIndex(1);
-			switch(line.m_sev)
-			{
-				//no need for fatal, we abort before we can see it
+					default:
+						ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, baseColor);
+						break;
+				}
 
-				case Severity::ERROR:
-					ImGui::TextUnformatted("Error");
-					break;
+				ImGui::TableSetColumnIndex(0);
+				ImGui::TextUnformatted(line.m_timestampText.c_str());
 
-				case Severity::WARNING:
-					ImGui::TextUnformatted("Warning");
-					break;
+				ImGui::TableSetColumnIndex(1);
+				switch(line.m_sev)
+				{
+					//no need for fatal, we abort before we can see it
 
-				case Severity::NOTICE:
-					ImGui::TextUnformatted("Notice");
-					break;
+					case Severity::ERROR:
+						ImGui::TextUnformatted("Error");
+						break;
 
-				case Severity::VERBOSE:
-					ImGui::TextUnformatted("Verbose");
-					break;
+					case Severity::WARNING:
+						ImGui::TextUnformatted("Warning");
+						break;
 
-				case Severity::DEBUG:
-				default:
-					ImGui::TextUnformatted("Debug");
-					break;
-			}
+					case Severity::NOTICE:
+						ImGui::TextUnformatted("Notice");
+						break;
 
-			ImGui::TableSetColumnIndex(2);
-			ImGui::TextUnformatted(line.m_msg.c_str());
+					case Severity::VERBOSE:
+						ImGui::TextUnformatted("Verbose");
+						break;
+
+					case Severity::DEBUG:
+					default:
+						ImGui::TextUnformatted("Debug");
+						break;
+				}
+
+				ImGui::TableSetColumnIndex(2);
+				ImGui::TextUnformatted(line.m_msg.c_str());
+			}
 		}
 
+		//Follow new messages if scrolled to the bottom
+		if(ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+			ImGui::SetScrollHereY(1.0f);
+
 		ImGui::EndTable();
 	}
 
 	ImGui::PopFont();
 
-	if(ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
-		ImGui::SetScrollHereY(1.0f);
-
 	ImGui::EndChild();
 
 	return true;
@@ -37,6 +37,8 @@
 
 #include "Dialog.h"
 
+#include <deque>
+
 class MainWindow;
 
 class LogViewerDialog : public Dialog
@@ -48,7 +50,22 @@ public:
 	virtual bool DoRender();
 
 protected:
+	void UpdateIndex(bool rebuild);
+	bool PassesFilter(const LogLine& line);
+
 	MainWindow* m_parent;
+
+	///@brief Filter for message text
+	ImGuiTextFilter m_textFilter;
+
+	///@brief Index of the least severe level to display, in the severity dropdown
+	int m_severityIndex;
+
+	///@brief Sequence numbers of the log lines passing the filter, oldest first
+	std::deque<uint64_t> m_index;
+
+	///@brief Sequence number of the next log line not yet checked against the filter
+	uint64_t m_nextUnindexed;
 };
 
 #endif
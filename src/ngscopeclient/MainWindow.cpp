@@ -53,6 +53,7 @@
 #include "ChannelPropertiesDialog.h"
 #include "CreateFilterBrowser.h"
 #include "FileBrowser.h"
+#include "FilterGraphTimelineDialog.h"
 #include "FilterGraphWorkspace.h"
 #include "FilterPropertiesDialog.h"
 #include "FunctionGeneratorDialog.h"
@@ -140,6 +141,7 @@ MainWindow::MainWindow(shared_ptr<QueueHandle> queue)
 	vk::CommandBufferAllocateInfo bufinfo(**m_cmdPool, vk::CommandBufferLevel::ePrimary, 1);
 	m_cmdBuffer = make_unique<vk::raii::CommandBuffer>(
 		std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+	m_toneMapQueries = make_unique<GpuTimestampQueries>(*m_cmdBuffer, queue->m_family);
 
 	if(g_hasDebugUtils)
 	{
@@ -189,6 +191,7 @@ MainWindow::~MainWindow()
 	g_vkComputeDevice->waitIdle();
 	m_texmgr.clear();
 
+	m_toneMapQueries = nullptr;
 	m_cmdBuffer = nullptr;
 	m_cmdPool = nullptr;
 
@@ -231,6 +234,10 @@ void MainWindow::CloseSession()
 	LogTrace("Closing session\n");
 	LogIndenter li;
 
+	//Let any save or load in progress finish before we tear down what it's working on
+	if(m_fileTask.valid())
+		m_fileTask.wait();
+
 	SaveRecentInstrumentList();
 
 	//Close background threads in our session before destroying views
@@ -245,7 +252,10 @@ void MainWindow::CloseSession()
 	m_splitRequests.clear();
 	m_groupsToClose.clear();
 	for(auto it : m_pendingChannelDisplayRequests)
+	{
+		m_session.RemoveConsumer(it.first);
 		it.first->Release();
+	}
 	m_pendingChannelDisplayRequests.clear();
 
 	//Clear any open dialogs before destroying the session.
@@ -253,6 +263,7 @@ void MainWindow::CloseSession()
 	LogTrace("Clearing dialogs\n");
 	m_logViewerDialog = nullptr;
 	m_metricsDialog = nullptr;
+	m_filterTimelineDialog = nullptr;
 	m_timebaseDialog = nullptr;
 	m_triggerDialog = nullptr;
 	m_filterPalette = nullptr;
@@ -549,11 +560,13 @@ void MainWindow::DoRender(vk::raii::CommandBuffer& /*cmdBuf*/)
  */
 void MainWindow::ToneMapAllWaveforms(vk::raii::CommandBuffer& cmdbuf)
 {
+	PerfEventScope perf(PERF_TONE_MAP);
 	double start = GetTime();
 
 	lock_guard<mutex> lock(m_session.GetRasterizedWaveformMutex());
 
 	m_cmdBuffer->begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+	m_toneMapQueries->Reset();
 
 	//Tone map the waveforms, holding the group mutex for as short a time as possible
 	vector<shared_ptr<WaveformGroup>> groups;
@@ -566,6 +579,7 @@ void MainWindow::ToneMapAllWaveforms(vk::raii::CommandBuffer& cmdbuf)
 
 	m_cmdBuffer->end();
 	m_renderQueue->SubmitAndBlock(*m_cmdBuffer);
+	m_toneMapQueries->Collect();
 
 	double dt = GetTime() - start;
 	m_toneMapTime = dt * FS_PER_SECOND;
@@ -605,6 +619,10 @@ void MainWindow::RenderUI()
 
 	m_needRender = false;
 
+	//While the session is being saved or loaded in the background, keep the rendering pipeline going but don't run
+	//any of the UI (the user can't interact with it under the progress popup anyway)
+	bool fileTaskRunning = PollFileTask();
+
 	//Keep references to all of our waveform textures until next frame
 	//Any groups we're closing will be destroyed at the start of that frame, once rendering has finished
 	{
@@ -622,12 +640,18 @@ void MainWindow::RenderUI()
 		m_groupsToClose.clear();
 	}
 
+	//Preferences are applied as soon as they're edited, so push polling interval changes out while the dialog is open
+	if(m_preferenceDialog)
+		m_session.UpdatePollIntervals();
+
 	//Request a refresh of any dirty filters next frame
-	m_session.RefreshDirtyFiltersNonblocking();
+	if(!fileTaskRunning)
+		m_session.RefreshDirtyFiltersNonblocking();
 
 	//See if we have new waveform data to look at.
+	//A file task may be walking the history, so leave any new waveform for after it's done.
 	//If we got one, highlight the new waveform in history
-	if(m_session.CheckForWaveforms(*m_cmdBuffer))
+	if(m_session.CheckForWaveforms(*m_cmdBuffer, !fileTaskRunning))
 	{
 		if(m_historyDialog != nullptr)
 			m_historyDialog->UpdateSelectionToLatest();
@@ -638,6 +662,9 @@ void MainWindow::RenderUI()
 			it.second->OnWaveformLoaded(t);
 	}
 
+	if(fileTaskRunning)
+		return;
+
 	//Menu for main window
 	MainMenu();
 	Toolbar();
@@ -662,6 +689,30 @@ void MainWindow::RenderUI()
 		}
 		for(ssize_t i = static_cast<ssize_t>(m_groupsToClose.size())-1; i >= 0; i--)
 			m_waveformGroups.erase(m_waveformGroups.begin() + m_groupsToClose[i]);
+
+		//Let the session know what's on screen, for region-of-interest filter evaluation
+		map<FlowGraphNode*, VisibleRange> ranges;
+		for(auto& group : m_waveformGroups)
+		{
+			if(!(group->GetXAxisUnit() == Unit::UNIT_FS))
+				continue;
+
+			int64_t start = group->GetXAxisOffset();
+			int64_t end = start + group->GetXAxisSpan();
+			for(auto& area : group->GetWaveformAreas())
+			{
+				for(size_t i=0; i<area->GetStreamCount(); i++)
+				{
+					auto node = area->GetStream(i).m_channel;
+					auto it = ranges.find(node);
+					if(it == ranges.end())
+						ranges.emplace(node, VisibleRange(start, end));
+					else
+						it->second.Extend(start, end);
+				}
+			}
+		}
+		m_session.UpdateVisibleRanges(ranges);
 	}
 
 	//Now that we are not holding the render mutex anymore, it's safe to have the session refresh newly created filters
@@ -677,6 +728,7 @@ void MainWindow::RenderUI()
 			for(size_t i=0; i<f->GetStreamCount(); i++)
 				FindAreaForStream(it.second, StreamDescriptor(f, i));
 
+			m_session.RemoveConsumer(f);
 			f->Release();
 		}
 
@@ -698,7 +750,7 @@ void MainWindow::RenderUI()
 	if( (m_historyDialog != nullptr) && (m_historyDialog->PollForSelectionChanges()))
 	{
 		LogTrace("history selection changed\n");
-		m_historyDialog->LoadHistoryFromSelection(m_session);
+		bool restored = m_historyDialog->LoadHistoryFromSelection(m_session);
 
 		auto t = m_historyDialog->GetSelectedPoint();
 		if(t != TimePoint(0,0))
@@ -707,7 +759,9 @@ void MainWindow::RenderUI()
 				it.second->OnWaveformLoaded(t);
 		}
 
-		m_session.RefreshAllFiltersNonblocking();
+		//Only re-run the filter graph if we didn't have its outputs for this point cached
+		if(!restored)
+			m_session.RefreshAllFiltersNonblocking();
 		m_needRender = true;
 	}
 
@@ -726,16 +780,25 @@ void MainWindow::RenderUI()
 				m_historyDialog->SelectTimestamp(tstamp);
 
 			auto hpt = hist.GetHistory(tstamp);
+			bool restored = false;
 			if(hpt)
 			{
-				hpt->LoadHistoryToSession(m_session);
+				restored = hpt->LoadHistoryToSession(m_session);
 				m_needRender = true;
 			}
-			m_session.RefreshAllFiltersNonblocking();
+			if(!restored)
+				m_session.RefreshAllFiltersNonblocking();
 		}
 	}
 
-	//Handle error messages
+	//Handle error messages, including any reported by background threads since last frame
+	if(m_errorPopupTitle.empty())
+	{
+		string title;
+		string msg;
+		if(m_session.PopQueuedErrorPopup(title, msg))
+			ShowErrorPopup(title, msg);
+	}
 	RenderErrorPopup();
 	RenderLoadWarningPopup();
 
@@ -901,7 +964,7 @@ void MainWindow::TriggerStartDropdown(float buttonsize)
 		DoTriggerDropdown("Start", group, all);
 
 		if(group)
-			group->Arm(TriggerGroup::TRIGGER_TYPE_NORMAL);
+			m_session.ArmTriggerGroup(group, TriggerGroup::TRIGGER_TYPE_NORMAL);
 		if(all)
 			m_session.ArmTrigger(TriggerGroup::TRIGGER_TYPE_NORMAL, true);
 
@@ -921,7 +984,7 @@ void MainWindow::TriggerSingleDropdown(float buttonsize)
 
 		//Start trigger for only a specific group
 		if(group)
-			group->Arm(TriggerGroup::TRIGGER_TYPE_SINGLE);
+			m_session.ArmTriggerGroup(group, TriggerGroup::TRIGGER_TYPE_SINGLE);
 
 		//Start trigger for all groups
 		if(all)
@@ -943,7 +1006,7 @@ void MainWindow::TriggerForceDropdown(float buttonsize)
 
 		//Start trigger for only a specific group
 		if(group)
-			group->Arm(TriggerGroup::TRIGGER_TYPE_FORCED);
+			m_session.ArmTriggerGroup(group, TriggerGroup::TRIGGER_TYPE_FORCED);
 
 		//Start trigger for all groups
 		if(all)
@@ -1121,6 +1184,8 @@ void MainWindow::OnDialogClosed(const std::shared_ptr<Dialog>& dlg)
 		m_streamBrowser = nullptr;
 	if(m_metricsDialog == dlg)
 		m_metricsDialog = nullptr;
+	if(m_filterTimelineDialog == dlg)
+		m_filterTimelineDialog = nullptr;
 	if(m_timebaseDialog == dlg)
 		m_timebaseDialog = nullptr;
 	if(m_triggerDialog == dlg)
@@ -1826,12 +1891,8 @@ void MainWindow::RenderLoadWarningPopup()
 		{
 			//Continue with the load
 			//always loading online if we are warning, offline loads can't warn)
-			if(LoadSessionFromYaml(m_fileBeingLoaded[0], m_sessionDataDir, true))
-			{
-				m_recentFiles[m_sessionFileName] = time(nullptr);
-				SaveRecentFileList();
-			}
-			else
+			//The recent file list is updated once the waveform data finishes loading
+			if(!LoadSessionFromYaml(m_fileBeingLoaded[0], m_sessionDataDir, true))
 				CloseSession();
 
 			m_showingLoadWarnings = false;
@@ -1909,6 +1970,12 @@ Filter* MainWindow::CreateFilter(
 	//Make the filter
 	auto f = Filter::CreateFilter(name, GetDefaultChannelColor(Filter::GetNumInstances()));
 
+	//Outputs cached for other history points don't include the new filter
+	{
+		lock_guard lock(m_session.GetWaveformDataMutex());
+		m_session.GetHistory().InvalidateFilterCache();
+	}
+
 	//Attempt to hook up first input
 	if(f->ValidateChannel(0, initialStream))
 		f->SetInput(0, initialStream);
@@ -1922,7 +1989,9 @@ Filter* MainWindow::CreateFilter(
 		m_session.MarkChannelDirty(f);
 		m_pendingChannelDisplayRequests.emplace(pair<OscilloscopeChannel*, WaveformArea*>(f, area));
 
+		//Hold a reference, and count as a consumer so the initial refresh isn't skipped
 		f->AddRef();
+		m_session.AddConsumer(f);
 	}
 
 	//Not adding waveforms to plots, but still check for scalar values and add to measurements view
@@ -2138,9 +2207,11 @@ void MainWindow::FindAreaForStream(WaveformArea* area, StreamDescriptor stream)
 void MainWindow::OnFilterReconfigured(Filter* f)
 {
 	//Remove any saved configuration, eye patterns, etc
+	//and any outputs cached for other history points, since they were computed with the old configuration
 	{
 		lock_guard lock(m_session.GetWaveformDataMutex());
 		f->ClearSweeps();
+		m_session.GetHistory().InvalidateFilterCache();
 	}
 
 	//Re-run the filter
@@ -2265,16 +2336,11 @@ void MainWindow::DoOpenFile(const string& sessionPath, bool online)
 			//Preload completed with no warnings, or loading offline? Commit now
 			if(!online || (m_session.GetWarnings().empty() && m_session.m_setupNotes.empty()) )
 			{
-				if(LoadSessionFromYaml(m_fileBeingLoaded[0], m_sessionDataDir, online))
-				{
-					m_recentFiles[sessionPath] = time(nullptr);
-					SaveRecentFileList();
-				}
-
 				//Loading failed, clean up any half-loaded stuff
 				//Do not print any error message; LoadSessionFromYaml() is responsible for calling ShowErrorPopup()
 				//if something goes wrong there.
-				else
+				//On success, the recent file list is updated once the waveform data finishes loading.
+				if(!LoadSessionFromYaml(m_fileBeingLoaded[0], m_sessionDataDir, online))
 					CloseSession();
 			}
 
@@ -2345,6 +2411,9 @@ bool MainWindow::PreLoadSessionFromYaml(const YAML::Node& node, const string& da
 
 	You must call PreLoadSessionFromYaml before calling this function.
 
+	Waveform data is loaded afterwards on the task scheduler. Once that completes the session is added to the recent
+	file list, or closed if loading failed.
+
 	@param node		Root YAML node of the file
 	@param dataDir	Path to the _data directory associated with the session
 	@param online	True if we should reconnect to instruments
@@ -2391,7 +2460,29 @@ bool MainWindow::LoadSessionFromYaml(const YAML::Node& node, const string& dataD
 	string ipath = dataDir + "/imgui.ini";
 	ImGui::LoadIniSettingsFromDisk(ipath.c_str());
 
-	LogTrace("Load completed successfully\n");
+	//Sample data can be large, so read it in the background
+	StartFileTask(
+		"Loading waveform data...",
+		[this, dataDir]
+		{
+			if(m_session.LoadWaveformData(dataDir))
+				return true;
+
+			m_fileTaskErrorTitle = "File loading error";
+			m_fileTaskErrorMessage = string("Could not load waveform data from \"") + dataDir + "\"!";
+			return false;
+		},
+		[this]
+		{
+			LogTrace("Load completed successfully\n");
+			m_recentFiles[m_sessionFileName] = time(nullptr);
+			SaveRecentFileList();
+		},
+		[this]
+		{
+			//Clean up any half-loaded stuff
+			CloseSession();
+		});
 	return true;
 }
 
@@ -2777,10 +2868,17 @@ bool MainWindow::LoadDialogs(const YAML::Node& node)
 	auto metrics = node["metrics"];
 	if(metrics && metrics.as<bool>())
 	{
-		m_metricsDialog = make_shared<MetricsDialog>(&m_session);
+		m_metricsDialog = make_shared<MetricsDialog>(&m_session, this);
 		AddDialog(m_metricsDialog);
 	}
 
+	auto timeline = node["filtertimeline"];
+	if(timeline && timeline.as<bool>())
+	{
+		m_filterTimelineDialog = make_shared<FilterGraphTimelineDialog>(m_session, this);
+		AddDialog(m_filterTimelineDialog);
+	}
+
 	auto sb = node["streambrowser"];
 	if(sb && sb.as<bool>())
 	{
@@ -2851,14 +2949,20 @@ bool MainWindow::LoadDialogs(const YAML::Node& node)
 
 /**
 	@brief Actually save a file (may be triggered by file|save or file|save as)
+
+	The configuration is serialized right away. Sample data and the session file itself are written in the background.
  */
 void MainWindow::DoSaveFile(string sessionPath)
 {
+	//Only one save or load at a time
+	if(m_fileTask.valid())
+		return;
+
 	//Stop the trigger so we don't have data races if a waveform comes in mid-save
 	m_session.StopTrigger();
 
-	//Saving the file conflicts with all other waveform data operations
-	lock_guard<shared_mutex> lock(m_session.GetWaveformDataMutex());
+	//Persisted filter waveforms must cover the entire input, not just what's on screen
+	m_session.FinishRegionOfInterest();
 
 	//If the filename does not end in .scopesession, add it
 	if(sessionPath.find(".scopesession") == string::npos)
@@ -2869,39 +2973,155 @@ void MainWindow::DoSaveFile(string sessionPath)
 	string datadir = base + "_data";
 	LogDebug("Saving session file \"%s\" (data directory %s)\n", sessionPath.c_str(), datadir.c_str());
 
-	//Serialize the session
+	//Serialize the session configuration here, since it includes UI state
 	YAML::Node node{};
-	if(!SaveSessionToYaml(node, datadir))
-		return;
+	{
+		lock_guard<shared_mutex> lock(m_session.GetWaveformDataMutex());
+		if(!SaveSessionToYaml(node, datadir))
+			return;
+	}
 
-	//Write the generated YAML to disk
-	ofstream outfs(sessionPath);
-	if(!outfs)
+	//Save the lab notes
+	SaveLabNotes(datadir);
+
+	//Writing the sample data can take a while, so do that and write the session file in the background
+	StartFileTask(
+		"Saving session...",
+		[this, node, sessionPath, datadir]
+		{
+			//Saving only reads waveform data, but nothing may change it until we're done
+			{
+				shared_lock<shared_mutex> lock(m_session.GetWaveformDataMutex());
+				if(!m_session.SerializeWaveforms(datadir))
+				{
+					m_fileTaskErrorTitle = "Write failed";
+					m_fileTaskErrorMessage = string("Failed to write waveform data to \"") + datadir + "\"";
+					return false;
+				}
+			}
+
+			//Write the generated YAML to disk
+			ofstream outfs(sessionPath);
+			if(!outfs)
+			{
+				m_fileTaskErrorTitle = "Cannot open file";
+				m_fileTaskErrorMessage = string("Failed to open output session file \"") + sessionPath + "\" for writing";
+				return false;
+			}
+
+			outfs << node;
+			outfs.close();
+
+			if(!outfs)
+			{
+				m_fileTaskErrorTitle = "Write failed";
+				m_fileTaskErrorMessage = string("Failed to write session file \"") + sessionPath + "\"";
+				return false;
+			}
+
+			return true;
+		},
+		[this, sessionPath, datadir]
+		{
+			//Add to recent files list
+			m_sessionFileName = sessionPath;
+			m_sessionDataDir = datadir;
+			m_recentFiles[sessionPath] = time(nullptr);
+			SaveRecentFileList();
+		});
+}
+
+/**
+	@brief Starts a session save or load on the task scheduler
+
+	Until it completes, RenderUI() shows a progress popup instead of anything that might touch the session.
+
+	@param status	Text to show while the task runs
+	@param task		The work to do. On failure, sets m_fileTaskErrorTitle and m_fileTaskErrorMessage and returns false
+	@param done		Called on the GUI thread once the task succeeds
+	@param failed	Called on the GUI thread if the task fails, after the error is shown
+ */
+void MainWindow::StartFileTask(
+	const string& status,
+	function<bool()> task,
+	function<void()> done,
+	function<void()> failed)
+{
+	m_fileTaskStatus = status;
+	m_fileTaskErrorTitle = "";
+	m_fileTaskErrorMessage = "";
+	m_fileTaskDone = done;
+	m_fileTaskFailed = failed;
+
+	m_fileTask = m_session.GetTaskScheduler().Submit(TaskScheduler::PRIORITY_BACKGROUND, [task]
+		{
+			bool ok = task();
+
+			//Wake up the event loop so we notice right away
+			glfwPostEmptyEvent();
+			return ok;
+		});
+}
+
+/**
+	@brief Checks on a background save or load, showing progress while it runs and reporting the result once done
+
+	@return True if the task is still running
+ */
+bool MainWindow::PollFileTask()
+{
+	if(!m_fileTask.valid())
+		return false;
+
+	const char* title = "Please wait";
+	if(m_fileTask.wait_for(chrono::seconds(0)) != future_status::ready)
 	{
-		ShowErrorPopup(
-			"Cannot open file",
-			string("Failed to open output session file \"") + sessionPath + "\" for writing");
-		return;
+		ImGui::OpenPopup(title);
+		if(ImGui::BeginPopupModal(title, nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove))
+		{
+			ImGui::TextUnformatted(m_fileTaskStatus.c_str());
+			ImGui::EndPopup();
+		}
+		return true;
 	}
 
-	outfs << node;
-	outfs.close();
+	if(ImGui::BeginPopupModal(title, nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove))
+	{
+		ImGui::CloseCurrentPopup();
+		ImGui::EndPopup();
+	}
 
-	if(!outfs)
+	bool ok = false;
+	try
 	{
-		ShowErrorPopup(
-			"Write failed",
-			string("Failed to write session file \"") + sessionPath + "\"");
+		ok = m_fileTask.get();
+	}
+	catch(const exception& ex)
+	{
+		m_fileTaskErrorTitle = "File error";
+		m_fileTaskErrorMessage = string("Debug information:\n") + ex.what();
 	}
 
-	//Save the lab notes
-	SaveLabNotes(datadir);
+	//Callbacks may start another task, so take them first
+	auto done = std::move(m_fileTaskDone);
+	auto failed = std::move(m_fileTaskFailed);
+	m_fileTaskDone = nullptr;
+	m_fileTaskFailed = nullptr;
+
+	if(ok)
+	{
+		if(done)
+			done();
+	}
+	else
+	{
+		if(!m_fileTaskErrorTitle.empty())
+			ShowErrorPopup(m_fileTaskErrorTitle, m_fileTaskErrorMessage);
+		if(failed)
+			failed();
+	}
 
-	//Add to recent files list
-	m_sessionFileName = sessionPath;
-	m_sessionDataDir = datadir;
-	m_recentFiles[sessionPath] = time(nullptr);
-	SaveRecentFileList();
+	return false;
 }
 
 /**
@@ -2998,7 +3218,7 @@ void MainWindow::LoadLabNotes(const string& dataDir)
 
 
 /**
-	@brief Serialize the current session to a YAML::Node
+	@brief Serialize the current session configuration to a YAML::Node (waveform data is saved separately)
 
 	@param node		Node for the main .scopesession
 	@param dataDir	Path to the _data directory (may not have been created yet)
@@ -3027,9 +3247,7 @@ bool MainWindow::SaveSessionToYaml(YAML::Node& node, const string& dataDir)
 	//Save UI widgets
 	node["ui_config"] = SerializeUIConfiguration();
 
-	//TODO: waveform data
-	if(!m_session.SerializeWaveforms(dataDir))
-		return false;
+	//Waveform data is written separately by DoSaveFile(), in the background
 
 	//Save ImGui configuration
 	string ipath = dataDir + "/imgui.ini";
@@ -3348,6 +3566,10 @@ YAML::Node MainWindow::SerializeDialogs()
 	if(m_metricsDialog)
 		node["metrics"] = true;
 
+	//Filter graph timeline has no separate settings
+	if(m_filterTimelineDialog)
+		node["filtertimeline"] = true;
+
 	//Preferences dialog has no separate settings
 	if(m_preferenceDialog)
 		node["preferences"] = true;
@@ -338,6 +338,9 @@ protected:
 	///@brief Performance metrics
 	std::shared_ptr<Dialog> m_metricsDialog;
 
+	///@brief Filter graph execution timeline
+	std::shared_ptr<Dialog> m_filterTimelineDialog;
+
 	///@brief Preferences
 	std::shared_ptr<Dialog> m_preferenceDialog;
 
@@ -457,6 +460,31 @@ protected:
 	///@brief True if we're actively loading a file
 	bool m_fileLoadInProgress;
 
+	///@brief Session save or waveform data load running on the task scheduler, if any
+	std::future<bool> m_fileTask;
+
+	///@brief Text shown while m_fileTask is running
+	std::string m_fileTaskStatus;
+
+	///@brief Title of the error popup to show if m_fileTask fails
+	std::string m_fileTaskErrorTitle;
+
+	///@brief Message for the error popup to show if m_fileTask fails
+	std::string m_fileTaskErrorMessage;
+
+	///@brief Called on the GUI thread once m_fileTask succeeds
+	std::function<void()> m_fileTaskDone;
+
+	///@brief Called on the GUI thread if m_fileTask fails
+	std::function<void()> m_fileTaskFailed;
+
+	void StartFileTask(
+		const std::string& status,
+		std::function<bool()> task,
+		std::function<void()> done,
+		std::function<void()> failed = nullptr);
+	bool PollFileTask();
+
 	///@brief Current session file path
 	std::string m_sessionFileName;
 
@@ -536,6 +564,9 @@ protected:
 	///@brief Command buffer used during rendering operations
 	std::unique_ptr<vk::raii::CommandBuffer> m_cmdBuffer;
 
+	///@brief GPU timestamps for tone mapping in m_cmdBuffer
+	std::unique_ptr<GpuTimestampQueries> m_toneMapQueries;
+
 	bool DropdownButton(const char* id, float height);
 
 public:
@@ -46,6 +46,7 @@
 #include "BERTDialog.h"
 #include "CreateFilterBrowser.h"
 #include "FilterGraphEditor.h"
+#include "FilterGraphTimelineDialog.h"
 #include "FunctionGeneratorDialog.h"
 #include "HistoryDialog.h"
 #include "LoadDialog.h"
@@ -592,13 +593,26 @@ void MainWindow::WindowMenu()
 
 		if(ImGui::MenuItem("Performance Metrics"))
 		{
-			m_metricsDialog = make_shared<MetricsDialog>(&m_session);
+			m_metricsDialog = make_shared<MetricsDialog>(&m_session, this);
 			AddDialog(m_metricsDialog);
 		}
 
 		if(hasMetrics)
 			ImGui::EndDisabled();
 
+		bool hasTimeline = m_filterTimelineDialog != nullptr;
+		if(hasTimeline)
+			ImGui::BeginDisabled();
+
+		if(ImGui::MenuItem("Filter Graph Timeline"))
+		{
+			m_filterTimelineDialog = make_shared<FilterGraphTimelineDialog>(m_session, this);
+			AddDialog(m_filterTimelineDialog);
+		}
+
+		if(hasTimeline)
+			ImGui::EndDisabled();
+
 		bool hasHistory = m_historyDialog != nullptr;
 		if(hasHistory)
 			ImGui::BeginDisabled();
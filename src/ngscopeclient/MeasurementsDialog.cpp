@@ -52,6 +52,7 @@ MeasurementsDialog::~MeasurementsDialog()
 {
 	for(auto s : m_streams)
 	{
+		m_session.RemoveConsumer(s.m_channel);
 		auto ochan = dynamic_cast<OscilloscopeChannel*>(s.m_channel);
 		if(ochan)
 			ochan->Release();
@@ -192,6 +193,7 @@ bool MeasurementsDialog::DoRender()
 
 void MeasurementsDialog::RemoveStream(size_t i)
 {
+	m_session.RemoveConsumer(m_streams[i].m_channel);
 	auto ochan = dynamic_cast<OscilloscopeChannel*>(m_streams[i].m_channel);
 	m_streamset.erase(ochan);
 	if(ochan)
@@ -210,6 +212,7 @@ void MeasurementsDialog::AddStream(StreamDescriptor stream)
 
 	m_streams.push_back(stream);
 	m_streamset.emplace(stream);
+	m_session.AddConsumer(stream.m_channel);
 
 	auto ochan = dynamic_cast<OscilloscopeChannel*>(stream.m_channel);
 	if(ochan)
@@ -42,9 +42,11 @@ using namespace std;
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
-MetricsDialog::MetricsDialog(Session* session)
+MetricsDialog::MetricsDialog(Session* session, MainWindow* parent)
 	: Dialog("Performance Metrics", "Metrics", ImVec2(300, 400))
 	, m_session(session)
+	, m_parent(parent)
+	, m_dumpTime(0)
 {
 	m_displayRefreshRate = 0;
 
@@ -75,11 +77,28 @@ bool MetricsDialog::DoRender()
 	Unit counts(Unit::UNIT_COUNTS);
 	Unit fs(Unit::UNIT_FS);
 	Unit hz(Unit::UNIT_HZ);
+	Unit pct(Unit::UNIT_PERCENT);
 
 	string str;
 
 	float width = ImGui::GetFontSize() * 7;
 
+	if(ImGui::Button("Dump last 30 s..."))
+	{
+		m_dumpTime = GetTime();
+		m_fileDialog = MakeFileBrowser(
+			m_parent,
+			".",
+			"Save Event Trace",
+			"Chrome trace files (*.json)",
+			"*.json",
+			true);
+	}
+	Tooltip(
+		"Save a timeline of instrument polling, waveform download, filter graph, and rendering activity\n"
+		"across all threads over the last 30 seconds, in Chrome trace event format.\n\n"
+		"View it in chrome://tracing or Perfetto, or attach it to a bug report about a stall.");
+
 	if(ImGui::CollapsingHeader("Rendering"))
 	{
 		ImGui::BeginDisabled();
@@ -114,6 +133,37 @@ bool MetricsDialog::DoRender()
 			"necessarily execute every frame. It runs asynchronously and is not locked to the display framerate."
 			);
 
+		ImGui::BeginDisabled();
+			str = fs.PrettyPrint(m_session->GetLastGpuRasterizeTime());
+			ImGui::SetNextItemWidth(width);
+			ImGui::InputText("GPU rasterize time", &str);
+		ImGui::EndDisabled();
+
+		HelpMarker(
+			"Rasterize time of the most recent update that used the compute shader.\n\n"
+			"Select the rasterizer under Miscellaneous > Rendering in the preferences, and compare against the "
+			"CPU rasterize time to see which is faster on this machine.");
+
+		ImGui::BeginDisabled();
+			str = fs.PrettyPrint(m_session->GetLastCpuRasterizeTime());
+			ImGui::SetNextItemWidth(width);
+			ImGui::InputText("CPU rasterize time", &str);
+		ImGui::EndDisabled();
+
+		HelpMarker(
+			"Rasterize time of the most recent update that used the CPU rasterizer (total across all waveforms).");
+
+		ImGui::BeginDisabled();
+			str = pct.PrettyPrint(m_session->GetLastRasterizeSkipRate());
+			ImGui::SetNextItemWidth(width);
+			ImGui::InputText("Rasterize skip rate", &str);
+		ImGui::EndDisabled();
+
+		HelpMarker(
+			"Fraction of waveforms in the most recent update that were not rasterized again because their data,
+"
+			"position, scale, size, and intensity settings had not changed since they were last drawn.");
+
 		ImGui::BeginDisabled();
 			str = fs.PrettyPrint(m_session->GetToneMapTime());
 			ImGui::SetNextItemWidth(width);
@@ -148,6 +198,13 @@ bool MetricsDialog::DoRender()
 			"Waveform samples are drawn by a compute shader and not included in this total");
 	}
 
+	//Sample CPU side timing every frame, even if not displayed, so history is available when we open the header
+	m_frameIntervals.AddSample(ImGui::GetIO().DeltaTime * FS_PER_SECOND);
+	m_filterTimes.AddSample(m_session->GetFilterGraphExecTime());
+
+	if(ImGui::CollapsingHeader("GPU timing"))
+		RenderGpuTiming();
+
 	if(ImGui::CollapsingHeader("Filter graph"))
 	{
 		ImGui::BeginDisabled();
@@ -165,6 +222,52 @@ bool MetricsDialog::DoRender()
 		ImGui::EndDisabled();
 
 		HelpMarker("Update time for the last evaluation of the filter graph");
+
+		ImGui::BeginDisabled();
+			str = counts.PrettyPrint(m_session->GetSkippedFilterCount());
+			ImGui::SetNextItemWidth(width);
+			ImGui::InputText("Skipped filters", &str);
+		ImGui::EndDisabled();
+
+		HelpMarker(
+			"Number of filters skipped during the last evaluation of the filter graph because their outputs\n"
+			"are not displayed or used by any other filter");
+
+		if(ImGui::TreeNode("History cache"))
+		{
+			auto& hist = m_session->GetHistory();
+			Unit bytes(Unit::UNIT_BYTES);
+
+			ImGui::BeginDisabled();
+				str = counts.PrettyPrint(hist.GetFilterCacheEntries());
+				ImGui::SetNextItemWidth(width);
+				ImGui::InputText("Cached points", &str);
+			ImGui::EndDisabled();
+
+			HelpMarker("Number of history points with filter graph outputs currently cached");
+
+			ImGui::BeginDisabled();
+				str = bytes.PrettyPrint(hist.GetFilterCacheSize());
+				ImGui::SetNextItemWidth(width);
+				ImGui::InputText("Cache size", &str);
+			ImGui::EndDisabled();
+
+			HelpMarker(
+				"Approximate memory used by cached filter outputs.\n\n"
+				"The limit can be changed under Miscellaneous > History in the preferences.");
+
+			auto hits = hist.GetFilterCacheHits();
+			auto total = hits + hist.GetFilterCacheMisses();
+			ImGui::BeginDisabled();
+				str = pct.PrettyPrint(total ? (hits * 1.0 / total) : 0);
+				ImGui::SetNextItemWidth(width);
+				ImGui::InputText("Hit rate", &str);
+			ImGui::EndDisabled();
+
+			HelpMarker("Fraction of history points loaded without needing to re-run the filter graph");
+
+			ImGui::TreePop();
+		}
 	}
 
 	if(ImGui::CollapsingHeader("Acquisition"))
@@ -201,11 +304,109 @@ bool MetricsDialog::DoRender()
 					"up with the instrument."
 					);
 
+				if(m_session->IsSecondaryOfMultiScopeGroup(s))
+				{
+					auto group = m_session->GetTriggerGroupForScope(s);
+
+					ImGui::BeginDisabled();
+						str = fs.PrettyPrint(group->GetArmLatency(s) * FS_PER_SECOND);
+						ImGui::SetNextItemWidth(width);
+						ImGui::InputText("Arm latency", &str);
+					ImGui::EndDisabled();
+
+					HelpMarker(
+						"Time this secondary instrument took to report its trigger as armed, the last time\n"
+						"the trigger group was armed.\n\n"
+						"Secondaries are armed in parallel, so the slowest one limits the multi-scope trigger rate."
+						);
+				}
+
+				ImGui::TreePop();
+			}
+		}
+	}
+
+	if(ImGui::CollapsingHeader("Instruments"))
+	{
+		auto insts = m_session->GetSCPIInstruments();
+		for(auto inst : insts)
+		{
+			auto state = m_session->GetInstrumentConnectionState(inst);
+			if(!state || !state->m_pollSchedule)
+				continue;
+
+			if(ImGui::TreeNode(inst->m_nickname.c_str()))
+			{
+				ImGui::BeginDisabled();
+					str = hz.PrettyPrint(state->m_pollSchedule->GetQueryRate());
+					ImGui::SetNextItemWidth(width);
+					ImGui::InputText("Status queries", &str);
+				ImGui::EndDisabled();
+
+				HelpMarker(
+					"Rate at which status queries are being sent to the instrument.\n\n"
+					"For oscilloscopes this counts trigger status polls.\n"
+					"For power supplies this counts data acquisition passes plus individual status queries.\n"
+					"For other instrument types it counts data acquisition passes.\n\n"
+					"Polling intervals can be adjusted under Drivers / Polling in the preferences dialog.");
+
+				ImGui::BeginDisabled();
+					str = hz.PrettyPrint(state->m_pollSchedule->GetCoalescedQueryRate());
+					ImGui::SetNextItemWidth(width);
+					ImGui::InputText("Round trips saved", &str);
+				ImGui::EndDisabled();
+
+				HelpMarker(
+					"Rate at which values are obtained without a query of their own.\n\n"
+					"Measured voltages, currents and meter readings for all channels are fetched in a single\n"
+					"data acquisition pass, and CC/CV mode is not queried for disabled outputs.");
+
 				ImGui::TreePop();
 			}
 		}
 	}
 
+	if(ImGui::CollapsingHeader("Task scheduler"))
+	{
+		auto& sched = m_session->GetTaskScheduler();
+
+		static const char* queueNames[TaskScheduler::PRIORITY_COUNT] =
+		{
+			"Interactive queue",
+			"Acquisition queue",
+			"Background queue"
+		};
+		for(int i=0; i<TaskScheduler::PRIORITY_COUNT; i++)
+		{
+			ImGui::BeginDisabled();
+				str = counts.PrettyPrint(sched.GetQueueDepth(static_cast<TaskScheduler::Priority>(i)));
+				ImGui::SetNextItemWidth(width);
+				ImGui::InputText(queueNames[i], &str);
+			ImGui::EndDisabled();
+		}
+
+		HelpMarker(
+			"Number of tasks waiting to run at each priority.\n\n"
+			"Interactive tasks (packet filtering, deskew correlation) always run before acquisition tasks,\n"
+			"which run before background tasks (saving, loading, history summary).");
+
+		if(ImGui::TreeNode("Workers"))
+		{
+			for(size_t i=0; i<sched.GetWorkerCount(); i++)
+			{
+				ImGui::BeginDisabled();
+					str = pct.PrettyPrint(sched.GetWorkerUtilization(i));
+					ImGui::SetNextItemWidth(width);
+					ImGui::InputText((string("Worker ") + to_string(i)).c_str(), &str);
+				ImGui::EndDisabled();
+			}
+
+			HelpMarker("Fraction of the last second each worker thread spent running tasks");
+
+			ImGui::TreePop();
+		}
+	}
+
 	//Only show this tab if available
 	if(g_hasMemoryBudget)
 	{
@@ -218,7 +419,6 @@ bool MetricsDialog::DoRender()
 			auto membudget = std::get<1>(properties);
 
 			Unit bytes(Unit::UNIT_BYTES);
-			Unit pct(Unit::UNIT_PERCENT);
 
 			auto pinnedUsage = membudget.heapUsage[g_vkPinnedMemoryHeap];
 			auto pinnedBudget = membudget.heapBudget[g_vkPinnedMemoryHeap];
@@ -292,8 +492,115 @@ bool MetricsDialog::DoRender()
 		}
 	}
 
+	//Run the export dialog
+	if(m_fileDialog)
+	{
+		m_fileDialog->Render();
+
+		if(m_fileDialog->IsClosedOK())
+		{
+			auto fname = m_fileDialog->GetFileName();
+			if(!g_perfRecorder.ExportChromeTrace(fname, m_dumpTime - 30, m_dumpTime))
+				ShowErrorPopup("Export failed", string("Could not write to ") + fname);
+		}
+
+		if(m_fileDialog->IsClosed())
+			m_fileDialog = nullptr;
+	}
+
+	RenderErrorPopup();
 	return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // UI event handlers
+
+/**
+	@brief Renders the per-stage GPU execution time plots
+ */
+void MetricsDialog::RenderGpuTiming()
+{
+	PlotStageHistory("Frame interval", m_frameIntervals);
+	HelpMarker(
+		"Wall clock time between GUI frames.\n\n"
+		"If this is much longer than the GPU stages below, the frame is CPU bound (or waiting on vsync).");
+
+	PlotStageHistory("Filter graph", m_filterTimes);
+	HelpMarker(
+		"Wall clock time of the last filter graph evaluation, including any compute shaders it ran.\n\n"
+		"Filters record into their own command buffers, so they are not broken down by GPU timestamps.");
+
+	if(!g_gpuProfiler.IsSupported())
+	{
+		ImGui::TextUnformatted("Timestamp queries are not supported by this GPU");
+		return;
+	}
+
+	ImGui::Separator();
+	RenderStageTree(g_gpuProfiler.GetStages(), "");
+
+	if(ImGui::Button("Clear history"))
+		g_gpuProfiler.Clear();
+	HelpMarker(
+		"GPU execution time of each rendering stage, measured with timestamp queries.\n\n"
+		"Rasterize runs on the waveform thread whenever a waveform changes; the other stages run on the GUI thread.\n"
+		"Expand a stage to see the breakdown by waveform area and channel.");
+}
+
+/**
+	@brief Renders the stages directly below a given path, and (if expanded) their children
+
+	@param stages	All stages, sorted by path
+	@param prefix	Path of the parent stage followed by a slash, or an empty string for top level stages
+ */
+void MetricsDialog::RenderStageTree(const map<string, GpuStageHistory>& stages, const string& prefix)
+{
+	for(auto it = stages.lower_bound(prefix); it != stages.end(); it++)
+	{
+		auto& path = it->first;
+		if(path.compare(0, prefix.size(), prefix) != 0)
+			break;
+		if( (path.size() == prefix.size()) || (path.find('/', prefix.size()) != string::npos) )
+			continue;
+
+		//Leaf stages just get a plot, anything with children gets a tree node too
+		auto name = path.substr(prefix.size());
+		auto childPrefix = path + "/";
+		auto next = stages.lower_bound(childPrefix);
+		bool hasChildren = (next != stages.end()) && (next->first.compare(0, childPrefix.size(), childPrefix) == 0);
+		if(!hasChildren)
+		{
+			PlotStageHistory(name, it->second);
+			continue;
+		}
+
+		bool open = ImGui::TreeNode(path.c_str(), "%s", name.c_str());
+		ImGui::SameLine();
+		ImGui::TextDisabled("%s", Unit(Unit::UNIT_FS).PrettyPrint(it->second.m_last).c_str());
+		if(open)
+		{
+			PlotStageHistory(name, it->second);
+			RenderStageTree(stages, childPrefix);
+			ImGui::TreePop();
+		}
+	}
+}
+
+/**
+	@brief Plots the rolling history of one stage, with the most recent time overlaid
+ */
+void MetricsDialog::PlotStageHistory(const string& label, const GpuStageHistory& hist)
+{
+	Unit fs(Unit::UNIT_FS);
+	string overlay = fs.PrettyPrint(hist.m_last);
+	int offset = (hist.m_count < GpuStageHistory::HISTORY_DEPTH) ? 0 : hist.m_next;
+	ImGui::PlotLines(
+		label.c_str(),
+		hist.m_times,
+		hist.m_count,
+		offset,
+		overlay.c_str(),
+		0,
+		FLT_MAX,
+		ImVec2(ImGui::GetFontSize() * 14, ImGui::GetFontSize() * 3));
+}
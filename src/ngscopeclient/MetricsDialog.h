@@ -36,19 +36,39 @@
 #define MetricsDialog_h
 
 #include "Dialog.h"
+#include "FileBrowser.h"
+
+class MainWindow;
 
 class MetricsDialog : public Dialog
 {
 public:
-	MetricsDialog(Session* session);
+	MetricsDialog(Session* session, MainWindow* parent);
 	virtual ~MetricsDialog();
 
 	virtual bool DoRender();
 
 protected:
+	void RenderGpuTiming();
+	void RenderStageTree(const std::map<std::string, GpuStageHistory>& stages, const std::string& prefix);
+	void PlotStageHistory(const std::string& label, const GpuStageHistory& hist);
+
 	Session* m_session;
+	MainWindow* m_parent;
 
 	int m_displayRefreshRate;
+
+	///@brief Browser for choosing where to save an event recorder dump
+	std::shared_ptr<FileBrowser> m_fileDialog;
+
+	///@brief Time the dump was requested, so the file covers the 30 seconds before the click and not the save
+	double m_dumpTime;
+
+	///@brief History of the interval between GUI frames
+	GpuStageHistory m_frameIntervals;
+
+	///@brief History of filter graph execution time, sampled once per frame
+	GpuStageHistory m_filterTimes;
 };
 
 #endif
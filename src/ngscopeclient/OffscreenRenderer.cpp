@@ -0,0 +1,443 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of OffscreenRenderer
+ */
+#include "ngscopeclient.h"
+#include "OffscreenRenderer.h"
+#include "WaveformRasterizer.h"
+
+#include <png.h>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a renderer
+
+	@param session		Session to draw waveforms from
+	@param width		Width of each image, in pixels
+	@param areaHeight	Height of each waveform area, in pixels
+ */
+OffscreenRenderer::OffscreenRenderer(Session& session, size_t width, size_t areaHeight)
+	: m_session(session)
+	, m_width(width)
+	, m_areaHeight(areaHeight)
+	, m_traceAlpha(0.75)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Rendering
+
+/**
+	@brief Draws every waveform group in the session to a PNG file
+
+	@param uiConfig		The session's UI configuration (ui_config node of the .scopesession file)
+	@param outdir		Directory to write images to
+	@param prefix		Prefix for image file names, followed by the group name
+
+	@return True on success, false if any image could not be written
+ */
+bool OffscreenRenderer::RenderGroups(const YAML::Node& uiConfig, const string& outdir, const string& prefix)
+{
+	auto areas = uiConfig["areas"];
+
+	bool ok = true;
+	for(auto it : uiConfig["groups"])
+	{
+		auto gn = it.second;
+		auto gname = gn["name"].as<string>();
+
+		//Same units conversion as WaveformGroup::LoadConfiguration()
+		double pixelsPerX = gn["pixelsPerXUnit"].as<float>();
+		int64_t xAxisOffset = gn["xAxisOffset"].as<long long>();
+		if(!gn["timebaseResolution"] || (gn["timebaseResolution"].as<string>() != "fs"))
+		{
+			pixelsPerX /= 1000;
+			xAxisOffset *= 1000;
+		}
+
+		vector< vector<StreamDescriptor> > groupAreas;
+		for(auto at : gn["areas"])
+		{
+			auto streams = GetAreaStreams(areas, at.second["id"].as<int>());
+			if(!streams.empty())
+				groupAreas.push_back(streams);
+		}
+		if(groupAreas.empty())
+		{
+			LogDebug("Group \"%s\" has no areas, skipping\n", gname.c_str());
+			continue;
+		}
+
+		//Draw each area into its own band of the image (RGB, top row first)
+		size_t height = m_areaHeight * groupAreas.size();
+		vector<float> image(m_width * height * 3);
+		for(size_t i=0; i<groupAreas.size(); i++)
+			RenderArea(groupAreas[i], xAxisOffset, pixelsPerX, &image[i * m_areaHeight * m_width * 3]);
+
+		//Make a filesystem-safe name for the group
+		string name = gname;
+		for(auto& c : name)
+		{
+			if(!isalnum(c) && (c != '-') && (c != '_') )
+				c = '_';
+		}
+		string fname = outdir + "/" + prefix + "_" + name + ".png";
+
+		if(!WritePNG(fname, image, height))
+			ok = false;
+		else
+			LogNotice("Wrote group \"%s\" to %s\n", gname.c_str(), fname.c_str());
+	}
+
+	return ok;
+}
+
+/**
+	@brief Gets the streams displayed in a waveform area
+
+	@param areas	The areas node of the UI configuration
+	@param id		ID of the area
+ */
+vector<StreamDescriptor> OffscreenRenderer::GetAreaStreams(const YAML::Node& areas, int id)
+{
+	vector<StreamDescriptor> ret;
+
+	auto an = areas[string("area") + to_string(id)];
+	if(!an)
+	{
+		LogWarning("Waveform area %d not found\n", id);
+		return ret;
+	}
+
+	//ngscopeclient has a single list of streams
+	auto streams = an["streams"];
+	if(streams)
+	{
+		for(auto jt : streams)
+		{
+			auto chan = static_cast<OscilloscopeChannel*>(m_session.m_idtable[jt.second["channel"].as<int>()]);
+			if(chan)
+				ret.push_back(StreamDescriptor(chan, jt.second["stream"].as<int>()));
+		}
+	}
+
+	//glscopeclient has one channel plus overlays
+	else
+	{
+		auto chan = static_cast<OscilloscopeChannel*>(m_session.m_idtable[an["channel"].as<int>()]);
+		if(chan)
+			ret.push_back(StreamDescriptor(chan, an["stream"] ? an["stream"].as<int>() : 0));
+
+		for(auto jt : an["overlays"])
+		{
+			auto filter = static_cast<Filter*>(m_session.m_idtable[jt.second["id"].as<int>()]);
+			if(filter)
+				ret.push_back(StreamDescriptor(filter, jt.second["stream"] ? jt.second["stream"].as<int>() : 0));
+		}
+	}
+
+	return ret;
+}
+
+/**
+	@brief Draws a single waveform area
+
+	Analog streams fill the whole area, scaled by the first analog stream's range like in WaveformArea. Digital
+	streams are drawn in strips from the top down, as many as fit.
+
+	@param streams		Streams in the area
+	@param xAxisOffset	X axis position of the left edge of the plot
+	@param pixelsPerX	Horizontal zoom, in pixels per X axis unit
+	@param image		Top left corner of the area in the output image
+ */
+void OffscreenRenderer::RenderArea(
+	const vector<StreamDescriptor>& streams,
+	int64_t xAxisOffset,
+	double pixelsPerX,
+	float* image)
+{
+	//Draw the background
+	auto& prefs = m_session.GetPreferences();
+	auto top = ImGui::ColorConvertU32ToFloat4(prefs.GetColor("Appearance.Graphs.top_color"));
+	auto bottom = ImGui::ColorConvertU32ToFloat4(prefs.GetColor("Appearance.Graphs.bottom_color"));
+	for(size_t y=0; y<m_areaHeight; y++)
+	{
+		float frac = y * 1.0f / max(m_areaHeight - 1, (size_t)1);
+		float rgb[3] =
+		{
+			top.x + (bottom.x - top.x)*frac,
+			top.y + (bottom.y - top.y)*frac,
+			top.z + (bottom.z - top.z)*frac
+		};
+
+		float* row = image + y*m_width*3;
+		for(size_t x=0; x<m_width; x++)
+		{
+			for(size_t j=0; j<3; j++)
+				row[x*3 + j] = rgb[j];
+		}
+	}
+
+	float pixelsPerYAxisUnit = 1;
+	for(auto& s : streams)
+	{
+		if(s.GetType() == Stream::STREAM_TYPE_ANALOG)
+		{
+			pixelsPerYAxisUnit = m_areaHeight / s.GetVoltageRange();
+			break;
+		}
+	}
+
+	size_t ndigital = 0;
+	for(auto& s : streams)
+	{
+		switch(s.GetType())
+		{
+			case Stream::STREAM_TYPE_ANALOG:
+				RenderStream(s, xAxisOffset, pixelsPerX, m_areaHeight, pixelsPerYAxisUnit, image);
+				break;
+
+			case Stream::STREAM_TYPE_DIGITAL:
+				if( (ndigital+1) * DIGITAL_HEIGHT > m_areaHeight)
+				{
+					LogDebug("No room to draw %s\n", s.GetName().c_str());
+					break;
+				}
+				RenderStream(
+					s,
+					xAxisOffset,
+					pixelsPerX,
+					DIGITAL_HEIGHT,
+					0,
+					image + ndigital*DIGITAL_HEIGHT*m_width*3);
+				ndigital ++;
+				break;
+
+			default:
+				LogDebug("Not drawing %s (unsupported stream type)\n", s.GetName().c_str());
+				break;
+		}
+	}
+}
+
+/**
+	@brief Rasterizes and tone maps a single analog or digital stream, then blends it into the image
+
+	@param stream				The stream to draw
+	@param xAxisOffset			X axis position of the left edge of the plot
+	@param pixelsPerX			Horizontal zoom, in pixels per X axis unit
+	@param height				Height of the waveform, in pixels
+	@param pixelsPerYAxisUnit	Vertical scale (analog only)
+	@param image				Top left corner of the waveform in the output image
+ */
+void OffscreenRenderer::RenderStream(
+	StreamDescriptor stream,
+	int64_t xAxisOffset,
+	double pixelsPerX,
+	size_t height,
+	float pixelsPerYAxisUnit,
+	float* image)
+{
+	auto data = stream.GetData();
+	if( (data == nullptr) || (data->size() < 2) )
+		return;
+
+	auto udata = dynamic_cast<UniformWaveformBase*>(data);
+	auto sdata = dynamic_cast<SparseWaveformBase*>(data);
+	auto uadata = dynamic_cast<UniformAnalogWaveform*>(data);
+	auto sadata = dynamic_cast<SparseAnalogWaveform*>(data);
+	auto uddata = dynamic_cast<UniformDigitalWaveform*>(data);
+	auto sddata = dynamic_cast<SparseDigitalWaveform*>(data);
+	bool digital = (uddata || sddata);
+	if(!digital && !uadata && !sadata)
+		return;
+
+	auto config = WaveformRasterizer::GetConfig(
+		data,
+		xAxisOffset,
+		pixelsPerX,
+		m_width,
+		height,
+		digital,
+		pixelsPerYAxisUnit,
+		stream.GetOffset());
+
+	//Same variant selection as WaveformArea
+	bool zeroHold = stream.GetFlags() & Stream::STREAM_DO_NOT_INTERPOLATE;
+	WaveformRasterizer::Inputs inputs;
+	auto variant = WaveformRasterizer::VARIANT_DIGITAL;
+	if(digital)
+	{
+		auto& samples = uddata ? uddata->m_samples : sddata->m_samples;
+		samples.PrepareForCpuAccess();
+		inputs.m_digital = reinterpret_cast<const uint8_t*>(samples.GetCpuPointer());
+	}
+	else
+	{
+		if(uadata && (stream.GetFlags() & Stream::STREAM_FILL_UNDER))
+			variant = WaveformRasterizer::VARIANT_HISTOGRAM;
+		else if(zeroHold)
+			variant = WaveformRasterizer::VARIANT_ANALOG_ZEROHOLD;
+		else
+			variant = WaveformRasterizer::VARIANT_ANALOG;
+
+		auto& samples = uadata ? uadata->m_samples : sadata->m_samples;
+		samples.PrepareForCpuAccess();
+		inputs.m_analog = samples.GetCpuPointer();
+	}
+
+	vector<uint32_t> indexes;
+	if(sdata)
+	{
+		int64_t offset_samples = (xAxisOffset - data->m_triggerPhase) / data->m_timescale;
+		vector<int64_t> targets(m_width);
+		for(size_t i=0; i<m_width; i++)
+			targets[i] = floor(i / config.xscale) + offset_samples;
+
+		indexes.resize(m_width);
+		sdata->m_offsets.PrepareForCpuAccess();
+		WaveformRasterizer::ComputeIndexes(
+			sdata->m_offsets.GetCpuPointer(),
+			data->size(),
+			targets.data(),
+			indexes.data(),
+			m_width);
+
+		inputs.m_offsets = sdata->m_offsets.GetCpuPointer();
+		inputs.m_indexes = indexes.data();
+		if(zeroHold)
+		{
+			sdata->m_durations.PrepareForCpuAccess();
+			inputs.m_durations = sdata->m_durations.GetCpuPointer();
+		}
+	}
+
+	vector<float> raster(m_width * height);
+	WaveformRasterizer::Rasterize(config, variant, (sdata == nullptr), inputs, raster.data());
+
+	//Intensity grading by zoom, as in WaveformArea
+	auto end = data->size() - 1;
+	float capture_len = GetOffsetScaled(sdata, udata, end) - GetOffsetScaled(sdata, udata, 0);
+	float samplesPerPixel = 1.0 / (pixelsPerX * capture_len / data->size());
+	float alpha = WaveformRasterizer::GetToneMapAlpha(m_traceAlpha, samplesPerPixel);
+
+	auto c = ImGui::ColorConvertU32ToFloat4(ColorFromString(stream.m_channel->m_displaycolor));
+	float color[3] = {c.x, c.y, c.z};
+	vector<float> rgba(m_width * height * 4);
+	WaveformRasterizer::ToneMap(raster.data(), m_width, height, color, alpha, rgba.data());
+
+	//Blend into the image. Rasterized waveforms have the bottom row first.
+	for(size_t y=0; y<height; y++)
+	{
+		const float* src = &rgba[(height - 1 - y) * m_width * 4];
+		float* dst = image + y*m_width*3;
+		for(size_t x=0; x<m_width; x++)
+		{
+			float a = src[x*4 + 3];
+			for(size_t j=0; j<3; j++)
+				dst[x*3 + j] = src[x*4 + j]*a + dst[x*3 + j]*(1 - a);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Output
+
+/**
+	@brief Writes an image to a PNG file
+
+	@param path		Path to the file
+	@param image	RGB image, m_width pixels wide, top row first
+	@param height	Height of the image
+
+	@return True on success, false on failure
+ */
+bool OffscreenRenderer::WritePNG(const string& path, const vector<float>& image, size_t height)
+{
+	auto png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	if(!png)
+	{
+		LogError("Failed to create PNG write struct\n");
+		return false;
+	}
+	auto info = png_create_info_struct(png);
+	if(!info)
+	{
+		png_destroy_write_struct(&png, nullptr);
+		LogError("Failed to create PNG info struct\n");
+		return false;
+	}
+
+	FILE* fp = fopen(path.c_str(), "wb");
+	if(!fp)
+	{
+		png_destroy_write_struct(&png, &info);
+		LogError("Failed to open \"%s\" for writing\n", path.c_str());
+		return false;
+	}
+	png_init_io(png, fp);
+
+	png_set_IHDR(
+		png,
+		info,
+		m_width,
+		height,
+		8,
+		PNG_COLOR_TYPE_RGB,
+		PNG_INTERLACE_NONE,
+		PNG_COMPRESSION_TYPE_DEFAULT,
+		PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(png, info);
+
+	vector<uint8_t> row(m_width * 3);
+	for(size_t y=0; y<height; y++)
+	{
+		const float* src = &image[y * m_width * 3];
+		for(size_t i=0; i<row.size(); i++)
+			row[i] = static_cast<uint8_t>(round(min(max(src[i], 0.0f), 1.0f) * 255));
+		png_write_row(png, row.data());
+	}
+	png_write_end(png, nullptr);
+
+	png_destroy_write_struct(&png, &info);
+	if(0 != fclose(fp))
+	{
+		LogError("Failed to write \"%s\"\n", path.c_str());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,92 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of OffscreenRenderer
+ */
+#ifndef OffscreenRenderer_h
+#define OffscreenRenderer_h
+
+#include "Session.h"
+
+/**
+	@brief Draws a session's waveform groups to PNG files, with no window or swapchain
+
+	Groups and areas are read from the session's saved UI configuration, and each group is written to one image with
+	its areas stacked top to bottom. Waveforms are rasterized and tone mapped with WaveformRasterizer, using the same
+	configuration WaveformArea would push to its shaders, so images match what the GUI shows at the same plot size.
+
+	Analog and digital streams are drawn; protocol, eye, constellation, waterfall, and spectrogram streams, the grid,
+	and axis labels are not.
+ */
+class OffscreenRenderer
+{
+public:
+	OffscreenRenderer(Session& session, size_t width, size_t areaHeight);
+
+	bool RenderGroups(const YAML::Node& uiConfig, const std::string& outdir, const std::string& prefix);
+
+	///@brief Height of each digital channel, in pixels
+	static const size_t DIGITAL_HEIGHT = 20;
+
+protected:
+	std::vector<StreamDescriptor> GetAreaStreams(const YAML::Node& areas, int id);
+
+	void RenderArea(
+		const std::vector<StreamDescriptor>& streams,
+		int64_t xAxisOffset,
+		double pixelsPerX,
+		float* image);
+
+	void RenderStream(
+		StreamDescriptor stream,
+		int64_t xAxisOffset,
+		double pixelsPerX,
+		size_t height,
+		float pixelsPerYAxisUnit,
+		float* image);
+
+	bool WritePNG(const std::string& path, const std::vector<float>& image, size_t height);
+
+	///@brief The session being drawn
+	Session& m_session;
+
+	///@brief Width of each image, in pixels
+	size_t m_width;
+
+	///@brief Height of each waveform area, in pixels
+	size_t m_areaHeight;
+
+	///@brief Trace intensity (same as the GUI's default)
+	float m_traceAlpha;
+};
+
+#endif
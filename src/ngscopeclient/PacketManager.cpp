@@ -74,6 +74,10 @@ void PacketManager::RefreshRows()
 	//Clear all existing row state
 	m_rows.clear();
 
+	//Rows are only used for display. If we're running headless there's no ImGui context to lay them out with
+	if(m_session.IsHeadless())
+		return;
+
 	//Make a list of waveform timestamps and make sure we display them in order
 	vector<TimePoint> times;
 	for(auto& it : m_filteredPackets)
@@ -268,37 +272,54 @@ void PacketManager::FilterPackets()
 	m_filteredPackets.clear();
 	m_filteredChildPackets.clear();
 
-	//Check all top level packets against the filter
-	for(auto it : m_packets)
-	{
-		auto timestamp = it.first;
-		auto& packets = it.second;
-		for(auto p : packets)
+	//Each waveform's packets can be checked independently, so spread them across the task scheduler
+	vector<const pair<const TimePoint, vector<Packet*> >*> waveforms;
+	for(auto& it : m_packets)
+		waveforms.push_back(&it);
+
+	//Per-waveform results, merged back into the filtered maps afterwards
+	vector< vector<Packet*> > matchedPackets(waveforms.size());
+	vector< vector< pair<Packet*, vector<Packet*> > > > matchedChildren(waveforms.size());
+
+	auto expr = m_filterExpression;
+	m_session.GetTaskScheduler().ParallelFor(TaskScheduler::PRIORITY_INTERACTIVE, 0, waveforms.size(),
+		[&](int64_t i)
 		{
-			//If no children, just check the top level packet for a match
-			if(m_childPackets[p].empty())
+			for(auto p : waveforms[i]->second)
 			{
-				if(m_filterExpression->Match(p))
-					m_filteredPackets[timestamp].push_back(p);
-			}
+				//If no children, just check the top level packet for a match
+				auto it = m_childPackets.find(p);
+				if( (it == m_childPackets.end()) || it->second.empty())
+				{
+					if(expr->Match(p))
+						matchedPackets[i].push_back(p);
+				}
 
-			//We have children.
-			//Check them for matches, and add the parent if any child matches
-			else
-			{
-				bool anyChildMatched = false;
-				for(auto c : m_childPackets[p])
+				//We have children.
+				//Check them for matches, and add the parent if any child matches
+				else
 				{
-					if(m_filterExpression->Match(c))
+					vector<Packet*> children;
+					for(auto c : it->second)
+					{
+						if(expr->Match(c))
+							children.push_back(c);
+					}
+					if(!children.empty())
 					{
-						m_filteredChildPackets[p].push_back(c);
-						anyChildMatched = true;
+						matchedPackets[i].push_back(p);
+						matchedChildren[i].push_back(pair<Packet*, vector<Packet*> >(p, std::move(children)));
 					}
 				}
-				if(anyChildMatched)
-					m_filteredPackets[timestamp].push_back(p);
 			}
-		}
+		});
+
+	for(size_t i=0; i<waveforms.size(); i++)
+	{
+		if(!matchedPackets[i].empty())
+			m_filteredPackets[waveforms[i]->first] = std::move(matchedPackets[i]);
+		for(auto& c : matchedChildren[i])
+			m_filteredChildPackets[c.first] = std::move(c.second);
 	}
 
 	//Refresh the set of rows being displayed
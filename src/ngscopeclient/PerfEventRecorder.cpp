@@ -0,0 +1,324 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PerfEventRecorder
+ */
+#include "ngscopeclient.h"
+#include "PerfEventRecorder.h"
+#include "FilterGraphTimeline.h"
+
+#include <fstream>
+
+using namespace std;
+
+PerfEventRecorder g_perfRecorder;
+
+///@brief Track of the calling thread, or NO_TRACK if it hasn't recorded anything yet
+static const uint16_t NO_TRACK = 0xffff;
+static thread_local uint16_t g_perfTrack = NO_TRACK;
+
+///@brief Display name and Chrome trace category of each event type
+static const char* g_perfEventNames[PERF_EVENT_TYPE_COUNT][2] =
+{
+	{ "Poll trigger",		"instrument" },
+	{ "Triggered",			"instrument" },
+	{ "Acquire",			"instrument" },
+	{ "Download waveforms",	"session" },
+	{ "Filter graph",		"filter" },
+	{ "Filter",				"filter" },
+	{ "Rasterize",			"render" },
+	{ "Tone map",			"render" },
+	{ "Present",			"render" }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+PerfEventRecorder::PerfEventRecorder(size_t capacity)
+	: m_slots(new Slot[max<size_t>(capacity, 1)])
+	, m_capacity(max<size_t>(capacity, 1))
+	, m_next(0)
+	, m_epoch(GetTime())
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Recording
+
+/**
+	@brief Records an event on the calling thread's track, timestamped now
+
+	@param type		Type of event
+	@param phase	Whether the event begins or ends a span, or is instantaneous
+	@param detail	ID from Intern() of a string describing the event (e.g. instrument name), or NO_DETAIL
+ */
+void PerfEventRecorder::Record(PerfEventType type, Phase phase, uint32_t detail)
+{
+	RecordAt(type, phase, GetTime(), GetCurrentTrack(), detail);
+}
+
+/**
+	@brief Records an event with an explicit timestamp and track
+
+	Used for events reconstructed after the fact, like individual filters within a filter graph run.
+
+	@param type		Type of event
+	@param phase	Whether the event begins or ends a span, or is instantaneous
+	@param time		Time of the event, from GetTime()
+	@param track	Track from GetCurrentTrack() or GetTrack()
+	@param detail	ID from Intern() of a string describing the event, or NO_DETAIL
+ */
+void PerfEventRecorder::RecordAt(PerfEventType type, Phase phase, double time, uint16_t track, uint32_t detail)
+{
+	uint64_t i = m_next.fetch_add(1, memory_order_relaxed);
+	auto& slot = m_slots[i % m_capacity];
+
+	slot.m_seq.store(0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	uint64_t info =
+		static_cast<uint64_t>(type) |
+		(static_cast<uint64_t>(phase) << 8) |
+		(static_cast<uint64_t>(track) << 16) |
+		(static_cast<uint64_t>(detail) << 32);
+	slot.m_time.store(static_cast<int64_t>((time - m_epoch) * 1e9), memory_order_relaxed);
+	slot.m_info.store(info, memory_order_relaxed);
+
+	slot.m_seq.store(i + 1, memory_order_release);
+}
+
+/**
+	@brief Gets the ID for a string, adding it if not seen before
+
+	Takes a lock, so callers on hot paths should intern their strings once up front.
+ */
+uint32_t PerfEventRecorder::Intern(const string& str)
+{
+	lock_guard<mutex> lock(m_mutex);
+	auto it = m_stringIDs.find(str);
+	if(it != m_stringIDs.end())
+		return it->second;
+
+	uint32_t id = m_strings.size();
+	m_strings.push_back(str);
+	m_stringIDs[str] = id;
+	return id;
+}
+
+/**
+	@brief Adds a new track
+
+	Must be called with m_mutex held.
+ */
+uint16_t PerfEventRecorder::AddTrack(const string& name)
+{
+	//Out of IDs (should never happen), share the last one
+	if(m_tracks.size() >= NO_TRACK)
+		return NO_TRACK - 1;
+
+	m_tracks.push_back(name);
+	return m_tracks.size() - 1;
+}
+
+/**
+	@brief Sets the name of the calling thread's track
+ */
+void PerfEventRecorder::NameThread(const string& name)
+{
+	lock_guard<mutex> lock(m_mutex);
+	if(g_perfTrack == NO_TRACK)
+		g_perfTrack = AddTrack(name);
+	else
+		m_tracks[g_perfTrack] = name;
+}
+
+/**
+	@brief Gets the track of the calling thread, creating it on first use
+ */
+uint16_t PerfEventRecorder::GetCurrentTrack()
+{
+	if(g_perfTrack == NO_TRACK)
+	{
+		lock_guard<mutex> lock(m_mutex);
+		g_perfTrack = AddTrack(string("Thread ") + to_string(m_tracks.size()));
+	}
+	return g_perfTrack;
+}
+
+/**
+	@brief Gets the virtual track with a given name, creating it if necessary
+ */
+uint16_t PerfEventRecorder::GetTrack(const string& name)
+{
+	lock_guard<mutex> lock(m_mutex);
+	for(size_t i=0; i<m_tracks.size(); i++)
+	{
+		if(m_tracks[i] == name)
+			return i;
+	}
+	return AddTrack(name);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Export
+
+/**
+	@brief Writes recent events in Chrome trace event format, for viewing in chrome://tracing or Perfetto
+
+	@param path			Path of the file to write
+	@param startTime	Start of the time range to export, from GetTime()
+	@param endTime		End of the time range to export, from GetTime()
+
+	@return True on success, false if the file could not be written
+ */
+bool PerfEventRecorder::ExportChromeTrace(const string& path, double startTime, double endTime)
+{
+	int64_t tstart = (startTime - m_epoch) * 1e9;
+	int64_t tend = (endTime - m_epoch) * 1e9;
+
+	//Copy out every complete event in the time window, skipping any overwritten while we read them
+	vector<pair<int64_t, uint64_t>> events;
+	uint64_t end = m_next.load(memory_order_acquire);
+	uint64_t start = (end > m_capacity) ? (end - m_capacity) : 0;
+	events.reserve(end - start);
+	for(uint64_t i=start; i<end; i++)
+	{
+		auto& slot = m_slots[i % m_capacity];
+		if(slot.m_seq.load(memory_order_acquire) != i+1)
+			continue;
+		int64_t time = slot.m_time.load(memory_order_relaxed);
+		uint64_t info = slot.m_info.load(memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+		if(slot.m_seq.load(memory_order_relaxed) != i+1)
+			continue;
+
+		if( (time >= tstart) && (time <= tend) )
+			events.push_back(pair<int64_t, uint64_t>(time, info));
+	}
+
+	//Events with explicit timestamps may be out of order. Keep ties in recording order so spans still nest.
+	stable_sort(events.begin(), events.end(),
+		[](const pair<int64_t, uint64_t>& a, const pair<int64_t, uint64_t>& b)
+		{ return a.first < b.first; });
+
+	vector<string> strings;
+	vector<string> tracks;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		strings = m_strings;
+		tracks = m_tracks;
+	}
+
+	ofstream outfs(path);
+	if(!outfs)
+		return false;
+
+	outfs << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	outfs << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ngscopeclient\"}}";
+	for(size_t i=0; i<tracks.size(); i++)
+	{
+		outfs << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+			<< ",\"args\":{\"name\":\"" << FilterGraphTimeline::JSONEscape(tracks[i]) << "\"}}";
+	}
+
+	//Timestamps are in microseconds, relative to the oldest event
+	int64_t base = events.empty() ? 0 : events[0].first;
+	vector<size_t> depth(tracks.size() + 1, 0);
+	outfs.precision(15);
+	for(auto& e : events)
+	{
+		auto type = static_cast<PerfEventType>(e.second & 0xff);
+		auto phase = static_cast<Phase>((e.second >> 8) & 0xff);
+		size_t track = (e.second >> 16) & 0xffff;
+		uint32_t detail = e.second >> 32;
+		if( (type >= PERF_EVENT_TYPE_COUNT) || (track >= tracks.size()) )
+			continue;
+
+		//Drop the ends of spans which began before the window
+		if(phase == PHASE_END)
+		{
+			if(depth[track] == 0)
+				continue;
+			depth[track] --;
+		}
+		else if(phase == PHASE_BEGIN)
+			depth[track] ++;
+
+		//Filters are named after the filter, everything else after the event type
+		string name = g_perfEventNames[type][0];
+		bool hasDetail = (detail != NO_DETAIL) && (detail < strings.size());
+		if( (type == PERF_FILTER) && hasDetail)
+			name = strings[detail];
+
+		outfs << ",\n{\"name\":\"" << FilterGraphTimeline::JSONEscape(name) << "\""
+			<< ",\"cat\":\"" << g_perfEventNames[type][1] << "\"";
+		switch(phase)
+		{
+			case PHASE_BEGIN:
+				outfs << ",\"ph\":\"B\"";
+				break;
+
+			case PHASE_END:
+				outfs << ",\"ph\":\"E\"";
+				break;
+
+			default:
+				outfs << ",\"ph\":\"i\",\"s\":\"t\"";
+				break;
+		}
+		outfs << ",\"pid\":1,\"tid\":" << track << ",\"ts\":" << ((e.first - base) * 1e-3);
+		if(type == PERF_FILTER)
+			outfs << ",\"args\":{\"estimated\":true}";
+		else if(hasDetail)
+			outfs << ",\"args\":{\"detail\":\"" << FilterGraphTimeline::JSONEscape(strings[detail]) << "\"}";
+		outfs << "}";
+	}
+	outfs << "\n]}\n";
+
+	outfs.close();
+	return !outfs.fail();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PerfEventScope
+
+PerfEventScope::PerfEventScope(PerfEventType type, uint32_t detail)
+	: m_type(type)
+	, m_detail(detail)
+{
+	g_perfRecorder.Record(m_type, PerfEventRecorder::PHASE_BEGIN, m_detail);
+}
+
+PerfEventScope::~PerfEventScope()
+{
+	g_perfRecorder.Record(m_type, PerfEventRecorder::PHASE_END, m_detail);
+}
@@ -0,0 +1,169 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PerfEventRecorder
+ */
+#ifndef PerfEventRecorder_h
+#define PerfEventRecorder_h
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+/**
+	@brief Kinds of event recorded by PerfEventRecorder
+ */
+enum PerfEventType
+{
+	PERF_POLL,				//Polling an instrument for trigger status
+	PERF_TRIGGER,			//Instrument reported a trigger
+	PERF_ACQUIRE,			//Downloading waveform data from an instrument
+	PERF_DOWNLOAD,			//Moving downloaded waveforms into the session
+	PERF_FILTER_GRAPH,		//A run of the filter graph
+	PERF_FILTER,			//A single filter within a run (times are estimated, see FilterGraphTimeline)
+	PERF_RASTERIZE,			//Rasterizing waveforms, from submission until the GPU completes
+	PERF_TONE_MAP,			//Tone mapping waveforms
+	PERF_PRESENT,			//Presenting a frame
+
+	PERF_EVENT_TYPE_COUNT
+};
+
+/**
+	@brief Always-on recorder of timestamped events from every pipeline thread, for diagnosing stalls
+
+	Events go into a fixed size ring buffer of small binary records, so recording costs a clock read and a few atomic
+	stores, and memory use is bounded no matter how long the application runs. Strings (instrument and filter names)
+	are interned once and referred to by ID.
+
+	Events are grouped into tracks, which are either real threads or virtual threads like filter graph executors.
+	Spans are recorded as begin/end pairs, which must nest properly within a track.
+
+	Writers claim slots with a single atomic increment and publish them with a per-slot sequence number, so the
+	exporter can skip any slot which was being overwritten while it read.
+ */
+class PerfEventRecorder
+{
+public:
+	PerfEventRecorder(size_t capacity = DEFAULT_CAPACITY);
+
+	enum Phase
+	{
+		PHASE_BEGIN,
+		PHASE_END,
+		PHASE_INSTANT
+	};
+
+	void Record(PerfEventType type, Phase phase, uint32_t detail = NO_DETAIL);
+	void RecordAt(PerfEventType type, Phase phase, double time, uint16_t track, uint32_t detail = NO_DETAIL);
+
+	uint32_t Intern(const std::string& str);
+
+	void NameThread(const std::string& name);
+	uint16_t GetCurrentTrack();
+	uint16_t GetTrack(const std::string& name);
+
+	bool ExportChromeTrace(const std::string& path, double startTime, double endTime);
+
+	///@brief Default number of events kept (about 12 MB)
+	static const size_t DEFAULT_CAPACITY = 512 * 1024;
+
+	///@brief Detail ID for events with no associated string
+	static const uint32_t NO_DETAIL = 0xffffffff;
+
+protected:
+	uint16_t AddTrack(const std::string& name);
+
+	/**
+		@brief A single event
+
+		m_seq is zero while the slot is being written, and one more than the event's index once complete.
+	 */
+	class Slot
+	{
+	public:
+		Slot()
+			: m_seq(0)
+			, m_time(0)
+			, m_info(0)
+		{}
+
+		std::atomic<uint64_t> m_seq;
+
+		///@brief Nanoseconds since m_epoch
+		std::atomic<int64_t> m_time;
+
+		///@brief Type (bits 7:0), phase (bits 15:8), track (bits 31:16), detail ID (bits 63:32)
+		std::atomic<uint64_t> m_info;
+	};
+
+	///@brief Ring buffer of events
+	std::unique_ptr<Slot[]> m_slots;
+
+	///@brief Number of slots in m_slots
+	size_t m_capacity;
+
+	///@brief Total number of events ever recorded (index of the next one)
+	std::atomic<uint64_t> m_next;
+
+	///@brief Time (from GetTime()) event timestamps are relative to
+	double m_epoch;
+
+	///@brief Mutex protecting m_strings, m_stringIDs, and m_tracks
+	std::mutex m_mutex;
+
+	///@brief Interned strings, by ID
+	std::vector<std::string> m_strings;
+
+	///@brief IDs of interned strings
+	std::map<std::string, uint32_t> m_stringIDs;
+
+	///@brief Names of each track, by ID
+	std::vector<std::string> m_tracks;
+};
+
+/**
+	@brief Records a span on the calling thread's track for the lifetime of this object
+ */
+class PerfEventScope
+{
+public:
+	PerfEventScope(PerfEventType type, uint32_t detail = PerfEventRecorder::NO_DETAIL);
+	~PerfEventScope();
+
+protected:
+	PerfEventType m_type;
+	uint32_t m_detail;
+};
+
+extern PerfEventRecorder g_perfRecorder;
+
+#endif
@@ -155,6 +155,11 @@ void PreferenceManager::InitializeDefaults()
 				Preference::Color("invalid_link_color", ColorFromString("#ff0000"))
 				.Label("Invalid link color")
 				.Description("Color indicating a potential connection path is invalid"));
+			graph.AddPreference(
+				Preference::Color("critical_path_color", ColorFromString("#ff00ff"))
+				.Label("Critical path color")
+				.Description(
+					"Color for highlighting the slowest chain of dependent filters when the performance overlay is on"));
 			graph.AddPreference(
 				Preference::Font("icon_caption_font", FontDescription(FindDataFile("fonts/DejaVuSans.ttf"), 13))
 				.Label("Icon font")
@@ -452,6 +457,28 @@ void PreferenceManager::InitializeDefaults()
 				.EnumValue("All non-MSO channels", HEADLESS_STARTUP_ALL_NON_MSO)
 				.EnumValue("Channel 1 only", HEADLESS_STARTUP_C1_ONLY) );
 
+		auto& polling = drivers.AddCategory("Polling");
+			polling.AddPreference(
+				Preference::Real("measurement_interval", FS_PER_SECOND / 20)
+				.Label("Measurement interval")
+				.Unit(Unit::UNIT_FS)
+				.Description(
+					"Minimum interval between polls of measured values (voltage, current, meter readings)\n"
+					"on power supplies, loads, and multimeters.\n\n"
+					"Shorter intervals give faster updating displays, but each poll costs one or more round trips\n"
+					"to the instrument."
+					)
+				);
+			polling.AddPreference(
+				Preference::Real("status_interval", FS_PER_SECOND / 4)
+				.Label("Status interval")
+				.Unit(Unit::UNIT_FS)
+				.Description(
+					"Minimum interval between polls of slowly changing power supply status\n"
+					"(output enable, CC/CV mode, overcurrent shutdown)."
+					)
+				);
+
 		auto& rigol = drivers.AddCategory("Rigol DHO");
 			rigol.AddPreference(
 				Preference::Enum("data_width", WIDTH_AUTO)
@@ -511,11 +538,56 @@ void PreferenceManager::InitializeDefaults()
 			.Unit(Unit::UNIT_COUNTS));
 
 	auto& misc = this->m_treeRoot.AddCategory("Miscellaneous");
+		auto& fgraph = misc.AddCategory("Filter Graph");
+			fgraph.AddPreference(
+				Preference::Bool("demand_driven_evaluation", true)
+				.Label("Demand-driven evaluation")
+				.Description(
+					"Only evaluate filters whose outputs are displayed in a waveform view, measurement, or protocol\n"
+					"analyzer (or which feed another filter that is).\n\n"
+					"Filters nobody is looking at are skipped and computed on demand when first viewed. Packets are\n"
+					"only collected into history for protocol decodes that are displayed in a waveform view or open\n"
+					"in a protocol analyzer; decodes with neither skip any waveforms acquired in the meantime.")
+				);
+			fgraph.AddPreference(
+				Preference::Bool("region_of_interest", false)
+				.Label("Region of interest evaluation")
+				.Description(
+					"When zoomed in, evaluate simple point-wise filters (math, thresholds, upsampling) over only\n"
+					"the visible part of the waveform plus a margin, rather than the entire acquisition.\n\n"
+					"Only applies when every filter downstream of an instrument channel supports it and is shown\n"
+					"only in waveform views. The full waveform is computed when zooming or panning outside the\n"
+					"computed region, and before saving.")
+				);
+		auto& history = misc.AddCategory("History");
+			history.AddPreference(
+				Preference::Int("filter_cache_size", 512 * 1024 * 1024)
+				.Label("Filter output cache size")
+				.Description(
+					"Maximum amount of memory used to cache filter graph outputs for waveforms in history.\n\n"
+					"When browsing history, previously viewed points are restored from the cache instead of\n"
+					"re-running the entire filter graph. Least recently viewed points are evicted first.\n"
+					"Set to zero to disable caching.")
+				.Unit(Unit::UNIT_BYTES));
 		auto& menus = misc.AddCategory("Menus");
 			menus.AddPreference(
 				Preference::Int("recent_instrument_count", 20)
 				.Label("Recent instrument count")
 				.Description("Number of recently used instruments to display"));
+		auto& rendering = misc.AddCategory("Rendering");
+			rendering.AddPreference(
+				Preference::Enum("rasterizer", 0)
+				.Label("Waveform rasterizer")
+				.Description(
+					"Select where analog and digital waveforms are rasterized.\n\n"
+					"The compute shader is fastest on a discrete or reasonably capable integrated GPU.\n"
+					"The CPU rasterizer (multithreaded, with AVX2 where available) is usually faster on software\n"
+					"Vulkan implementations such as lavapipe or llvmpipe, and on very weak integrated GPUs.\n\n"
+					"Automatic uses the CPU rasterizer if the Vulkan device is a software implementation.")
+				.EnumValue("Automatic", 0)
+				.EnumValue("GPU (compute shader)", 1)
+				.EnumValue("CPU", 2)
+				);
 
 	auto& pwr = this->m_treeRoot.AddCategory("Power");
 		auto& events = pwr.AddCategory("Events");
@@ -63,10 +63,14 @@ ProtocolAnalyzerDialog::ProtocolAnalyzerDialog(
 {
 	//Hold a reference open to the filter so it doesn't disappear on us
 	m_filter->AddRef();
+
+	//and make sure it keeps producing packets while we're open
+	m_session.AddConsumer(m_filter);
 }
 
 ProtocolAnalyzerDialog::~ProtocolAnalyzerDialog()
 {
+	m_session.RemoveConsumer(m_filter);
 	m_filter->Release();
 }
 
@@ -0,0 +1,216 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of ProtocolRenderCache
+ */
+#include "ngscopeclient.h"
+#include "ProtocolRenderCache.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+ProtocolRenderCache::ProtocolRenderCache()
+	: m_pixelsPerXUnit(0)
+	, m_font(nullptr)
+	, m_fontSize(0)
+{
+}
+
+/**
+	@brief Discards all cached spans and text
+ */
+void ProtocolRenderCache::Clear()
+{
+	m_key = WaveformCacheKey();
+	m_pixelsPerXUnit = 0;
+	m_spans.clear();
+	m_starts.clear();
+	m_text.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Span generation
+
+/**
+	@brief Rebuilds the span list if the waveform or X axis scale has changed since the last call
+
+	@param data				The protocol waveform
+	@param pixelsPerXUnit	Current X axis scale
+ */
+void ProtocolRenderCache::Update(SparseWaveformBase* data, double pixelsPerXUnit)
+{
+	WaveformCacheKey key(data);
+	if( (key == m_key) && (pixelsPerXUnit == m_pixelsPerXUnit) )
+		return;
+
+	//Text only depends on the waveform, not the zoom
+	if(!(key == m_key))
+		m_text.clear();
+
+	m_key = key;
+	m_pixelsPerXUnit = pixelsPerXUnit;
+	m_spans.clear();
+	m_starts.clear();
+
+	data->CacheColors();
+	data->PrepareForCpuAccess();
+
+	//Cells narrower than this (in X axis units) get merged
+	double minWidth = MIN_CELL_WIDTH / pixelsPerXUnit;
+
+	size_t len = data->size();
+	for(size_t i=0; i<len; i++)
+	{
+		ProtocolRenderSpan span;
+		span.m_start = (data->m_offsets[i] * data->m_timescale) + data->m_triggerPhase;
+		span.m_end = span.m_start + (data->m_durations[i] * data->m_timescale);
+		span.m_index = i;
+		span.m_count = 1;
+		span.m_color = data->GetColorCached(i);
+
+		//This sample is really skinny, average the color of all samples touching the same pixels
+		if( (span.m_end - span.m_start) < minWidth)
+		{
+			float sum_red = (span.m_color >> IM_COL32_R_SHIFT) & 0xff;
+			float sum_green = (span.m_color >> IM_COL32_G_SHIFT) & 0xff;
+			float sum_blue = (span.m_color >> IM_COL32_B_SHIFT) & 0xff;
+			int64_t limit = span.m_start + static_cast<int64_t>(minWidth);
+
+			for(size_t j=i+1; j<len; j++)
+			{
+				int64_t cellstart = (data->m_offsets[j] * data->m_timescale) + data->m_triggerPhase;
+				if(cellstart > limit)
+					break;
+
+				//Stop at the first cell that's wide enough to draw by itself, the outer loop will handle it
+				int64_t cellend = cellstart + (data->m_durations[j] * data->m_timescale);
+				if( (cellend - cellstart) >= minWidth)
+					break;
+
+				auto c = data->GetColorCached(j);
+				sum_red += (c >> IM_COL32_R_SHIFT) & 0xff;
+				sum_green += (c >> IM_COL32_G_SHIFT) & 0xff;
+				sum_blue += (c >> IM_COL32_B_SHIFT) & 0xff;
+
+				span.m_end = min(max(span.m_end, cellend), limit);
+				span.m_count ++;
+
+				//Skip these samples in the outer loop
+				i = j;
+			}
+
+			sum_red /= span.m_count;
+			sum_green /= span.m_count;
+			sum_blue /= span.m_count;
+			span.m_color =
+				((static_cast<int>(sum_red) & 0xff) << IM_COL32_R_SHIFT) |
+				((static_cast<int>(sum_green) & 0xff) << IM_COL32_G_SHIFT) |
+				((static_cast<int>(sum_blue) & 0xff) << IM_COL32_B_SHIFT) |
+				(0xff << IM_COL32_A_SHIFT);
+		}
+
+		m_spans.push_back(span);
+		m_starts.push_back(span.m_start);
+	}
+}
+
+/**
+	@brief Finds the first span that may be visible when the left edge of the view is at the specified time
+ */
+size_t ProtocolRenderCache::FindFirstVisible(int64_t t)
+{
+	if(m_starts.empty())
+		return 0;
+
+	size_t ifirst = BinarySearchForGequal(m_starts.data(), m_starts.size(), t);
+
+	//Go left by one span
+	//The last span BEFORE the left side of our view might extend into the visible space
+	if(ifirst > 0)
+		ifirst --;
+	return ifirst;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Text
+
+/**
+	@brief Gets the text of a sample and its size when drawn in a given font, formatting and measuring it if needed
+
+	@param data			The protocol waveform
+	@param i			Sample index
+	@param font			Font the text will be drawn in
+	@param fontSize		Size the text will be drawn at
+	@param textSize		Size of the text
+ */
+const string& ProtocolRenderCache::GetText(
+	SparseWaveformBase* data,
+	size_t i,
+	ImFont* font,
+	float fontSize,
+	ImVec2& textSize)
+{
+	//Sizes are stale if the font changed
+	if( (font != m_font) || (fontSize != m_fontSize) )
+	{
+		m_text.clear();
+		m_font = font;
+		m_fontSize = fontSize;
+	}
+
+	auto it = m_text.find(i);
+	if(it == m_text.end())
+	{
+		//Don't grow without bound while scrolling through a huge decode
+		if(m_text.size() >= MAX_CACHED_TEXT)
+			m_text.clear();
+
+		auto& entry = m_text[i];
+
+		//Convert all whitespace in text to spaces
+		entry.m_text = data->GetText(i);
+		for(auto& c : entry.m_text)
+		{
+			if(isspace(c))
+				c = ' ';
+		}
+
+		entry.m_size = font->CalcTextSizeA(fontSize, FLT_MAX, 0, entry.m_text.c_str());
+		textSize = entry.m_size;
+		return entry.m_text;
+	}
+
+	textSize = it->second.m_size;
+	return it->second.m_text;
+}
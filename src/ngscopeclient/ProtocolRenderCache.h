@@ -0,0 +1,130 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of ProtocolRenderCache
+ */
+#ifndef ProtocolRenderCache_h
+#define ProtocolRenderCache_h
+
+#include <unordered_map>
+
+/**
+	@brief One cell of a protocol decode, as drawn at a particular zoom level
+
+	Cells too narrow to draw individually are merged into a single span with the average color of all of them.
+ */
+class ProtocolRenderSpan
+{
+public:
+	///@brief Start time of the span, in X axis units
+	int64_t m_start;
+
+	///@brief End time of the span, in X axis units
+	int64_t m_end;
+
+	///@brief Index of the first sample in the span
+	size_t m_index;
+
+	///@brief Number of samples merged into the span (text is only drawn if this is 1)
+	size_t m_count;
+
+	///@brief Fill color
+	ImU32 m_color;
+};
+
+/**
+	@brief Level-of-detail cache for drawing protocol decodes
+
+	Holds the list of cells for the current zoom level, in X axis units so panning doesn't invalidate it, and is
+	rebuilt only when the waveform or the X axis scale changes. Drawing a frame then costs one binary search plus one
+	span per cell on screen, regardless of how many samples the decode has.
+
+	Text and text size are also cached for cells that have been drawn, since formatting and measuring them is the
+	most expensive part of drawing a wide cell.
+ */
+class ProtocolRenderCache
+{
+public:
+	ProtocolRenderCache();
+
+	void Update(SparseWaveformBase* data, double pixelsPerXUnit);
+	size_t FindFirstVisible(int64_t t);
+
+	///@brief Gets the spans for the current zoom level
+	const std::vector<ProtocolRenderSpan>& GetSpans()
+	{ return m_spans; }
+
+	const std::string& GetText(SparseWaveformBase* data, size_t i, ImFont* font, float fontSize, ImVec2& textSize);
+
+	void Clear();
+
+protected:
+
+	///@brief Minimum width of a drawn cell, in pixels. Anything narrower is merged with its neighbors
+	static constexpr double MIN_CELL_WIDTH = 2;
+
+	///@brief Maximum number of samples to cache text for
+	static const size_t MAX_CACHED_TEXT = 65536;
+
+	///@brief Identifies the waveform the spans were built from
+	WaveformCacheKey m_key;
+
+	///@brief X axis scale the spans were built for
+	double m_pixelsPerXUnit;
+
+	///@brief Spans for the current zoom level, sorted by start time
+	std::vector<ProtocolRenderSpan> m_spans;
+
+	///@brief Start time of each span (for binary searching)
+	std::vector<int64_t> m_starts;
+
+	/**
+		@brief Text of a sample, and its size when drawn
+	 */
+	class CachedText
+	{
+	public:
+		std::string m_text;
+		ImVec2 m_size;
+	};
+
+	///@brief Text for samples that have been drawn, indexed by sample
+	std::unordered_map<size_t, CachedText> m_text;
+
+	///@brief Font the text sizes were measured with
+	ImFont* m_font;
+
+	///@brief Font size the text sizes were measured with
+	float m_fontSize;
+};
+
+#endif
@@ -0,0 +1,490 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of RasterizerBenchmark
+ */
+#include "ngscopeclient.h"
+#include "RasterizerBenchmark.h"
+#include "FilterGraphBenchmark.h"
+#include "FilterGraphTimeline.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+/**
+	@brief Cheap deterministic pseudorandom number, so deep waveforms can be generated in parallel
+ */
+static inline uint64_t Hash(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates the benchmark
+
+	@param height		Height of the rasterized output, in pixels
+	@param iterations	Number of measured iterations per case
+	@param warmup		Number of iterations to run first and discard
+ */
+RasterizerBenchmark::RasterizerBenchmark(size_t height, size_t iterations, size_t warmup)
+	: m_height(height)
+	, m_iterations(iterations)
+	, m_warmup(warmup)
+	, m_queue(g_vkQueueManager->GetComputeQueue("RasterizerBenchmark.queue"))
+	, m_pool(*g_vkComputeDevice,
+		vk::CommandPoolCreateInfo(
+			vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+			m_queue->m_family ))
+	, m_cmdBuf(std::move(vk::raii::CommandBuffers(*g_vkComputeDevice,
+		vk::CommandBufferAllocateInfo(*m_pool, vk::CommandBufferLevel::ePrimary, 1)).front()))
+	, m_analog("RasterizerBenchmark.m_analog")
+	, m_digital("RasterizerBenchmark.m_digital")
+	, m_offsets("RasterizerBenchmark.m_offsets")
+	, m_durations("RasterizerBenchmark.m_durations")
+	, m_indexes("RasterizerBenchmark.m_indexes")
+	, m_out("RasterizerBenchmark.m_out")
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Processing
+
+/**
+	@brief Runs every variant at every combination of memory depth and window width
+
+	@param depths	Memory depths to test, in samples
+	@param widths	Window widths to test, in pixels
+	@param cpu		True to time WaveformRasterizer
+	@param gpu		True to time the compute shaders
+ */
+void RasterizerBenchmark::Run(const vector<size_t>& depths, const vector<size_t>& widths, bool cpu, bool gpu)
+{
+	//Variants to test, named as in the shader build
+	struct BenchmarkVariant
+	{
+		string name;
+		WaveformRasterizer::Variant variant;
+		bool dense;
+	};
+	vector<BenchmarkVariant> variants =
+	{
+		{ "analog.dense",			WaveformRasterizer::VARIANT_ANALOG,				true },
+		{ "analog.zerohold.dense",	WaveformRasterizer::VARIANT_ANALOG_ZEROHOLD,	true },
+		{ "digital.dense",			WaveformRasterizer::VARIANT_DIGITAL,			true },
+		{ "histogram.dense",		WaveformRasterizer::VARIANT_HISTOGRAM,			true },
+		{ "analog",					WaveformRasterizer::VARIANT_ANALOG,				false },
+		{ "analog.zerohold",		WaveformRasterizer::VARIANT_ANALOG_ZEROHOLD,	false },
+		{ "digital",				WaveformRasterizer::VARIANT_DIGITAL,			false }
+	};
+
+	for(auto depth : depths)
+	{
+		LogNotice("Memory depth %s\n", Unit(Unit::UNIT_SAMPLEDEPTH).PrettyPrint(depth).c_str());
+		LogIndenter li;
+
+		GenerateWaveforms(depth);
+		for(auto width : widths)
+		{
+			for(auto& v : variants)
+			{
+				LogDebug("%s, %zu pixels wide\n", v.name.c_str(), width);
+				RunCase(v.name, v.variant, v.dense, depth, width, cpu, gpu);
+			}
+		}
+	}
+}
+
+/**
+	@brief Generates synthetic analog and digital waveforms, along with offsets and durations for the sparse variants
+
+	Analog data is a slow sine wave plus noise, digital data toggles randomly every 16 samples, and sparse samples are
+	1 to 4 time units long.
+ */
+void RasterizerBenchmark::GenerateWaveforms(size_t depth)
+{
+	m_analog.resize(depth);
+	m_digital.resize(depth);
+	m_offsets.resize(depth);
+	m_durations.resize(depth);
+	m_analog.PrepareForCpuAccess();
+	m_digital.PrepareForCpuAccess();
+	m_offsets.PrepareForCpuAccess();
+	m_durations.PrepareForCpuAccess();
+
+	#pragma omp parallel for
+	for(int64_t i=0; i<static_cast<int64_t>(depth); i++)
+	{
+		uint64_t r = Hash(i);
+		m_analog[i] = 0.4f * sin(i * 0.001f) + 0.1f * ((r & 0xffff) / 65535.0f - 0.5f);
+		m_digital[i] = Hash(i / 16) & 1;
+		m_durations[i] = 1 + ((r >> 16) & 3);
+	}
+
+	int64_t t = 0;
+	for(size_t i=0; i<depth; i++)
+	{
+		m_offsets[i] = t;
+		t += m_durations[i];
+	}
+
+	m_analog.MarkModifiedFromCpu();
+	m_digital.MarkModifiedFromCpu();
+	m_offsets.MarkModifiedFromCpu();
+	m_durations.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Calculates the rendering configuration to fit an entire synthetic waveform in the window
+ */
+ConfigPushConstants RasterizerBenchmark::GetConfig(bool dense, bool digital, size_t depth, size_t width)
+{
+	double span = depth;
+	if(!dense)
+		span = m_offsets[depth-1] + m_durations[depth-1];
+
+	ConfigPushConstants config;
+	config.innerXoff = 0;
+	config.windowHeight = m_height;
+	config.windowWidth = width;
+	config.memDepth = depth;
+	config.offset_samples = static_cast<uint32_t>(-2);
+	config.alpha = 1;
+	config.xoff = 0;
+	config.xscale = width / span;
+	if(digital)
+	{
+		config.yoff = 0;
+		config.yscale = m_height - 1;
+		config.ybase = 0;
+	}
+	else
+	{
+		config.yoff = 0;
+		config.yscale = m_height * 0.4f;
+		config.ybase = m_height * 0.5f;
+	}
+	config.persistScale = 0;
+	return config;
+}
+
+/**
+	@brief Times one variant at one memory depth and window width, on the CPU and/or GPU
+ */
+void RasterizerBenchmark::RunCase(
+	const string& name,
+	WaveformRasterizer::Variant variant,
+	bool dense,
+	size_t depth,
+	size_t width,
+	bool cpu,
+	bool gpu)
+{
+	auto config = GetConfig(dense, (variant == WaveformRasterizer::VARIANT_DIGITAL), depth, width);
+
+	//Sparse index buffers aren't part of rasterization, calculate them up front
+	if(!dense)
+	{
+		vector<int64_t> targets(width);
+		for(size_t i=0; i<width; i++)
+			targets[i] = floor(i / config.xscale);
+
+		m_indexes.resize(width);
+		m_indexes.PrepareForCpuAccess();
+		WaveformRasterizer::ComputeIndexes(
+			m_offsets.GetCpuPointer(),
+			depth,
+			targets.data(),
+			m_indexes.GetCpuPointer(),
+			width);
+		m_indexes.MarkModifiedFromCpu();
+	}
+
+	m_out.resize(width * m_height);
+
+	RasterizerBenchmarkResult result;
+	result.m_variant = name;
+	result.m_dense = dense;
+	result.m_depth = depth;
+	result.m_width = width;
+
+	if(cpu)
+	{
+		TimeCpu(result, config, variant);
+		m_results.push_back(result);
+	}
+
+	if(gpu)
+	{
+		result.m_gpu = true;
+		for(int i=0; i<2; i++)
+		{
+			result.m_int64 = (i == 1);
+			if(result.m_int64 && !g_hasShaderInt64)
+				continue;
+
+			TimeGpu(result, config, variant);
+			m_results.push_back(result);
+		}
+	}
+}
+
+/**
+	@brief Times WaveformRasterizer on the current waveforms
+ */
+void RasterizerBenchmark::TimeCpu(
+	RasterizerBenchmarkResult& result,
+	const ConfigPushConstants& config,
+	WaveformRasterizer::Variant variant)
+{
+	m_analog.PrepareForCpuAccess();
+	m_digital.PrepareForCpuAccess();
+	m_offsets.PrepareForCpuAccess();
+	m_durations.PrepareForCpuAccess();
+	m_indexes.PrepareForCpuAccess();
+	m_out.PrepareForCpuAccess();
+
+	WaveformRasterizer::Inputs inputs;
+	inputs.m_analog = m_analog.GetCpuPointer();
+	inputs.m_digital = m_digital.GetCpuPointer();
+	inputs.m_offsets = m_offsets.GetCpuPointer();
+	inputs.m_indexes = m_indexes.GetCpuPointer();
+	inputs.m_durations = m_durations.GetCpuPointer();
+
+	result.m_times.clear();
+	for(size_t i=0; i<m_warmup + m_iterations; i++)
+	{
+		double start = GetTime();
+		WaveformRasterizer::Rasterize(config, variant, result.m_dense, inputs, m_out.GetCpuPointer());
+		int64_t dt = (GetTime() - start) * FS_PER_SECOND;
+		if(i >= m_warmup)
+			result.m_times.push_back(dt);
+	}
+
+	m_out.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Times a compute shader variant on the current waveforms
+ */
+void RasterizerBenchmark::TimeGpu(
+	RasterizerBenchmarkResult& result,
+	const ConfigPushConstants& config,
+	WaveformRasterizer::Variant variant)
+{
+	auto pipe = GetPipeline(result.m_variant, variant, result.m_dense, result.m_int64);
+
+	//Make sure nothing but the shader itself is timed
+	if(variant == WaveformRasterizer::VARIANT_DIGITAL)
+		m_digital.PrepareForGpuAccess();
+	else
+		m_analog.PrepareForGpuAccess();
+	if(!result.m_dense)
+	{
+		m_offsets.PrepareForGpuAccess();
+		m_indexes.PrepareForGpuAccess();
+		if(variant == WaveformRasterizer::VARIANT_ANALOG_ZEROHOLD)
+			m_durations.PrepareForGpuAccess();
+	}
+	m_out.PrepareForGpuAccess();
+
+	result.m_times.clear();
+	for(size_t i=0; i<m_warmup + m_iterations; i++)
+	{
+		m_cmdBuf.reset();
+		m_cmdBuf.begin({});
+		pipe->BindBufferNonblocking(0, m_out, m_cmdBuf, true);
+		if(variant == WaveformRasterizer::VARIANT_DIGITAL)
+			pipe->BindBufferNonblocking(1, m_digital, m_cmdBuf);
+		else
+			pipe->BindBufferNonblocking(1, m_analog, m_cmdBuf);
+		if(!result.m_dense)
+		{
+			pipe->BindBufferNonblocking(2, m_offsets, m_cmdBuf);
+			pipe->BindBufferNonblocking(3, m_indexes, m_cmdBuf);
+			if(variant == WaveformRasterizer::VARIANT_ANALOG_ZEROHOLD)
+				pipe->BindBufferNonblocking(4, m_durations, m_cmdBuf);
+		}
+		pipe->Dispatch(m_cmdBuf, config, config.windowWidth, 1, 1);
+		m_cmdBuf.end();
+
+		double start = GetTime();
+		m_queue->SubmitAndBlock(m_cmdBuf);
+		int64_t dt = (GetTime() - start) * FS_PER_SECOND;
+		if(i >= m_warmup)
+			result.m_times.push_back(dt);
+	}
+
+	m_out.MarkModifiedFromGpu();
+}
+
+/**
+	@brief Gets the compute pipeline for a shader variant, creating it if necessary
+ */
+shared_ptr<ComputePipeline> RasterizerBenchmark::GetPipeline(
+	const string& name,
+	WaveformRasterizer::Variant variant,
+	bool dense,
+	bool int64)
+{
+	string fname = name;
+	if(int64)
+	{
+		auto pos = fname.find(".dense");
+		if(pos == string::npos)
+			fname += ".int64";
+		else
+			fname.insert(pos, ".int64");
+	}
+	fname = "shaders/waveform-compute." + fname + ".spv";
+
+	auto it = m_pipelines.find(fname);
+	if(it != m_pipelines.end())
+		return it->second;
+
+	size_t nbindings = 2;
+	if(!dense)
+		nbindings = (variant == WaveformRasterizer::VARIANT_ANALOG_ZEROHOLD) ? 5 : 4;
+	auto pipe = make_shared<ComputePipeline>(fname, nbindings, sizeof(ConfigPushConstants));
+	m_pipelines[fname] = pipe;
+	return pipe;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Output
+
+/**
+	@brief Prints the results as a human readable table
+ */
+void RasterizerBenchmark::PrintTable(FILE* fp)
+{
+	Unit depth(Unit::UNIT_SAMPLEDEPTH);
+
+	fprintf(fp, "%-22s %-7s %8s %6s %10s %10s %10s %10s %10s\n",
+		"Variant", "Backend", "Depth", "Width", "Mean ms", "Median ms", "Min ms", "Max ms", "MS/s");
+	for(auto& r : m_results)
+	{
+		if(r.m_times.empty())
+			continue;
+
+		auto times = r.m_times;
+		sort(times.begin(), times.end());
+		double sum = 0;
+		for(auto t : times)
+			sum += t;
+		double mean = sum / times.size();
+
+		string backend = r.m_gpu ? (r.m_int64 ? "gpu64" : "gpu") : "cpu";
+		double scale = 1e-12;
+		fprintf(fp, "%-22s %-7s %8s %6zu %10.3f %10.3f %10.3f %10.3f %10.1f\n",
+			r.m_variant.c_str(),
+			backend.c_str(),
+			depth.PrettyPrint(r.m_depth).c_str(),
+			r.m_width,
+			mean * scale,
+			times[times.size() / 2] * scale,
+			times[0] * scale,
+			times[times.size() - 1] * scale,
+			(mean > 0) ? (r.m_depth * FS_PER_SECOND / mean * 1e-6) : 0);
+	}
+}
+
+/**
+	@brief Writes the results as JSON
+
+	@param path		Output file path, or "-" for stdout
+
+	@return True on success, false on failure
+ */
+bool RasterizerBenchmark::WriteJSON(const string& path)
+{
+	stringstream out;
+	out.precision(15);
+	out << "{\n";
+	out << "\t\"height\": " << m_height << ",\n";
+	out << "\t\"iterations\": " << m_iterations << ",\n";
+	out << "\t\"warmup\": " << m_warmup << ",\n";
+	out << "\t\"results\": [";
+	for(size_t i=0; i<m_results.size(); i++)
+	{
+		auto& r = m_results[i];
+
+		double mean = 0;
+		for(auto t : r.m_times)
+			mean += t;
+		if(!r.m_times.empty())
+			mean /= r.m_times.size();
+		double rate = (mean > 0) ? (r.m_depth * FS_PER_SECOND / mean) : 0;
+
+		if(i > 0)
+			out << ",";
+		out << "\n\t\t{\"variant\":\"" << FilterGraphTimeline::JSONEscape(r.m_variant) << "\""
+			<< ",\"dense\":" << (r.m_dense ? "true" : "false")
+			<< ",\"backend\":\"" << (r.m_gpu ? "gpu" : "cpu") << "\""
+			<< ",\"int64\":" << (r.m_int64 ? "true" : "false")
+			<< ",\"depth\":" << r.m_depth
+			<< ",\"width\":" << r.m_width << ","
+			<< FilterGraphBenchmark::FormatStatistics(r.m_times)
+			<< ",\"samples_per_sec\":" << rate << "}";
+	}
+	out << "\n\t]\n}\n";
+
+	if(path == "-")
+	{
+		fputs(out.str().c_str(), stdout);
+		return true;
+	}
+
+	ofstream outfs(path);
+	if(!outfs)
+	{
+		LogError("Failed to open \"%s\" for writing\n", path.c_str());
+		return false;
+	}
+	outfs << out.str();
+	outfs.close();
+	if(!outfs)
+	{
+		LogError("Failed to write \"%s\"\n", path.c_str());
+		return false;
+	}
+
+	LogNotice("Wrote benchmark results to %s\n", path.c_str());
+	return true;
+}
@@ -0,0 +1,168 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of RasterizerBenchmark
+ */
+#ifndef RasterizerBenchmark_h
+#define RasterizerBenchmark_h
+
+#include "WaveformRasterizer.h"
+
+/**
+	@brief Timing results for one rasterizer variant, memory depth, and window width
+ */
+class RasterizerBenchmarkResult
+{
+public:
+	RasterizerBenchmarkResult()
+		: m_dense(false)
+		, m_int64(false)
+		, m_gpu(false)
+		, m_depth(0)
+		, m_width(0)
+	{}
+
+	///@brief Shader variant name, as in the shader build (e.g. "analog.zerohold")
+	std::string m_variant;
+
+	///@brief True for uniformly sampled input, false for sparse
+	bool m_dense;
+
+	///@brief True if the int64 shader variant was used
+	bool m_int64;
+
+	///@brief True for the compute shader, false for WaveformRasterizer
+	bool m_gpu;
+
+	///@brief Number of samples in the waveform
+	size_t m_depth;
+
+	///@brief Window width, in pixels
+	size_t m_width;
+
+	///@brief Time taken by each measured iteration (fs)
+	std::vector<int64_t> m_times;
+};
+
+/**
+	@brief Times every waveform-compute shader variant, and the equivalent CPU rasterizer, on synthetic waveforms
+
+	Each waveform is zoomed out to fit the window, which is the worst case for deep captures and the case that the
+	min/max pyramid level thresholds need to be chosen for. Only the rasterization itself is timed: input data is
+	already resident on the GPU, and sparse index buffers are precomputed.
+
+	GPU times are wall clock time to submit the dispatch and wait for it, so include submission overhead.
+ */
+class RasterizerBenchmark
+{
+public:
+	RasterizerBenchmark(size_t height, size_t iterations, size_t warmup);
+
+	void Run(const std::vector<size_t>& depths, const std::vector<size_t>& widths, bool cpu, bool gpu);
+
+	void PrintTable(FILE* fp);
+	bool WriteJSON(const std::string& path);
+
+protected:
+	void GenerateWaveforms(size_t depth);
+
+	void RunCase(
+		const std::string& name,
+		WaveformRasterizer::Variant variant,
+		bool dense,
+		size_t depth,
+		size_t width,
+		bool cpu,
+		bool gpu);
+
+	ConfigPushConstants GetConfig(bool dense, bool digital, size_t depth, size_t width);
+
+	void TimeCpu(
+		RasterizerBenchmarkResult& result,
+		const ConfigPushConstants& config,
+		WaveformRasterizer::Variant variant);
+
+	void TimeGpu(
+		RasterizerBenchmarkResult& result,
+		const ConfigPushConstants& config,
+		WaveformRasterizer::Variant variant);
+
+	std::shared_ptr<ComputePipeline> GetPipeline(
+		const std::string& name,
+		WaveformRasterizer::Variant variant,
+		bool dense,
+		bool int64);
+
+	///@brief Height of the output, in pixels
+	size_t m_height;
+
+	///@brief Number of measured iterations per case
+	size_t m_iterations;
+
+	///@brief Number of iterations to run and discard first
+	size_t m_warmup;
+
+	///@brief Results for each case, in the order they were run
+	std::vector<RasterizerBenchmarkResult> m_results;
+
+	///@brief Queue for GPU rasterization
+	std::shared_ptr<QueueHandle> m_queue;
+
+	///@brief Command pool for GPU rasterization
+	vk::raii::CommandPool m_pool;
+
+	///@brief Command buffer for GPU rasterization
+	vk::raii::CommandBuffer m_cmdBuf;
+
+	///@brief Compute pipelines for each shader variant, by file name
+	std::map<std::string, std::shared_ptr<ComputePipeline> > m_pipelines;
+
+	///@brief Synthetic analog samples
+	AcceleratorBuffer<float> m_analog;
+
+	///@brief Synthetic digital samples
+	AcceleratorBuffer<uint8_t> m_digital;
+
+	///@brief Sample offsets for the sparse variants
+	AcceleratorBuffer<int64_t> m_offsets;
+
+	///@brief Sample durations for the sparse variants
+	AcceleratorBuffer<int64_t> m_durations;
+
+	///@brief Index of the first sample in each column, for the sparse variants
+	AcceleratorBuffer<uint32_t> m_indexes;
+
+	///@brief Rasterized output
+	AcceleratorBuffer<float> m_out;
+};
+
+#endif
@@ -80,6 +80,7 @@ ScopeDeskewWizard::ScopeDeskewWizard(
 	, m_lastTriggerFs(0)
 	, m_bestCorrelation(0)
 	, m_bestCorrelationOffset(0)
+	, m_correlationTimescale(0)
 	, m_maxSkewSamples(30000)
 	, m_medianSkew(0)
 	, m_queue(g_vkQueueManager->GetComputeQueue("ScopeDeskewWizard.queue"))
@@ -127,6 +128,9 @@ ScopeDeskewWizard::ScopeDeskewWizard(
 
 ScopeDeskewWizard::~ScopeDeskewWizard()
 {
+	//Don't pull the rug out from under a correlation that's still running
+	if(m_correlationDone.valid())
+		m_session.GetTaskScheduler().WaitFor(m_correlationDone);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -292,7 +296,7 @@ bool ScopeDeskewWizard::DoRender()
 				}
 
 				//Acquire the first test waveform
-				m_group->Arm(TriggerGroup::TRIGGER_TYPE_SINGLE);
+				m_session.ArmTriggerGroup(m_group, TriggerGroup::TRIGGER_TYPE_SINGLE);
 			}
 
 			break;
@@ -481,15 +485,21 @@ void ScopeDeskewWizard::DoMainProcessingFlow()
 				m_lastTriggerFs = data->m_startFemtoseconds;
 
 				//We're now ready to do the correlation
+				//Run it on the task scheduler so the UI stays responsive while we crunch
 				LogTrace("Acquired waveform %d, starting correlation\n", m_measureCycle);
-				StartCorrelation();
+				m_correlationDone = m_session.GetTaskScheduler().Submit(
+					TaskScheduler::PRIORITY_INTERACTIVE, [this]{ return StartCorrelation(); });
 				m_state = STATE_CORRELATE;
 			}
 			break;
 
 		case STATE_CORRELATE:
 			{
-				//TODO: check if the correlation is done
+				//Wait for the correlation to finish
+				if(m_correlationDone.wait_for(0s) != future_status::ready)
+					return;
+				if(m_correlationDone.get())
+					FinishCorrelation();
 
 				m_measureCycle ++;
 
@@ -507,7 +517,7 @@ void ScopeDeskewWizard::DoMainProcessingFlow()
 
 				//Ready to grab next waveform
 				LogTrace("Acquiring next waveform\n");
-				m_group->Arm(TriggerGroup::TRIGGER_TYPE_SINGLE);
+				m_session.ArmTriggerGroup(m_group, TriggerGroup::TRIGGER_TYPE_SINGLE);
 				m_state = STATE_ACQUIRE;
 			}
 			break;
@@ -530,10 +540,25 @@ void ScopeDeskewWizard::DoMainProcessingFlow()
 	}
 }
 
-void ScopeDeskewWizard::StartCorrelation()
+/**
+	@brief Finds the best correlation between the primary and secondary waveforms
+
+	Runs on the task scheduler. Results are recorded by FinishCorrelation() once complete.
+
+	@return True if the correlation was performed, false if the waveforms couldn't be correlated
+ */
+bool ScopeDeskewWizard::StartCorrelation()
 {
+	//Hold the waveform data for the whole correlation so a new acquisition can't replace it under us
+	shared_lock<shared_mutex> lock(m_session.GetWaveformDataMutex());
+
 	auto pri = m_primaryStream.GetData();
 	auto sec = m_secondaryStream.GetData();
+	if(!pri || !sec)
+		return false;
+
+	//The primary may have changed by the time FinishCorrelation() runs, so remember the scale we correlated at
+	m_correlationTimescale = pri->m_timescale;
 
 	auto upri = dynamic_cast<UniformAnalogWaveform*>(pri);
 	auto usec = dynamic_cast<UniformAnalogWaveform*>(sec);
@@ -575,11 +600,19 @@ void ScopeDeskewWizard::StartCorrelation()
 	else
 	{
 		LogError("Mixed sparse and uniform waveforms not implemented\n");
-		return;
+		return false;
 	}
 
+	return true;
+}
+
+/**
+	@brief Records the result of a completed correlation (called from the UI thread)
+ */
+void ScopeDeskewWizard::FinishCorrelation()
+{
 	//Collect the skew from this round
-	int64_t skew = m_bestCorrelationOffset * pri->m_timescale;
+	int64_t skew = m_bestCorrelationOffset * m_correlationTimescale;
 	Unit fs(Unit::UNIT_FS);
 	LogTrace("Bxest correlation = %f (delta = %" PRId64 " / %s)\n",
 		m_bestCorrelation, m_bestCorrelationOffset, fs.PrettyPrint(skew).c_str());
@@ -596,69 +629,67 @@ void ScopeDeskewWizard::StartCorrelation()
 
 void ScopeDeskewWizard::DoProcessWaveformSparse(SparseAnalogWaveform* ppri, SparseAnalogWaveform* psec)
 {
-	shared_lock<shared_mutex> lock(m_session.GetWaveformDataMutex());
-
 	//Calculate cross-correlation between the primary and secondary waveforms at up to +/- half the waveform length
 	int64_t len = ppri->size();
 	size_t slen = psec->size();
 
 	std::mutex cmutex;
 
-	#pragma omp parallel for
-	for(int64_t d = -m_maxSkewSamples; d < m_maxSkewSamples; d ++)
-	{
-		//Convert delta from samples of the primary waveform to femtoseconds
-		int64_t deltaFs = ppri->m_timescale * d;
-
-		//Loop over samples in the primary waveform
-		//TODO: Can we AVX this?
-		ssize_t samplesProcessed = 0;
-		size_t isecondary = 0;
-		double correlation = 0;
-		for(size_t i=0; i<(size_t)len; i++)
+	m_session.GetTaskScheduler().ParallelFor(TaskScheduler::PRIORITY_INTERACTIVE, -m_maxSkewSamples, m_maxSkewSamples,
+		[&](int64_t d)
 		{
-			//Timestamp of this sample, in fs
-			int64_t start = ppri->m_offsets[i] * ppri->m_timescale + ppri->m_triggerPhase;
-
-			//Target timestamp in the secondary waveform
-			int64_t target = start + deltaFs;
+			//Convert delta from samples of the primary waveform to femtoseconds
+			int64_t deltaFs = ppri->m_timescale * d;
+
+			//Loop over samples in the primary waveform
+			//TODO: Can we AVX this?
+			ssize_t samplesProcessed = 0;
+			size_t isecondary = 0;
+			double correlation = 0;
+			for(size_t i=0; i<(size_t)len; i++)
+			{
+				//Timestamp of this sample, in fs
+				int64_t start = ppri->m_offsets[i] * ppri->m_timescale + ppri->m_triggerPhase;
 
-			//If off the start of the waveform, skip it
-			if(target < 0)
-				continue;
+				//Target timestamp in the secondary waveform
+				int64_t target = start + deltaFs;
 
-			//Skip secondary samples if the current secondary sample ends before the primary sample starts
-			bool done = false;
-			while( (((psec->m_offsets[isecondary] + psec->m_durations[isecondary]) *
-						psec->m_timescale) + psec->m_triggerPhase) < target)
-			{
-				isecondary ++;
+				//If off the start of the waveform, skip it
+				if(target < 0)
+					continue;
 
-				//If off the end of the waveform, stop
-				if(isecondary >= slen)
+				//Skip secondary samples if the current secondary sample ends before the primary sample starts
+				bool done = false;
+				while( (((psec->m_offsets[isecondary] + psec->m_durations[isecondary]) *
+							psec->m_timescale) + psec->m_triggerPhase) < target)
 				{
-					done = true;
-					break;
+					isecondary ++;
+
+					//If off the end of the waveform, stop
+					if(isecondary >= slen)
+					{
+						done = true;
+						break;
+					}
 				}
-			}
-			if(done)
-				break;
+				if(done)
+					break;
 
-			//Do the actual cross-correlation
-			correlation += ppri->m_samples[i] * psec->m_samples[isecondary];
-			samplesProcessed ++;
-		}
+				//Do the actual cross-correlation
+				correlation += ppri->m_samples[i] * psec->m_samples[isecondary];
+				samplesProcessed ++;
+			}
 
-		double normalizedCorrelation = correlation / samplesProcessed;
+			double normalizedCorrelation = correlation / samplesProcessed;
 
-		//Update correlation
-		lock_guard<mutex> lock2(cmutex);
-		if(normalizedCorrelation > m_bestCorrelation)
-		{
-			m_bestCorrelation = normalizedCorrelation;
-			m_bestCorrelationOffset = d;
-		}
-	}
+			//Update correlation
+			lock_guard<mutex> lock2(cmutex);
+			if(normalizedCorrelation > m_bestCorrelation)
+			{
+				m_bestCorrelation = normalizedCorrelation;
+				m_bestCorrelationOffset = d;
+			}
+		});
 }
 
 /*
@@ -768,8 +799,6 @@ void ScopeSyncWizard::DoProcessWaveformDensePackedEqualRateGeneric()
 */
 void ScopeDeskewWizard::DoProcessWaveformUniformUnequalRate(UniformAnalogWaveform* ppri, UniformAnalogWaveform* psec)
 {
-	shared_lock<shared_mutex> lock(m_session.GetWaveformDataMutex());
-
 	double start = GetTime();
 
 	int64_t len = ppri->size();
@@ -777,61 +806,61 @@ void ScopeDeskewWizard::DoProcessWaveformUniformUnequalRate(UniformAnalogWavefor
 
 	std::mutex cmutex;
 
-	#pragma omp parallel for
-	for(int64_t d = -m_maxSkewSamples; d < m_maxSkewSamples; d ++)
-	{
-		//Convert delta from samples of the primary waveform to femtoseconds
-		int64_t deltaFs = ppri->m_timescale * d;
-
-		//Shift by relative trigger phase
-		deltaFs += (ppri->m_triggerPhase - psec->m_triggerPhase);
-
-		//Loop over samples in the primary waveform
-		ssize_t samplesProcessed = 0;
-		size_t isecondary = 0;
-		double correlation = 0;
-		for(size_t i=0; i<(size_t)len; i++)
+	m_session.GetTaskScheduler().ParallelFor(TaskScheduler::PRIORITY_INTERACTIVE, -m_maxSkewSamples, m_maxSkewSamples,
+		[&](int64_t d)
 		{
-			//Target timestamp in the secondary waveform
-			int64_t target = i * ppri->m_timescale + deltaFs;
-
-			//If off the start of the waveform, skip it
-			if(target < 0)
-				continue;
+			//Convert delta from samples of the primary waveform to femtoseconds
+			int64_t deltaFs = ppri->m_timescale * d;
 
-			uint64_t utarget = target;
+			//Shift by relative trigger phase
+			deltaFs += (ppri->m_triggerPhase - psec->m_triggerPhase);
 
-			//Skip secondary samples if the current secondary sample ends before the primary sample starts
-			bool done = false;
-			while( static_cast<uint64_t>((isecondary + 1) *	psec->m_timescale) < utarget)
+			//Loop over samples in the primary waveform
+			ssize_t samplesProcessed = 0;
+			size_t isecondary = 0;
+			double correlation = 0;
+			for(size_t i=0; i<(size_t)len; i++)
 			{
-				isecondary ++;
+				//Target timestamp in the secondary waveform
+				int64_t target = i * ppri->m_timescale + deltaFs;
 
-				//If off the end of the waveform, stop
-				if(isecondary >= slen)
+				//If off the start of the waveform, skip it
+				if(target < 0)
+					continue;
+
+				uint64_t utarget = target;
+
+				//Skip secondary samples if the current secondary sample ends before the primary sample starts
+				bool done = false;
+				while( static_cast<uint64_t>((isecondary + 1) *	psec->m_timescale) < utarget)
 				{
-					done = true;
-					break;
+					isecondary ++;
+
+					//If off the end of the waveform, stop
+					if(isecondary >= slen)
+					{
+						done = true;
+						break;
+					}
 				}
-			}
-			if(done)
-				break;
+				if(done)
+					break;
 
-			//Do the actual cross-correlation
-			correlation += ppri->m_samples[i] * psec->m_samples[isecondary];
-			samplesProcessed ++;
-		}
+				//Do the actual cross-correlation
+				correlation += ppri->m_samples[i] * psec->m_samples[isecondary];
+				samplesProcessed ++;
+			}
 
-		double normalizedCorrelation = correlation / samplesProcessed;
+			double normalizedCorrelation = correlation / samplesProcessed;
 
-		//Update correlation
-		lock_guard<mutex> lock2(cmutex);
-		if(normalizedCorrelation > m_bestCorrelation)
-		{
-			m_bestCorrelation = normalizedCorrelation;
-			m_bestCorrelationOffset = d;
-		}
-	}
+			//Update correlation
+			lock_guard<mutex> lock2(cmutex);
+			if(normalizedCorrelation > m_bestCorrelation)
+			{
+				m_bestCorrelation = normalizedCorrelation;
+				m_bestCorrelationOffset = d;
+			}
+		});
 
 	double dt = GetTime() - start;
 	LogTrace("Correlation evaluated in %.3f sec\n", dt);
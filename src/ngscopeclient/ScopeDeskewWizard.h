@@ -69,7 +69,8 @@ public:
 
 protected:
 	void DoMainProcessingFlow();
-	void StartCorrelation();
+	bool StartCorrelation();
+	void FinishCorrelation();
 	void DoProcessWaveformUniformUnequalRate(UniformAnalogWaveform* ppri, UniformAnalogWaveform* psec);
 	void DoProcessWaveformUniform4xRateVulkan(UniformAnalogWaveform* ppri, UniformAnalogWaveform* psec);
 	void DoProcessWaveformUniformUnequalRateVulkan(UniformAnalogWaveform* ppri, UniformAnalogWaveform* psec);
@@ -116,6 +117,12 @@ protected:
 	float m_bestCorrelation;
 	int64_t m_bestCorrelationOffset;
 
+	//Timescale of the primary waveform the current correlation was run on
+	int64_t m_correlationTimescale;
+
+	//Completion of the correlation running on the task scheduler
+	std::future<bool> m_correlationDone;
+
 	bool m_gpuCorrelationAvailable;
 
 	//Maximum number of samples offset to consider
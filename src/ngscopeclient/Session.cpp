@@ -80,18 +80,25 @@ using namespace std;
 
 Session::Session(MainWindow* wnd)
 	: m_fileLoadVersion(0)
+	, m_taskScheduler(max(2U, thread::hardware_concurrency()))
 	, m_mainWindow(wnd)
 	, m_shuttingDown(false)
 	, m_modifiedSinceLastSave(false)
+	, m_appliedMeasurementInterval(-1)
+	, m_appliedStatusInterval(-1)
 	, m_tArm(0)
 	, m_tPrimaryTrigger(0)
 	, m_triggerArmed(false)
 	, m_triggerOneShot(false)
-	, m_graphExecutor(4)
+	, m_stopGeneration(0)
+	, m_graphExecutor(m_graphExecutorThreads)
 	, m_lastFilterGraphExecTime(0)
 	, m_history(*this)
 	, m_multiScope(false)
 	, m_nextMarkerNum(1)
+	, m_skippedFilterCount(0)
+	, m_roiComputedRange(0, 0)
+	, m_roiSuspended(false)
 {
 	CreateReferenceFilters();
 
@@ -144,6 +151,10 @@ void Session::ClearBackgroundThreads()
 	g_waveformReadyEvent.Clear();
 	g_rerenderDoneEvent.Clear();
 	g_waveformProcessedEvent.Signal();
+	{
+		lock_guard<mutex> lock(m_pendingArmMutex);
+		m_pendingArmRequests.clear();
+	}
 
 	//Signal our other worker threads to exit, then wait until they do so
 	m_shuttingDown = true;
@@ -240,6 +251,10 @@ void Session::Clear()
 	m_scopeDeskewCal.clear();
 	m_markers.clear();
 	m_instrumentStates.clear();
+	{
+		lock_guard<mutex> lock(m_consumersMutex);
+		m_staleNodes.clear();
+	}
 
 	//Remove all trigger groups
 	m_triggerGroups.clear();
@@ -340,6 +355,8 @@ bool Session::PreLoadFromYaml(const YAML::Node& node, const std::string& /*dataD
 /**
 	@brief Deserialize a YAML::Node (and associated data directory) to the current session
 
+	Waveform data is not loaded; call LoadWaveformData(dataDir) afterwards.
+
 	@param node		Root YAML node of the file
 	@param dataDir	Path to the _data directory associated with the session
 	@param online	True if we should reconnect to instruments
@@ -357,12 +374,10 @@ bool Session::LoadFromYaml(const YAML::Node& node, const string& dataDir, bool o
 		return false;
 	if(!LoadInstrumentInputs(m_fileLoadVersion, node["instruments"]))
 		return false;
-	if(!m_mainWindow->LoadUIConfiguration(m_fileLoadVersion, node["ui_config"]))
+	if(m_mainWindow && !m_mainWindow->LoadUIConfiguration(m_fileLoadVersion, node["ui_config"]))
 		return false;
 	if(!LoadTriggerGroups(node["triggergroups"]))
 		return false;
-	if(!LoadWaveformData(m_fileLoadVersion, dataDir))
-		return false;
 
 	//Markers
 	auto markers = node["ui_config"]["markers"];
@@ -379,6 +394,24 @@ bool Session::LoadFromYaml(const YAML::Node& node, const string& dataDir, bool o
 
 	OnMarkerChanged();
 
+	return true;
+}
+
+/**
+	@brief Loads waveform data for a session whose configuration was loaded by LoadFromYaml()
+
+	Reading the sample data can take a while, so the GUI runs this on the task scheduler and doesn't touch the session
+	until it returns.
+
+	@param dataDir	Path to the _data directory associated with the session
+
+	@return			True if successful, false on error
+ */
+bool Session::LoadWaveformData(const string& dataDir)
+{
+	if(!LoadWaveformData(m_fileLoadVersion, dataDir))
+		return false;
+
 	//If we have no waveform data (filter-only session) create a WaveformThread to do rendering,
 	//then refresh the filter graph
 	if(m_history.empty())
@@ -390,7 +423,6 @@ bool Session::LoadFromYaml(const YAML::Node& node, const string& dataDir, bool o
 	return true;
 }
 
-//TODO: this should run in a background thread or something to keep the UI responsive
 bool Session::LoadWaveformData(int version, const string& dataDir)
 {
 	LogTrace("Loading waveform data\n");
@@ -675,10 +707,13 @@ bool Session::LoadWaveformDataForScope(
 		}
 
 		//Actually load the data for each channel
+		//(each stream is independent, so read them in parallel on the task scheduler)
 		size_t nchans = channels.size();
-		char tmp[512];
+		auto readGroup = m_taskScheduler.NewGroup();
+		vector<future<void>> reads;
 		for(size_t i=0; i<nchans; i++)
 		{
+			char tmp[512];
 			auto nchan = channels[i].first;
 			auto nstream = channels[i].second;
 
@@ -700,12 +735,15 @@ bool Session::LoadWaveformDataForScope(
 					nstream);
 			}
 
-			DoLoadWaveformDataForStream(
-				scope->GetOscilloscopeChannel(nchan),
-				nstream,
-				formats[i],
-				tmp);
+			auto chan = scope->GetOscilloscopeChannel(nchan);
+			string fname = tmp;
+			string format = formats[i];
+			reads.push_back(m_taskScheduler.Submit(TaskScheduler::PRIORITY_BACKGROUND,
+				[this, chan, nstream, format, fname]{ DoLoadWaveformDataForStream(chan, nstream, format, fname); },
+				readGroup));
 		}
+		for(auto& f : reads)
+			m_taskScheduler.WaitFor(f, readGroup);
 
 		vector<shared_ptr<Oscilloscope>> temp;
 		temp.push_back(scope);
@@ -912,7 +950,7 @@ bool Session::PreLoadInstruments(int version, const YAML::Node& node, bool onlin
 
 	if(!node)
 	{
-		m_mainWindow->ShowErrorPopup(
+		ShowErrorPopup(
 			"File load error",
 			"The session file is invalid because there is no \"instruments\" section.");
 		return false;
@@ -987,7 +1025,7 @@ bool Session::PreLoadInstruments(int version, const YAML::Node& node, bool onlin
 		//Unknown instrument type - too new file format?
 		else
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"File load error",
 				string("Instrument ") + nick.c_str() + " is of unknown type " + type.c_str());
 			return false;
@@ -1027,7 +1065,7 @@ SCPITransport* Session::CreateTransportForNode(const YAML::Node& node)
 	//Check if the transport failed to initialize
 	if((transport == nullptr) || !transport->IsConnected())
 	{
-		m_mainWindow->ShowErrorPopup(
+		ShowErrorPopup(
 			"Unable to reconnect",
 			string("Failed to connect to instrument using connection string ") + node["args"].as<string>() +
 			"Loading in offline mode.");
@@ -1042,7 +1080,7 @@ bool Session::VerifyInstrument(const YAML::Node& node, shared_ptr<Instrument> in
 	//TODO: preference to enforce serial match?
 	if(node["name"].as<string>() != inst->GetName())
 	{
-		m_mainWindow->ShowErrorPopup(
+		ShowErrorPopup(
 			"Unable to reconnect",
 			string("Unable to connect to oscilloscope: instrument has model name \"") +
 			inst->GetName() + "\", save file has model name \"" + node["name"].as<string>()  + "\"");
@@ -1050,7 +1088,7 @@ bool Session::VerifyInstrument(const YAML::Node& node, shared_ptr<Instrument> in
 	}
 	else if(node["vendor"].as<string>() != inst->GetVendor())
 	{
-		m_mainWindow->ShowErrorPopup(
+		ShowErrorPopup(
 			"Unable to reconnect",
 			string("Unable to connect to oscilloscope: instrument has vendor \"") +
 			inst->GetVendor() + "\", save file has vendor \"" + node["vendor"].as<string>()  + "\"");
@@ -1058,7 +1096,7 @@ bool Session::VerifyInstrument(const YAML::Node& node, shared_ptr<Instrument> in
 	}
 	else if(node["serial"].as<string>() != inst->GetSerial())
 	{
-		m_mainWindow->ShowErrorPopup(
+		ShowErrorPopup(
 			"Unable to reconnect",
 			string("Unable to connect to oscilloscope: instrument has serial \"") +
 			inst->GetSerial() + "\", save file has serial \"" + node["serial"].as<string>()  + "\"");
@@ -1080,7 +1118,7 @@ bool Session::PreLoadOscilloscope(int version, const YAML::Node& node, bool onli
 	{
 		if( (transtype == "null") && (driver != "demo") )
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Unable to reconnect",
 				"The session file does not contain any connection information.\n\n"
 				"Loading in offline mode.");
@@ -1101,7 +1139,7 @@ bool Session::PreLoadOscilloscope(int version, const YAML::Node& node, bool onli
 			{
 				delete transport;
 
-				m_mainWindow->ShowErrorPopup(
+				ShowErrorPopup(
 					"Unable to reconnect",
 					string("Failed to reconnect to oscilloscope at ") + node["args"].as<string>() + ".\n\n"
 					"Loading this instrument in offline mode.");
@@ -1151,7 +1189,7 @@ bool Session::PreLoadVNA(int version, const YAML::Node& node, bool online)
 	{
 		if( (transtype == "null") && (driver != "demo") )
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Unable to reconnect",
 				"The session file does not contain any connection information.\n\n"
 				"Loading in offline mode.");
@@ -1172,7 +1210,7 @@ bool Session::PreLoadVNA(int version, const YAML::Node& node, bool online)
 			{
 				delete transport;
 
-				m_mainWindow->ShowErrorPopup(
+				ShowErrorPopup(
 					"Unable to reconnect",
 					string("Failed to reconnect to oscilloscope at ") + node["args"].as<string>() + ".\n\n"
 					"Loading this instrument in offline mode.");
@@ -1218,7 +1256,7 @@ bool Session::PreLoadLoad(int version, const YAML::Node& node, bool online)
 	{
 		if( (transtype == "null") && (driver != "demoload") )
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Unable to reconnect",
 				"The session file does not contain any connection information.\n\n"
 				"Loading in offline mode.");
@@ -1240,7 +1278,7 @@ bool Session::PreLoadLoad(int version, const YAML::Node& node, bool online)
 			{
 				delete transport;
 
-				m_mainWindow->ShowErrorPopup(
+				ShowErrorPopup(
 					"Unable to reconnect",
 					string("Failed to reconnect to load at ") + node["args"].as<string>() + ".\n\n"
 					"Loading this instrument in offline mode.");
@@ -1290,7 +1328,7 @@ bool Session::PreLoadMisc(int version, const YAML::Node& node, bool online)
 	{
 		if( (transtype == "null") && (driver != "demoload") )
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Unable to reconnect",
 				"The session file does not contain any connection information.\n\n"
 				"Loading in offline mode.");
@@ -1312,7 +1350,7 @@ bool Session::PreLoadMisc(int version, const YAML::Node& node, bool online)
 			{
 				delete transport;
 
-				m_mainWindow->ShowErrorPopup(
+				ShowErrorPopup(
 					"Unable to reconnect",
 					string("Failed to reconnect to miscellaneous instrument at ") + node["args"].as<string>() + ".\n\n"
 					"Loading this instrument in offline mode.");
@@ -1362,7 +1400,7 @@ bool Session::PreLoadBERT(int version, const YAML::Node& node, bool online)
 	{
 		if(transtype == "null")
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Unable to reconnect",
 				"The session file does not contain any connection information.\n\n"
 				"Loading in offline mode.");
@@ -1384,7 +1422,7 @@ bool Session::PreLoadBERT(int version, const YAML::Node& node, bool online)
 			{
 				delete transport;
 
-				m_mainWindow->ShowErrorPopup(
+				ShowErrorPopup(
 					"Unable to reconnect",
 					string("Failed to reconnect to BERT at ") + node["args"].as<string>() + ".\n\n"
 					"Loading this instrument in offline mode.");
@@ -1434,7 +1472,7 @@ bool Session::PreLoadSDR(int version, const YAML::Node& node, bool online)
 	{
 		if( (transtype == "null") && (driver != "demospec") )
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Unable to reconnect",
 				"The session file does not contain any connection information.\n\n"
 				"Loading in offline mode.");
@@ -1456,7 +1494,7 @@ bool Session::PreLoadSDR(int version, const YAML::Node& node, bool online)
 			{
 				delete transport;
 
-				m_mainWindow->ShowErrorPopup(
+				ShowErrorPopup(
 					"Unable to reconnect",
 					string("Failed to reconnect to SDR at ") + node["args"].as<string>() + ".\n\n"
 					"Loading this instrument in offline mode.");
@@ -1506,7 +1544,7 @@ bool Session::PreLoadSpectrometer(int version, const YAML::Node& node, bool onli
 	{
 		if( (transtype == "null") && (driver != "demospec") )
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Unable to reconnect",
 				"The session file does not contain any connection information.\n\n"
 				"Loading in offline mode.");
@@ -1528,7 +1566,7 @@ bool Session::PreLoadSpectrometer(int version, const YAML::Node& node, bool onli
 			{
 				delete transport;
 
-				m_mainWindow->ShowErrorPopup(
+				ShowErrorPopup(
 					"Unable to reconnect",
 					string("Failed to reconnect to spectrometer at ") + node["args"].as<string>() + ".\n\n"
 					"Loading this instrument in offline mode.");
@@ -1578,7 +1616,7 @@ bool Session::PreLoadMultimeter(int version, const YAML::Node& node, bool online
 	{
 		if( (transtype == "null") && (driver != "demometer") )
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Unable to reconnect",
 				"The session file does not contain any connection information.\n\n"
 				"Loading in offline mode.");
@@ -1600,7 +1638,7 @@ bool Session::PreLoadMultimeter(int version, const YAML::Node& node, bool online
 			{
 				delete transport;
 
-				m_mainWindow->ShowErrorPopup(
+				ShowErrorPopup(
 					"Unable to reconnect",
 					string("Failed to reconnect to multimeter at ") + node["args"].as<string>() + ".\n\n"
 					"Loading this instrument in offline mode.");
@@ -1650,7 +1688,7 @@ bool Session::PreLoadPowerSupply(int version, const YAML::Node& node, bool onlin
 	{
 		if( (transtype == "null") && (driver != "demopsu") )
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Unable to reconnect",
 				"The session file does not contain any connection information.\n\n"
 				"Loading in offline mode.");
@@ -1672,7 +1710,7 @@ bool Session::PreLoadPowerSupply(int version, const YAML::Node& node, bool onlin
 			{
 				delete transport;
 
-				m_mainWindow->ShowErrorPopup(
+				ShowErrorPopup(
 					"Unable to reconnect",
 					string("Failed to reconnect to power supply at ") + node["args"].as<string>() + ".\n\n"
 					"Loading this instrument in offline mode.");
@@ -1722,7 +1760,7 @@ bool Session::PreLoadRFSignalGenerator(int version, const YAML::Node& node, bool
 	{
 		if(transtype == "null")
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Unable to reconnect",
 				"The session file does not contain any connection information.\n\n"
 				"Loading in offline mode.");
@@ -1744,7 +1782,7 @@ bool Session::PreLoadRFSignalGenerator(int version, const YAML::Node& node, bool
 			{
 				delete transport;
 
-				m_mainWindow->ShowErrorPopup(
+				ShowErrorPopup(
 					"Unable to reconnect",
 					string("Failed to reconnect to RF signal generator at ") + node["args"].as<string>() + ".\n\n"
 					"Loading this instrument in offline mode.");
@@ -1794,7 +1832,7 @@ bool Session::PreLoadFunctionGenerator(int version, const YAML::Node& node, bool
 	{
 		if(transtype == "null")
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Unable to reconnect",
 				"The session file does not contain any connection information.\n\n"
 				"Loading in offline mode.");
@@ -1816,7 +1854,7 @@ bool Session::PreLoadFunctionGenerator(int version, const YAML::Node& node, bool
 			{
 				delete transport;
 
-				m_mainWindow->ShowErrorPopup(
+				ShowErrorPopup(
 					"Unable to reconnect",
 					string("Failed to reconnect to function generator at ") + node["args"].as<string>() + ".\n\n"
 					"Loading this instrument in offline mode.");
@@ -1988,7 +2026,7 @@ bool Session::LoadFilters(int /*version*/, const YAML::Node& node)
 		auto filter = Filter::CreateFilter(proto, dnode["color"].as<string>());
 		if(filter == NULL)
 		{
-			m_mainWindow->ShowErrorPopup(
+			ShowErrorPopup(
 				"Filter creation failed",
 				string("Unable to create filter \"") + proto + "\". Skipping...\n");
 			continue;
@@ -2203,11 +2241,34 @@ YAML::Node Session::SerializeMarkers()
 	return node;
 }
 
+/**
+	@brief Saves all waveform data to the data directory
+
+	The caller must hold the waveform data mutex, and must call FinishRegionOfInterest() before taking it so persisted
+	filter waveforms cover the entire input rather than just what's on screen.
+ */
 bool Session::SerializeWaveforms(const string& dataDir)
 {
 	//Metadata nodes for each scope
 	std::map<std::shared_ptr<Oscilloscope>, YAML::Node> metadataNodes;
 
+	//Sample data files are independent of each other, so write them in parallel on the task scheduler
+	//while we build up the metadata here
+	auto writeGroup = m_taskScheduler.NewGroup();
+	vector<future<bool>> writes;
+	auto waitForWrites = [&]
+	{
+		bool ok = true;
+		for(auto& f : writes)
+		{
+			m_taskScheduler.WaitFor(f, writeGroup);
+			if(!f.get())
+				ok = false;
+		}
+		writes.clear();
+		return ok;
+	};
+
 	//Serialize data from each history point
 	size_t numwfm = 0;
 	for(auto& hpoint : m_history.m_history)
@@ -2280,7 +2341,9 @@ bool Session::SerializeWaveforms(const string& dataDir)
 					if(sparse)
 					{
 						chnode["format"] = "sparsev1";
-						SerializeSparseWaveform(sparse, datapath);
+						writes.push_back(m_taskScheduler.Submit(TaskScheduler::PRIORITY_BACKGROUND,
+							[this, sparse, datapath]{ return SerializeSparseWaveform(sparse, datapath); },
+							writeGroup));
 
 						//Save type if it's a protocol waveform
 						//so if we do an offline load, we know what type of waveform to make
@@ -2294,7 +2357,9 @@ bool Session::SerializeWaveforms(const string& dataDir)
 					else
 					{
 						chnode["format"] = "densev1";
-						SerializeUniformWaveform(uniform, datapath);
+						writes.push_back(m_taskScheduler.Submit(TaskScheduler::PRIORITY_BACKGROUND,
+							[this, uniform, datapath]{ return SerializeUniformWaveform(uniform, datapath); },
+							writeGroup));
 					}
 
 					mnode["channels"][string("ch") + to_string(i) + "s" + to_string(j)] = chnode;
@@ -2315,7 +2380,10 @@ bool Session::SerializeWaveforms(const string& dataDir)
 
 		ofstream outfs(fname);
 		if(!outfs)
+		{
+			waitForWrites();
 			return false;
+		}
 		outfs << metadataNodes[scope];
 		outfs.close();
 	}
@@ -2384,12 +2452,16 @@ bool Session::SerializeWaveforms(const string& dataDir)
 			if(sparse)
 			{
 				chnode["format"] = "sparsev1";
-				SerializeSparseWaveform(sparse, datapath);
+				writes.push_back(m_taskScheduler.Submit(TaskScheduler::PRIORITY_BACKGROUND,
+					[this, sparse, datapath]{ return SerializeSparseWaveform(sparse, datapath); },
+					writeGroup));
 			}
 			else
 			{
 				chnode["format"] = "densev1";
-				SerializeUniformWaveform(uniform, datapath);
+				writes.push_back(m_taskScheduler.Submit(TaskScheduler::PRIORITY_BACKGROUND,
+					[this, uniform, datapath]{ return SerializeUniformWaveform(uniform, datapath); },
+					writeGroup));
 			}
 
 			mnode["streams"][string("s") + to_string(j)] = chnode;
@@ -2401,11 +2473,14 @@ bool Session::SerializeWaveforms(const string& dataDir)
 	string fname = dataDir + "/filter_metadata.yml";
 	ofstream outfs(fname);
 	if(!outfs)
+	{
+		waitForWrites();
 		return false;
+	}
 	outfs << filterNode;
 	outfs.close();
 
-	return true;
+	return waitForWrites();
 }
 
 /**
@@ -2773,6 +2848,10 @@ void Session::ApplyPreferences(shared_ptr<Oscilloscope> scope)
  */
 void Session::StartWaveformThreadIfNeeded()
 {
+	//In headless mode, the caller drives waveform processing directly via ProcessPendingWaveforms()
+	if(IsHeadless())
+		return;
+
 	if(m_waveformThread == nullptr)
 		m_waveformThread = make_unique<thread>(WaveformThread, this, &m_shuttingDown);
 }
@@ -2829,7 +2908,7 @@ void Session::CreateAndAddInstrument(const string& driver, SCPITransport* transp
 	//If we couldn't make it, abort
 	if(!inst)
 	{
-		m_mainWindow->ShowErrorPopup(
+		ShowErrorPopup(
 			"Driver error",
 			"Failed to create instrument driver instance of type \"" + driver + "\"");
 		delete transport;
@@ -2860,6 +2939,7 @@ void Session::AddInstrument(shared_ptr<Instrument> inst, bool createDialogs)
 
 	auto si = dynamic_pointer_cast<SCPIInstrument>(inst);
 	InstrumentThreadArgs args(si, this);
+	args.schedule = make_shared<InstrumentPollSchedule>();
 
 	//Create shared state, if needed
 	auto psu = dynamic_pointer_cast<SCPIPowerSupply>(inst);
@@ -2870,6 +2950,7 @@ void Session::AddInstrument(shared_ptr<Instrument> inst, bool createDialogs)
 	auto rfgen = dynamic_pointer_cast<SCPIRFSignalGenerator>(inst);
 	auto scope = dynamic_pointer_cast<Oscilloscope>(inst);
 	auto types = inst->GetInstrumentTypes();
+	UpdatePollSchedule(inst, args.schedule);
 	if(psu && (types & Instrument::INST_PSU) )
 	{
 		auto state = make_shared<PowerSupplyState>(psu->GetChannelCount());
@@ -2913,7 +2994,7 @@ void Session::AddInstrument(shared_ptr<Instrument> inst, bool createDialogs)
 		m_instrumentStates[inst] = make_shared<InstrumentConnectionState>(args);
 
 	//Spawn dialogs/views if requested
-	if(createDialogs)
+	if(createDialogs && m_mainWindow)
 	{
 		if(psu && (types & Instrument::INST_PSU) )
 			m_mainWindow->AddDialog(make_shared<PowerSupplyDialog>(psu, args.psustate, this));
@@ -2935,12 +3016,14 @@ void Session::AddInstrument(shared_ptr<Instrument> inst, bool createDialogs)
 	}
 	if(scope)
 	{
-		m_mainWindow->OnScopeAdded(scope, createDialogs);
+		if(m_mainWindow)
+			m_mainWindow->OnScopeAdded(scope, createDialogs);
 		if(!scope->IsOffline())
 			MakeNewTriggerGroup(scope);
 	}
 
-	m_mainWindow->AddToRecentInstrumentList(si);
+	if(m_mainWindow)
+		m_mainWindow->AddToRecentInstrumentList(si);
 
 	StartWaveformThreadIfNeeded();
 }
@@ -2979,7 +3062,51 @@ void Session::RemoveInstrument(shared_ptr<Instrument> inst)
  */
 void Session::AddMultimeterDialog(shared_ptr<SCPIMultimeter> meter)
 {
-	m_mainWindow->AddDialog(make_shared<MultimeterDialog>(meter, m_meters[meter], this));
+	if(m_mainWindow)
+		m_mainWindow->AddDialog(make_shared<MultimeterDialog>(meter, m_meters[meter], this));
+}
+
+/**
+	@brief Applies the polling interval preferences to every connected instrument, if they changed since the last call
+
+	Intervals are atomic, so this is safe to call while the instrument threads are running.
+ */
+void Session::UpdatePollIntervals()
+{
+	auto measurementInterval = m_preferences.GetReal("Drivers.Polling.measurement_interval");
+	auto statusInterval = m_preferences.GetReal("Drivers.Polling.status_interval");
+	if( (measurementInterval == m_appliedMeasurementInterval) && (statusInterval == m_appliedStatusInterval) )
+		return;
+	m_appliedMeasurementInterval = measurementInterval;
+	m_appliedStatusInterval = statusInterval;
+
+	lock_guard<mutex> lock(m_scopeMutex);
+
+	for(auto& it : m_instrumentStates)
+	{
+		if(it.second->m_pollSchedule)
+			UpdatePollSchedule(it.first, it.second->m_pollSchedule);
+	}
+}
+
+/**
+	@brief Sets the polling intervals for one instrument from the current preferences
+
+	Only quantities the instrument actually has are rate limited; everything else is polled on every pass.
+
+	@param inst		The instrument being polled
+	@param schedule	Poll schedule for the instrument
+ */
+void Session::UpdatePollSchedule(shared_ptr<Instrument> inst, shared_ptr<InstrumentPollSchedule> schedule)
+{
+	auto types = inst->GetInstrumentTypes();
+	auto measurementInterval = m_preferences.GetReal("Drivers.Polling.measurement_interval") / FS_PER_SECOND;
+	auto statusInterval = m_preferences.GetReal("Drivers.Polling.status_interval") / FS_PER_SECOND;
+
+	if(types & (Instrument::INST_PSU | Instrument::INST_DMM | Instrument::INST_LOAD) )
+		schedule->SetInterval(InstrumentPollSchedule::POLL_MEASUREMENT, measurementInterval);
+	if(types & Instrument::INST_PSU)
+		schedule->SetInterval(InstrumentPollSchedule::POLL_STATUS, statusInterval);
 }
 
 /**
@@ -3064,11 +3191,115 @@ set<shared_ptr<Instrument>> Session::GetInstruments()
 /**
 	@brief Arms the trigger for all trigger groups
 
+	Arming can take several seconds if a secondary instrument is slow to respond, so if the waveform thread is running
+	the request is handed off to it and this returns immediately.
+
 	@param type		Type of trigger to start
 	@param all		If true, arm all groups in the sesison.
 					If false, only stop groups with the "default" flag set
+
+	@return False if arming was attempted right away and failed
+ */
+bool Session::ArmTrigger(TriggerGroup::TriggerType type, bool all)
+{
+	if(m_waveformThread)
+	{
+		SubmitArmRequest(TriggerArmRequest(nullptr, type, all, false));
+		return true;
+	}
+
+	return DoArmTrigger(type, all);
+}
+
+/**
+	@brief Arms the trigger for a single trigger group
+
+	Like ArmTrigger(), this is done on the waveform thread if it's running.
  */
-void Session::ArmTrigger(TriggerGroup::TriggerType type, bool all)
+void Session::ArmTriggerGroup(shared_ptr<TriggerGroup> group, TriggerGroup::TriggerType type)
+{
+	SubmitArmRequest(TriggerArmRequest(group, type, false, false));
+}
+
+/**
+	@brief Re-arms any of the given groups that are in multi-scope free-run mode
+
+	Called after each set of waveforms has been committed to history.
+ */
+void Session::RearmIfMultiScope(const set<shared_ptr<TriggerGroup>>& groups)
+{
+	for(auto group : groups)
+		SubmitArmRequest(TriggerArmRequest(group, TriggerGroup::TRIGGER_TYPE_NORMAL, false, true));
+}
+
+/**
+	@brief Queues an arm request for the waveform thread, or carries it out immediately if there isn't one
+ */
+void Session::SubmitArmRequest(const TriggerArmRequest& req)
+{
+	if(!m_waveformThread)
+	{
+		RunArmRequest(req);
+		return;
+	}
+
+	lock_guard<mutex> lock(m_pendingArmMutex);
+	m_pendingArmRequests.push_back(req);
+}
+
+/**
+	@brief Carries out all queued arm requests
+
+	Called by the waveform thread.
+ */
+void Session::ProcessPendingArmRequests()
+{
+	vector<TriggerArmRequest> reqs;
+	{
+		lock_guard<mutex> lock(m_pendingArmMutex);
+		reqs.swap(m_pendingArmRequests);
+	}
+
+	for(auto& req : reqs)
+		RunArmRequest(req);
+}
+
+/**
+	@brief Arms the trigger for the whole session or one group, as requested
+ */
+void Session::RunArmRequest(const TriggerArmRequest& req)
+{
+	if(!req.m_group)
+	{
+		DoArmTrigger(req.m_type, req.m_all);
+		return;
+	}
+
+	auto generation = m_stopGeneration.load();
+	bool armed;
+	if(req.m_rearm)
+		armed = req.m_group->RearmIfMultiScope();
+	else
+		armed = req.m_group->Arm(req.m_type);
+
+	//A group that stopped free-running because it failed to re-arm means the session isn't acquiring any more
+	if(req.m_rearm && !armed)
+		m_triggerArmed = false;
+
+	//If the trigger was stopped while we were arming, don't leave the group running
+	if(armed && (generation != m_stopGeneration) )
+	{
+		lock_guard<shared_mutex> lock(m_waveformDataMutex);
+		req.m_group->Stop();
+	}
+}
+
+/**
+	@brief Arms the trigger for all trigger groups (default ones only, unless all is set)
+
+	@return True if every group armed successfully
+ */
+bool Session::DoArmTrigger(TriggerGroup::TriggerType type, bool all)
 {
 	LogTrace("Arming trigger\n");
 	LogIndenter li;
@@ -3080,7 +3311,7 @@ void Session::ArmTrigger(TriggerGroup::TriggerType type, bool all)
 	{
 		m_tArm = GetTime();
 		m_triggerArmed = true;
-		return;
+		return true;
 	}
 
 	m_tPrimaryTrigger = -1;
@@ -3094,19 +3325,43 @@ void Session::ArmTrigger(TriggerGroup::TriggerType type, bool all)
 		ensure that the primary doesn't trigger until the secondaries are ready for the event.
 	*/
 
-	//Arm each trigger group (if it's defaulted)
+	//Find the groups to arm. Don't hold m_triggerGroupMutex while arming them: TriggerGroup::Arm() takes the
+	//waveform data mutex, and StopTrigger() locks the two in the opposite order.
+	vector<shared_ptr<TriggerGroup>> groups;
 	{
 		lock_guard<recursive_mutex> lock(m_triggerGroupMutex);
 		for(auto& group : m_triggerGroups)
 		{
 			if(group->m_default || all)
-				group->Arm(type);
+				groups.push_back(group);
 		}
 	}
 
+	//Arm each trigger group
+	auto generation = m_stopGeneration.load();
+	for(auto& group : groups)
+	{
+		//If a group fails to arm, don't leave the others running with the trigger shown as stopped
+		if(!group->Arm(type))
+		{
+			LogTrace("Arming failed, stopping trigger\n");
+			StopTrigger(all);
+			return false;
+		}
+	}
+
+	//If the trigger was stopped while we were arming, undo whatever we armed after the stop
+	if(generation != m_stopGeneration)
+	{
+		LogTrace("Trigger was stopped while arming\n");
+		StopTrigger(all);
+		return false;
+	}
+
 	LogTrace("All instruments are armed\n");
 	m_tArm = GetTime();
 	m_triggerArmed = true;
+	return true;
 }
 
 /**
@@ -3119,6 +3374,13 @@ void Session::StopTrigger(bool all)
 {
 	m_triggerArmed = false;
 
+	//Discard any arm requests that haven't been carried out yet, and abort one in progress
+	m_stopGeneration ++;
+	{
+		lock_guard<mutex> lock(m_pendingArmMutex);
+		m_pendingArmRequests.clear();
+	}
+
 	lock_guard<shared_mutex> lock(m_waveformDataMutex);
 	lock_guard<recursive_mutex> lock2(m_triggerGroupMutex);
 	for(auto& group : m_triggerGroups)
@@ -3166,6 +3428,8 @@ bool Session::CheckForPendingWaveforms()
  */
 void Session::DownloadWaveforms()
 {
+	PerfEventScope perf(PERF_DOWNLOAD);
+
 	{
 		lock_guard<mutex> lock(m_perfClockMutex);
 		m_waveformDownloadRate.Tick();
@@ -3175,6 +3439,9 @@ void Session::DownloadWaveforms()
 	lock_guard<mutex> lock2(m_scopeMutex);
 	lock_guard<recursive_mutex> lock3(m_triggerGroupMutex);
 
+	//Filter outputs will no longer match any history point once they're re-run on the new data
+	m_history.OnNewWaveformsDownloaded();
+
 	//Get the data from each  trigger group
 	for(auto group : m_triggerGroups)
 	{
@@ -3198,6 +3465,62 @@ void Session::DownloadWaveforms()
 		m_triggerArmed = false;
 }
 
+/**
+	@brief Headless equivalent of the WaveformThread / CheckForWaveforms() pipeline
+
+	Downloads waveforms if all scopes in a trigger group have data, runs the filter graph, commits the result to
+	history, and re-arms multi-scope groups. No rendering or tone mapping is done.
+
+	@return True if a new waveform came in, false if not
+ */
+bool Session::ProcessPendingWaveforms()
+{
+	if(!AcquirePendingWaveforms())
+		return false;
+
+	CommitWaveformsToHistory();
+	return true;
+}
+
+/**
+	@brief Downloads waveforms if all scopes in a trigger group have data, then runs the filter graph on them
+
+	@return True if a new waveform came in, false if not
+ */
+bool Session::AcquirePendingWaveforms()
+{
+	if(!CheckForPendingWaveforms())
+		return false;
+
+	DownloadWaveforms();
+	RefreshAllFilters();
+	return true;
+}
+
+/**
+	@brief Adds the most recently downloaded waveforms to history, then re-arms multi-scope groups that triggered
+ */
+void Session::CommitWaveformsToHistory()
+{
+	vector<shared_ptr<Oscilloscope>> scopes;
+	set<shared_ptr<TriggerGroup>> groups;
+	{
+		shared_lock<shared_mutex> lock2(m_waveformDataMutex);
+		lock_guard<mutex> lock(m_recentlyTriggeredScopeMutex);
+		for(auto scope : m_recentlyTriggeredScopes)
+			scopes.push_back(scope);
+		m_recentlyTriggeredScopes.clear();
+
+		groups = m_recentlyTriggeredGroups;
+		m_recentlyTriggeredGroups.clear();
+
+		m_history.AddHistory(scopes);
+	}
+
+	//In multi-scope free-run mode, re-arm every instrument's trigger after we've processed all data
+	RearmIfMultiScope(groups);
+}
+
 /**
 	@brief Check if new waveform data has arrived
 
@@ -3205,31 +3528,23 @@ void Session::DownloadWaveforms()
 
 	TODO: this might be best to move to MainWindow?
 
+	@param cmdbuf				Command buffer for tone mapping
+	@param acceptNewWaveforms	If false, a newly arrived waveform is left pending (and the waveform thread waiting)
+								until a later call. Re-rendered waveforms are still tone mapped.
+
 	@return True if a new waveform came in, false if not
  */
-bool Session::CheckForWaveforms(vk::raii::CommandBuffer& cmdbuf)
+bool Session::CheckForWaveforms(vk::raii::CommandBuffer& cmdbuf, bool acceptNewWaveforms)
 {
 	bool hadNewWaveforms = false;
 
-	if(g_waveformReadyEvent.Peek())
+	if(acceptNewWaveforms && g_waveformReadyEvent.Peek())
 	{
 		LogTrace("Waveform is ready\n");
 
-		//Add to history
-		vector<shared_ptr<Oscilloscope>> scopes;
-		set<shared_ptr<TriggerGroup>> groups;
-		{
-			shared_lock<shared_mutex> lock2(m_waveformDataMutex);
-			lock_guard<mutex> lock(m_recentlyTriggeredScopeMutex);
-			for(auto scope : m_recentlyTriggeredScopes)
-				scopes.push_back(scope);
-			m_recentlyTriggeredScopes.clear();
-
-			groups = m_recentlyTriggeredGroups;
-			m_recentlyTriggeredGroups.clear();
-
-			m_history.AddHistory(scopes);
-		}
+		//Add to history.
+		//Re-arm requests are carried out by the waveform thread, so they won't happen until we release it below.
+		CommitWaveformsToHistory();
 
 		//Tone-map all of our waveforms
 		//Generally does not need waveform data locked since it only works on *rendered* data...
@@ -3243,10 +3558,6 @@ bool Session::CheckForWaveforms(vk::raii::CommandBuffer& cmdbuf)
 
 		//Release the waveform processing thread
 		g_waveformProcessedEvent.Signal();
-
-		//In multi-scope free-run mode, re-arm every instrument's trigger after we've processed all data
-		for(auto group : groups)
-			group->RearmIfMultiScope();
 	}
 
 	//If a re-render operation completed, tone map everything again
@@ -3328,14 +3639,34 @@ void Session::RefreshAllFilters()
 		//Must lock mutexes in this order to avoid deadlock
 		lock_guard<shared_mutex> lock(m_waveformDataMutex);
 		//shared_lock<shared_mutex> lock3(g_vulkanActivityMutex);
-		m_graphExecutor.RunBlocking(nodes);
-		UpdatePacketManagers(nodes);
-	}
 
-	m_lastFilterGraphExecTime = (GetTime() - tstart) * FS_PER_SECOND;
-	{
-		lock_guard<mutex> lock(m_lastFilterGraphRuntimeMutex);
-		m_lastFilterGraphRuntimeStats = m_graphExecutor.GetRunTimes();
+		//Only run the part of the graph somebody is actually looking at
+		auto demanded = GetDemandedNodes(nodes);
+		vector<pair<StreamDescriptor, WaveformBase*>> originals;
+		bool cropped = CropToRegionOfInterest(demanded, originals);
+		m_graphExecutor.RunBlocking(demanded);
+		RestoreFromRegionOfInterest(originals);
+		UpdatePacketManagers(nodes, demanded);
+
+		//Everything else is now out of date
+		bool skipped;
+		{
+			lock_guard<mutex> lock2(m_consumersMutex);
+			m_staleNodes.clear();
+			for(auto node : nodes)
+			{
+				if(demanded.find(node) == demanded.end())
+					m_staleNodes.emplace(node);
+			}
+			m_skippedFilterCount = m_staleNodes.size();
+			skipped = !m_staleNodes.empty();
+		}
+
+		//Outputs are only worth caching if every filter ran over its whole input
+		m_history.OnFiltersRefreshed(!cropped && !skipped);
+
+		//Record stats while still holding the waveform data lock, so no filters can be deleted out from under us
+		RecordFilterGraphStats(demanded, tstart);
 	}
 }
 
@@ -3384,17 +3715,81 @@ bool Session::RefreshDirtyFilters()
 		//Must lock mutexes in this order to avoid deadlock
 		lock_guard<shared_mutex> lock(m_waveformDataMutex);
 		shared_lock<shared_mutex> lock3(g_vulkanActivityMutex);
+
+		//Skip anything nobody is looking at, but remember it's out of date
+		auto allNodes = GetAllGraphNodes();
+		auto all = nodesToUpdate;
+		nodesToUpdate = GetDemandedNodes(all);
+		{
+			lock_guard<mutex> lock2(m_consumersMutex);
+			for(auto node : all)
+			{
+				if(nodesToUpdate.find(node) == nodesToUpdate.end())
+					m_staleNodes.emplace(node);
+			}
+
+			//Forget about anything skipped earlier that has since been deleted
+			for(auto it = m_staleNodes.begin(); it != m_staleNodes.end(); )
+			{
+				if(allNodes.find(*it) == allNodes.end())
+					it = m_staleNodes.erase(it);
+				else
+					it ++;
+			}
+			m_skippedFilterCount = m_staleNodes.size();
+		}
+
+		vector<pair<StreamDescriptor, WaveformBase*>> originals;
+		CropToRegionOfInterest(nodesToUpdate, originals);
 		m_graphExecutor.RunBlocking(nodesToUpdate);
-		UpdatePacketManagers(nodesToUpdate);
+		RestoreFromRegionOfInterest(originals);
+		UpdatePacketManagers(allNodes, nodesToUpdate);
+
+		//Only part of the graph was re-run, so the outputs no longer match the loaded history point
+		m_history.OnFiltersRefreshed(false);
+
+		//Record stats while still holding the waveform data lock, so no filters can be deleted out from under us
+		RecordFilterGraphStats(nodesToUpdate, tstart);
 	}
 
+	return true;
+}
+
+/**
+	@brief Snapshots runtime and output size of each filter after a graph execution
+
+	Must be called with the waveform data mutex held exclusively, so the filters and their outputs can't change under
+	us. The GUI reads the snapshot every frame without having to touch the waveform data mutex.
+
+	@param nodes	Nodes that were executed
+	@param tstart	Timestamp the execution started at
+ */
+void Session::RecordFilterGraphStats(const set<FlowGraphNode*>& nodes, double tstart)
+{
 	m_lastFilterGraphExecTime = (GetTime() - tstart) * FS_PER_SECOND;
+
+	lock_guard<mutex> lock(m_lastFilterGraphRuntimeMutex);
+	m_lastFilterGraphRuntimeStats = m_graphExecutor.GetRunTimes();
+
+	m_lastFilterGraphSampleCounts.clear();
+	for(auto it : m_lastFilterGraphRuntimeStats)
 	{
-		lock_guard<mutex> lock(m_lastFilterGraphRuntimeMutex);
-		m_lastFilterGraphRuntimeStats = m_graphExecutor.GetRunTimes();
+		auto chan = dynamic_cast<InstrumentChannel*>(it.first);
+		if(!chan)
+			continue;
+
+		size_t samples = 0;
+		for(size_t i=0; i<chan->GetStreamCount(); i++)
+		{
+			auto data = chan->GetData(i);
+			if(data)
+				samples += data->size();
+		}
+		m_lastFilterGraphSampleCounts[it.first] = samples;
 	}
 
-	return true;
+	m_filterGraphTimeline.RecordRun(
+		nodes, m_lastFilterGraphRuntimeStats, tstart, m_lastFilterGraphExecTime, m_graphExecutorThreads);
 }
 
 /**
@@ -3406,6 +3801,442 @@ void Session::MarkChannelDirty(InstrumentChannel* chan)
 	m_dirtyChannels.emplace(chan);
 }
 
+/**
+	@brief Registers a consumer of a graph node's output (a displayed channel, measurement, protocol analyzer, etc)
+
+	Filters with no consumers, directly or via downstream filters, are skipped during graph execution. If the node
+	was skipped in a previous run, it and everything stale upstream of it are marked dirty so they get computed before
+	being displayed.
+ */
+void Session::AddConsumer(FlowGraphNode* node)
+{
+	if(!node)
+		return;
+
+	set<FlowGraphNode*> nodesToRefresh;
+	{
+		lock_guard<mutex> lock(m_consumersMutex);
+		if(m_consumers[node] ++ != 0)
+			return;
+
+		//First consumer. Find anything we skipped that this node depends on
+		set<FlowGraphNode*> visited;
+		vector<FlowGraphNode*> work = { node };
+		while(!work.empty())
+		{
+			auto n = work.back();
+			work.pop_back();
+			if(visited.find(n) != visited.end())
+				continue;
+			visited.emplace(n);
+
+			if(m_staleNodes.erase(n))
+				nodesToRefresh.emplace(n);
+
+			for(size_t i=0; i<n->GetInputCount(); i++)
+			{
+				auto upstream = n->GetInput(i).m_channel;
+				if(upstream)
+					work.push_back(upstream);
+			}
+		}
+	}
+
+	if(!nodesToRefresh.empty())
+	{
+		lock_guard<mutex> lock(m_dirtyChannelsMutex);
+		for(auto n : nodesToRefresh)
+			m_dirtyChannels.emplace(n);
+	}
+}
+
+/**
+	@brief Unregisters a consumer previously added by AddConsumer()
+ */
+void Session::RemoveConsumer(FlowGraphNode* node)
+{
+	if(!node)
+		return;
+
+	lock_guard<mutex> lock(m_consumersMutex);
+	auto it = m_consumers.find(node);
+	if(it == m_consumers.end())
+	{
+		LogWarning("Session::RemoveConsumer: node has no consumers\n");
+		return;
+	}
+	if(--it->second == 0)
+		m_consumers.erase(it);
+}
+
+/**
+	@brief Figures out which nodes in a set need to be evaluated
+
+	A node is in demand if it has a consumer, or is upstream of one via graph edges. Instrument channels and export
+	filters (which have side effects) are always included.
+
+	@param nodes	The nodes being considered for evaluation
+
+	@return The subset of nodes which should actually be run
+ */
+set<FlowGraphNode*> Session::GetDemandedNodes(const set<FlowGraphNode*>& nodes)
+{
+	//Headless sessions write out results for every filter, so run everything
+	if(IsHeadless() || !m_preferences.GetBool("Miscellaneous.Filter Graph.demand_driven_evaluation"))
+		return nodes;
+
+	//Find the sinks
+	auto all = GetAllGraphNodes();
+	vector<FlowGraphNode*> work;
+	{
+		lock_guard<mutex> lock(m_consumersMutex);
+		for(auto node : all)
+		{
+			auto f = dynamic_cast<Filter*>(node);
+			if(!f || (f->GetCategory() == Filter::CAT_EXPORT) || (m_consumers.find(node) != m_consumers.end()) )
+				work.push_back(node);
+		}
+	}
+
+	//Walk upstream from them along graph edges.
+	//Nodes outside the set being evaluated aren't returned, but we still need to walk through them.
+	set<FlowGraphNode*> visited;
+	set<FlowGraphNode*> demanded;
+	while(!work.empty())
+	{
+		auto node = work.back();
+		work.pop_back();
+		if(visited.find(node) != visited.end())
+			continue;
+		visited.emplace(node);
+
+		if(nodes.find(node) != nodes.end())
+			demanded.emplace(node);
+
+		for(size_t i=0; i<node->GetInputCount(); i++)
+		{
+			auto upstream = node->GetInput(i).m_channel;
+			if(upstream)
+				work.push_back(upstream);
+		}
+	}
+
+	return demanded;
+}
+
+/**
+	@brief Filters which can be evaluated over just the visible part of their input
+
+	These compute each output sample from input samples at (or very close to) the same point in time. The value is
+	the number of extra input samples needed on either side of the region of interest.
+ */
+static const map<string, int64_t> g_roiCapableFilters =
+{
+	{ "Add",		0 },
+	{ "Divide",		0 },
+	{ "Multiply",	0 },
+	{ "Scale",		0 },
+	{ "Subtract",	0 },
+	{ "Threshold",	0 },
+	{ "Upsample",	128 }
+};
+
+/**
+	@brief Makes a copy of part of a uniformly sampled waveform
+ */
+template<class T>
+static T* CropUniformWaveform(T* wfm, size_t start, size_t end)
+{
+	auto ret = new T;
+	ret->m_timescale = wfm->m_timescale;
+	ret->m_startTimestamp = wfm->m_startTimestamp;
+	ret->m_startFemtoseconds = wfm->m_startFemtoseconds;
+	ret->m_triggerPhase = wfm->m_triggerPhase + start*wfm->m_timescale;
+	ret->m_flags = wfm->m_flags;
+
+	size_t len = end - start;
+	ret->Resize(len);
+	wfm->PrepareForCpuAccess();
+	ret->PrepareForCpuAccess();
+	memcpy(ret->m_samples.GetCpuPointer(), wfm->m_samples.GetCpuPointer() + start, len*sizeof(ret->m_samples[0]));
+	ret->MarkModifiedFromCpu();
+
+	return ret;
+}
+
+/**
+	@brief Called every frame with the X axis range visible in each time domain waveform view
+
+	If the last graph execution only computed some filters over part of their input, and the user has since panned or
+	zoomed outside that part, the graph is re-run.
+ */
+void Session::UpdateVisibleRanges(const map<FlowGraphNode*, VisibleRange>& ranges)
+{
+	lock_guard<mutex> lock(m_roiMutex);
+	m_visibleRanges = ranges;
+
+	if(m_roiNodes.empty())
+		return;
+
+	bool refresh = !m_preferences.GetBool("Miscellaneous.Filter Graph.region_of_interest");
+	for(auto node : m_roiNodes)
+	{
+		auto it = ranges.find(node);
+		if(it == ranges.end())
+			continue;
+		if( (it->second.m_start < m_roiComputedRange.first) || (it->second.m_end > m_roiComputedRange.second) )
+			refresh = true;
+	}
+
+	if(refresh)
+	{
+		LogTrace("View moved outside region of interest, re-running filter graph\n");
+		m_roiNodes.clear();
+		RefreshAllFiltersNonblocking();
+	}
+}
+
+/**
+	@brief Temporarily replaces instrument waveforms with copies cropped to the region of interest
+
+	An instrument channel feeding the set being evaluated is cropped only if every filter in the set downstream of
+	it is ROI-capable, and is consumed only by time domain waveform views. The region of interest is the union of all
+	views of those filters, widened by half a screen on either side so small pans don't trigger a re-run, plus the
+	largest margin needed along any chain of filters from the channel.
+
+	All cropped channels use the same sample window, so filters combining several inputs stay sample aligned.
+
+	The caller must hold the waveform data mutex exclusively, and call RestoreFromRegionOfInterest() once the graph
+	has been run.
+
+	@param nodes		The nodes about to be evaluated
+	@param originals	Receives the original (uncropped) waveforms, to be restored afterwards
+
+	@return True if anything was cropped
+ */
+bool Session::CropToRegionOfInterest(
+	const set<FlowGraphNode*>& nodes,
+	vector<pair<StreamDescriptor, WaveformBase*>>& originals)
+{
+	lock_guard<mutex> lock(m_roiMutex);
+
+	//Anything being re-run is no longer partially computed (unless we decide to crop it again below)
+	for(auto node : nodes)
+		m_roiNodes.erase(node);
+
+	if(IsHeadless() || m_roiSuspended || !m_preferences.GetBool("Miscellaneous.Filter Graph.region_of_interest"))
+		return false;
+
+	//The instrument channels feeding the filters being evaluated are the candidates for cropping.
+	//(On a partial refresh the channels themselves aren't being re-run, so look at filter inputs rather than nodes.)
+	set<InstrumentChannel*> candidates;
+	for(auto node : nodes)
+	{
+		if(!dynamic_cast<Filter*>(node))
+			continue;
+		for(size_t i=0; i<node->GetInputCount(); i++)
+		{
+			auto upstream = node->GetInput(i).m_channel;
+			if(upstream && !dynamic_cast<Filter*>(upstream))
+				candidates.emplace(upstream);
+		}
+	}
+
+	//Find instrument channels whose downstream filters can all be evaluated over a partial region
+	vector<InstrumentChannel*> sources;
+	set<FlowGraphNode*> roiNodes;
+	int64_t xstart = INT64_MAX;
+	int64_t xend = INT64_MIN;
+	int64_t margin = 0;
+	{
+		lock_guard<mutex> lock2(m_consumersMutex);
+		for(auto chan : candidates)
+		{
+			//Walk the filters being evaluated that see the cropped data, directly or via another such filter.
+			//Each one's margin is its own plus the largest of its inputs', so parallel consumers of the same
+			//source don't add up but filters chained one after another do.
+			map<FlowGraphNode*, int64_t> downstream;
+			bool ok = true;
+			bool changed = true;
+			while(ok && changed)
+			{
+				changed = false;
+				for(auto n : nodes)
+				{
+					auto f = dynamic_cast<Filter*>(n);
+					if(!f)
+						continue;
+
+					bool affected = false;
+					int64_t inputMargin = 0;
+					for(size_t i=0; i<f->GetInputCount(); i++)
+					{
+						auto upstream = f->GetInput(i).m_channel;
+						if(upstream == chan)
+							affected = true;
+						else
+						{
+							auto it = downstream.find(upstream);
+							if(it != downstream.end())
+							{
+								affected = true;
+								inputMargin = max(inputMargin, it->second);
+							}
+						}
+					}
+					if(!affected)
+						continue;
+
+					auto it = g_roiCapableFilters.find(f->GetProtocolDisplayName());
+					if(it == g_roiCapableFilters.end())
+					{
+						ok = false;
+						break;
+					}
+
+					int64_t filterMargin = inputMargin + it->second;
+					auto jt = downstream.find(f);
+					if( (jt == downstream.end()) || (jt->second < filterMargin) )
+					{
+						downstream[f] = filterMargin;
+						changed = true;
+					}
+				}
+			}
+			if(!ok)
+				continue;
+
+			bool visible = false;
+			int64_t chanMargin = 0;
+			int64_t chanStart = INT64_MAX;
+			int64_t chanEnd = INT64_MIN;
+			for(auto it : downstream)
+			{
+				chanMargin = max(chanMargin, it.second);
+
+				//Anything other than a waveform view (measurements, protocol analyzer, etc) needs the whole thing
+				auto jt = m_consumers.find(it.first);
+				size_t consumers = (jt == m_consumers.end()) ? 0 : jt->second;
+				auto kt = m_visibleRanges.find(it.first);
+				size_t views = (kt == m_visibleRanges.end()) ? 0 : kt->second.m_views;
+				if(consumers != views)
+				{
+					ok = false;
+					break;
+				}
+				if(views)
+				{
+					visible = true;
+					chanStart = min(chanStart, kt->second.m_start);
+					chanEnd = max(chanEnd, kt->second.m_end);
+				}
+			}
+			if(!ok || !visible)
+				continue;
+
+			sources.push_back(chan);
+			for(auto it : downstream)
+				roiNodes.emplace(it.first);
+			xstart = min(xstart, chanStart);
+			xend = max(xend, chanEnd);
+			margin = max(margin, chanMargin);
+		}
+	}
+	if(sources.empty())
+		return false;
+
+	//Add some hysteresis
+	int64_t span = xend - xstart;
+	xstart -= span/2;
+	xend += span/2;
+
+	//Convert to a sample window covering the region in every source
+	int64_t istart = INT64_MAX;
+	int64_t iend = INT64_MIN;
+	size_t minlen = SIZE_MAX;
+	vector<StreamDescriptor> streams;
+	for(auto chan : sources)
+	{
+		for(size_t i=0; i<chan->GetStreamCount(); i++)
+		{
+			StreamDescriptor stream(chan, i);
+			auto data = stream.GetData();
+			if(!dynamic_cast<UniformAnalogWaveform*>(data) && !dynamic_cast<UniformDigitalWaveform*>(data))
+				continue;
+			if(data->empty())
+				continue;
+
+			streams.push_back(stream);
+			istart = min(istart, (xstart - data->m_triggerPhase) / data->m_timescale - margin);
+			iend = max(iend, (xend - data->m_triggerPhase) / data->m_timescale + margin + 1);
+			minlen = min(minlen, data->size());
+		}
+	}
+	if(streams.empty())
+		return false;
+	istart = max(istart, (int64_t)0);
+	iend = min(iend, (int64_t)minlen);
+
+	//Not worth it if we'd still process most of the waveform
+	if( (iend <= istart) || ( (iend - istart) > (int64_t)(minlen / 2) ) )
+		return false;
+
+	LogTrace("Cropping %zu streams to samples %" PRId64 " - %" PRId64 " for region of interest evaluation\n",
+		streams.size(), istart, iend);
+
+	for(auto stream : streams)
+	{
+		auto data = stream.GetData();
+		WaveformBase* crop = nullptr;
+		if(auto udata = dynamic_cast<UniformAnalogWaveform*>(data))
+			crop = CropUniformWaveform(udata, istart, iend);
+		else if(auto ddata = dynamic_cast<UniformDigitalWaveform*>(data))
+			crop = CropUniformWaveform(ddata, istart, iend);
+
+		originals.push_back(pair<StreamDescriptor, WaveformBase*>(stream, stream.m_channel->Detach(stream.m_stream)));
+		stream.m_channel->SetData(crop, stream.m_stream);
+	}
+
+	//If other filters are still partially computed from an earlier run, only the overlap is valid for all of them
+	if(m_roiNodes.empty())
+		m_roiComputedRange = pair<int64_t, int64_t>(xstart, xend);
+	else
+	{
+		m_roiComputedRange.first = max(m_roiComputedRange.first, xstart);
+		m_roiComputedRange.second = min(m_roiComputedRange.second, xend);
+	}
+	m_roiNodes.insert(roiNodes.begin(), roiNodes.end());
+	return true;
+}
+
+/**
+	@brief Re-runs the filter graph over full waveforms if anything was last computed over only a region of interest
+ */
+void Session::FinishRegionOfInterest()
+{
+	{
+		lock_guard<mutex> lock(m_roiMutex);
+		if(m_roiNodes.empty())
+			return;
+	}
+
+	LogTrace("Completing region of interest evaluation\n");
+	m_roiSuspended = true;
+	RefreshAllFilters();
+	m_roiSuspended = false;
+}
+
+/**
+	@brief Puts back the original waveforms replaced by CropToRegionOfInterest()
+ */
+void Session::RestoreFromRegionOfInterest(vector<pair<StreamDescriptor, WaveformBase*>>& originals)
+{
+	//SetData frees the cropped copy
+	for(auto it : originals)
+		it.first.m_channel->SetData(it.second, it.first.m_stream);
+	originals.clear();
+}
+
 /**
 	@brief Clear state on all of our filters
  */
@@ -3421,12 +4252,18 @@ void Session::ClearSweeps()
 
 	for(auto f : filters)
 		f->ClearSweeps();
+
+	//Cached outputs include accumulated sweeps
+	m_history.InvalidateFilterCache();
 }
 
 /**
 	@brief Update all of the packet managers when new data arrives
+
+	@param nodes	All nodes in the graph (managers for filters not in this set are deleted)
+	@param updated	Nodes which were actually evaluated (managers for filters not in this set are left alone)
  */
-void Session::UpdatePacketManagers(const set<FlowGraphNode*>& nodes)
+void Session::UpdatePacketManagers(const set<FlowGraphNode*>& nodes, const set<FlowGraphNode*>& updated)
 {
 	lock_guard<mutex> lock(m_packetMgrMutex);
 
@@ -3437,8 +4274,8 @@ void Session::UpdatePacketManagers(const set<FlowGraphNode*>& nodes)
 		if(nodes.find(it.first) == nodes.end())
 			deletedFilters.emplace(it.first);
 
-		//It exists, update it
-		else
+		//It exists and has new data, update it
+		else if(updated.find(it.first) != updated.end())
 			it.second->Update();
 	}
 
@@ -3472,17 +4309,67 @@ void Session::RemovePackets(TimePoint t)
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Rendering
 
+/**
+	@brief Displays an error message
+
+	Forwarded to the main window if we have one, otherwise just logged.
+ */
+void Session::ShowErrorPopup(const string& title, const string& msg)
+{
+	if(m_mainWindow)
+		m_mainWindow->ShowErrorPopup(title, msg);
+	else
+		LogError("%s: %s\n", title.c_str(), msg.c_str());
+}
+
+/**
+	@brief Displays an error message from a background thread
+
+	The message is queued for the GUI thread to pick up, since popups can only be opened from there.
+ */
+void Session::QueueErrorPopup(const string& title, const string& msg)
+{
+	if(!m_mainWindow)
+	{
+		LogError("%s: %s\n", title.c_str(), msg.c_str());
+		return;
+	}
+
+	lock_guard<mutex> lock(m_queuedErrorPopupMutex);
+	m_queuedErrorPopups.push_back(pair<string, string>(title, msg));
+}
+
+/**
+	@brief Removes the oldest error message queued by QueueErrorPopup(), if there is one
+
+	@return True if a message was returned
+ */
+bool Session::PopQueuedErrorPopup(string& title, string& msg)
+{
+	lock_guard<mutex> lock(m_queuedErrorPopupMutex);
+	if(m_queuedErrorPopups.empty())
+		return false;
+
+	title = m_queuedErrorPopups.front().first;
+	msg = m_queuedErrorPopups.front().second;
+	m_queuedErrorPopups.erase(m_queuedErrorPopups.begin());
+	return true;
+}
+
 /**
 	@brief Gets the last execution time of the tone mapping shaders
  */
 int64_t Session::GetToneMapTime()
 {
+	if(!m_mainWindow)
+		return 0;
 	return m_mainWindow->GetToneMapTime();
 }
 
 void Session::RenderWaveformTextures(vk::raii::CommandBuffer& cmdbuf, vector<shared_ptr<DisplayedChannel> >& channels)
 {
-	m_mainWindow->RenderWaveformTextures(cmdbuf, channels);
+	if(m_mainWindow)
+		m_mainWindow->RenderWaveformTextures(cmdbuf, channels);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
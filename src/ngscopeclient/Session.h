@@ -45,11 +45,73 @@ class DisplayedChannel;
 #include "PreferenceManager.h"
 #include "Marker.h"
 #include "TriggerGroup.h"
+#include "TaskScheduler.h"
+#include "FilterGraphTimeline.h"
 
 extern std::atomic<int64_t> g_lastWaveformRenderTime;
+extern std::atomic<int64_t> g_lastGpuRasterizeTime;
+extern std::atomic<int64_t> g_lastCpuRasterizeTime;
+extern std::atomic<size_t> g_lastRasterizeSkipCount;
+extern std::atomic<size_t> g_lastRasterizeChannelCount;
 
 class Session;
 
+/**
+	@brief Range of the X axis visible in waveform views showing a graph node
+ */
+class VisibleRange
+{
+public:
+	VisibleRange(int64_t start, int64_t end)
+	: m_start(start)
+	, m_end(end)
+	, m_views(1)
+	{}
+
+	///@brief Adds another view of the same node
+	void Extend(int64_t start, int64_t end)
+	{
+		m_start = std::min(m_start, start);
+		m_end = std::max(m_end, end);
+		m_views ++;
+	}
+
+	///@brief Start of the visible range, in X axis units
+	int64_t m_start;
+
+	///@brief End of the visible range, in X axis units
+	int64_t m_end;
+
+	///@brief Number of waveform views showing the node
+	size_t m_views;
+};
+
+/**
+	@brief A request to arm the trigger, carried out on the waveform thread
+ */
+class TriggerArmRequest
+{
+public:
+	TriggerArmRequest(std::shared_ptr<TriggerGroup> group, TriggerGroup::TriggerType type, bool all, bool rearm)
+	: m_group(group)
+	, m_type(type)
+	, m_all(all)
+	, m_rearm(rearm)
+	{}
+
+	///@brief The group to arm, or null to arm the whole session
+	std::shared_ptr<TriggerGroup> m_group;
+
+	///@brief Type of trigger to start
+	TriggerGroup::TriggerType m_type;
+
+	///@brief When arming the whole session, true to arm all groups rather than only the default ones
+	bool m_all;
+
+	///@brief True to only re-arm m_group if it's in multi-scope free-run mode
+	bool m_rearm;
+};
+
 class InstrumentConnectionState
 {
 public:
@@ -57,6 +119,7 @@ public:
 	{
 		m_shuttingDown = false;
 		args.shuttingDown = &m_shuttingDown;
+		m_pollSchedule = args.schedule;
 		m_thread = std::make_unique<std::thread>(InstrumentThread, args);
 		m_lastTriggerState = Oscilloscope::TRIGGER_MODE_WAIT;
 	}
@@ -83,6 +146,9 @@ public:
 
 	///@brief Cached trigger state, to reflect in the UI
 	Oscilloscope::TriggerMode m_lastTriggerState;
+
+	///@brief Timing and statistics for status polls
+	std::shared_ptr<InstrumentPollSchedule> m_pollSchedule;
 };
 
 /**
@@ -99,11 +165,18 @@ public:
 
 	bool OnMemoryPressure(MemoryPressureLevel level, MemoryPressureType type, size_t requestedSize);
 
-	void ArmTrigger(TriggerGroup::TriggerType type, bool all=false);
+	bool ArmTrigger(TriggerGroup::TriggerType type, bool all=false);
+	void ArmTriggerGroup(std::shared_ptr<TriggerGroup> group, TriggerGroup::TriggerType type);
+	void ProcessPendingArmRequests();
 	void StopTrigger(bool all=false);
+
+	///@brief Returns true if the session trigger is armed
+	bool IsTriggerArmed()
+	{ return m_triggerArmed; }
+
 	bool HasOnlineScopes();
 	void DownloadWaveforms();
-	bool CheckForWaveforms(vk::raii::CommandBuffer& cmdbuf);
+	bool CheckForWaveforms(vk::raii::CommandBuffer& cmdbuf, bool acceptNewWaveforms = true);
 	void RefreshAllFilters();
 	void RefreshAllFiltersNonblocking();
 	void RefreshDirtyFiltersNonblocking();
@@ -112,6 +185,11 @@ public:
 
 	void MarkChannelDirty(InstrumentChannel* chan);
 
+	void AddConsumer(FlowGraphNode* node);
+	void RemoveConsumer(FlowGraphNode* node);
+	void UpdateVisibleRanges(const std::map<FlowGraphNode*, VisibleRange>& ranges);
+	void FinishRegionOfInterest();
+
 	void RenderWaveformTextures(
 		vk::raii::CommandBuffer& cmdbuf,
 		std::vector<std::shared_ptr<DisplayedChannel> >& channels);
@@ -121,6 +199,7 @@ public:
 
 	bool PreLoadFromYaml(const YAML::Node& node, const std::string& dataDir, bool online);
 	bool LoadFromYaml(const YAML::Node& node, const std::string& dataDir, bool online);
+	bool LoadWaveformData(const std::string& dataDir);
 	YAML::Node SerializeInstrumentConfiguration();
 	YAML::Node SerializeMetadata();
 	YAML::Node SerializeTriggerGroups();
@@ -137,6 +216,7 @@ public:
 	void AddInstrument(std::shared_ptr<Instrument> inst, bool createDialogs = true);
 	void RemoveInstrument(std::shared_ptr<Instrument> inst);
 	std::shared_ptr<InstrumentConnectionState> GetInstrumentConnectionState(std::shared_ptr<Instrument> inst) { return m_instrumentStates[inst]; }
+	void UpdatePollIntervals();
 
 	bool IsMultiScope()
 	{ return m_multiScope; }
@@ -144,6 +224,19 @@ public:
 	MainWindow* GetMainWindow()
 	{ return m_mainWindow; }
 
+	/**
+		@brief Returns true if we're running without a GUI (no MainWindow)
+	 */
+	bool IsHeadless()
+	{ return m_mainWindow == nullptr; }
+
+	void ShowErrorPopup(const std::string& title, const std::string& msg);
+	void QueueErrorPopup(const std::string& title, const std::string& msg);
+	bool PopQueuedErrorPopup(std::string& title, std::string& msg);
+	bool ProcessPendingWaveforms();
+	bool AcquirePendingWaveforms();
+	void CommitWaveformsToHistory();
+
 	/**
 		@brief Returns a pointer to the state for a BERT
 	 */
@@ -180,6 +273,15 @@ public:
 		return m_packetmgrs[filter];
 	}
 
+	/**
+		@brief Returns a snapshot of all protocol decode filters and their packet managers
+	 */
+	std::map<PacketDecoder*, std::shared_ptr<PacketManager> > GetPacketManagers()
+	{
+		std::lock_guard<std::mutex> lock(m_packetMgrMutex);
+		return m_packetmgrs;
+	}
+
 	void ApplyPreferences(std::shared_ptr<Oscilloscope> scope);
 
 	size_t GetFilterCount();
@@ -194,12 +296,42 @@ public:
 	int64_t GetFilterGraphExecTime()
 	{ return m_lastFilterGraphExecTime.load(); }
 
+	/**
+		@brief Gets the number of filters skipped during the last filter graph execution because nothing consumed them
+	 */
+	size_t GetSkippedFilterCount()
+	{ return m_skippedFilterCount.load(); }
+
 	/**
 		@brief Gets the last run time of the waveform rendering shaders
 	 */
 	int64_t GetLastWaveformRenderTime()
 	{ return g_lastWaveformRenderTime.load(); }
 
+	/**
+		@brief Gets the run time of the most recent rendering cycle that used the waveform rasterizing shader
+	 */
+	int64_t GetLastGpuRasterizeTime()
+	{ return g_lastGpuRasterizeTime.load(); }
+
+	/**
+		@brief Gets the run time of the most recent rendering cycle that used the CPU waveform rasterizer
+	 */
+	int64_t GetLastCpuRasterizeTime()
+	{ return g_lastCpuRasterizeTime.load(); }
+
+	/**
+		@brief Gets the fraction of waveforms in the most recent rendering cycle that were not rasterized because
+		nothing had changed since they were last drawn
+	 */
+	double GetLastRasterizeSkipRate()
+	{
+		size_t total = g_lastRasterizeChannelCount.load();
+		if(total == 0)
+			return 0;
+		return g_lastRasterizeSkipCount.load() * 1.0 / total;
+	}
+
 	/**
 		@brief Gets the average rate at which we are pulling waveforms off the scope, in Hz
 	 */
@@ -263,6 +395,12 @@ public:
 	HistoryManager& GetHistory()
 	{ return m_history; }
 
+	/**
+		@brief Get the worker pool for background jobs
+	 */
+	TaskScheduler& GetTaskScheduler()
+	{ return m_taskScheduler; }
+
 	/**
 		@brief Adds a marker
 	 */
@@ -340,8 +478,25 @@ public:
 		return m_lastFilterGraphRuntimeStats;
 	}
 
+	///@brief Return the total output sample count of each filter as of the last graph execution
+	std::map<FlowGraphNode*, size_t> GetFilterGraphSampleCounts()
+	{
+		std::lock_guard<std::mutex> lock(m_lastFilterGraphRuntimeMutex);
+		return m_lastFilterGraphSampleCounts;
+	}
+
+	///@brief Get the per-filter timeline of recent filter graph runs
+	FilterGraphTimeline& GetFilterGraphTimeline()
+	{ return m_filterGraphTimeline; }
+
 protected:
-	void UpdatePacketManagers(const std::set<FlowGraphNode*>& nodes);
+	void UpdatePacketManagers(const std::set<FlowGraphNode*>& nodes, const std::set<FlowGraphNode*>& updated);
+	std::set<FlowGraphNode*> GetDemandedNodes(const std::set<FlowGraphNode*>& nodes);
+	bool CropToRegionOfInterest(
+		const std::set<FlowGraphNode*>& nodes,
+		std::vector<std::pair<StreamDescriptor, WaveformBase*>>& originals);
+	void RestoreFromRegionOfInterest(std::vector<std::pair<StreamDescriptor, WaveformBase*>>& originals);
+	void RecordFilterGraphStats(const std::set<FlowGraphNode*>& nodes, double tstart);
 
 	std::string GetRegisteredTypeOfDriver(const std::string& drivername);
 
@@ -349,6 +504,12 @@ protected:
 	bool PreLoadInstruments(int version, const YAML::Node& node, bool online);
 	SCPITransport* CreateTransportForNode(const YAML::Node& node);
 	bool VerifyInstrument(const YAML::Node& node, std::shared_ptr<Instrument> inst);
+	void UpdatePollSchedule(std::shared_ptr<Instrument> inst, std::shared_ptr<InstrumentPollSchedule> schedule);
+
+	bool DoArmTrigger(TriggerGroup::TriggerType type, bool all);
+	void SubmitArmRequest(const TriggerArmRequest& req);
+	void RunArmRequest(const TriggerArmRequest& req);
+	void RearmIfMultiScope(const std::set<std::shared_ptr<TriggerGroup>>& groups);
 	bool PreLoadVNA(int version, const YAML::Node& node, bool online);
 	bool PreLoadOscilloscope(int version, const YAML::Node& node, bool online);
 	bool PreLoadPowerSupply(int version, const YAML::Node& node, bool online);
@@ -396,6 +557,9 @@ protected:
 	///@brief Mutex for controlling access to filter graph
 	std::mutex m_filterUpdatingMutex;
 
+	///@brief Worker pool for background jobs (declared early so it outlives anything that might have tasks queued)
+	TaskScheduler m_taskScheduler;
+
 	///@brief Top level UI window
 	MainWindow* m_mainWindow;
 
@@ -435,6 +599,12 @@ protected:
 	///@brief Worker threads and other bookkeeping metadata for instruments
 	std::map<std::shared_ptr<Instrument>, std::shared_ptr<InstrumentConnectionState> > m_instrumentStates;
 
+	///@brief Measurement polling interval preference as of the last UpdatePollIntervals() call
+	double m_appliedMeasurementInterval;
+
+	///@brief Status polling interval preference as of the last UpdatePollIntervals() call
+	double m_appliedStatusInterval;
+
 	///@brief Processing thread for waveform data
 	std::unique_ptr<std::thread> m_waveformThread;
 
@@ -454,23 +624,47 @@ protected:
 	double m_tPrimaryTrigger;
 
 	///@brief Indicates trigger is armed (incoming waveforms are ignored if not armed)
-	bool m_triggerArmed;
+	std::atomic<bool> m_triggerArmed;
 
 	///@brief If true, trigger is currently armed in single-shot mode
 	bool m_triggerOneShot;
 
+	///@brief Incremented by StopTrigger(), so an arm in progress on the waveform thread knows to undo itself
+	std::atomic<uint64_t> m_stopGeneration;
+
+	///@brief Arm requests waiting for the waveform thread
+	std::vector<TriggerArmRequest> m_pendingArmRequests;
+
+	///@brief Mutex controlling access to m_pendingArmRequests
+	std::mutex m_pendingArmMutex;
+
+	///@brief Error messages from background threads waiting to be shown by the GUI thread (title, message)
+	std::vector<std::pair<std::string, std::string> > m_queuedErrorPopups;
+
+	///@brief Mutex controlling access to m_queuedErrorPopups
+	std::mutex m_queuedErrorPopupMutex;
+
+	///@brief Number of threads used for filter graph evaluation
+	static const size_t m_graphExecutorThreads = 4;
+
 	///@brief Context for filter graph evaluation
 	FilterGraphExecutor m_graphExecutor;
 
 	///@brief Time spent on the last filter graph execution
 	std::atomic<int64_t> m_lastFilterGraphExecTime;
 
-	///@brief Mutex for controlling access to m_lastFilterGraphRuntimeStats
+	///@brief Mutex for controlling access to m_lastFilterGraphRuntimeStats and m_lastFilterGraphSampleCounts
 	std::mutex m_lastFilterGraphRuntimeMutex;
 
 	///@brief Performance stats from last graph execution
 	std::map<FlowGraphNode*, int64_t> m_lastFilterGraphRuntimeStats;
 
+	///@brief Total output sample count of each filter run in the last graph execution
+	std::map<FlowGraphNode*, size_t> m_lastFilterGraphSampleCounts;
+
+	///@brief Per-filter timing for recent filter graph runs
+	FilterGraphTimeline m_filterGraphTimeline;
+
 	///@brief Mutex for controlling access to performance counters
 	std::mutex m_perfClockMutex;
 
@@ -510,6 +704,39 @@ protected:
 	///@brief Mutex controlling access to m_dirtyChannels
 	std::mutex m_dirtyChannelsMutex;
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Demand tracking
+
+	///@brief Number of consumers (displayed channels, measurements, protocol analyzers) of each graph node
+	std::map<FlowGraphNode*, size_t> m_consumers;
+
+	///@brief Filters skipped by previous graph executions, whose outputs are out of date
+	std::set<FlowGraphNode*> m_staleNodes;
+
+	///@brief Mutex controlling access to m_consumers and m_staleNodes
+	std::mutex m_consumersMutex;
+
+	///@brief Number of filters skipped during the last graph execution
+	std::atomic<size_t> m_skippedFilterCount;
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Region of interest evaluation
+
+	///@brief Visible X axis range of each displayed node, as of the last frame
+	std::map<FlowGraphNode*, VisibleRange> m_visibleRanges;
+
+	///@brief Filters whose outputs were computed over only part of their input by the last graph execution
+	std::set<FlowGraphNode*> m_roiNodes;
+
+	///@brief X axis range (including margin) the filters in m_roiNodes were computed over
+	std::pair<int64_t, int64_t> m_roiComputedRange;
+
+	///@brief Mutex controlling access to m_visibleRanges, m_roiNodes, and m_roiComputedRange
+	std::mutex m_roiMutex;
+
+	///@brief Set while forcing a full evaluation of the graph
+	std::atomic<bool> m_roiSuspended;
+
 public:
 
 	/**
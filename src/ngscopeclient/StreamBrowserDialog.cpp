@@ -892,13 +892,18 @@ void StreamBrowserDialog::renderInstrumentNode(shared_ptr<Instrument> instrument
 		}
 		if(result != allOn)
 		{
+			//Update state right now, since status is only polled occasionally
 			if(psu->SupportsMasterOutputSwitching())
+			{
 				psu->SetMasterPowerEnable(result);
+				psustate->m_masterEnable = result;
+			}
 			else
 			{
 				for(size_t i = 0 ; i < channelCount ; i++)
 				{
 					psu->SetPowerChannelActive(i,result);
+					psustate->m_channelOn[i] = result;
 				}
 			}
 		}
@@ -1116,7 +1121,12 @@ void StreamBrowserDialog::renderChannelNode(shared_ptr<Instrument> instrument, s
 		bool active = psustate->m_channelOn[channelIndex];
 		bool result = renderOnOffToggle("###active", true, active);
 		if(result != active)
+		{
 			psu->SetPowerChannelActive(channelIndex,result);
+
+			//Update state right now, since status is only polled occasionally
+			psustate->m_channelOn[channelIndex] = result;
+		}
 	}
 	else if(awg && awgchan)
 	{
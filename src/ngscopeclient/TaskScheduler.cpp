@@ -0,0 +1,283 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of TaskScheduler
+ */
+#include "ngscopeclient.h"
+#include "TaskScheduler.h"
+#include "pthread_compat.h"
+
+using namespace std;
+
+///@brief Index of the current thread in its scheduler's worker list, or SIZE_MAX if not a worker
+static thread_local size_t g_workerIndex = SIZE_MAX;
+
+///@brief The scheduler the current thread is a worker of, if any
+static thread_local TaskScheduler* g_workerScheduler = nullptr;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+TaskScheduler::TaskScheduler(size_t numWorkers)
+	: m_nextWorker(0)
+	, m_nextGroup(NO_GROUP + 1)
+	, m_shuttingDown(false)
+{
+	for(auto& d : m_queueDepth)
+		d = 0;
+
+	if(numWorkers == 0)
+		numWorkers = 1;
+
+	//Create all worker state before starting any threads, since they look at each other's queues
+	for(size_t i=0; i<numWorkers; i++)
+		m_workers.push_back(make_unique<Worker>());
+	for(size_t i=0; i<numWorkers; i++)
+		m_workers[i]->m_thread = thread(&TaskScheduler::WorkerThread, this, i);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	{
+		lock_guard<mutex> lock(m_wakeMutex);
+		m_shuttingDown = true;
+	}
+	m_wakeEvent.notify_all();
+
+	for(auto& w : m_workers)
+		w->m_thread.join();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Task submission
+
+/**
+	@brief Adds a task to a queue and wakes a worker to run it
+ */
+void TaskScheduler::Push(Priority prio, Task task, GroupID group)
+{
+	//Tasks spawned by one of our own workers stay local to it, others are spread across the pool
+	size_t i;
+	if(g_workerScheduler == this)
+		i = g_workerIndex;
+	else
+		i = m_nextWorker.fetch_add(1) % m_workers.size();
+
+	{
+		auto& w = m_workers[i];
+		lock_guard<mutex> lock(w->m_mutex);
+		w->m_queues[prio].push_back(QueuedTask(std::move(task), group));
+		m_queueDepth[prio] ++;
+	}
+
+	//Take the lock briefly so a worker that just found nothing to do can't miss the wakeup
+	{
+		lock_guard<mutex> lock(m_wakeMutex);
+	}
+	m_wakeEvent.notify_one();
+}
+
+/**
+	@brief Runs a function over a range of indexes, split across the pool
+
+	The calling thread participates in the work and does not return until every index has been processed.
+ */
+void TaskScheduler::ParallelFor(Priority prio, int64_t begin, int64_t end, function<void(int64_t)> func)
+{
+	if(end <= begin)
+		return;
+
+	//A few chunks per worker gives reasonable load balancing without too much per-task overhead
+	int64_t count = end - begin;
+	int64_t nchunks = min(count, static_cast<int64_t>(m_workers.size() * 4));
+	int64_t chunksize = (count + nchunks - 1) / nchunks;
+
+	auto nextChunk = make_shared<atomic<int64_t>>(0);
+	auto runChunks = [=]
+	{
+		int64_t c;
+		while( (c = nextChunk->fetch_add(1)) < nchunks)
+		{
+			int64_t cbegin = begin + c*chunksize;
+			int64_t cend = min(cbegin + chunksize, end);
+			for(int64_t i=cbegin; i<cend; i++)
+				func(i);
+		}
+	};
+
+	//Start helpers on the other workers, then pitch in ourselves
+	auto group = NewGroup();
+	vector<future<void>> helpers;
+	size_t nhelpers = min(static_cast<size_t>(nchunks - 1), m_workers.size());
+	for(size_t i=0; i<nhelpers; i++)
+		helpers.push_back(Submit(prio, runChunks, group));
+	runChunks();
+
+	for(auto& f : helpers)
+		WaitFor(f, group);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Execution
+
+/**
+	@brief Finds the highest priority pending task, preferring our own queue then stealing from others
+
+	@param task		The task to run
+	@param prio		Priority of the task
+	@param group	Only consider tasks from this group, or ANY_GROUP for all tasks
+
+	@return True if a task was found
+ */
+bool TaskScheduler::Pop(Task& task, Priority& prio, GroupID group)
+{
+	size_t self = (g_workerScheduler == this) ? g_workerIndex : SIZE_MAX;
+	size_t nworkers = m_workers.size();
+
+	for(int p=0; p<PRIORITY_COUNT; p++)
+	{
+		if(m_queueDepth[p] == 0)
+			continue;
+
+		//Our own queue first, newest task (most likely to still be in cache)
+		if(self != SIZE_MAX)
+		{
+			auto& w = m_workers[self];
+			lock_guard<mutex> lock(w->m_mutex);
+			auto& q = w->m_queues[p];
+			for(auto it = q.rbegin(); it != q.rend(); it++)
+			{
+				if( (group != ANY_GROUP) && (it->m_group != group) )
+					continue;
+
+				task = std::move(it->m_func);
+				q.erase(std::next(it).base());
+				m_queueDepth[p] --;
+				prio = static_cast<Priority>(p);
+				return true;
+			}
+		}
+
+		//Steal the oldest task from someone else, starting with our neighbor so thieves don't all pile onto worker 0
+		size_t start = (self == SIZE_MAX) ? 0 : self + 1;
+		for(size_t j=0; j<nworkers; j++)
+		{
+			size_t victim = (start + j) % nworkers;
+			if(victim == self)
+				continue;
+
+			auto& w = m_workers[victim];
+			lock_guard<mutex> lock(w->m_mutex);
+			auto& q = w->m_queues[p];
+			for(auto it = q.begin(); it != q.end(); it++)
+			{
+				if( (group != ANY_GROUP) && (it->m_group != group) )
+					continue;
+
+				task = std::move(it->m_func);
+				q.erase(it);
+				m_queueDepth[p] --;
+				prio = static_cast<Priority>(p);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+	@brief Runs a single pending task from the specified group on the calling thread, if there is one
+
+	@return True if a task was run
+ */
+bool TaskScheduler::RunOneTask(GroupID group)
+{
+	Task task;
+	Priority prio;
+	if(!Pop(task, prio, group))
+		return false;
+
+	task();
+	return true;
+}
+
+void TaskScheduler::WorkerThread(size_t i)
+{
+	pthread_setname_np_compat("TaskWorker");
+
+	g_workerScheduler = this;
+	g_workerIndex = i;
+
+	auto& w = m_workers[i];
+	w->m_windowStart = GetTime();
+
+	while(!m_shuttingDown)
+	{
+		Task task;
+		Priority prio;
+		if(Pop(task, prio, ANY_GROUP))
+		{
+			double start = GetTime();
+			task();
+			w->m_windowBusy += GetTime() - start;
+		}
+
+		//Nothing to do, sleep until something is submitted.
+		//Time out periodically so utilization stats still update when idle.
+		else
+		{
+			unique_lock<mutex> lock(m_wakeMutex);
+			m_wakeEvent.wait_for(lock, chrono::milliseconds(100), [&]
+				{
+					if(m_shuttingDown)
+						return true;
+					for(auto& d : m_queueDepth)
+					{
+						if(d != 0)
+							return true;
+					}
+					return false;
+				});
+		}
+
+		//Update utilization about once a second
+		double now = GetTime();
+		double dt = now - w->m_windowStart;
+		if(dt >= 1)
+		{
+			w->m_utilization = min(1.0, w->m_windowBusy / dt);
+			w->m_windowStart = now;
+			w->m_windowBusy = 0;
+		}
+	}
+}
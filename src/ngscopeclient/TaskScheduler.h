@@ -0,0 +1,206 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of TaskScheduler
+ */
+#ifndef TaskScheduler_h
+#define TaskScheduler_h
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+
+/**
+	@brief Session-wide pool of worker threads for background jobs
+
+	Each worker has its own set of per-priority queues. Tasks submitted from a worker go to that worker's queue, tasks
+	submitted from any other thread are distributed round-robin. Idle workers steal from the other end of their peers'
+	queues. Higher priority work is always picked up first, no matter which queue it's sitting in.
+
+	Tasks may be tagged with a group from NewGroup(). Threads waiting on a group (WaitFor, ParallelFor) run queued
+	tasks from that group while they wait, so nested parallelism can't deadlock the pool. Tasks from other groups are
+	left alone, so the GUI thread never gets stuck running an unrelated file save or history scan.
+ */
+class TaskScheduler
+{
+public:
+	TaskScheduler(size_t numWorkers);
+	virtual ~TaskScheduler();
+
+	enum Priority
+	{
+		///@brief Work the user is actively waiting on (filtering a packet list, deskew correlation)
+		PRIORITY_INTERACTIVE,
+
+		///@brief Processing of incoming waveform data
+		PRIORITY_ACQUISITION,
+
+		///@brief File I/O and housekeeping
+		PRIORITY_BACKGROUND,
+
+		PRIORITY_COUNT
+	};
+
+	///@brief Identifies a set of tasks that are waited on together
+	typedef uint64_t GroupID;
+
+	///@brief Group for tasks nobody will help with while waiting
+	static const GroupID NO_GROUP = 0;
+
+	///@brief Allocates a new task group
+	GroupID NewGroup()
+	{ return m_nextGroup.fetch_add(1); }
+
+	/**
+		@brief Queues a task for execution
+
+		@param prio		Priority of the task
+		@param func		Function to run
+		@param group	Group the task belongs to, if the caller will WaitFor() it with help
+
+		@return	Future for the return value of func
+	 */
+	template<class F>
+	std::future<std::invoke_result_t<F>> Submit(Priority prio, F func, GroupID group = NO_GROUP)
+	{
+		auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::move(func));
+		auto ret = task->get_future();
+		Push(prio, [task]{ (*task)(); }, group);
+		return ret;
+	}
+
+	/**
+		@brief Blocks until a task completes, running other queued tasks from the same group in the meantime
+
+		@param f		Future for the task
+		@param group	Group the task was submitted to. If NO_GROUP, just block.
+	 */
+	template<class T>
+	void WaitFor(std::future<T>& f, GroupID group = NO_GROUP)
+	{
+		while(f.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			if( (group == NO_GROUP) || !RunOneTask(group) )
+				f.wait_for(std::chrono::microseconds(100));
+		}
+	}
+
+	void ParallelFor(Priority prio, int64_t begin, int64_t end, std::function<void(int64_t)> func);
+
+	///@brief Gets the number of worker threads
+	size_t GetWorkerCount()
+	{ return m_workers.size(); }
+
+	///@brief Gets the number of tasks waiting to run at the specified priority
+	size_t GetQueueDepth(Priority prio)
+	{ return m_queueDepth[prio].load(); }
+
+	///@brief Gets the fraction of time (0-1) a worker spent running tasks over the last second or so
+	float GetWorkerUtilization(size_t i)
+	{ return m_workers[i]->m_utilization.load(); }
+
+protected:
+	typedef std::function<void()> Task;
+
+	///@brief A task and the group it belongs to
+	class QueuedTask
+	{
+	public:
+		QueuedTask(Task&& func, GroupID group)
+		: m_func(std::move(func))
+		, m_group(group)
+		{}
+
+		Task m_func;
+		GroupID m_group;
+	};
+
+	///@brief Group value for Pop() that matches tasks from any group
+	static const GroupID ANY_GROUP = UINT64_MAX;
+
+	void Push(Priority prio, Task task, GroupID group);
+	bool Pop(Task& task, Priority& prio, GroupID group);
+	bool RunOneTask(GroupID group);
+	void WorkerThread(size_t i);
+
+	///@brief State for a single worker thread
+	class Worker
+	{
+	public:
+		Worker()
+		: m_utilization(0)
+		, m_windowStart(0)
+		, m_windowBusy(0)
+		{}
+
+		///@brief Mutex protecting m_queues
+		std::mutex m_mutex;
+
+		///@brief Pending tasks at each priority. The owner pops from the back, thieves from the front
+		std::deque<QueuedTask> m_queues[PRIORITY_COUNT];
+
+		///@brief The thread itself
+		std::thread m_thread;
+
+		///@brief Fraction of time spent busy over the last completed window
+		std::atomic<float> m_utilization;
+
+		///@brief Start of the current utilization measurement window
+		double m_windowStart;
+
+		///@brief Time spent running tasks so far in the current window
+		double m_windowBusy;
+	};
+
+	///@brief Our worker threads
+	std::vector<std::unique_ptr<Worker>> m_workers;
+
+	///@brief Number of tasks pending at each priority
+	std::atomic<size_t> m_queueDepth[PRIORITY_COUNT];
+
+	///@brief Round-robin counter for tasks submitted from outside the pool
+	std::atomic<size_t> m_nextWorker;
+
+	///@brief Next group ID to hand out
+	std::atomic<GroupID> m_nextGroup;
+
+	///@brief Mutex for m_wakeEvent
+	std::mutex m_wakeMutex;
+
+	///@brief Signaled whenever a task is submitted
+	std::condition_variable m_wakeEvent;
+
+	///@brief Set to true to shut down the workers
+	std::atomic<bool> m_shuttingDown;
+};
+
+#endif
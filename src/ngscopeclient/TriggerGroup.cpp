@@ -140,8 +140,10 @@ void TriggerGroup::AddFilter(PausableFilter* f)
 
 /**
 	@brief Arm the trigger for the group
+
+	@return True on success, false if a secondary failed to arm (in which case nothing in the group is left running)
  */
-void TriggerGroup::Arm(TriggerType type)
+bool TriggerGroup::Arm(TriggerType type)
 {
 	if(m_primary)
 		LogTrace("Arming trigger for group %s\n", m_primary->m_nickname.c_str());
@@ -179,36 +181,45 @@ void TriggerGroup::Arm(TriggerType type)
 	//We're in multiscope normal mode if we're doing a non-oneshot trigger and have secondaries
 	m_multiScopeFreeRun = !oneshot && !m_secondaries.empty();
 
-	//Start secondaries (always in single shot mode)
+	//Start secondaries (always in single shot mode) and wait for all of them to arm.
+	//Each secondary has its own transport, so arm them all in parallel rather than paying the sum of their latencies.
+	auto& sched = m_session->GetTaskScheduler();
+	auto armGroup = sched.NewGroup();
+	vector<future<bool>> armTasks;
 	for(auto scope : m_secondaries)
 	{
-		LogTrace("Starting trigger for secondary scope %s\n", scope->m_nickname.c_str());
-		scope->StartSingleTrigger();
+		armTasks.push_back(sched.Submit(
+			TaskScheduler::PRIORITY_ACQUISITION, [this, scope] { return ArmSecondary(scope); }, armGroup));
 	}
-
-	//Verify all secondaries are armed
-	for(auto scope : m_secondaries)
+	string failed;
+	for(size_t i=0; i<armTasks.size(); i++)
 	{
-		double start = GetTime();
+		sched.WaitFor(armTasks[i], armGroup);
+		if(!armTasks[i].get())
+		{
+			if(!failed.empty())
+				failed += ", ";
+			failed += m_secondaries[i]->m_nickname;
+		}
+	}
 
-		while(!scope->PeekTriggerArmed())
+	//If any secondary didn't arm, don't start the primary: we'd get a trigger the group can't capture.
+	//Stop the secondaries that did arm so they don't sit there waiting for it either.
+	if(!failed.empty())
+	{
+		for(auto scope : m_secondaries)
 		{
-			//After 3 sec of no activity, time out
-			//(must be longer than the default 2 sec socket timeout)
-			double now = GetTime();
-			if( (now - start) > 3)
-			{
-				LogWarning("Timeout waiting for scope %s to arm\n",  scope->m_nickname.c_str());
-				scope->Stop();
-				scope->StartSingleTrigger();
-				start = now;
-			}
+			scope->Stop();
+			scope->ClearPendingWaveforms();
 		}
-		LogTrace("Secondary is armed\n");
+		m_multiScopeFreeRun = false;
 
-		//Scope is armed. Clear any garbage in the pending queue
-		//TODO: this should now be redundant, but verify?
-		scope->ClearPendingWaveforms();
+		//We're normally called from the waveform thread, so let the GUI thread show the error
+		m_session->QueueErrorPopup(
+			"Trigger arm failed",
+			string("Secondary instrument(s) ") + failed + " did not report the trigger as armed.\n\n" +
+			"The trigger group " + GetDescription() + " was not started.");
+		return false;
 	}
 
 	//Start the primary normally
@@ -253,6 +264,64 @@ void TriggerGroup::Arm(TriggerType type)
 		else
 			f->Run();
 	}
+
+	return true;
+}
+
+/**
+	@brief Starts a secondary scope in single shot mode and blocks until it reports that the trigger is armed
+
+	Called in parallel for each secondary from Arm().
+
+	@return True if the scope armed, false if it still hadn't after several attempts
+ */
+bool TriggerGroup::ArmSecondary(shared_ptr<Oscilloscope> scope)
+{
+	LogTrace("Starting trigger for secondary scope %s\n", scope->m_nickname.c_str());
+
+	double start = GetTime();
+	scope->StartSingleTrigger();
+
+	//After 3 sec of no activity, time out and restart the trigger
+	//(must be longer than the default 2 sec socket timeout)
+	const int maxAttempts = 3;
+	int attempt = 1;
+	double attemptStart = start;
+	while(!scope->PeekTriggerArmed())
+	{
+		double now = GetTime();
+		if( (now - attemptStart) > 3)
+		{
+			if(attempt >= maxAttempts)
+			{
+				LogError("Scope %s failed to arm after %d attempts, giving up\n", scope->m_nickname.c_str(), attempt);
+				return false;
+			}
+
+			LogWarning("Timeout waiting for scope %s to arm\n",  scope->m_nickname.c_str());
+			scope->Stop();
+			scope->StartSingleTrigger();
+			attemptStart = now;
+			attempt ++;
+		}
+
+		//Don't hammer the instrument (or our CPU) with back to back polls
+		else
+			this_thread::sleep_for(chrono::milliseconds(1));
+	}
+
+	double dt = GetTime() - start;
+	LogTrace("Secondary %s is armed (%.2f ms)\n", scope->m_nickname.c_str(), dt * 1000);
+
+	{
+		lock_guard<mutex> lock(m_armLatencyMutex);
+		m_armLatency[scope] = dt;
+	}
+
+	//Scope is armed. Clear any garbage in the pending queue
+	//TODO: this should now be redundant, but verify?
+	scope->ClearPendingWaveforms();
+	return true;
 }
 
 string TriggerGroup::GetDescription()
@@ -353,16 +422,37 @@ bool TriggerGroup::CheckForPendingWaveforms()
  */
 void TriggerGroup::DownloadWaveforms()
 {
+	//All good if we're a single-scope trigger group.
+	if(m_secondaries.empty())
+	{
+		if(!m_primary->IsAppendingToWaveform())
+			DetachAllWaveforms(m_primary);
+		m_primary->PopPendingWaveform();
+		return;
+	}
+
+	//If not, we have more work to do.
+	//Each secondary has its own queue and instrument thread, so pull their data in parallel while we're handling
+	//the primary
+	auto& sched = m_session->GetTaskScheduler();
+	auto popGroup = sched.NewGroup();
+	vector<future<void>> popTasks;
+	for(auto scope : m_secondaries)
+	{
+		popTasks.push_back(sched.Submit(TaskScheduler::PRIORITY_ACQUISITION, [this, scope]
+			{
+				if(!scope->IsAppendingToWaveform())
+					DetachAllWaveforms(scope);
+				scope->PopPendingWaveform();
+			},
+			popGroup));
+	}
+
 	//Grab the data from the primary
 	if(!m_primary->IsAppendingToWaveform())
 		DetachAllWaveforms(m_primary);
 	m_primary->PopPendingWaveform();
 
-	//All good if we're a single-scope trigger group.
-	//If not, we have more work to do
-	if(m_secondaries.empty())
-		return;
-
 	LogTrace("Multi scope: patching timestamps\n");
 
 	//Get the timestamp of the primary scope's first waveform
@@ -389,13 +479,13 @@ void TriggerGroup::DownloadWaveforms()
 			break;
 	}
 
-	//Grab the data from secondaries and retcon the timestamps so they match the primary's trigger
+	for(auto& t : popTasks)
+		sched.WaitFor(t, popGroup);
+
+	//Retcon the secondaries' timestamps so they match the primary's trigger
 	for(auto scope : m_secondaries)
 	{
-		if(!scope->IsAppendingToWaveform())
-			DetachAllWaveforms(scope);
-		scope->PopPendingWaveform();
-
+		auto skew = m_session->GetDeskew(scope);
 		for(size_t j=0; j<scope->GetChannelCount(); j++)
 		{
 			auto chan = scope->GetOscilloscopeChannel(j);
@@ -409,7 +499,7 @@ void TriggerGroup::DownloadWaveforms()
 
 				data->m_startTimestamp = timeSec;
 				data->m_startFemtoseconds = timeFs;
-				data->m_triggerPhase -= m_session->GetDeskew(scope);
+				data->m_triggerPhase -= skew;
 			}
 		}
 	}
@@ -429,8 +519,14 @@ void TriggerGroup::DetachAllWaveforms(shared_ptr<Oscilloscope> scope)
 	}
 }
 
-void TriggerGroup::RearmIfMultiScope()
+/**
+	@brief Re-arms the group if it's in multi-scope free-run mode
+
+	@return False if the group needed re-arming and it failed
+ */
+bool TriggerGroup::RearmIfMultiScope()
 {
 	if(m_multiScopeFreeRun)
-		Arm(TRIGGER_TYPE_NORMAL);
+		return Arm(TRIGGER_TYPE_NORMAL);
+	return true;
 }
@@ -72,11 +72,11 @@ public:
 	void AddSecondary(std::shared_ptr<Oscilloscope> scope);
 	void AddFilter(PausableFilter* f);
 
-	void Arm(TriggerType type);
+	bool Arm(TriggerType type);
 	void Stop();
 	bool CheckForPendingWaveforms();
 	void DownloadWaveforms();
-	void RearmIfMultiScope();
+	bool RearmIfMultiScope();
 
 	bool empty()
 	{ return m_secondaries.empty() && (m_primary == nullptr) && m_filters.empty(); }
@@ -97,13 +97,29 @@ public:
 	///@brief True if we should be activated when the start/stop toolbar button is clicked
 	bool m_default;
 
+	/**
+		@brief Get the time it took a secondary scope to arm during the most recent Arm() call, in seconds
+	 */
+	double GetArmLatency(std::shared_ptr<Oscilloscope> scope)
+	{
+		std::lock_guard<std::mutex> lock(m_armLatencyMutex);
+		return m_armLatency[scope];
+	}
+
 protected:
 	void DetachAllWaveforms(std::shared_ptr<Oscilloscope> scope);
+	bool ArmSecondary(std::shared_ptr<Oscilloscope> scope);
 
 	Session* m_session;
 
 	///@brief True if we have multiple scopes and are in normal trigger mode
-	bool m_multiScopeFreeRun;
+	std::atomic<bool> m_multiScopeFreeRun;
+
+	///@brief Mutex controlling access to m_armLatency
+	std::mutex m_armLatencyMutex;
+
+	///@brief Time each secondary took to arm during the most recent Arm() call
+	std::map<std::shared_ptr<Oscilloscope>, double> m_armLatency;
 };
 
 #endif
@@ -155,6 +155,7 @@ VulkanWindow::VulkanWindow(const string& title, shared_ptr<QueueHandle> queue)
 		m_fences.push_back(make_unique<vk::raii::Fence>(*g_vkComputeDevice, finfo));
 		m_cmdBuffers.push_back(make_unique<vk::raii::CommandBuffer>(
 			std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front())));
+		m_drawQueries.push_back(make_unique<GpuTimestampQueries>(*m_cmdBuffers[i], queue->m_family, 1));
 	}
 
 	//Initialize ImGui
@@ -518,9 +519,14 @@ void VulkanWindow::Render()
 		g_vkComputeDevice->resetFences({**m_fences[m_frameIndex]});
 		(*QueueLock(m_renderQueue)).waitIdle();
 
+		//The queue is idle, so timestamps from the last use of this command buffer are ready
+		auto& queries = *m_drawQueries[m_frameIndex];
+		queries.Collect();
+
 		//Start render pass
 		auto& cmdBuf = *m_cmdBuffers[m_frameIndex];
 		cmdBuf.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+		queries.Reset();
 		vk::ClearValue clearValue;
 		vk::ClearColorValue clearColor;
 		clearColor.setFloat32({0.1f, 0.1f, 0.1f, 1.0f});
@@ -533,7 +539,9 @@ void VulkanWindow::Render()
 		cmdBuf.beginRenderPass(passInfo, vk::SubpassContents::eInline);
 
 		//Draw GUI
+		auto id = queries.Begin("ImGui draw");
 		ImGui_ImplVulkan_RenderDrawData(main_draw_data, *cmdBuf);
+		queries.End(id);
 
 		//Draw waveform data etc
 		DoRender(cmdBuf);
@@ -569,6 +577,7 @@ void VulkanWindow::Render()
 		m_semaphoreIndex = (m_semaphoreIndex + 1) % m_backBuffers.size();
 		try
 		{
+			PerfEventScope perf(PERF_PRESENT);
 			QueueLock qlock(m_renderQueue);
 			(*qlock).waitIdle();
 			if(vk::Result::eSuboptimalKHR == (*qlock).presentKHR(presentInfo))
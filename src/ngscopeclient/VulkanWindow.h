@@ -104,6 +104,9 @@ protected:
 	///@brief Frame command buffers
 	std::vector<std::unique_ptr<vk::raii::CommandBuffer> > m_cmdBuffers;
 
+	///@brief GPU timestamps for each frame command buffer
+	std::vector<std::unique_ptr<GpuTimestampQueries> > m_drawQueries;
+
 	///@brief Semaphore indicating framebuffer is ready
 	std::vector<std::unique_ptr<vk::raii::Semaphore> > m_imageAcquiredSemaphores;
 
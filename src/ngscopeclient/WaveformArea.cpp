@@ -46,6 +46,11 @@
 
 using namespace std;
 
+extern atomic<int64_t> g_cpuRasterizeTime;
+extern atomic<size_t> g_cpuRasterizeCount;
+extern atomic<size_t> g_gpuRasterizeCount;
+extern atomic<size_t> g_rasterizeSkipCount;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // DisplayedChannel
 
@@ -53,10 +58,14 @@ DisplayedChannel::DisplayedChannel(StreamDescriptor stream, Session& session)
 		: m_colorRamp("eye-gradient-viridis")
 		, m_stream(stream)
 		, m_session(session)
-		, m_rasterizedWaveform("DisplayedChannel.m_rasterizedWaveform")
+		, m_rasterOffset{0, 0}
+		, m_frontBuffer(0)
+		, m_backBufferReady(false)
 		, m_indexBuffer("DisplayedChannel.m_indexBuffer")
-		, m_rasterizedX(0)
-		, m_rasterizedY(0)
+		, m_indexTargets("DisplayedChannel.m_indexTargets")
+		, m_rasterizedX{0, 0}
+		, m_rasterizedY{0, 0}
+		, m_pointsPerPixel{1, 1}
 		, m_cachedX(0)
 		, m_cachedY(0)
 		, m_persistenceEnabled(false)
@@ -65,6 +74,7 @@ DisplayedChannel::DisplayedChannel(StreamDescriptor stream, Session& session)
 	auto schan = dynamic_cast<OscilloscopeChannel*>(stream.m_channel);
 	if(schan)
 		schan->AddRef();
+	session.AddConsumer(stream.m_channel);
 
 	vk::CommandPoolCreateInfo cmdPoolInfo(
 		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
@@ -77,12 +87,22 @@ DisplayedChannel::DisplayedChannel(StreamDescriptor stream, Session& session)
 
 	//Use GPU-side memory for rasterized waveform
 	//TODO: instead of using CPU-side mirror, use a shader to memset it when clearing?
-	m_rasterizedWaveform.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-	m_rasterizedWaveform.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	for(size_t i=0; i<2; i++)
+	{
+		auto buf = make_shared< AcceleratorBuffer<float> >("DisplayedChannel.m_ownRasterBuffers");
+		buf->SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		buf->SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		m_ownRasterBuffers[i] = buf;
+		m_rasterBuffers[i] = buf;
+	}
 
-	//Use pinned memory for index buffer since it should only be read once
+	//Index buffer is generated on whichever side does the rasterizing
 	m_indexBuffer.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
-	m_indexBuffer.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_UNLIKELY);
+	m_indexBuffer.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+
+	//Use pinned memory for index targets since they should only be read once
+	m_indexTargets.SetCpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
+	m_indexTargets.SetGpuAccessHint(AcceleratorBuffer<int64_t>::HINT_UNLIKELY);
 
 	//Create tone map pipeline depending on waveform type
 	switch(m_stream.GetType())
@@ -115,6 +135,8 @@ DisplayedChannel::DisplayedChannel(StreamDescriptor stream, Session& session)
 
 DisplayedChannel::~DisplayedChannel()
 {
+	m_session.RemoveConsumer(m_stream.m_channel);
+
 	auto schan = dynamic_cast<OscilloscopeChannel*>(m_stream.m_channel);
 	if(schan)
 	{
@@ -285,29 +307,113 @@ bool DisplayedChannel::UpdateSize(ImVec2 newSize, MainWindow* top)
 }
 
 /**
-	@brief Prepares to rasterize the waveform at the specified resolution
+	@brief Prepares to rasterize the waveform into the back buffer at the specified resolution
+
+	@param x		Width of the rasterized image
+	@param y		Height of the rasterized image
+	@param persist	True if the new image will be drawn on top of the currently displayed one
  */
-void DisplayedChannel::PrepareToRasterize(size_t x, size_t y)
+void DisplayedChannel::PrepareToRasterize(size_t x, size_t y, bool persist)
 {
-	bool sizeChanged = (m_rasterizedX != x) || (m_rasterizedY != y);
+	UseOwnBackBuffer();
+
+	size_t back = m_frontBuffer ^ 1;
+	auto& buf = *m_rasterBuffers[back];
 
-	m_rasterizedX = x;
-	m_rasterizedY = y;
+	bool sizeChanged = (m_rasterizedX[back] != x) || (m_rasterizedY[back] != y);
 
-	if(sizeChanged)
+	m_rasterizedX[back] = x;
+	m_rasterizedY[back] = y;
+
+	//Persistence accumulates onto the most recent image, which is in the front buffer
+	bool frontMatches =
+		(m_rasterizedX[m_frontBuffer] == x) &&
+		(m_rasterizedY[m_frontBuffer] == y) &&
+		(m_rasterOffset[m_frontBuffer] == 0);
+	if(persist && frontMatches)
+	{
+		buf.resize(x*y);
+		buf.CopyFrom(*m_rasterBuffers[m_frontBuffer]);
+	}
+
+	else if(sizeChanged)
 	{
 		size_t npixels = x*y;
-		m_rasterizedWaveform.resize(npixels);
+		buf.resize(npixels);
 
 		//fill with black
-		m_rasterizedWaveform.PrepareForCpuAccess();
-		memset(m_rasterizedWaveform.GetCpuPointer(), 0, npixels * sizeof(float));
-		m_rasterizedWaveform.MarkModifiedFromCpu();
+		buf.PrepareForCpuAccess();
+		memset(buf.GetCpuPointer(), 0, npixels * sizeof(float));
+		buf.MarkModifiedFromCpu();
 	}
 
 	//Allocate index buffer for sparse waveforms
 	if(!IsDensePacked())
+	{
 		m_indexBuffer.resize(x);
+		m_indexTargets.resize(x);
+	}
+}
+
+/**
+	@brief Makes the back buffer the displayed one, if a new image was rasterized into it
+
+	Must only be called once the GPU has finished drawing, with the rasterized waveform mutex held.
+ */
+void DisplayedChannel::PublishRasterizedWaveform()
+{
+	if(!m_backBufferReady)
+		return;
+
+	m_frontBuffer ^= 1;
+	m_backBufferReady = false;
+
+	//Don't keep a reference to a bus raster buffer we're no longer displaying, so the bus rasterizer can reuse it
+	UseOwnBackBuffer();
+}
+
+/**
+	@brief Points the back buffer at one of our own raster buffers, if it currently points to a bus raster buffer
+ */
+void DisplayedChannel::UseOwnBackBuffer()
+{
+	size_t back = m_frontBuffer ^ 1;
+	if( (m_rasterBuffers[back] == m_ownRasterBuffers[0]) || (m_rasterBuffers[back] == m_ownRasterBuffers[1]) )
+		return;
+
+	if(m_rasterBuffers[m_frontBuffer] == m_ownRasterBuffers[0])
+		m_rasterBuffers[back] = m_ownRasterBuffers[1];
+	else
+		m_rasterBuffers[back] = m_ownRasterBuffers[0];
+	m_rasterOffset[back] = 0;
+
+	//Contents are unknown, force a clear before drawing into it
+	m_rasterizedX[back] = 0;
+	m_rasterizedY[back] = 0;
+}
+
+/**
+	@brief Uses a strip of a DigitalBusRasterizer's output as the back buffer, and marks it as rasterized
+
+	@param buf				The bus raster buffer
+	@param offset			Offset of this channel's strip within the buffer, in pixels
+	@param x				Width of the strip
+	@param y				Height of the strip
+	@param pointsPerPixel	Average number of points drawn per pixel column
+ */
+void DisplayedChannel::SetBusRasterTarget(
+	shared_ptr< AcceleratorBuffer<float> > buf,
+	size_t offset,
+	size_t x,
+	size_t y,
+	float pointsPerPixel)
+{
+	size_t back = m_frontBuffer ^ 1;
+	m_rasterBuffers[back] = buf;
+	m_rasterOffset[back] = offset;
+	m_rasterizedX[back] = x;
+	m_rasterizedY[back] = y;
+	MarkRasterized(pointsPerPixel);
 }
 
 /**
@@ -1651,104 +1757,58 @@ void WaveformArea::RenderProtocolWaveform(std::shared_ptr<DisplayedChannel> chan
 	auto data = dynamic_cast<SparseWaveformBase*>(stream.GetData());
 	if(data == nullptr)
 		return;
-	data->CacheColors();
-
-	auto list = ImGui::GetWindowDrawList();
-
-	//Calculate a bunch of constants
-	int64_t offset = m_group->GetXAxisOffset();
-	int64_t offset_samples = (offset - data->m_triggerPhase) / data->m_timescale;
 
-	//Find the index of the first sample visible on screen
-	data->PrepareForCpuAccess();
-	auto ifirst = BinarySearchForGequal(
-		data->m_offsets.GetCpuPointer(),
-		data->size(),
-		offset_samples);
+	//Merge skinny cells for the current zoom level (only does any work if the data or zoom changed)
+	auto& cache = channel->GetProtocolRenderCache();
+	cache.Update(data, m_group->GetPixelsPerXUnit());
+	auto& spans = cache.GetSpans();
 
-	//Go left by one sample
-	//The last sample BEFORE the left side of our view might extend into the visible space
-	if(ifirst > 0)
-		ifirst --;
+	auto list = ImGui::GetWindowDrawList();
+	auto font = m_parent->GetFontPref("Appearance.Decodes.protocol_font");
+	auto fontSize = font->FontSize * ImGui::GetIO().FontGlobalScale;
 
 	float ybot = (channel->GetYButtonPos() * ImGui::GetWindowDpiScale()) + start.y;
 	float ytop = ybot - m_channelButtonHeight;
 	float ymid = ybot - m_channelButtonHeight/2;
 
-	//Draw the actual stuff
-	size_t len = data->size();
+	//Draw the actual stuff, starting from the first span visible on screen
+	size_t len = spans.size();
 	size_t xend = start.x + size.x;
-	for(size_t i=ifirst; i<len; i++)
+	for(size_t i=cache.FindFirstVisible(m_group->GetXAxisOffset()); i<len; i++)
 	{
-		int64_t tstart = (data->m_offsets[i] * data->m_timescale) + data->m_triggerPhase;
-		int64_t end = tstart + (data->m_durations[i] * data->m_timescale);
+		auto& span = spans[i];
 
-		double xs = m_group->XAxisUnitsToXPosition(tstart);
-		double xe = m_group->XAxisUnitsToXPosition(end);
+		double xs = m_group->XAxisUnitsToXPosition(span.m_start);
+		double xe = m_group->XAxisUnitsToXPosition(span.m_end);
 
 		if(xe < start.x)
 			continue;
 		if(xs > xend)
 			break;
 
-		double cellwidth = xe - xs;
-		auto color = data->GetColorCached(i);
-		if(cellwidth < 2)
+		//There's no text to render in merged or really skinny cells, so don't waste time with that
+		if( (span.m_count > 1) || ( (xe - xs) < 2) )
 		{
-			//This sample is really skinny. There's no text to render so don't waste time with that.
-
-			//Average the color of all samples touching this pixel
-			size_t nmerged = 1;
-			float sum_red = (color >> IM_COL32_R_SHIFT) & 0xff;
-			float sum_green = (color >> IM_COL32_G_SHIFT) & 0xff;
-			float sum_blue = (color >> IM_COL32_B_SHIFT) & 0xff;
-			for(size_t j=i+1; j<len; j++)
-			{
-				int64_t cellstart = (data->m_offsets[j] * data->m_timescale) + data->m_triggerPhase;
-				double cellxs = m_group->XAxisUnitsToXPosition(cellstart);
-
-				if(cellxs > xs+2)
-					break;
-
-				auto c = data->GetColorCached(j);
-
-				sum_red += (c >> IM_COL32_R_SHIFT) & 0xff;
-				sum_green += (c >> IM_COL32_G_SHIFT) & 0xff;
-				sum_blue += (c >> IM_COL32_B_SHIFT) & 0xff;
-				nmerged ++;
-
-				//Skip these samples in the outer loop
-				i = j-1;
-			}
-
-			//Render a single box for them all
-			sum_red /= nmerged;
-			sum_green /= nmerged;
-			sum_blue /= nmerged;
-			color =
-				((static_cast<int>(sum_red) & 0xff) << IM_COL32_R_SHIFT) |
-				((static_cast<int>(sum_green) & 0xff) << IM_COL32_G_SHIFT) |
-				((static_cast<int>(sum_blue) & 0xff) << IM_COL32_B_SHIFT) |
-				(0xff << IM_COL32_A_SHIFT);
-
-
 			RenderComplexSignal(
 				list,
 				start.x, xend,
 				xs, xe, 5,
 				ybot, ymid, ytop,
 				"",
-				color);
+				span.m_color);
 		}
 		else
 		{
+			ImVec2 textsize;
+			auto& text = cache.GetText(data, span.m_index, font, fontSize, textsize);
 			RenderComplexSignal(
 				list,
 				start.x, xend,
 				xs, xe, 5,
 				ybot, ymid, ytop,
-				data->GetText(i),
-				color);
+				text,
+				span.m_color,
+				textsize);
 		}
 	}
 }
@@ -1759,7 +1819,8 @@ void WaveformArea::RenderComplexSignal(
 		float xstart, float xend, float xoff,
 		float ybot, float ymid, float ytop,
 		string str,
-		ImU32 color)
+		ImU32 color,
+		ImVec2 textsize)
 {
 	//Clamp start point to left side of display
 	if(xstart < visleft)
@@ -1786,7 +1847,8 @@ void WaveformArea::RenderComplexSignal(
 	{
 		auto font = m_parent->GetFontPref("Appearance.Decodes.protocol_font");
 		auto fontSize = font->FontSize * ImGui::GetIO().FontGlobalScale;
-		auto textsize = font->CalcTextSizeA(fontSize, FLT_MAX, 0, str.c_str());
+		if(textsize.x < 0)
+			textsize = font->CalcTextSizeA(fontSize, FLT_MAX, 0, str.c_str());
 
 		//Minimum width (if outline ends up being smaller than this, just fill)
 		float min_width = 40;
@@ -1925,38 +1987,69 @@ void WaveformArea::MakePathSignalBody(ImDrawList* list, float xstart, float xend
 	list->PathLineTo(ImVec2(xstart, 			ymid));	//left point again
 }
 
+/**
+	@brief Gets the name of this area for GPU profiling, e.g. "Group 1 area 2"
+ */
+string WaveformArea::GetProfilingName()
+{
+	auto areas = m_group->GetWaveformAreas();
+	for(size_t i=0; i<areas.size(); i++)
+	{
+		if(areas[i].get() == this)
+			return GpuProfiler::EscapeName(m_group->GetTitle() + " area " + to_string(i+1));
+	}
+	return GpuProfiler::EscapeName(m_group->GetTitle());
+}
+
 /**
 	@brief Tone map our waveforms
  */
 void WaveformArea::ToneMapAllWaveforms(vk::raii::CommandBuffer& cmdbuf)
 {
+	string area = GetProfilingName();
 	for(auto& chan : m_displayedChannels)
 	{
 		auto stream = chan->GetStream();
 		if(chan->GetStream().IsOutOfRange())
 			continue;
 
+		string suffix = "/" + area + "/" + GpuProfiler::EscapeName(chan->GetName());
 		switch(stream.GetType())
 		{
 			case Stream::STREAM_TYPE_ANALOG:
 			case Stream::STREAM_TYPE_DIGITAL:
-				ToneMapAnalogOrDigitalWaveform(chan, cmdbuf);
+				{
+					GpuTimestampScope scope(cmdbuf, "Tone map" + suffix);
+					ToneMapAnalogOrDigitalWaveform(chan, cmdbuf);
+				}
 				break;
 
 			case Stream::STREAM_TYPE_WATERFALL:
-				ToneMapWaterfallWaveform(chan, cmdbuf);
+				{
+					GpuTimestampScope scope(cmdbuf, "Waterfall" + suffix);
+					ToneMapWaterfallWaveform(chan, cmdbuf);
+				}
 				break;
 
 			case Stream::STREAM_TYPE_SPECTROGRAM:
-				ToneMapSpectrogramWaveform(chan, cmdbuf);
+				{
+					GpuTimestampScope scope(cmdbuf, "Spectrogram" + suffix);
+					ToneMapSpectrogramWaveform(chan, cmdbuf);
+				}
 				break;
 
 			case Stream::STREAM_TYPE_EYE:
-				ToneMapEyeWaveform(chan, cmdbuf);
+				{
+					GpuTimestampScope scope(cmdbuf, "Eye" + suffix);
+					ToneMapEyeWaveform(chan, cmdbuf);
+				}
 				break;
 
 			case Stream::STREAM_TYPE_CONSTELLATION:
-				ToneMapConstellationWaveform(chan, cmdbuf);
+				{
+					GpuTimestampScope scope(cmdbuf, "Constellation" + suffix);
+					ToneMapConstellationWaveform(chan, cmdbuf);
+				}
 				break;
 
 			//no tone mapping required
@@ -1994,17 +2087,29 @@ void WaveformArea::RenderWaveformTextures(
 	bool clearThisAreaOnly = m_clearPersistence.exchange(false);
 	bool clearing = clearThisAreaOnly || clearPersistence;
 
+	string prefix = "Rasterize/" + GetProfilingName() + "/";
+
+	//Wide digital captures are drawn all at once, anything else one channel at a time
+	set<DisplayedChannel*> drawnAsBus;
+	if(!ShouldUseCpuRasterizer())
+		drawnAsBus = RasterizeDigitalBus(cmdbuf, chans);
+
 	for(auto& chan : chans)
 	{
 		auto stream = chan->GetStream();
 		if(chan->GetStream().IsOutOfRange())
 			continue;
+		if(drawnAsBus.find(chan.get()) != drawnAsBus.end())
+			continue;
 
 		switch(stream.GetType())
 		{
 			case Stream::STREAM_TYPE_ANALOG:
 			case Stream::STREAM_TYPE_DIGITAL:
-				RasterizeAnalogOrDigitalWaveform(chan, cmdbuf, clearing);
+				{
+					GpuTimestampScope scope(cmdbuf, prefix + GpuProfiler::EscapeName(chan->GetName()));
+					RasterizeAnalogOrDigitalWaveform(chan, cmdbuf, clearing);
+				}
 				break;
 
 			//no background rendering required, we do everything in Refresh()
@@ -2029,6 +2134,108 @@ void WaveformArea::RenderWaveformTextures(
 	}
 }
 
+/**
+	@brief Rasterizes all of the uniform digital channels sharing a timebase with a single dispatch
+
+	Only channels without persistence are considered, since a shared strip buffer has no per-channel history to
+	accumulate into. If there are too few qualifying channels, nothing is drawn.
+
+	@param cmdbuf	Command buffer to record rendering commands into
+	@param chans	Channels displayed in this area
+
+	@return The channels that were drawn (or were already up to date), so the caller can skip them
+ */
+set<DisplayedChannel*> WaveformArea::RasterizeDigitalBus(
+	vk::raii::CommandBuffer& cmdbuf,
+	vector<shared_ptr<DisplayedChannel> >& chans)
+{
+	set<DisplayedChannel*> ret;
+	if(m_height < 0)
+		return ret;
+
+	//Find channels that can be drawn together: all must match the first one found
+	vector<DisplayedChannel*> bus;
+	vector<UniformDigitalWaveform*> waveforms;
+	for(auto& chan : chans)
+	{
+		auto stream = chan->GetStream();
+		if(stream.IsOutOfRange() || (stream.GetType() != Stream::STREAM_TYPE_DIGITAL) || chan->IsPersistenceEnabled())
+			continue;
+		auto data = dynamic_cast<UniformDigitalWaveform*>(stream.GetData());
+		if( (data == nullptr) || (data->size() < 2) )
+			continue;
+
+		if(!waveforms.empty())
+		{
+			auto first = waveforms[0];
+			if( (data->m_timescale != first->m_timescale) ||
+				(data->m_triggerPhase != first->m_triggerPhase) ||
+				(data->size() != first->size()) )
+			{
+				continue;
+			}
+		}
+
+		bus.push_back(chan.get());
+		waveforms.push_back(data);
+	}
+	if(bus.size() < DigitalBusRasterizer::MIN_CHANNELS)
+		return ret;
+
+	//Same configuration as RasterizeAnalogOrDigitalWaveform() would use for each channel
+	auto data = waveforms[0];
+	size_t w = m_width;
+	size_t h = m_channelButtonHeight;
+	double pixelsPerX = m_group->GetPixelsPerXUnit();
+	auto config = WaveformRasterizer::GetConfig(data, m_group->GetXAxisOffset(), pixelsPerX, w, h, true, 0, 0);
+	float samplesPerPixel = data->size() / ((data->size() - 1) * config.xscale);
+
+	for(auto chan : bus)
+		ret.emplace(chan);
+
+	//If every channel is unchanged, the existing images are still good
+	bool changed = false;
+	for(size_t i=0; i<bus.size(); i++)
+	{
+		WaveformRenderKey key(
+			waveforms[i],
+			config,
+			false,
+			bus[i]->ShouldFillUnder(),
+			bus[i]->ZeroHoldFlagSet(),
+			bus[i]->ShouldMapDurations());
+		if(key == bus[i]->GetRenderKey())
+			continue;
+
+		bus[i]->GetRenderKey() = key;
+		changed = true;
+	}
+	if(!changed)
+	{
+		g_rasterizeSkipCount += bus.size();
+		return ret;
+	}
+
+	if( (w == 0) || (h == 0) )
+	{
+		for(auto chan : bus)
+		{
+			chan->PrepareToRasterize(0, 0, false);
+			chan->MarkRasterized(1);
+		}
+		return ret;
+	}
+
+	GpuTimestampScope scope(cmdbuf, "Rasterize/" + GetProfilingName() + "/Digital bus");
+	m_digitalBus.Pack(waveforms);
+	auto strip = m_digitalBus.Rasterize(cmdbuf, config);
+	for(size_t i=0; i<bus.size(); i++)
+		bus[i]->SetBusRasterTarget(strip, i*w*h, w, h, samplesPerPixel);
+	g_gpuRasterizeCount += bus.size();
+
+	return ret;
+}
+
 void WaveformArea::RasterizeAnalogOrDigitalWaveform(
 	shared_ptr<DisplayedChannel> channel,
 	vk::raii::CommandBuffer& cmdbuf,
@@ -2048,21 +2255,21 @@ void WaveformArea::RasterizeAnalogOrDigitalWaveform(
 	//If no data (or an empty buffer with no samples), set to 0x0 pixels and return
 	if( (data == nullptr) || data->empty() )
 	{
-		channel->PrepareToRasterize(0, 0);
+		channel->PrepareToRasterize(0, 0, false);
+		channel->MarkRasterized(1);
+		channel->GetRenderKey() = WaveformRenderKey();
 		return;
 	}
 	size_t w = m_width;
 	size_t h = m_height;
 	if(channel->GetStream().GetType() == Stream::STREAM_TYPE_DIGITAL)
 		h = m_channelButtonHeight;
-	channel->PrepareToRasterize(w, h);
 
 	shared_ptr<ComputePipeline> comp;
 
 	//Calculate a bunch of constants
 	int64_t offset = m_group->GetXAxisOffset();
 	int64_t innerxoff = offset / data->m_timescale;
-	int64_t fractional_offset = offset % data->m_timescale;
 	int64_t offset_samples = (offset - data->m_triggerPhase) / data->m_timescale;
 	double pixelsPerX = m_group->GetPixelsPerXUnit();
 	double xscale = data->m_timescale * pixelsPerX;
@@ -2074,109 +2281,271 @@ void WaveformArea::RasterizeAnalogOrDigitalWaveform(
 	auto sadata = dynamic_cast<SparseAnalogWaveform*>(data);
 	auto uddata = dynamic_cast<UniformDigitalWaveform*>(data);
 	auto sddata = dynamic_cast<SparseDigitalWaveform*>(data);
+	bool cpu = ShouldUseCpuRasterizer();
+
+	//Deep uniform analog waveforms zoomed far out are drawn from a min/max envelope rather than raw samples.
+	//Fill-under and zero-hold rendering need every sample, so they always use the raw waveform.
+	size_t level = 0;
+	AcceleratorBuffer<float>* samples = nullptr;
 	if(uadata)
 	{
-		if(channel->ShouldFillUnder())
-			comp = channel->GetHistogramPipeline();
-		else
-			comp = channel->GetUniformAnalogPipeline();
+		samples = &uadata->m_samples;
+		if(!channel->ShouldFillUnder() && !channel->ZeroHoldFlagSet())
+		{
+			level = WaveformPyramid::SelectLevel(1.0 / xscale, data->size());
+			if(level > 0)
+				samples = &channel->GetPyramid().GetLevel(uadata, level, cpu, cmdbuf);
+			else
+				channel->GetPyramid().Clear();
+		}
+	}
+
+	//Measure how many samples land in each pixel column.
+	//Intensity grading by zoom and trace alpha is applied at tone mapping time, so the raster buffer holds plain
+	//hit counts and dragging the intensity slider doesn't need a re-render.
+	auto end = data->size() - 1;
+	int64_t firstOff = GetOffsetScaled(sdata, udata, 0);
+	int64_t lastOff = GetOffsetScaled(sdata, udata, end);
+	float capture_len = lastOff - firstOff;
+	float avg_sample_len = capture_len / data->size();
+	float samplesPerPixel = 1.0 / (pixelsPerX * avg_sample_len);
+	float pointsPerPixel = samplesPerPixel;
+
+	//Fill shader configuration
+	auto config = WaveformRasterizer::GetConfig(
+		data,
+		offset,
+		pixelsPerX,
+		w,
+		h,
+		!(sadata || uadata),
+		m_pixelsPerYAxisUnit,
+		stream.GetOffset());
+	if(channel->IsPersistenceEnabled() && !clearPersistence)
+		config.persistScale = m_parent->GetPersistDecay();
+
+	//Rendering from a pyramid level: each point stands for "step" samples, so rescale the X axis to match.
+	//The part of the trigger offset that isn't a whole number of points goes into the floating point offset.
+	if(level > 0)
+	{
+		int64_t step = WaveformPyramid::GetLevelStep(level);
+		int64_t q = WaveformPyramid::FloorDivide(-innerxoff, step);
+		int64_t r = -innerxoff - q*step;
+
+		config.innerXoff = q;
+		config.xoff += r * xscale;
+		config.xscale = xscale * step;
+		config.offset_samples = WaveformPyramid::FloorDivide(offset_samples, step) - 2;
+		config.memDepth = samples->size();
+
+		//Intensity grading by envelope points rather than raw samples (only approximate)
+		pointsPerPixel = samplesPerPixel / step;
 	}
-	else if(uddata)
-		comp = channel->GetUniformDigitalPipeline();
-	else if(sadata)
-		comp = channel->GetSparseAnalogPipeline();
-	else if(sddata)
-		comp = channel->GetSparseDigitalPipeline();
-	if(!comp)
+
+	//If nothing changed since we last drew this channel, the existing image is still good
+	WaveformRenderKey key(
+		data,
+		config,
+		cpu,
+		channel->ShouldFillUnder(),
+		channel->ZeroHoldFlagSet(),
+		channel->ShouldMapDurations());
+	if(key == channel->GetRenderKey())
 	{
-		LogWarning("no pipeline found\n");
+		g_rasterizeSkipCount ++;
 		return;
 	}
+	channel->GetRenderKey() = key;
 
-	//Bind input buffers
-	if(uadata)
-		comp->BindBufferNonblocking(1, uadata->m_samples, cmdbuf);
-	if(uddata)
-		comp->BindBufferNonblocking(1, uddata->m_samples, cmdbuf);
-	if(sdata)
+	//Allocate the back buffer, and bail if there's nothing to draw into
+	channel->PrepareToRasterize(w, h, config.persistScale != 0);
+	auto& imgOut = channel->GetRasterizedWaveform();
+	if(imgOut.empty())
+		return;
+	channel->MarkRasterized(pointsPerPixel);
+
+	if(!cpu)
 	{
-		if(sadata)
-			comp->BindBufferNonblocking(1, sadata->m_samples, cmdbuf);
-		if(sddata)
-			comp->BindBufferNonblocking(1, sddata->m_samples, cmdbuf);
+		if(uadata)
+		{
+			if(channel->ShouldFillUnder())
+				comp = channel->GetHistogramPipeline();
+			else
+				comp = channel->GetUniformAnalogPipeline();
+		}
+		else if(uddata)
+			comp = channel->GetUniformDigitalPipeline();
+		else if(sadata)
+			comp = channel->GetSparseAnalogPipeline();
+		else if(sddata)
+			comp = channel->GetSparseDigitalPipeline();
+		if(!comp)
+		{
+			LogWarning("no pipeline found\n");
+			return;
+		}
 
-		//Map offsets and, if requested, durations
-		comp->BindBufferNonblocking(2, sdata->m_offsets, cmdbuf);
-		if(channel->ShouldMapDurations())
-			comp->BindBufferNonblocking(4, sdata->m_durations, cmdbuf);
+		//Bind input buffers
+		if(uadata)
+			comp->BindBufferNonblocking(1, *samples, cmdbuf);
+		if(uddata)
+			comp->BindBufferNonblocking(1, uddata->m_samples, cmdbuf);
+		if(sdata)
+		{
+			if(sadata)
+				comp->BindBufferNonblocking(1, sadata->m_samples, cmdbuf);
+			if(sddata)
+				comp->BindBufferNonblocking(1, sddata->m_samples, cmdbuf);
+
+			//Map offsets and, if requested, durations
+			comp->BindBufferNonblocking(2, sdata->m_offsets, cmdbuf);
+			if(channel->ShouldMapDurations())
+				comp->BindBufferNonblocking(4, sdata->m_durations, cmdbuf);
+		}
+	}
 
-		//Calculate indexes for X axis
-		auto& ibuf = channel->GetIndexBuffer();
-		ibuf.PrepareForCpuAccess();
-		sdata->m_offsets.PrepareForCpuAccess();
+	//Calculate indexes for X axis.
+	//Only the (tiny) per-column targets are calculated here. The search runs wherever the rasterizer does, so that
+	//panning or zooming a GPU-resident waveform never has to copy the offsets back to the host.
+	if(sdata)
+	{
+		auto& targets = channel->GetIndexTargetBuffer();
+		targets.PrepareForCpuAccess();
 		for(size_t i=0; i<w; i++)
+			targets[i] = floor(i / xscale) + offset_samples;
+		targets.MarkModifiedFromCpu();
+
+		auto& ibuf = channel->GetIndexBuffer();
+		if(cpu)
 		{
-			int64_t target = floor(i / xscale) + offset_samples;
-			ibuf[i] = BinarySearchForGequal(
+			ibuf.PrepareForCpuAccess();
+			sdata->m_offsets.PrepareForCpuAccess();
+			WaveformRasterizer::ComputeIndexes(
 				sdata->m_offsets.GetCpuPointer(),
 				data->size(),
-				target);
+				targets.GetCpuPointer(),
+				ibuf.GetCpuPointer(),
+				w);
+			ibuf.MarkModifiedFromCpu();
+		}
+		else
+		{
+			auto ipipe = channel->GetIndexPipeline();
+			ipipe->BindBufferNonblocking(0, sdata->m_offsets, cmdbuf);
+			ipipe->BindBufferNonblocking(1, targets, cmdbuf);
+			ipipe->BindBufferNonblocking(2, ibuf, cmdbuf, true);
+			WaveformIndexArgs args(data->size(), w);
+			ipipe->Dispatch(cmdbuf, args, GetComputeBlockCount(w, 64));
+			ipipe->AddComputeMemoryBarrier(cmdbuf);
+			ibuf.MarkModifiedFromGpu();
+
+			comp->BindBufferNonblocking(3, ibuf, cmdbuf);
 		}
-		ibuf.MarkModifiedFromCpu();
-		comp->BindBufferNonblocking(3, ibuf, cmdbuf);
 	}
 
-	//Bind output texture and bail if there's nothing there
-	auto& imgOut = channel->GetRasterizedWaveform();
-	if(imgOut.empty())
-		return;
-	comp->BindBufferNonblocking(0, imgOut, cmdbuf);
-
-	//Scale alpha by zoom.
-	//As we zoom out more, reduce alpha to get proper intensity grading
-	//TODO: make this constant, then apply a second alpha pass in tone mapping?
-	//This will eliminate the need for a (potentially heavy) re-render when adjusting the slider.
-	float alpha = m_parent->GetTraceAlpha();
-	auto end = data->size() - 1;
-	int64_t firstOff = GetOffsetScaled(sdata, udata, 0);
-	int64_t lastOff = GetOffsetScaled(sdata, udata, end);
-	float capture_len = lastOff - firstOff;
-	float avg_sample_len = capture_len / data->size();
-	float samplesPerPixel = 1.0 / (pixelsPerX * avg_sample_len);
-	float alpha_scaled = alpha / sqrt(samplesPerPixel);
-	alpha_scaled = min(1.0f, alpha_scaled) * 2;
+	if(!cpu)
+		comp->BindBufferNonblocking(0, imgOut, cmdbuf);
 
-	//Fill shader configuration
-	ConfigPushConstants config;
-	config.innerXoff = -innerxoff;
-	config.windowHeight = h;
-	config.windowWidth = w;
-	config.memDepth = data->size();
-	config.offset_samples = offset_samples - 2;
-	config.alpha = alpha_scaled;
-	config.xoff = (data->m_triggerPhase - fractional_offset) * pixelsPerX;
-	config.xscale = xscale;
-	if(sadata || uadata)	//analog
-	{
-		config.yscale = m_pixelsPerYAxisUnit;
-		config.yoff = stream.GetOffset();
-		config.ybase = h * 0.5f;
-	}
-	else					//digital
+	if(cpu)
 	{
-		config.yoff = 0;
-		config.yscale = m_channelButtonHeight - 1;
-		config.ybase = 0;
+		RasterizeOnCpu(channel, config, samples);
+		return;
 	}
-	if(channel->IsPersistenceEnabled() && !clearPersistence)
-		config.persistScale = m_parent->GetPersistDecay();
-	else
-		config.persistScale = 0;
 
 	//Dispatch the shader
 	comp->Dispatch(cmdbuf, config, w, 1, 1);
 	comp->AddComputeMemoryBarrier(cmdbuf);
 	imgOut.MarkModifiedFromGpu();
+	g_gpuRasterizeCount ++;
+}
+
+/**
+	@brief Rasterizes an analog or digital waveform with WaveformRasterizer rather than the compute shader
+
+	The output buffer is pushed to the GPU when the tone mapping shader binds it.
+
+	@param channel	The channel to draw
+	@param config	Rendering configuration, exactly as would be pushed to the shader
+	@param samples	Samples to draw for uniform analog waveforms (either the raw samples or a pyramid level)
+ */
+void WaveformArea::RasterizeOnCpu(
+	shared_ptr<DisplayedChannel> channel,
+	const ConfigPushConstants& config,
+	AcceleratorBuffer<float>* samples)
+{
+	double start = GetTime();
+
+	auto data = channel->GetStream().GetData();
+	auto sdata = dynamic_cast<SparseWaveformBase*>(data);
+	auto uadata = dynamic_cast<UniformAnalogWaveform*>(data);
+	auto sadata = dynamic_cast<SparseAnalogWaveform*>(data);
+	auto uddata = dynamic_cast<UniformDigitalWaveform*>(data);
+	auto sddata = dynamic_cast<SparseDigitalWaveform*>(data);
+
+	//Same variant selection as the shader pipelines
+	WaveformRasterizer::Inputs inputs;
+	auto variant = WaveformRasterizer::VARIANT_ANALOG;
+	if(uadata || sadata)
+	{
+		if(uadata && channel->ShouldFillUnder())
+			variant = WaveformRasterizer::VARIANT_HISTOGRAM;
+		else if(channel->ZeroHoldFlagSet())
+			variant = WaveformRasterizer::VARIANT_ANALOG_ZEROHOLD;
+
+		auto& analog = uadata ? *samples : sadata->m_samples;
+		analog.PrepareForCpuAccess();
+		inputs.m_analog = analog.GetCpuPointer();
+	}
+	else
+	{
+		variant = WaveformRasterizer::VARIANT_DIGITAL;
+
+		auto& samples = uddata ? uddata->m_samples : sddata->m_samples;
+		samples.PrepareForCpuAccess();
+		inputs.m_digital = reinterpret_cast<const uint8_t*>(samples.GetCpuPointer());
+	}
+	if(sdata)
+	{
+		//Offsets and index buffer were already made CPU-accessible by ComputeIndexes()
+		inputs.m_offsets = sdata->m_offsets.GetCpuPointer();
+		inputs.m_indexes = channel->GetIndexBuffer().GetCpuPointer();
+		if(channel->ShouldMapDurations())
+		{
+			sdata->m_durations.PrepareForCpuAccess();
+			inputs.m_durations = sdata->m_durations.GetCpuPointer();
+		}
+	}
+
+	auto& imgOut = channel->GetRasterizedWaveform();
+	imgOut.PrepareForCpuAccess();
+	WaveformRasterizer::Rasterize(config, variant, (sdata == nullptr), inputs, imgOut.GetCpuPointer());
+	imgOut.MarkModifiedFromCpu();
+
+	g_cpuRasterizeTime += (GetTime() - start) * FS_PER_SECOND;
+	g_cpuRasterizeCount ++;
+}
+
+/**
+	@brief Decides whether waveforms should be rasterized on the CPU or with the compute shader
+ */
+bool WaveformArea::ShouldUseCpuRasterizer()
+{
+	switch(m_parent->GetSession().GetPreferences().GetEnumRaw("Miscellaneous.Rendering.rasterizer"))
+	{
+		case 1:
+			return false;
+
+		case 2:
+			return true;
+
+		//Automatic: CPU if the "GPU" is really a software implementation
+		default:
+			{
+				static bool softwareDevice =
+					(g_vkComputePhysicalDevice->getProperties().deviceType == vk::PhysicalDeviceType::eCpu);
+				return softwareDevice;
+			}
+	}
 }
 
 /**
@@ -2189,21 +2558,25 @@ void WaveformArea::ToneMapAnalogOrDigitalWaveform(shared_ptr<DisplayedChannel> c
 		return;
 
 	//Nothing to draw? Early out if we haven't processed the window resize yet or there's no data
-	auto width = channel->GetRasterizedX();
-	auto height = channel->GetRasterizedY();
+	auto width = channel->GetDisplayedX();
+	auto height = channel->GetDisplayedY();
 	if( (width == 0) || (height == 0) )
 		return;
 
 	//Run the actual compute shader
 	auto pipe = channel->GetToneMapPipeline();
-	pipe->BindBufferNonblocking(0, channel->GetRasterizedWaveform(), cmdbuf);
+	pipe->BindBufferNonblocking(0, channel->GetDisplayedWaveform(), cmdbuf);
 	pipe->BindStorageImage(
 		1,
 		**m_parent->GetTextureManager()->GetSampler(),
 		tex->GetView(),
 		vk::ImageLayout::eGeneral);
+	//Scale alpha by zoom
+	float alpha = WaveformRasterizer::GetToneMapAlpha(
+		m_parent->GetTraceAlpha(), channel->GetDisplayedPointsPerPixel());
+
 	auto color = ImGui::ColorConvertU32ToFloat4(ColorFromString(channel->GetStream().m_channel->m_displaycolor));
-	WaveformToneMapArgs args(color, width, height);
+	WaveformToneMapArgs args(color, width, height, alpha, channel->GetDisplayedOffset());
 	pipe->Dispatch(cmdbuf, args, GetComputeBlockCount(width, 64), height);
 
 	//Add a barrier before we read from the fragment shader
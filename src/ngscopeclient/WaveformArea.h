@@ -40,17 +40,23 @@ class WaveformGroup;
 class MainWindow;
 
 #include "TextureManager.h"
+#include "DigitalBusRasterizer.h"
 #include "Marker.h"
+#include "ProtocolRenderCache.h"
+#include "WaveformPyramid.h"
+#include "WaveformRasterizer.h"
 
 class WaveformToneMapArgs
 {
 public:
-	WaveformToneMapArgs(ImVec4 channelColor, uint32_t w, uint32_t h)
+	WaveformToneMapArgs(ImVec4 channelColor, uint32_t w, uint32_t h, float alpha, uint32_t offset)
 	: m_red(channelColor.x)
 	, m_green(channelColor.y)
 	, m_blue(channelColor.z)
 	, m_width(w)
 	, m_height(h)
+	, m_alpha(alpha)
+	, m_offset(offset)
 	{}
 
 	float m_red;
@@ -58,6 +64,8 @@ public:
 	float m_blue;
 	uint32_t m_width;
 	uint32_t m_height;
+	float m_alpha;
+	uint32_t m_offset;
 };
 
 class EyeToneMapArgs
@@ -129,22 +137,6 @@ public:
 	float m_yscale;
 };
 
-struct ConfigPushConstants
-{
-	int64_t innerXoff;
-	uint32_t windowHeight;
-	uint32_t windowWidth;
-	uint32_t memDepth;
-	uint32_t offset_samples;
-	float alpha;
-	float xoff;
-	float xscale;
-	float ybase;
-	float yscale;
-	float yoff;
-	float persistScale;
-};
-
 /**
 	@brief State for a single peak label
 
@@ -183,6 +175,84 @@ struct PeakLabel
 	float m_fwhm;
 };
 
+/**
+	@brief Everything that affects the rasterized image of an analog or digital channel
+
+	If this is unchanged since a channel was last rasterized, the existing image is still valid and the channel does
+	not need to be drawn again.
+ */
+class WaveformRenderKey
+{
+public:
+	WaveformRenderKey()
+	: m_config{}
+	, m_cpu(false)
+	, m_fillUnder(false)
+	, m_zeroHold(false)
+	, m_mapDurations(false)
+	{}
+
+	WaveformRenderKey(
+		WaveformBase* data,
+		const ConfigPushConstants& config,
+		bool cpu,
+		bool fillUnder,
+		bool zeroHold,
+		bool mapDurations)
+	: m_data(data)
+	, m_config(config)
+	, m_cpu(cpu)
+	, m_fillUnder(fillUnder)
+	, m_zeroHold(zeroHold)
+	, m_mapDurations(mapDurations)
+	{}
+
+	bool operator==(const WaveformRenderKey& rhs) const
+	{
+		return
+			(m_data == rhs.m_data) &&
+			(m_config.innerXoff == rhs.m_config.innerXoff) &&
+			(m_config.windowHeight == rhs.m_config.windowHeight) &&
+			(m_config.windowWidth == rhs.m_config.windowWidth) &&
+			(m_config.memDepth == rhs.m_config.memDepth) &&
+			(m_config.offset_samples == rhs.m_config.offset_samples) &&
+			(m_config.alpha == rhs.m_config.alpha) &&
+			(m_config.xoff == rhs.m_config.xoff) &&
+			(m_config.xscale == rhs.m_config.xscale) &&
+			(m_config.ybase == rhs.m_config.ybase) &&
+			(m_config.yscale == rhs.m_config.yscale) &&
+			(m_config.yoff == rhs.m_config.yoff) &&
+			((m_config.persistScale != 0) == (rhs.m_config.persistScale != 0)) &&
+			(m_cpu == rhs.m_cpu) &&
+			(m_fillUnder == rhs.m_fillUnder) &&
+			(m_zeroHold == rhs.m_zeroHold) &&
+			(m_mapDurations == rhs.m_mapDurations);
+	}
+
+	///@brief The waveform that was drawn
+	WaveformCacheKey m_data;
+
+	/**
+		@brief Position, scale, and size settings
+
+		Only whether persistence is enabled matters, not the decay rate: drawing the same waveform again just because
+		the decay changed would double its intensity.
+	 */
+	ConfigPushConstants m_config;
+
+	///@brief True if drawn by the CPU rasterizer
+	bool m_cpu;
+
+	///@brief Fill-under (histogram) rendering
+	bool m_fillUnder;
+
+	///@brief Zero-hold rendering
+	bool m_zeroHold;
+
+	///@brief Sample durations were used
+	bool m_mapDurations;
+};
+
 /**
 	@brief Context data for a single channel being displayed within a WaveformArea
  */
@@ -207,24 +277,67 @@ public:
 	void SetTexture(std::shared_ptr<Texture> tex)
 	{ m_texture = tex; }
 
-	void PrepareToRasterize(size_t x, size_t y);
+	void PrepareToRasterize(size_t x, size_t y, bool persist);
 
 	bool UpdateSize(ImVec2 newSize, MainWindow* top);
 
+	/**
+		@brief Gets the back buffer, which the waveform is rasterized into
+	 */
 	AcceleratorBuffer<float>& GetRasterizedWaveform()
-	{ return m_rasterizedWaveform; }
+	{ return *m_rasterBuffers[m_frontBuffer ^ 1]; }
+
+	/**
+		@brief Gets the front buffer, holding the most recently completed rasterization (to be tone mapped)
+	 */
+	AcceleratorBuffer<float>& GetDisplayedWaveform()
+	{ return *m_rasterBuffers[m_frontBuffer]; }
 
 	/**
-		@brief Return the X axis size of the rasterized waveform
+		@brief Return the offset of the displayed waveform within GetDisplayedWaveform(), in pixels
+
+		This is only nonzero if the waveform was drawn as one strip of a DigitalBusRasterizer's output.
 	 */
-	size_t GetRasterizedX()
-	{ return m_rasterizedX; }
+	size_t GetDisplayedOffset()
+	{ return m_rasterOffset[m_frontBuffer]; }
 
 	/**
-		@brief Return the Y axis size of the rasterized waveform
+		@brief Return the X axis size of the displayed waveform
 	 */
-	size_t GetRasterizedY()
-	{ return m_rasterizedY; }
+	size_t GetDisplayedX()
+	{ return m_rasterizedX[m_frontBuffer]; }
+
+	/**
+		@brief Return the Y axis size of the displayed waveform
+	 */
+	size_t GetDisplayedY()
+	{ return m_rasterizedY[m_frontBuffer]; }
+
+	/**
+		@brief Marks the back buffer as holding a new image, to be displayed at the next PublishRasterizedWaveform()
+
+		@param pointsPerPixel	Average number of points drawn per pixel column, used for intensity grading
+	 */
+	void MarkRasterized(float pointsPerPixel)
+	{
+		m_backBufferReady = true;
+		m_pointsPerPixel[m_frontBuffer ^ 1] = pointsPerPixel;
+	}
+
+	/**
+		@brief Return the average number of points per pixel column of the displayed waveform
+	 */
+	float GetDisplayedPointsPerPixel()
+	{ return m_pointsPerPixel[m_frontBuffer]; }
+
+	void PublishRasterizedWaveform();
+
+	void SetBusRasterTarget(
+		std::shared_ptr< AcceleratorBuffer<float> > buf,
+		size_t offset,
+		size_t x,
+		size_t y,
+		float pointsPerPixel);
 
 	/**
 		@brief Gets the pipeline for drawing uniform analog waveforms, creating it if necessary
@@ -371,6 +484,35 @@ public:
 	AcceleratorBuffer<uint32_t>& GetIndexBuffer()
 	{ return m_indexBuffer; }
 
+	///@brief Gets the buffer of per-column target offsets used to calculate the index buffer
+	AcceleratorBuffer<int64_t>& GetIndexTargetBuffer()
+	{ return m_indexTargets; }
+
+	/**
+		@brief Gets the pipeline for calculating X axis indexes of sparse waveforms, creating it if necessary
+	 */
+	std::shared_ptr<ComputePipeline> GetIndexPipeline()
+	{
+		if(m_indexComputePipeline == nullptr)
+		{
+			m_indexComputePipeline = std::make_shared<ComputePipeline>(
+				"shaders/WaveformIndex.spv", 3, sizeof(WaveformIndexArgs));
+		}
+		return m_indexComputePipeline;
+	}
+
+	///@brief Gets the level-of-detail cache used for drawing protocol decodes
+	ProtocolRenderCache& GetProtocolRenderCache()
+	{ return m_protocolRenderCache; }
+
+	///@brief Gets the settings this channel was last rasterized with
+	WaveformRenderKey& GetRenderKey()
+	{ return m_renderKey; }
+
+	///@brief Gets the min/max envelope pyramid used for zoomed-out rendering of uniform analog waveforms
+	WaveformPyramid& GetPyramid()
+	{ return m_pyramid; }
+
 	void SetYButtonPos(float y)
 	{ m_yButtonPos = y; }
 
@@ -383,22 +525,47 @@ public:
 	std::string m_colorRamp;
 
 protected:
+	void UseOwnBackBuffer();
+
 	StreamDescriptor m_stream;
 
 	///@brief Parent session object
 	Session& m_session;
 
-	///@brief Buffer storing our rasterized waveform, prior to tone mapping
-	AcceleratorBuffer<float> m_rasterizedWaveform;
+	/**
+		@brief Buffers storing our rasterized waveform, prior to tone mapping
+
+		The back buffer is drawn into by the waveform thread while the front buffer is tone mapped by the GUI thread.
+		They are swapped once the GPU has finished drawing.
+	 */
+	std::shared_ptr< AcceleratorBuffer<float> > m_rasterBuffers[2];
+
+	///@brief Offset of the image within each raster buffer, in pixels (nonzero if drawn by a DigitalBusRasterizer)
+	size_t m_rasterOffset[2];
+
+	///@brief Raster buffers belonging to this channel (m_rasterBuffers points to these unless drawn as part of a bus)
+	std::shared_ptr< AcceleratorBuffer<float> > m_ownRasterBuffers[2];
+
+	///@brief Index of the front buffer in m_rasterBuffers
+	size_t m_frontBuffer;
+
+	///@brief True if the back buffer holds a new image that has not been published yet
+	bool m_backBufferReady;
 
 	///@brief Buffer for X axis indexes (only used for sparse waveforms)
 	AcceleratorBuffer<uint32_t> m_indexBuffer;
 
-	///@brief X axis size of rasterized waveform
-	size_t m_rasterizedX;
+	///@brief Offset of the left edge of each column, used to calculate m_indexBuffer (only used for sparse waveforms)
+	AcceleratorBuffer<int64_t> m_indexTargets;
 
-	///@brief Y axis size of rasterized waveform
-	size_t m_rasterizedY;
+	///@brief X axis size of each raster buffer
+	size_t m_rasterizedX[2];
+
+	///@brief Y axis size of each raster buffer
+	size_t m_rasterizedY[2];
+
+	///@brief Average number of points per pixel column in each raster buffer
+	float m_pointsPerPixel[2];
 
 	///@brief The texture storing our final rendered waveform
 	std::shared_ptr<Texture> m_texture;
@@ -430,6 +597,18 @@ protected:
 	///@brief Compute pipeline for rendering sparse digital waveforms
 	std::shared_ptr<ComputePipeline> m_sparseDigitalComputePipeline;
 
+	///@brief Compute pipeline for calculating X axis indexes of sparse waveforms
+	std::shared_ptr<ComputePipeline> m_indexComputePipeline;
+
+	///@brief Min/max envelope of the waveform for zoomed-out rendering
+	WaveformPyramid m_pyramid;
+
+	///@brief Merged cells and text for drawing protocol decodes
+	ProtocolRenderCache m_protocolRenderCache;
+
+	///@brief Settings the most recently rasterized image was drawn with
+	WaveformRenderKey m_renderKey;
+
 	///@brief Y axis position of our button within the view
 	float m_yButtonPos;
 
@@ -455,6 +634,7 @@ public:
 		bool clearPersistence);
 	void ReferenceWaveformTextures();
 	void ToneMapAllWaveforms(vk::raii::CommandBuffer& cmdbuf);
+	std::string GetProfilingName();
 
 	size_t GetStreamCount()
 	{ return m_displayedChannels.size(); }
@@ -517,7 +697,8 @@ protected:
 		float xstart, float xend, float xoff,
 		float ybot, float ymid, float ytop,
 		std::string str,
-		ImU32 color);
+		ImU32 color,
+		ImVec2 textsize = ImVec2(-1, -1));
 	void MakePathSignalBody(ImDrawList* list, float xstart, float xend, float ybot, float ymid, float ytop);
 	void ToneMapAnalogOrDigitalWaveform(std::shared_ptr<DisplayedChannel> channel, vk::raii::CommandBuffer& cmdbuf);
 	void ToneMapEyeWaveform(std::shared_ptr<DisplayedChannel> channel, vk::raii::CommandBuffer& cmdbuf);
@@ -528,6 +709,14 @@ protected:
 		std::shared_ptr<DisplayedChannel> channel,
 		vk::raii::CommandBuffer& cmdbuf,
 		bool clearPersistence);
+	void RasterizeOnCpu(
+		std::shared_ptr<DisplayedChannel> channel,
+		const ConfigPushConstants& config,
+		AcceleratorBuffer<float>* samples);
+	std::set<DisplayedChannel*> RasterizeDigitalBus(
+		vk::raii::CommandBuffer& cmdbuf,
+		std::vector<std::shared_ptr<DisplayedChannel> >& chans);
+	bool ShouldUseCpuRasterizer();
 	void PlotContextMenu();
 
 	void DrawDropRangeMismatchMessage(
@@ -651,6 +840,9 @@ protected:
 	///@brief True if clearing persistence next render
 	std::atomic<bool> m_clearPersistence;
 
+	///@brief Draws wide uniform digital captures in a single dispatch
+	DigitalBusRasterizer m_digitalBus;
+
 	///@brief Height of a channel button
 	float m_channelButtonHeight;
 
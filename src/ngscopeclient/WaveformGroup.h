@@ -114,6 +114,10 @@ public:
 	int64_t GetXAxisOffset()
 	{ return m_xAxisOffset; }
 
+	///@brief Gets the width of the plot area in X axis units
+	int64_t GetXAxisSpan()
+	{ return PixelsToXAxisUnits(m_width); }
+
 	void ClearPersistence();
 
 	float GetYAxisWidth()
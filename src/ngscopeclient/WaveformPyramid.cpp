@@ -0,0 +1,224 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformPyramid
+ */
+#include "WaveformPyramid.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+WaveformPyramid::WaveformPyramid()
+	: m_cpu(false)
+{
+}
+
+/**
+	@brief Frees all levels
+ */
+void WaveformPyramid::Clear()
+{
+	m_levels.clear();
+	m_key = WaveformCacheKey();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Level selection
+
+/**
+	@brief Picks the coarsest level that still has at least MIN_POINTS_PER_PIXEL points per pixel column
+
+	@param samplesPerPixel	Number of raw samples per pixel column at the current zoom
+	@param memDepth			Number of samples in the waveform
+
+	@return Level to render from, or 0 to render the raw waveform
+ */
+size_t WaveformPyramid::SelectLevel(double samplesPerPixel, size_t memDepth)
+{
+	size_t level = 0;
+	while(level < 7)
+	{
+		int64_t step = GetLevelStep(level + 1);
+		if( (step * MIN_POINTS_PER_PIXEL) > samplesPerPixel)
+			break;
+
+		//Need at least two points to draw a line
+		if(memDepth < static_cast<size_t>(step * 2))
+			break;
+
+		level ++;
+	}
+	return level;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Level generation
+
+/**
+	@brief Gets a level of the pyramid, building it (and any levels below it) if needed
+
+	@param data		The waveform. If it has changed since the last call, all levels are rebuilt.
+	@param level	Level to get (must be at least 1)
+	@param cpu		True to build on the CPU (for the CPU rasterizer), false to build on the GPU
+	@param cmdbuf	Command buffer to record GPU work into
+
+	@return Envelope points for the requested level
+ */
+AcceleratorBuffer<float>& WaveformPyramid::GetLevel(
+	UniformAnalogWaveform* data,
+	size_t level,
+	bool cpu,
+	vk::raii::CommandBuffer& cmdbuf)
+{
+	//Discard everything if the waveform changed, or if it was built for the other rasterizer
+	WaveformCacheKey key(data);
+	if( !(key == m_key) || (cpu != m_cpu) )
+	{
+		Clear();
+		m_key = key;
+		m_cpu = cpu;
+	}
+
+	while(m_levels.size() < level)
+	{
+		auto out = make_unique< AcceleratorBuffer<float> >("WaveformPyramid.level");
+		if(cpu)
+		{
+			out->SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+			out->SetGpuAccessHint(AcceleratorBuffer<float>::HINT_UNLIKELY);
+		}
+		else
+		{
+			out->SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+			out->SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		}
+
+		//Level 1 is built from raw samples, higher levels from pairs of points in the level below
+		size_t n = m_levels.size();
+		auto& in = (n == 0) ? data->m_samples : *m_levels[n-1];
+		size_t groupSize = (n == 0) ? DECIMATION : 2*DECIMATION;
+
+		if(cpu)
+		{
+			in.PrepareForCpuAccess();
+			BuildLevelOnCpu(in.GetCpuPointer(), in.size(), groupSize, *out);
+		}
+		else
+			BuildLevelOnGpu(in, groupSize, *out, cmdbuf);
+
+		m_levels.push_back(std::move(out));
+	}
+
+	return *m_levels[level-1];
+}
+
+/**
+	@brief Reduces each block of groupSize input points to its min and max, in the order they occurred
+ */
+void WaveformPyramid::BuildLevelOnCpu(const float* in, size_t inlen, size_t groupSize, AcceleratorBuffer<float>& out)
+{
+	int64_t buckets = (inlen + groupSize - 1) / groupSize;
+	out.resize(buckets * 2);
+	out.PrepareForCpuAccess();
+	float* pout = out.GetCpuPointer();
+
+	#pragma omp parallel for
+	for(int64_t b=0; b<buckets; b++)
+	{
+		size_t start = b * groupSize;
+		size_t end = min(start + groupSize, inlen);
+
+		float vmin = in[start];
+		float vmax = vmin;
+		size_t imin = start;
+		size_t imax = start;
+		for(size_t i=start+1; i<end; i++)
+		{
+			float v = in[i];
+			if(v < vmin)
+			{
+				vmin = v;
+				imin = i;
+			}
+			if(v > vmax)
+			{
+				vmax = v;
+				imax = i;
+			}
+		}
+
+		if(imin <= imax)
+		{
+			pout[b*2] = vmin;
+			pout[b*2 + 1] = vmax;
+		}
+		else
+		{
+			pout[b*2] = vmax;
+			pout[b*2 + 1] = vmin;
+		}
+	}
+
+	out.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Same as BuildLevelOnCpu(), but records the work into a command buffer to run on the GPU
+ */
+void WaveformPyramid::BuildLevelOnGpu(
+	AcceleratorBuffer<float>& in,
+	size_t groupSize,
+	AcceleratorBuffer<float>& out,
+	vk::raii::CommandBuffer& cmdbuf)
+{
+	size_t buckets = (in.size() + groupSize - 1) / groupSize;
+	out.resize(buckets * 2);
+
+	if(m_buildPipeline == nullptr)
+	{
+		m_buildPipeline = make_shared<ComputePipeline>(
+			"shaders/WaveformPyramid.spv", 2, sizeof(WaveformPyramidArgs));
+	}
+
+	m_buildPipeline->BindBufferNonblocking(0, in, cmdbuf);
+	m_buildPipeline->BindBufferNonblocking(1, out, cmdbuf, true);
+	WaveformPyramidArgs args(in.size(), buckets, groupSize);
+
+	//Deep waveforms have more buckets than we can dispatch blocks in one dimension
+	const uint32_t blocks = GetComputeBlockCount(buckets, 64);
+	const uint32_t maxBlocks = 32768;
+	m_buildPipeline->Dispatch(cmdbuf, args, min(blocks, maxBlocks), blocks / maxBlocks + 1);
+	m_buildPipeline->AddComputeMemoryBarrier(cmdbuf);
+	out.MarkModifiedFromGpu();
+}
@@ -0,0 +1,129 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformPyramid
+ */
+#ifndef WaveformPyramid_h
+#define WaveformPyramid_h
+
+#include "../scopehal/scopehal.h"
+
+/**
+	@brief Push constants for WaveformPyramid.glsl
+ */
+class WaveformPyramidArgs
+{
+public:
+	WaveformPyramidArgs(uint32_t inlen, uint32_t buckets, uint32_t groupSize)
+	: m_inLen(inlen)
+	, m_outBuckets(buckets)
+	, m_groupSize(groupSize)
+	{}
+
+	uint32_t m_inLen;
+	uint32_t m_outBuckets;
+	uint32_t m_groupSize;
+};
+
+/**
+	@brief Multi-resolution min/max envelope of a uniform analog waveform, for fast zoomed-out rendering
+
+	Level N reduces each block of DECIMATION^N samples to two points: the minimum and maximum, in the order they
+	occurred. Each level is built from the one below it, so building all of them costs about as much as one pass over
+	the raw samples. Rendering a level instead of the raw waveform draws the same envelope with far fewer samples per
+	pixel column.
+
+	Levels are built lazily (on the GPU or CPU, to match the rasterizer in use) and discarded when the waveform changes.
+ */
+class WaveformPyramid
+{
+public:
+	WaveformPyramid();
+
+	static size_t SelectLevel(double samplesPerPixel, size_t memDepth);
+
+	/**
+		@brief Number of raw samples each point of a level represents
+	 */
+	static int64_t GetLevelStep(size_t level)
+	{ return (1LL << (DECIMATION_BITS * level)) / 2; }
+
+	/**
+		@brief Integer division rounding towards negative infinity
+	 */
+	static int64_t FloorDivide(int64_t a, int64_t b)
+	{
+		int64_t q = a / b;
+		if( ((a % b) != 0) && ((a < 0) != (b < 0)) )
+			q --;
+		return q;
+	}
+
+	AcceleratorBuffer<float>& GetLevel(
+		UniformAnalogWaveform* data,
+		size_t level,
+		bool cpu,
+		vk::raii::CommandBuffer& cmdbuf);
+
+	void Clear();
+
+	///@brief Log2 of the decimation ratio between adjacent levels
+	static const size_t DECIMATION_BITS = 4;
+
+	///@brief Decimation ratio between adjacent levels
+	static const size_t DECIMATION = 1 << DECIMATION_BITS;
+
+	///@brief Minimum number of envelope points per pixel column when rendering from a level
+	static const size_t MIN_POINTS_PER_PIXEL = 4;
+
+protected:
+	void BuildLevelOnCpu(const float* in, size_t inlen, size_t groupSize, AcceleratorBuffer<float>& out);
+	void BuildLevelOnGpu(
+		AcceleratorBuffer<float>& in,
+		size_t groupSize,
+		AcceleratorBuffer<float>& out,
+		vk::raii::CommandBuffer& cmdbuf);
+
+	///@brief Identifies the waveform the current levels were built from
+	WaveformCacheKey m_key;
+
+	///@brief True if the current levels were built for the CPU rasterizer
+	bool m_cpu;
+
+	///@brief Levels built so far (index 0 is level 1, level 0 is the raw waveform)
+	std::vector< std::unique_ptr< AcceleratorBuffer<float> > > m_levels;
+
+	///@brief Compute pipeline for building levels on the GPU
+	std::shared_ptr<ComputePipeline> m_buildPipeline;
+};
+
+#endif
@@ -0,0 +1,679 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformRasterizer
+ */
+#include "WaveformRasterizer.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+/**
+	@brief Converts a float to uint32_t, saturating rather than invoking undefined behavior when out of range
+ */
+static inline uint32_t FloatToUint32(float f)
+{
+	if(!(f > 0))
+		return 0;
+	if(f >= 4294967296.0f)
+		return 0xffffffff;
+	return static_cast<uint32_t>(f);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Top level entry point
+
+/**
+	@brief Rasterizes a waveform into an fp32 intensity buffer
+
+	Matches the behavior of the corresponding waveform-compute.glsl variant, including persistence.
+
+	@param config	Rendering configuration, exactly as would be pushed to the shader
+	@param variant	Which shader variant to emulate
+	@param dense	True for uniformly sampled waveforms, false for sparse
+	@param inputs	Sample data
+	@param out		Output buffer (windowWidth * windowHeight pixels, row major)
+ */
+void WaveformRasterizer::Rasterize(
+	const ConfigPushConstants& config,
+	Variant variant,
+	bool dense,
+	const Inputs& inputs,
+	float* out)
+{
+	switch(variant)
+	{
+		case VARIANT_ANALOG:
+			if(dense)
+				RasterizeAll<VARIANT_ANALOG, true>(config, inputs, out);
+			else
+				RasterizeAll<VARIANT_ANALOG, false>(config, inputs, out);
+			break;
+
+		case VARIANT_ANALOG_ZEROHOLD:
+			if(dense)
+				RasterizeAll<VARIANT_ANALOG_ZEROHOLD, true>(config, inputs, out);
+			else
+				RasterizeAll<VARIANT_ANALOG_ZEROHOLD, false>(config, inputs, out);
+			break;
+
+		case VARIANT_DIGITAL:
+			if(dense)
+				RasterizeAll<VARIANT_DIGITAL, true>(config, inputs, out);
+			else
+				RasterizeAll<VARIANT_DIGITAL, false>(config, inputs, out);
+			break;
+
+		case VARIANT_HISTOGRAM:
+			if(dense)
+				RasterizeAll<VARIANT_HISTOGRAM, true>(config, inputs, out);
+			else
+				RasterizeAll<VARIANT_HISTOGRAM, false>(config, inputs, out);
+			break;
+	}
+}
+
+/**
+	@brief Rasterizes every column of the output, in parallel
+ */
+template<WaveformRasterizer::Variant variant, bool dense>
+void WaveformRasterizer::RasterizeAll(const ConfigPushConstants& config, const Inputs& inputs, float* out)
+{
+	//Same early-outs as the shader (which leaves the output buffer untouched)
+	const uint32_t addtlSamples = (variant == VARIANT_ANALOG_ZEROHOLD) ? 0 : 1;
+	if(config.windowHeight > MAX_HEIGHT)
+		return;
+	if(config.memDepth < (1 + addtlSamples))
+		return;
+
+	int64_t width = config.windowWidth;
+	#pragma omp parallel
+	{
+		//One extra entry since each span decrements the row after its end
+		vector<int32_t> diff(config.windowHeight + 1);
+
+		#pragma omp for schedule(dynamic, 16)
+		for(int64_t col=0; col<width; col++)
+		{
+			memset(diff.data(), 0, diff.size() * sizeof(int32_t));
+			RasterizeColumn<variant, dense>(config, inputs, col, diff.data());
+			ResolveColumn(config, (variant == VARIANT_HISTOGRAM), col, diff.data(), out);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sparse waveform indexing
+
+/**
+	@brief Finds the first sample of a sparse waveform in each pixel column
+
+	Same result as calling BinarySearchForGequal() for each column, or running WaveformIndex.glsl.
+
+	@param offsets	Sample offsets (must be sorted)
+	@param len		Number of samples
+	@param targets	Offset of the left edge of each column, in samples
+	@param indexes	Output index buffer
+	@param count	Number of columns
+ */
+void WaveformRasterizer::ComputeIndexes(
+	const int64_t* offsets,
+	uint32_t len,
+	const int64_t* targets,
+	uint32_t* indexes,
+	uint32_t count)
+{
+	if(len == 0)
+	{
+		memset(indexes, 0, count * sizeof(uint32_t));
+		return;
+	}
+
+	uint32_t start = 0;
+	#ifdef __x86_64__
+		if(g_hasAvx2)
+			start = ComputeIndexesAVX2(offsets, len, targets, indexes, count);
+	#endif
+
+	for(uint32_t i=start; i<count; i++)
+		indexes[i] = FindIndex(offsets, len, targets[i]);
+}
+
+/**
+	@brief Finds the index of the last sample at or before a target offset
+ */
+uint32_t WaveformRasterizer::FindIndex(const int64_t* offsets, uint32_t len, int64_t target)
+{
+	//Clip if out of range
+	if(offsets[0] >= target)
+		return 0;
+	if(offsets[len-1] < target)
+		return len;
+
+	//Branchless binary search
+	uint32_t base = 0;
+	uint32_t n = len;
+	while(n > 1)
+	{
+		uint32_t half = n / 2;
+		base = (offsets[base + half] <= target) ? (base + half) : base;
+		n -= half;
+	}
+
+	//BinarySearchForGequal() brackets the target between two samples, so never returns the last one here
+	return min(base, len - 2);
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 version of ComputeIndexes(), searching for four columns at once
+
+	Every column takes the same number of steps, so the searches run in lockstep using gathers.
+
+	@return Number of columns processed
+ */
+__attribute__((target("avx2")))
+uint32_t WaveformRasterizer::ComputeIndexesAVX2(
+	const int64_t* offsets,
+	uint32_t len,
+	const int64_t* targets,
+	uint32_t* indexes,
+	uint32_t count)
+{
+	auto buf = reinterpret_cast<const long long*>(offsets);
+	int64_t first = offsets[0];
+	int64_t last = offsets[len-1];
+
+	uint32_t end = count - (count % 4);
+	alignas(32) int64_t bases[4];
+	for(uint32_t i=0; i<end; i+=4)
+	{
+		__m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(targets + i));
+
+		__m256i base = _mm256_setzero_si256();
+		uint32_t n = len;
+		while(n > 1)
+		{
+			uint32_t half = n / 2;
+			__m256i mid = _mm256_add_epi64(base, _mm256_set1_epi64x(half));
+			__m256i value = _mm256_i64gather_epi64(buf, mid, 8);
+
+			//Move up if offsets[mid] <= target
+			__m256i tooFar = _mm256_cmpgt_epi64(value, target);
+			base = _mm256_blendv_epi8(mid, base, tooFar);
+			n -= half;
+		}
+		_mm256_store_si256(reinterpret_cast<__m256i*>(bases), base);
+
+		//Clip if out of range
+		for(uint32_t j=0; j<4; j++)
+		{
+			int64_t t = targets[i+j];
+			if(first >= t)
+				indexes[i+j] = 0;
+			else if(last < t)
+				indexes[i+j] = len;
+			else
+				indexes[i+j] = min(static_cast<uint32_t>(bases[j]), len - 2);
+		}
+	}
+
+	return end;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Configuration and tone mapping
+
+/**
+	@brief Calculates the rendering configuration for a waveform, the same way WaveformArea does
+
+	Persistence is left disabled; callers that use it set persistScale afterwards.
+
+	@param data					The waveform to draw
+	@param xAxisOffset			X axis position of the left edge of the plot
+	@param pixelsPerX			Horizontal zoom, in pixels per X axis unit
+	@param width				Width of the plot, in pixels
+	@param height				Height of the plot (or digital channel strip), in pixels
+	@param digital				True for digital waveforms
+	@param pixelsPerYAxisUnit	Vertical scale (analog only)
+	@param yoff					Vertical offset, in Y axis units (analog only)
+ */
+ConfigPushConstants WaveformRasterizer::GetConfig(
+	WaveformBase* data,
+	int64_t xAxisOffset,
+	double pixelsPerX,
+	uint32_t width,
+	uint32_t height,
+	bool digital,
+	float pixelsPerYAxisUnit,
+	float yoff)
+{
+	int64_t innerxoff = xAxisOffset / data->m_timescale;
+	int64_t fractional_offset = xAxisOffset % data->m_timescale;
+	int64_t offset_samples = (xAxisOffset - data->m_triggerPhase) / data->m_timescale;
+
+	ConfigPushConstants config;
+	config.innerXoff = -innerxoff;
+	config.windowHeight = height;
+	config.windowWidth = width;
+	config.memDepth = data->size();
+	config.offset_samples = offset_samples - 2;
+	config.alpha = 1;
+	config.xoff = (data->m_triggerPhase - fractional_offset) * pixelsPerX;
+	config.xscale = data->m_timescale * pixelsPerX;
+	if(digital)
+	{
+		config.yoff = 0;
+		config.yscale = height - 1;
+		config.ybase = 0;
+	}
+	else
+	{
+		config.yscale = pixelsPerYAxisUnit;
+		config.yoff = yoff;
+		config.ybase = height * 0.5f;
+	}
+	config.persistScale = 0;
+	return config;
+}
+
+/**
+	@brief Calculates the intensity scale for tone mapping a waveform
+
+	As we zoom out more, alpha is reduced to get proper intensity grading.
+
+	@param traceAlpha		Trace alpha setting
+	@param pointsPerPixel	Average number of points drawn per pixel column
+ */
+float WaveformRasterizer::GetToneMapAlpha(float traceAlpha, float pointsPerPixel)
+{
+	float alpha = traceAlpha / sqrt(pointsPerPixel);
+	return min(1.0f, alpha) * 2;
+}
+
+/**
+	@brief Converts rasterized hit counts to color, the same way WaveformToneMap.glsl does
+
+	@param pixels	Rasterized waveform (width * height pixels, row major, bottom row first)
+	@param width	Width of the waveform
+	@param height	Height of the waveform
+	@param color	Channel color (red, green, blue)
+	@param alpha	Intensity scale, from GetToneMapAlpha()
+	@param out		Output buffer (width * height RGBA pixels, not premultiplied)
+ */
+void WaveformRasterizer::ToneMap(
+	const float* pixels,
+	uint32_t width,
+	uint32_t height,
+	const float* color,
+	float alpha,
+	float* out)
+{
+	size_t npixels = static_cast<size_t>(width) * height;
+	for(size_t i=0; i<npixels; i++)
+	{
+		//Logarithmic shading
+		float y = pow(pixels[i] * alpha, 1.0f / 4);
+		y = min(y, 2.0f);
+		y = max(y, 0.0f);
+
+		float* rgba = out + i*4;
+
+		//Supersaturated: 100% alpha, color gets even more intense
+		if(y > 1)
+		{
+			for(size_t j=0; j<3; j++)
+				rgba[j] = min(color[j] * y, 1.0f);
+			rgba[3] = 1;
+		}
+
+		//No, normal
+		else
+		{
+			for(size_t j=0; j<3; j++)
+				rgba[j] = color[j];
+			rgba[3] = y;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Per-column processing
+
+/**
+	@brief Accumulates every sample touching one column into a difference array
+
+	The shader processes ROWS_PER_BLOCK samples at a time and stops at the end of the pass in which any sample reaches
+	the right edge of the column (or the end of the waveform). We walk the same samples sequentially and stop at the
+	same place, so that the output matches exactly.
+ */
+template<WaveformRasterizer::Variant variant, bool dense>
+void WaveformRasterizer::RasterizeColumn(
+	const ConfigPushConstants& config,
+	const Inputs& inputs,
+	uint32_t col,
+	int32_t* diff)
+{
+	const bool analog = (variant != VARIANT_DIGITAL);
+	const bool useNextCoords = (variant != VARIANT_ANALOG_ZEROHOLD);
+	const uint32_t limit = config.memDepth - (useNextCoords ? 1 : 0);
+
+	const float fcol = col;
+	const float fcolEnd = col + 1;
+	const float fheight = config.windowHeight;
+	const float fmaxY = static_cast<uint32_t>(config.windowHeight - 1);
+
+	//Find the first sample in the column
+	bool done = false;
+	uint32_t istart;
+	if(dense)
+	{
+		istart = FloatToUint32(floor(fcol / config.xscale)) + config.offset_samples;
+		uint32_t iend = FloatToUint32(floor(fcolEnd / config.xscale)) + config.offset_samples;
+		if(iend == 0)
+			done = true;
+	}
+	else
+	{
+		istart = inputs.m_indexes[col];
+		if( ( (col + 1) < config.windowWidth) && (inputs.m_indexes[col + 1] == 0) )
+			done = true;
+	}
+
+	//If we're already done, the shader still runs one full pass
+	uint64_t stopAt = done ? ROWS_PER_BLOCK : UINT64_MAX;
+	uint64_t r = 0;
+
+	#ifdef __x86_64__
+		if( (variant == VARIANT_ANALOG) && dense && g_hasAvx2)
+			RasterizeDenseAnalogBlocksAVX2(config, inputs, col, istart, r, stopAt, diff);
+	#endif
+
+	for(; r < stopAt; r++)
+	{
+		uint32_t i = istart + static_cast<uint32_t>(r);
+
+		bool sampleDone = true;
+		if(i < limit)
+		{
+			//Fetch coordinates
+			float lx;
+			float rx;
+			if(dense)
+				lx = static_cast<int64_t>(i) + config.innerXoff;
+			else
+				lx = inputs.m_offsets[i] + config.innerXoff;
+			lx = lx * config.xscale + config.xoff;
+
+			float v = 0;
+			float ly;
+			float ry;
+			if(analog)
+			{
+				v = inputs.m_analog[i];
+				ly = (v + config.yoff) * config.yscale + config.ybase;
+			}
+			else
+				ly = static_cast<float>(inputs.m_digital[i]) * config.yscale + config.ybase;
+
+			if(useNextCoords)
+			{
+				if(dense)
+					rx = static_cast<int64_t>(i + 1) + config.innerXoff;
+				else
+					rx = inputs.m_offsets[i + 1] + config.innerXoff;
+				rx = rx * config.xscale + config.xoff;
+
+				if(analog)
+					ry = (inputs.m_analog[i + 1] + config.yoff) * config.yscale + config.ybase;
+				else
+					ry = static_cast<float>(inputs.m_digital[i + 1]) * config.yscale + config.ybase;
+			}
+			else
+			{
+				float duration = 1;
+				if(!dense)
+					duration = inputs.m_durations[i];
+				rx = lx + duration * config.xscale;
+				ry = ly;
+			}
+
+			//Skip offscreen samples
+			if( (rx >= fcol) && (lx <= fcolEnd) )
+			{
+				float starty = ly;
+				float endy = ry;
+
+				//Interpolate analog signals if either end is outside our column
+				if(variant == VARIANT_ANALOG)
+				{
+					float slope = (ry - ly) / (rx - lx);
+					if(lx < fcol)
+						starty = ly + (fcol - lx) * slope;
+					if(rx > fcolEnd)
+						endy = ly + (fcolEnd - lx) * slope;
+				}
+
+				//Digital: vertical line at the right edge, otherwise a single pixel
+				else if(variant == VARIANT_DIGITAL)
+				{
+					if(fabs(rx - fcol) <= 1)
+						endy = ry;
+					else
+						endy = ly;
+				}
+
+				//Histogram: bar from the baseline
+				else if(variant == VARIANT_HISTOGRAM)
+				{
+					starty = config.yoff * config.yscale + config.ybase;
+					endy = ly;
+				}
+
+				bool offscreen =
+					( (starty < 0) && (endy < 0) ) ||
+					( (starty >= fheight) && (endy >= fheight) );
+				bool zeroHeight = (variant == VARIANT_HISTOGRAM) && (v <= 0);
+
+				if(!offscreen && !zeroHeight)
+				{
+					starty = (starty < fmaxY) ? starty : fmaxY;
+					endy = (endy < fmaxY) ? endy : fmaxY;
+					starty = (starty > 0) ? starty : 0;
+					endy = (endy > 0) ? endy : 0;
+
+					int32_t blockmin = static_cast<int32_t>(min(starty, endy));
+					int32_t blockmax = static_cast<int32_t>(max(starty, endy));
+					diff[blockmin] ++;
+					diff[blockmax + 1] --;
+				}
+			}
+
+			//Check if we're at the end of the pixel
+			sampleDone = (rx > fcolEnd);
+		}
+
+		//Finish the current pass, then stop
+		if(sampleDone && (stopAt == UINT64_MAX) )
+			stopAt = (r / ROWS_PER_BLOCK + 1) * ROWS_PER_BLOCK;
+	}
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 version of the dense interpolated analog inner loop, processing 8 samples at a time
+
+	Processes whole blocks starting from sample r until the end of the column, the end of the waveform, or a block it
+	can't handle (timestamps outside int32 range). Updates r and stopAt so the caller can finish with the scalar loop.
+ */
+__attribute__((target("avx2")))
+void WaveformRasterizer::RasterizeDenseAnalogBlocksAVX2(
+	const ConfigPushConstants& config,
+	const Inputs& inputs,
+	uint32_t col,
+	uint32_t istart,
+	uint64_t& r,
+	uint64_t& stopAt,
+	int32_t* diff)
+{
+	const uint32_t limit = config.memDepth - 1;
+
+	__m256 vcol = _mm256_set1_ps(static_cast<float>(col));
+	__m256 vcolEnd = _mm256_set1_ps(static_cast<float>(col + 1));
+	__m256 vheight = _mm256_set1_ps(static_cast<float>(config.windowHeight));
+	__m256 vmaxY = _mm256_set1_ps(static_cast<float>(static_cast<uint32_t>(config.windowHeight - 1)));
+	__m256 vzero = _mm256_setzero_ps();
+	__m256 vxscale = _mm256_set1_ps(config.xscale);
+	__m256 vxoff = _mm256_set1_ps(config.xoff);
+	__m256 vyscale = _mm256_set1_ps(config.yscale);
+	__m256 vyoff = _mm256_set1_ps(config.yoff);
+	__m256 vybase = _mm256_set1_ps(config.ybase);
+	__m256i vlane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i vone = _mm256_set1_epi32(1);
+
+	alignas(32) int32_t blockmin[8];
+	alignas(32) int32_t blockmax[8];
+
+	//Blocks start at r=0 so they never straddle the end of a pass
+	while( (r + 8) <= stopAt)
+	{
+		//Need samples i ... i+8 all within the waveform, with no wraparound
+		uint32_t i = istart + static_cast<uint32_t>(r);
+		if( (i > limit) || ( (limit - i) < 8) )
+			return;
+
+		//Need timestamps to fit in int32 so we can convert with cvtepi32 (same rounding as int64 to float)
+		int64_t base = static_cast<int64_t>(i) + config.innerXoff;
+		if( (base < INT32_MIN) || ( (base + 8) > INT32_MAX) )
+			return;
+
+		//Fetch coordinates
+		__m256i vbase = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(base)), vlane);
+		__m256 lx = _mm256_cvtepi32_ps(vbase);
+		__m256 rx = _mm256_cvtepi32_ps(_mm256_add_epi32(vbase, vone));
+		lx = _mm256_add_ps(_mm256_mul_ps(lx, vxscale), vxoff);
+		rx = _mm256_add_ps(_mm256_mul_ps(rx, vxscale), vxoff);
+
+		__m256 ly = _mm256_loadu_ps(inputs.m_analog + i);
+		__m256 ry = _mm256_loadu_ps(inputs.m_analog + i + 1);
+		ly = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(ly, vyoff), vyscale), vybase);
+		ry = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(ry, vyoff), vyscale), vybase);
+
+		//Skip offscreen samples
+		__m256 visible = _mm256_and_ps(
+			_mm256_cmp_ps(rx, vcol, _CMP_GE_OQ),
+			_mm256_cmp_ps(lx, vcolEnd, _CMP_LE_OQ));
+
+		//Interpolate if either end is outside our column
+		__m256 slope = _mm256_div_ps(_mm256_sub_ps(ry, ly), _mm256_sub_ps(rx, lx));
+		__m256 starty = _mm256_blendv_ps(
+			ly,
+			_mm256_add_ps(ly, _mm256_mul_ps(_mm256_sub_ps(vcol, lx), slope)),
+			_mm256_cmp_ps(lx, vcol, _CMP_LT_OQ));
+		__m256 pastEnd = _mm256_cmp_ps(rx, vcolEnd, _CMP_GT_OQ);
+		__m256 endy = _mm256_blendv_ps(
+			ry,
+			_mm256_add_ps(ly, _mm256_mul_ps(_mm256_sub_ps(vcolEnd, lx), slope)),
+			pastEnd);
+
+		//Nothing to draw if both ends are above or below the window
+		__m256 offscreen = _mm256_or_ps(
+			_mm256_and_ps(_mm256_cmp_ps(starty, vzero, _CMP_LT_OQ), _mm256_cmp_ps(endy, vzero, _CMP_LT_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(starty, vheight, _CMP_GE_OQ), _mm256_cmp_ps(endy, vheight, _CMP_GE_OQ)));
+		int updating = _mm256_movemask_ps(_mm256_andnot_ps(offscreen, visible));
+
+		if(updating)
+		{
+			//Clip to window size
+			starty = _mm256_blendv_ps(vmaxY, starty, _mm256_cmp_ps(starty, vmaxY, _CMP_LT_OQ));
+			endy = _mm256_blendv_ps(vmaxY, endy, _mm256_cmp_ps(endy, vmaxY, _CMP_LT_OQ));
+			starty = _mm256_blendv_ps(vzero, starty, _mm256_cmp_ps(starty, vzero, _CMP_GT_OQ));
+			endy = _mm256_blendv_ps(vzero, endy, _mm256_cmp_ps(endy, vzero, _CMP_GT_OQ));
+
+			_mm256_store_si256(
+				reinterpret_cast<__m256i*>(blockmin), _mm256_cvttps_epi32(_mm256_min_ps(starty, endy)));
+			_mm256_store_si256(
+				reinterpret_cast<__m256i*>(blockmax), _mm256_cvttps_epi32(_mm256_max_ps(starty, endy)));
+
+			for(int k=0; k<8; k++)
+			{
+				if(updating & (1 << k))
+				{
+					diff[blockmin[k]] ++;
+					diff[blockmax[k] + 1] --;
+				}
+			}
+		}
+
+		//Check if any sample reached the end of the pixel, and if so finish the current pass
+		int done = _mm256_movemask_ps(pastEnd);
+		if(done && (stopAt == UINT64_MAX) )
+			stopAt = ( (r + __builtin_ctz(done)) / ROWS_PER_BLOCK + 1) * ROWS_PER_BLOCK;
+
+		r += 8;
+	}
+}
+#endif
+
+/**
+	@brief Integrates a column's difference array and writes it to the output, applying alpha and persistence
+ */
+void WaveformRasterizer::ResolveColumn(
+	const ConfigPushConstants& config,
+	bool histogram,
+	uint32_t col,
+	int32_t* diff,
+	float* out)
+{
+	int32_t count = 0;
+	for(uint32_t y=0; y<config.windowHeight; y++)
+	{
+		count += diff[y];
+
+		uint32_t hits = count;
+		if(histogram)
+			hits = (count > 0) ? 1 : 0;
+
+		float fout = hits * config.alpha;
+		size_t npix = static_cast<size_t>(config.windowWidth) * y + col;
+		if(config.persistScale != 0)
+			fout += out[npix] * config.persistScale;
+		out[npix] = fout;
+	}
+}
@@ -0,0 +1,207 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformRasterizer
+ */
+#ifndef WaveformRasterizer_h
+#define WaveformRasterizer_h
+
+#include "../scopehal/scopehal.h"
+
+/**
+	@brief Push constants for waveform-compute.glsl (also used as configuration for the CPU rasterizer)
+ */
+struct ConfigPushConstants
+{
+	int64_t innerXoff;
+	uint32_t windowHeight;
+	uint32_t windowWidth;
+	uint32_t memDepth;
+	uint32_t offset_samples;
+	float alpha;
+	float xoff;
+	float xscale;
+	float ybase;
+	float yscale;
+	float yoff;
+	float persistScale;
+};
+
+/**
+	@brief Push constants for WaveformIndex.glsl
+ */
+class WaveformIndexArgs
+{
+public:
+	WaveformIndexArgs(uint32_t len, uint32_t w)
+	: m_len(len)
+	, m_width(w)
+	{}
+
+	uint32_t m_len;
+	uint32_t m_width;
+};
+
+/**
+	@brief CPU implementation of the column rasterizer in waveform-compute.glsl
+
+	Produces the same fp32 intensity buffer as the shader, for use on machines where the shader is slow (software
+	Vulkan, weak integrated GPUs) and as a reference for testing the shader.
+
+	Columns are rasterized in parallel. Within a column, each sample adds a vertical span to a difference array
+	rather than incrementing every pixel it covers, so cost is proportional to the number of samples rather than the
+	number of pixels drawn. Dense analog waveforms have an AVX2 path for the per-sample coordinate math.
+ */
+class WaveformRasterizer
+{
+public:
+
+	///@brief Shader variant to emulate (see the add_render_shader_variants call in shaders/CMakeLists.txt)
+	enum Variant
+	{
+		VARIANT_ANALOG,
+		VARIANT_ANALOG_ZEROHOLD,
+		VARIANT_DIGITAL,
+		VARIANT_HISTOGRAM
+	};
+
+	/**
+		@brief Input buffers, as CPU pointers. Unused buffers may be null.
+	 */
+	struct Inputs
+	{
+		Inputs()
+			: m_analog(nullptr)
+			, m_digital(nullptr)
+			, m_offsets(nullptr)
+			, m_indexes(nullptr)
+			, m_durations(nullptr)
+		{}
+
+		///@brief Analog sample values (analog and histogram variants)
+		const float* m_analog;
+
+		///@brief Digital sample values, one byte per sample (digital variant)
+		const uint8_t* m_digital;
+
+		///@brief Sample offsets (sparse only)
+		const int64_t* m_offsets;
+
+		///@brief Index of the first sample in each column (sparse only)
+		const uint32_t* m_indexes;
+
+		///@brief Sample durations (sparse zero-hold only)
+		const int64_t* m_durations;
+	};
+
+	static void Rasterize(
+		const ConfigPushConstants& config,
+		Variant variant,
+		bool dense,
+		const Inputs& inputs,
+		float* out);
+
+	static void ComputeIndexes(
+		const int64_t* offsets,
+		uint32_t len,
+		const int64_t* targets,
+		uint32_t* indexes,
+		uint32_t count);
+
+	static ConfigPushConstants GetConfig(
+		WaveformBase* data,
+		int64_t xAxisOffset,
+		double pixelsPerX,
+		uint32_t width,
+		uint32_t height,
+		bool digital,
+		float pixelsPerYAxisUnit,
+		float yoff);
+
+	static float GetToneMapAlpha(float traceAlpha, float pointsPerPixel);
+
+	static void ToneMap(
+		const float* pixels,
+		uint32_t width,
+		uint32_t height,
+		const float* color,
+		float alpha,
+		float* out);
+
+	///@brief Maximum height of a waveform, in pixels (must match MAX_HEIGHT in the shader)
+	static const uint32_t MAX_HEIGHT = 2048;
+
+	///@brief Number of samples each shader workgroup processes per pass (must match ROWS_PER_BLOCK in the shader)
+	static const uint32_t ROWS_PER_BLOCK = 128;
+
+protected:
+	template<Variant variant, bool dense>
+	static void RasterizeAll(const ConfigPushConstants& config, const Inputs& inputs, float* out);
+
+	template<Variant variant, bool dense>
+	static void RasterizeColumn(
+		const ConfigPushConstants& config,
+		const Inputs& inputs,
+		uint32_t col,
+		int32_t* diff);
+
+#ifdef __x86_64__
+	static void RasterizeDenseAnalogBlocksAVX2(
+		const ConfigPushConstants& config,
+		const Inputs& inputs,
+		uint32_t col,
+		uint32_t istart,
+		uint64_t& r,
+		uint64_t& stopAt,
+		int32_t* diff);
+#endif
+
+	static uint32_t FindIndex(const int64_t* offsets, uint32_t len, int64_t target);
+
+#ifdef __x86_64__
+	static uint32_t ComputeIndexesAVX2(
+		const int64_t* offsets,
+		uint32_t len,
+		const int64_t* targets,
+		uint32_t* indexes,
+		uint32_t count);
+#endif
+
+	static void ResolveColumn(
+		const ConfigPushConstants& config,
+		bool histogram,
+		uint32_t col,
+		int32_t* diff,
+		float* out);
+};
+
+#endif
@@ -52,11 +52,41 @@ Event g_waveformProcessedEvent;
 ///@brief Time spent on the last cycle of waveform rendering shaders
 atomic<int64_t> g_lastWaveformRenderTime;
 
-void RenderAllWaveforms(vk::raii::CommandBuffer& cmdbuf, Session* session, shared_ptr<QueueHandle> queue);
+///@brief Time spent on the last rendering cycle that rasterized waveforms with the compute shader
+atomic<int64_t> g_lastGpuRasterizeTime;
+
+///@brief Time spent on the last rendering cycle that rasterized waveforms on the CPU
+atomic<int64_t> g_lastCpuRasterizeTime;
+
+///@brief Time spent in the CPU rasterizer so far during the current rendering cycle
+atomic<int64_t> g_cpuRasterizeTime;
+
+///@brief Number of waveforms rasterized on the CPU so far during the current rendering cycle
+atomic<size_t> g_cpuRasterizeCount;
+
+///@brief Number of waveforms rasterized by the compute shader so far during the current rendering cycle
+atomic<size_t> g_gpuRasterizeCount;
+
+///@brief Number of waveforms not rasterized so far during the current rendering cycle because nothing changed
+atomic<size_t> g_rasterizeSkipCount;
+
+///@brief Number of waveforms skipped during the last rendering cycle
+atomic<size_t> g_lastRasterizeSkipCount;
+
+///@brief Number of waveforms considered for rasterizing (drawn or skipped) during the last rendering cycle
+atomic<size_t> g_lastRasterizeChannelCount;
+
+void RenderAllWaveforms(
+	vk::raii::CommandBuffer& cmdbuf,
+	vk::raii::Fence& fence,
+	GpuTimestampQueries& queries,
+	Session* session,
+	shared_ptr<QueueHandle> queue);
 
 void WaveformThread(Session* session, atomic<bool>* shuttingDown)
 {
 	pthread_setname_np_compat("WaveformThread");
+	g_perfRecorder.NameThread("WaveformThread");
 
 	LogTrace("Starting\n");
 
@@ -69,6 +99,8 @@ void WaveformThread(Session* session, atomic<bool>* shuttingDown)
 
 	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
 	vk::raii::CommandBuffer cmdbuf(std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+	vk::raii::Fence fence(*g_vkComputeDevice, vk::FenceCreateInfo());
+	GpuTimestampQueries queries(cmdbuf, queue->m_family);
 
 	if(g_hasDebugUtils)
 	{
@@ -91,6 +123,9 @@ void WaveformThread(Session* session, atomic<bool>* shuttingDown)
 
 	while(!*shuttingDown)
 	{
+		//Arm triggers here rather than in the GUI thread, since it can take a while
+		session->ProcessPendingArmRequests();
+
 		//If re-running the filter graph was requested, do that (and re-render)
 		if(g_refilterRequestedEvent.Peek())
 		{
@@ -99,7 +134,7 @@ void WaveformThread(Session* session, atomic<bool>* shuttingDown)
 
 			LogTrace("WaveformThread: re-running filter graph and re-rendering\n");
 			session->RefreshAllFilters();
-			RenderAllWaveforms(cmdbuf, session, queue);
+			RenderAllWaveforms(cmdbuf, fence, queries, session, queue);
 			g_refilterDoneEvent.Signal();
 			continue;
 		}
@@ -108,7 +143,7 @@ void WaveformThread(Session* session, atomic<bool>* shuttingDown)
 		{
 			LogTrace("WaveformThread: re-running partial filter graph and re-rendering\n");
 			if(session->RefreshDirtyFilters())
-				RenderAllWaveforms(cmdbuf, session, queue);
+				RenderAllWaveforms(cmdbuf, fence, queries, session, queue);
 			g_refilterDoneEvent.Signal();
 			continue;
 		}
@@ -117,24 +152,20 @@ void WaveformThread(Session* session, atomic<bool>* shuttingDown)
 		if(g_rerenderRequestedEvent.Peek())
 		{
 			LogTrace("WaveformThread: re-rendering\n");
-			RenderAllWaveforms(cmdbuf, session, queue);
+			RenderAllWaveforms(cmdbuf, fence, queries, session, queue);
 			g_rerenderDoneEvent.Signal();
 			continue;
 		}
 
-		//Wait for data to be available from all scopes
-		if(!session->CheckForPendingWaveforms())
+		//Wait for data to be available from all scopes, then download it and run the filter graph
+		if(!session->AcquirePendingWaveforms())
 		{
 			this_thread::sleep_for(chrono::milliseconds(1));
 			continue;
 		}
 
-		//We've got data. Download it, then run the filter graph
-		session->DownloadWaveforms();
-		session->RefreshAllFilters();
-
 		//Rerun the heavyweight rendering shaders
-		RenderAllWaveforms(cmdbuf, session, queue);
+		RenderAllWaveforms(cmdbuf, fence, queries, session, queue);
 
 		//Unblock the UI threads, then wait for acknowledgement that it's processed
 		g_waveformReadyEvent.Signal();
@@ -144,22 +175,72 @@ void WaveformThread(Session* session, atomic<bool>* shuttingDown)
 	LogTrace("Shutting down\n");
 }
 
-void RenderAllWaveforms(vk::raii::CommandBuffer& cmdbuf, Session* session, shared_ptr<QueueHandle> queue)
+/**
+	@brief Rasterizes all displayed waveforms and publishes the results for tone mapping
+
+	Waveforms are drawn into the back buffer of each DisplayedChannel, so the GUI thread can keep tone mapping the
+	previous images while the GPU is busy. The rasterized waveform mutex is only held while recording commands and
+	while swapping buffers, not while waiting for the GPU.
+ */
+void RenderAllWaveforms(
+	vk::raii::CommandBuffer& cmdbuf,
+	vk::raii::Fence& fence,
+	GpuTimestampQueries& queries,
+	Session* session,
+	shared_ptr<QueueHandle> queue)
 {
 	double tstart = GetTime();
 
 	//Must lock mutexes in this order to avoid deadlock
 	shared_lock<shared_mutex> lock1(session->GetWaveformDataMutex());
 	shared_lock<shared_mutex> lock2(g_vulkanActivityMutex);
-	lock_guard<mutex> lock3(session->GetRasterizedWaveformMutex());
 
 	//Keep references to all displayed channels open until the rendering finishes
 	//This prevents problems if we close a WaveformArea or remove a channel from it before the shader completes
 	vector< shared_ptr<DisplayedChannel> > channels;
-	cmdbuf.begin({});
-	session->RenderWaveformTextures(cmdbuf, channels);
-	cmdbuf.end();
-	queue->SubmitAndBlock(cmdbuf);
+	g_cpuRasterizeTime = 0;
+	g_cpuRasterizeCount = 0;
+	g_gpuRasterizeCount = 0;
+	g_rasterizeSkipCount = 0;
+	{
+		lock_guard<mutex> lock3(session->GetRasterizedWaveformMutex());
+		cmdbuf.begin({});
+		queries.Reset();
+		{
+			GpuTimestampScope scope(cmdbuf, "Rasterize");
+			session->RenderWaveformTextures(cmdbuf, channels);
+		}
+		cmdbuf.end();
+
+		QueueLock qlock(queue);
+		vk::SubmitInfo info({}, {}, *cmdbuf);
+		g_perfRecorder.Record(PERF_RASTERIZE, PerfEventRecorder::PHASE_BEGIN);
+		(*qlock).submit(info, *fence);
+	}
+
+	//Wait for the shaders without blocking tone mapping of the front buffers
+	(void)g_vkComputeDevice->waitForFences({*fence}, VK_TRUE, UINT64_MAX);
+	g_perfRecorder.Record(PERF_RASTERIZE, PerfEventRecorder::PHASE_END);
+	g_vkComputeDevice->resetFences({*fence});
+	queries.Collect();
+
+	//Then swap in the new images
+	{
+		lock_guard<mutex> lock3(session->GetRasterizedWaveformMutex());
+		for(auto& chan : channels)
+			chan->PublishRasterizedWaveform();
+	}
+
+	int64_t total = (GetTime() - tstart) * FS_PER_SECOND;
+	g_lastWaveformRenderTime = total;
+
+	//CPU rasterizing happens while recording the command buffer, everything else is the shaders
+	int64_t cpuTime = g_cpuRasterizeTime;
+	if(g_cpuRasterizeCount)
+		g_lastCpuRasterizeTime = cpuTime;
+	if(g_gpuRasterizeCount)
+		g_lastGpuRasterizeTime = total - cpuTime;
 
-	g_lastWaveformRenderTime = (GetTime() - tstart) * FS_PER_SECOND;
+	g_lastRasterizeSkipCount = g_rasterizeSkipCount.load();
+	g_lastRasterizeChannelCount = g_rasterizeSkipCount + g_cpuRasterizeCount + g_gpuRasterizeCount;
 }
@@ -0,0 +1,126 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Entry point for the filter graph benchmark (ngscopeclient-bench)
+ */
+#include "ngscopeclient.h"
+#include "MainWindow.h"
+#include "FilterGraphBenchmark.h"
+#include "../scopeprotocols/scopeprotocols.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	//Global settings
+	//Default to quiet so the JSON can be piped straight out of stdout
+	Severity console_verbosity = Severity::WARNING;
+	string sessionPath;
+	string outpath = "-";
+	size_t iterations = 10;
+	size_t warmup = 2;
+
+	for(int i=1; i<argc; i++)
+	{
+		string s(argv[i]);
+
+		//Let the logger eat its args first
+		if(ParseLoggerArguments(i, argc, argv, console_verbosity))
+			continue;
+
+		if( (s == "--iterations") && (i+1 < argc) )
+		{
+			if(!ParseSizeArgument(s, argv[++i], 1, iterations))
+				return 1;
+		}
+		else if( (s == "--warmup") && (i+1 < argc) )
+		{
+			if(!ParseSizeArgument(s, argv[++i], 0, warmup))
+				return 1;
+		}
+		else if( (s == "--output") && (i+1 < argc) )
+			outpath = argv[++i];
+		else if(s == "--help")
+		{
+			fprintf(stderr,
+				"Usage: ngscopeclient-bench [logger args] [--iterations N] [--warmup N] [--output file.json]\n"
+				"                           file.scopesession\n"
+				"\n"
+				"Loads a session offline and runs its filter graph over every saved waveform, repeatedly, then\n"
+				"reports per-filter and total run time, throughput, and peak memory usage as JSON.\n"
+				"\n"
+				"  --iterations N     Number of measured iterations (default 10)\n"
+				"  --warmup N         Number of iterations to run and discard first (default 2)\n"
+				"  --output file      Write results to a file instead of stdout\n");
+			return 0;
+		}
+		else if(s[0] == '-')
+		{
+			fprintf(stderr, "Unrecognized argument \"%s\", use --help\n", s.c_str());
+			return 1;
+		}
+		else
+			sessionPath = s;
+	}
+
+	if(sessionPath.empty())
+	{
+		fprintf(stderr, "No .scopesession file specified, use --help\n");
+		return 1;
+	}
+
+	//Set up logging
+	g_log_sinks.push_back(make_unique<ColoredSTDLogSink>(console_verbosity));
+
+	//Initialize object creation tables for predefined libraries
+	if(!VulkanInit(true))
+		return 1;
+	TransportStaticInit();
+	DriverStaticInit();
+	ScopeProtocolStaticInit();
+	InitializePlugins();
+
+	bool ok = true;
+	{
+		FilterGraphBenchmark bench;
+		if(!bench.LoadSession(sessionPath, false))
+			ok = false;
+		else
+		{
+			bench.Run(iterations, warmup);
+			ok = bench.WriteJSON(outpath, sessionPath);
+		}
+	}
+
+	ScopehalStaticCleanup();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Entry point for the GUI log sink benchmark (ngscopeclient-logbench)
+ */
+#include "ngscopeclient.h"
+#include "MainWindow.h"
+
+#include <thread>
+
+using namespace std;
+
+extern GuiLogSink* g_guiLog;
+
+/**
+	@brief Logs a number of messages from each of several threads while another thread flushes the sink
+
+	@param sink			The sink being benchmarked (already registered in g_log_sinks)
+	@param threads		Number of logging threads
+	@param messages		Number of messages logged by each thread
+	@param enabled		True to log at a severity the sink displays, false to use one it discards
+	@param flushTime	Total time spent in GuiLogSink::Flush(), in seconds
+
+	@return Mean time per call to the logging function, in seconds
+ */
+double TimeLogging(GuiLogSink& sink, size_t threads, size_t messages, bool enabled, double& flushTime)
+{
+	//Flush at about the rate the GUI thread would
+	atomic<bool> done(false);
+	flushTime = 0;
+	thread flusher([&]
+	{
+		while(!done)
+		{
+			double start = GetTime();
+			sink.Flush();
+			flushTime += GetTime() - start;
+			this_thread::sleep_for(chrono::milliseconds(16));
+		}
+	});
+
+	double start = GetTime();
+	vector<thread> loggers;
+	for(size_t t=0; t<threads; t++)
+	{
+		loggers.push_back(thread([=]
+		{
+			for(size_t i=0; i<messages; i++)
+			{
+				if(enabled)
+					LogNotice("Thread %zu message %zu\n", t, i);
+				else
+					LogDebug("Thread %zu message %zu\n", t, i);
+			}
+		}));
+	}
+	for(auto& t : loggers)
+		t.join();
+	double dt = GetTime() - start;
+
+	done = true;
+	flusher.join();
+
+	double start2 = GetTime();
+	sink.Flush();
+	flushTime += GetTime() - start2;
+
+	return dt / messages;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t messages = 1000000;
+	size_t maxThreads = 4;
+
+	for(int i=1; i<argc; i++)
+	{
+		string s(argv[i]);
+
+		if( (s == "--messages") && (i+1 < argc) )
+		{
+			if(!ParseSizeArgument(s, argv[++i], 1, messages))
+				return 1;
+		}
+		else if( (s == "--threads") && (i+1 < argc) )
+		{
+			if(!ParseSizeArgument(s, argv[++i], 1, maxThreads))
+				return 1;
+		}
+		else if(s == "--help")
+		{
+			fprintf(stderr,
+				"Usage: ngscopeclient-logbench [--messages N] [--threads N]\n"
+				"\n"
+				"Measures the cost of logging to the GUI log sink from background threads, both at a severity\n"
+				"which is filtered out and at one which is displayed, and prints a table of results.\n"
+				"\n"
+				"  --messages N       Number of messages logged by each thread (default 1000000)\n"
+				"  --threads N        Largest number of logging threads to test (default 4)\n");
+			return 0;
+		}
+		else
+		{
+			fprintf(stderr, "Unrecognized argument \"%s\", use --help\n", s.c_str());
+			return 1;
+		}
+	}
+
+	//The sink under test is the only one, so nothing else adds to the cost
+	g_guiLog = new GuiLogSink(Severity::NOTICE);
+	g_log_sinks.push_back(unique_ptr<GuiLogSink>(g_guiLog));
+
+	printf("%-10s %8s %16s %16s\n", "Severity", "Threads", "Log call (ns)", "Flush (ns/msg)");
+	for(int enabled=0; enabled<2; enabled++)
+	{
+		for(size_t threads=1; threads<=maxThreads; threads *= 2)
+		{
+			double flushTime;
+			double t = TimeLogging(*g_guiLog, threads, messages, enabled, flushTime);
+			if(enabled)
+			{
+				printf("%-10s %8zu %16.1f %16.1f\n",
+					"enabled", threads, t * 1e9, flushTime * 1e9 / (messages * threads));
+			}
+			else
+				printf("%-10s %8zu %16.1f %16s\n", "disabled", threads, t * 1e9, "-");
+
+			//Start each case with an empty log
+			g_guiLog->Clear();
+		}
+	}
+
+	g_log_sinks.clear();
+	return 0;
+}
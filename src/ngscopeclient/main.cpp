@@ -35,23 +35,39 @@
 #define IMGUI_DEFINE_MATH_OPERATORS
 #include "ngscopeclient.h"
 #include "MainWindow.h"
+#include "HeadlessRunner.h"
 #include "../scopeprotocols/scopeprotocols.h"
 #include "imgui_internal.h"
 
-using namespace std;
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
 
-unique_ptr<MainWindow> g_mainWindow;
+using namespace std;
 
-GuiLogSink* g_guiLog;
+extern unique_ptr<MainWindow> g_mainWindow;
+extern GuiLogSink* g_guiLog;
 
 #ifndef _WIN32
 void Relaunch(int argc, char* argv[]);
+bool ForkRenderJobs(vector<string>& sessions, size_t jobs, bool& ok);
 #endif
+bool RenderSessions(const vector<string>& sessions, const string& outdir, size_t width, size_t areaHeight);
 
 int main(int argc, char* argv[])
 {
 	//Global settings
 	Severity console_verbosity = Severity::NOTICE;
+	string headlessSession;
+	string outdir = ".";
+	bool online = false;
+	size_t count = 1;
+	vector<string> renderSessions;
+	size_t renderWidth = 1920;
+	size_t renderAreaHeight = 200;
+	size_t jobs = 1;
 
 	for(int i=1; i<argc; i++)
 	{
@@ -61,8 +77,82 @@ int main(int argc, char* argv[])
 		if(ParseLoggerArguments(i, argc, argv, console_verbosity))
 			continue;
 
-		//TODO: other arguments
+		//Flags that take a value must actually have one
+		bool needsValue =
+			(s == "--headless") || (s == "--outdir") || (s == "--count") || (s == "--render") ||
+			(s == "--render-list") || (s == "--width") || (s == "--area-height") || (s == "--jobs");
+		if(needsValue && (i+1 >= argc) )
+		{
+			fprintf(stderr, "%s requires an argument, use --help\n", s.c_str());
+			return 1;
+		}
 
+		if(s == "--headless")
+			headlessSession = argv[++i];
+		else if(s == "--outdir")
+			outdir = argv[++i];
+		else if(s == "--count")
+		{
+			if(!ParseSizeArgument(s, argv[++i], 0, count))
+				return 1;
+		}
+		else if(s == "--online")
+			online = true;
+		else if(s == "--render")
+			renderSessions.push_back(argv[++i]);
+		else if(s == "--render-list")
+		{
+			ifstream list(argv[++i]);
+			if(!list)
+			{
+				fprintf(stderr, "Failed to open session list %s\n", argv[i]);
+				return 1;
+			}
+			string line;
+			while(getline(list, line))
+			{
+				if(!line.empty())
+					renderSessions.push_back(line);
+			}
+		}
+		else if(s == "--width")
+		{
+			if(!ParseSizeArgument(s, argv[++i], 1, renderWidth))
+				return 1;
+		}
+		else if(s == "--area-height")
+		{
+			if(!ParseSizeArgument(s, argv[++i], 1, renderAreaHeight))
+				return 1;
+		}
+		else if(s == "--jobs")
+		{
+			if(!ParseSizeArgument(s, argv[++i], 1, jobs))
+				return 1;
+		}
+		else if(s == "--help")
+		{
+			fprintf(stderr,
+				"Usage: ngscopeclient [logger args] [--headless file.scopesession [--online] [--count N] [--outdir dir]]\n"
+				"       ngscopeclient [logger args] --render file.scopesession [--render ...] [--render-list file]\n"
+				"                     [--width N] [--area-height N] [--jobs N] [--outdir dir]\n"
+				"\n"
+				"  --headless file    Run the session's acquisition and filter graph without a GUI, then write\n"
+				"                     protocol packets and measurements to CSV files and exit.\n"
+				"                     Works with any Vulkan device including software rasterizers (e.g. lavapipe,\n"
+				"                     selected via VK_ICD_FILENAMES)\n"
+				"  --online           Reconnect to the instruments and acquire live data (default: process\n"
+				"                     saved waveforms from the session offline)\n"
+				"  --count N          Number of acquisitions to process when online (default 1)\n"
+				"  --outdir dir       Directory for output files (default: current directory)\n"
+				"  --render file      Draw each waveform group of a session's saved waveforms to a PNG file\n"
+				"                     (may be given more than once)\n"
+				"  --render-list file Render every session listed in a text file, one path per line\n"
+				"  --width N          Width of rendered images (default 1920)\n"
+				"  --area-height N    Height of each waveform area in rendered images (default 200)\n"
+				"  --jobs N           Number of sessions to render in parallel, each in its own process (default 1)\n");
+			return 0;
+		}
 	}
 
 	//Set up logging
@@ -100,20 +190,68 @@ int main(int argc, char* argv[])
 		}
 	#endif
 
+	//Batch rendering: split the sessions over child processes before anything is initialized
+	bool rendering = !renderSessions.empty();
+	#ifndef _WIN32
+		if(rendering && (jobs > 1) && (renderSessions.size() > 1) )
+		{
+			bool ok = true;
+			if(!ForkRenderJobs(renderSessions, jobs, ok))
+				return ok ? 0 : 1;
+		}
+	#else
+		if(jobs > 1)
+			LogWarning("--jobs is not supported on Windows, rendering sessions one at a time\n");
+	#endif
+
 	//Initialize object creation tables for predefined libraries
-	if(!VulkanInit())
+	//(no window system needed when running headless)
+	bool headless = !headlessSession.empty() || rendering;
+	if(!VulkanInit(headless))
 		return 1;
 	TransportStaticInit();
 	DriverStaticInit();
 	ScopeProtocolStaticInit();
 	InitializePlugins();
 
+	if(rendering)
+	{
+		bool ok = RenderSessions(renderSessions, outdir, renderWidth, renderAreaHeight);
+		ScopehalStaticCleanup();
+		return ok ? 0 : 1;
+	}
+
+	if(headless)
+	{
+		bool ok = true;
+		{
+			HeadlessRunner runner;
+			if(!runner.LoadSession(headlessSession, online))
+				ok = false;
+			else
+			{
+				if(online)
+					ok = runner.RunOnline(count);
+				else
+					runner.RunOffline();
+
+				//Write whatever we got, even if acquisition was cut short
+				if(!runner.WriteResults(outdir))
+					ok = false;
+			}
+		}
+
+		ScopehalStaticCleanup();
+		return ok ? 0 : 1;
+	}
+
 	{
 		//Make the top level window
 		shared_ptr<QueueHandle> queue(g_vkQueueManager->GetRenderQueue("g_mainWindow.render"));
 		g_mainWindow = make_unique<MainWindow>(queue);
 
 		//Main event loop
+		g_perfRecorder.NameThread("GUI thread");
 		auto& session = g_mainWindow->GetSession();
 		while(!glfwWindowShouldClose(g_mainWindow->GetWindow()))
 		{
@@ -123,6 +261,9 @@ int main(int argc, char* argv[])
 			else
 				glfwPollEvents();
 
+			//Pick up anything logged by background threads since the last frame
+			g_guiLog->Flush();
+
 			//Draw the main window
 			g_mainWindow->Render();
 		}
@@ -151,79 +292,82 @@ void Relaunch(int argc, char* argv[])
 #endif
 
 /**
-	@brief Helper function for right justified text in a table
- */
-void RightJustifiedText(const string& str)
-{
-	//Getting column width is a pain, we have to use some nonpublic APIs here
-	auto rect = ImGui::TableGetCellBgRect(ImGui::GetCurrentTable(), ImGui::TableGetColumnIndex());
+	@brief Renders the waveform groups of each session, one after another
 
-	float delta = rect.GetWidth() -
-		(ImGui::CalcTextSize(str.c_str()).x + ImGui::GetScrollX() + 2*ImGui::GetStyle().ItemSpacing.x);
-	if(delta < 0)
-		delta = 0;
-
-	ImGui::SetCursorPosX(ImGui::GetCursorPosX() + delta);
-	ImGui::TextUnformatted(str.c_str());
-}
-
-/**
-	@brief Check if two rectangles intersect
+	@return True if every session was rendered successfully
  */
-bool RectIntersect(ImVec2 posA, ImVec2 sizeA, ImVec2 posB, ImVec2 sizeB)
+bool RenderSessions(const vector<string>& sessions, const string& outdir, size_t width, size_t areaHeight)
 {
-	//Enlarge hitboxes by a small margin to keep spacing between nodes
-	float margin = 5;
-	posA.x -= margin;
-	posA.y -= margin;
-	posB.x -= margin;
-	posB.y -= margin;
-	sizeA.x += 2*margin;
-	sizeA.y += 2*margin;
-	sizeB.x += 2*margin;
-	sizeB.y += 2*margin;
-
-	//A completely above B? No intersection
-	if( (posA.y + sizeA.y) < posB.y)
-		return false;
-
-	//B completely above A? No intersection
-	if( (posB.y + sizeB.y) < posA.y)
-		return false;
-
-	//A completely left of B? No intersection
-	if( (posA.x + sizeA.x) < posB.x)
-		return false;
-
-	//B completely left of A? No intersection
-	if( (posB.x + sizeB.x) < posA.x)
-		return false;
-
-	//If we get here, they overlap
-	return true;
+	bool ok = true;
+	for(auto& path : sessions)
+	{
+		//Name images after the session file
+		string prefix = path.substr(path.find_last_of("/\\") + 1);
+		auto ext = prefix.rfind(".scopesession");
+		if( (ext != string::npos) && (ext > 0) )
+			prefix = prefix.substr(0, ext);
+
+		HeadlessRunner runner;
+		if(!runner.LoadSession(path, false) || !runner.RenderGroups(outdir, prefix, width, areaHeight))
+		{
+			LogError("Failed to render \"%s\"\n", path.c_str());
+			ok = false;
+		}
+	}
+	return ok;
 }
 
+#ifndef _WIN32
 /**
-	@brief Check if a rectangle is completely within the other one
+	@brief Renders each session in its own child process, running up to a fixed number of them at once
 
-	A is outer, B is inner
+	Each child is a fresh copy of the process from before Vulkan and the scopehal libraries were initialized, so
+	children share no state and can all run on a software Vulkan device at once.
+
+	@param sessions	List of sessions. In a child process, replaced by the single session it should render.
+	@param jobs		Maximum number of child processes to run at once
+	@param ok		Set to false if any child failed (parent only)
+
+	@return True in a child process, false in the parent once every child has exited
  */
-bool RectContains(ImVec2 posA, ImVec2 sizeA, ImVec2 posB, ImVec2 sizeB)
+bool ForkRenderJobs(vector<string>& sessions, size_t jobs, bool& ok)
 {
-	//Top left of B must be in A
-	ImVec2 brA (posA.x + sizeA.x, posA.y + sizeA.y);
-	if( (posB.x < posA.x) || (posB.x >= brA.x) )
-		return false;
-	if( (posB.y < posA.y) || (posB.y >= brA.y) )
-		return false;
-
-	//Bottom right of B must be in A
-	ImVec2 brB (posB.x + sizeB.x, posB.y + sizeB.y);
-	if( (brB.x < posA.x) || (brB.x >= brA.x) )
-		return false;
-	if( (brB.y < posA.y) || (brB.y >= brA.y) )
-		return false;
-
-	//Contianed if we get here
-	return true;
+	size_t running = 0;
+	auto reap = [&]()
+	{
+		int status;
+		if(wait(&status) < 0)
+		{
+			running = 0;
+			return;
+		}
+		running --;
+		if(!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+			ok = false;
+	};
+
+	for(auto& path : sessions)
+	{
+		while(running >= jobs)
+			reap();
+
+		pid_t pid = fork();
+		if(pid == 0)
+		{
+			sessions = vector<string>{path};
+			return true;
+		}
+		else if(pid < 0)
+		{
+			LogError("Failed to start a process to render \"%s\"\n", path.c_str());
+			ok = false;
+		}
+		else
+			running ++;
+	}
+
+	while(running > 0)
+		reap();
+	return false;
 }
+#endif
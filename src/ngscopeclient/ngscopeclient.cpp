@@ -0,0 +1,158 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Globals and miscellaneous helpers shared by all ngscopeclient executables
+ */
+#define IMGUI_DEFINE_MATH_OPERATORS
+#include "ngscopeclient.h"
+#include "MainWindow.h"
+#include "imgui_internal.h"
+
+#include <cerrno>
+
+using namespace std;
+
+//The GUI creates these in main(). The benchmarks leave them empty, but link code shared with the GUI which uses them.
+unique_ptr<MainWindow> g_mainWindow;
+GuiLogSink* g_guiLog = nullptr;
+
+/**
+	@brief Parses a non-negative integer command line argument, printing a usage error if it's malformed
+
+	@param flag		Name of the flag, for error messages
+	@param value	Text following the flag
+	@param minimum	Smallest legal value
+	@param out		Parsed value (not modified on failure)
+
+	@return True on success
+ */
+bool ParseSizeArgument(const string& flag, const char* value, size_t minimum, size_t& out)
+{
+	//strtoull() silently negates values with a leading minus sign, so only accept digits up front
+	char* end = nullptr;
+	errno = 0;
+	unsigned long long n = 0;
+	if(isdigit(static_cast<unsigned char>(value[0])))
+		n = strtoull(value, &end, 10);
+
+	if( (end == nullptr) || (*end != '\0') || (errno == ERANGE) || (n > SIZE_MAX) )
+	{
+		fprintf(stderr, "%s requires a number, got \"%s\"; use --help\n", flag.c_str(), value);
+		return false;
+	}
+	if(n < minimum)
+	{
+		fprintf(stderr, "%s must be at least %zu\n", flag.c_str(), minimum);
+		return false;
+	}
+
+	out = n;
+	return true;
+}
+
+/**
+	@brief Helper function for right justified text in a table
+ */
+void RightJustifiedText(const string& str)
+{
+	//Getting column width is a pain, we have to use some nonpublic APIs here
+	auto rect = ImGui::TableGetCellBgRect(ImGui::GetCurrentTable(), ImGui::TableGetColumnIndex());
+
+	float delta = rect.GetWidth() -
+		(ImGui::CalcTextSize(str.c_str()).x + ImGui::GetScrollX() + 2*ImGui::GetStyle().ItemSpacing.x);
+	if(delta < 0)
+		delta = 0;
+
+	ImGui::SetCursorPosX(ImGui::GetCursorPosX() + delta);
+	ImGui::TextUnformatted(str.c_str());
+}
+
+/**
+	@brief Check if two rectangles intersect
+ */
+bool RectIntersect(ImVec2 posA, ImVec2 sizeA, ImVec2 posB, ImVec2 sizeB)
+{
+	//Enlarge hitboxes by a small margin to keep spacing between nodes
+	float margin = 5;
+	posA.x -= margin;
+	posA.y -= margin;
+	posB.x -= margin;
+	posB.y -= margin;
+	sizeA.x += 2*margin;
+	sizeA.y += 2*margin;
+	sizeB.x += 2*margin;
+	sizeB.y += 2*margin;
+
+	//A completely above B? No intersection
+	if( (posA.y + sizeA.y) < posB.y)
+		return false;
+
+	//B completely above A? No intersection
+	if( (posB.y + sizeB.y) < posA.y)
+		return false;
+
+	//A completely left of B? No intersection
+	if( (posA.x + sizeA.x) < posB.x)
+		return false;
+
+	//B completely left of A? No intersection
+	if( (posB.x + sizeB.x) < posA.x)
+		return false;
+
+	//If we get here, they overlap
+	return true;
+}
+
+/**
+	@brief Check if a rectangle is completely within the other one
+
+	A is outer, B is inner
+ */
+bool RectContains(ImVec2 posA, ImVec2 sizeA, ImVec2 posB, ImVec2 sizeB)
+{
+	//Top left of B must be in A
+	ImVec2 brA (posA.x + sizeA.x, posA.y + sizeA.y);
+	if( (posB.x < posA.x) || (posB.x >= brA.x) )
+		return false;
+	if( (posB.y < posA.y) || (posB.y >= brA.y) )
+		return false;
+
+	//Bottom right of B must be in A
+	ImVec2 brB (posB.x + sizeB.x, posB.y + sizeB.y);
+	if( (brB.x < posA.x) || (brB.x >= brA.x) )
+		return false;
+	if( (brB.y < posA.y) || (brB.y >= brA.y) )
+		return false;
+
+	//Contianed if we get here
+	return true;
+}
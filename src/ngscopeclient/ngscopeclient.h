@@ -49,8 +49,11 @@
 #include "FunctionGeneratorState.h"
 #include "MultimeterState.h"
 #include "LoadState.h"
+#include "InstrumentPollSchedule.h"
 #include "GuiLogSink.h"
 #include "Event.h"
+#include "GpuProfiler.h"
+#include "PerfEventRecorder.h"
 
 class Session;
 
@@ -72,6 +75,9 @@ public:
 	std::shared_ptr<BERTState> bertstate;
 	std::shared_ptr<PowerSupplyState> psustate;
 	std::shared_ptr<FunctionGeneratorState> awgstate;
+
+	///@brief Timing for status polls
+	std::shared_ptr<InstrumentPollSchedule> schedule;
 };
 
 void InstrumentThread(InstrumentThreadArgs args);
@@ -82,4 +88,6 @@ void RightJustifiedText(const std::string& str);
 bool RectIntersect(ImVec2 posA, ImVec2 sizeA, ImVec2 posB, ImVec2 sizeB);
 bool RectContains(ImVec2 posA, ImVec2 sizeA, ImVec2 posB, ImVec2 sizeB);
 
+bool ParseSizeArgument(const std::string& flag, const char* value, size_t minimum, size_t& out);
+
 #endif
@@ -0,0 +1,169 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Entry point for the waveform rasterizer benchmark (ngscopeclient-rasterbench)
+ */
+#include "ngscopeclient.h"
+#include "MainWindow.h"
+#include "RasterizerBenchmark.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	//Global settings
+	Severity console_verbosity = Severity::WARNING;
+	string outpath;
+	size_t iterations = 5;
+	size_t warmup = 1;
+	size_t height = 256;
+	size_t minDepth = 1000;
+	size_t maxDepth = 100000000;
+	vector<size_t> widths = {256, 1024, 4096};
+	bool cpu = true;
+	bool gpu = true;
+
+	for(int i=1; i<argc; i++)
+	{
+		string s(argv[i]);
+
+		//Let the logger eat its args first
+		if(ParseLoggerArguments(i, argc, argv, console_verbosity))
+			continue;
+
+		if( (s == "--iterations") && (i+1 < argc) )
+		{
+			if(!ParseSizeArgument(s, argv[++i], 1, iterations))
+				return 1;
+		}
+		else if( (s == "--warmup") && (i+1 < argc) )
+		{
+			if(!ParseSizeArgument(s, argv[++i], 0, warmup))
+				return 1;
+		}
+		else if( (s == "--height") && (i+1 < argc) )
+		{
+			if(!ParseSizeArgument(s, argv[++i], 1, height))
+				return 1;
+		}
+		else if( (s == "--min-depth") && (i+1 < argc) )
+		{
+			if(!ParseSizeArgument(s, argv[++i], 2, minDepth))
+				return 1;
+		}
+		else if( (s == "--max-depth") && (i+1 < argc) )
+		{
+			if(!ParseSizeArgument(s, argv[++i], 2, maxDepth))
+				return 1;
+		}
+		else if( (s == "--widths") && (i+1 < argc) )
+		{
+			widths.clear();
+			string list = argv[++i];
+			size_t start = 0;
+			do
+			{
+				auto end = list.find(',', start);
+				if(end == string::npos)
+					end = list.length();
+				size_t width;
+				if(!ParseSizeArgument(s, list.substr(start, end - start).c_str(), 1, width))
+					return 1;
+				widths.push_back(width);
+				start = end + 1;
+			} while(start <= list.length());
+		}
+		else if(s == "--cpu-only")
+			gpu = false;
+		else if(s == "--gpu-only")
+			cpu = false;
+		else if( (s == "--output") && (i+1 < argc) )
+			outpath = argv[++i];
+		else if(s == "--help")
+		{
+			fprintf(stderr,
+				"Usage: ngscopeclient-rasterbench [logger args] [--iterations N] [--warmup N] [--height N]\n"
+				"                                 [--min-depth N] [--max-depth N] [--widths N,N,...]\n"
+				"                                 [--cpu-only | --gpu-only] [--output file.json]\n"
+				"\n"
+				"Rasterizes synthetic waveforms with every waveform-compute shader variant (and the equivalent CPU\n"
+				"rasterizer), zoomed out to fit the window, and prints a table of run times.\n"
+				"\n"
+				"  --iterations N     Number of measured iterations per case (default 5)\n"
+				"  --warmup N         Number of iterations to run and discard first (default 1)\n"
+				"  --height N         Height of the rasterized waveform, in pixels (default 256)\n"
+				"  --min-depth N      Smallest memory depth, in samples (default 1000)\n"
+				"  --max-depth N      Largest memory depth, in samples (default 100000000). Depths go up in\n"
+				"                     steps of 10x. Needs about 21 bytes of RAM and VRAM per sample.\n"
+				"  --widths N,N,...   Window widths, in pixels (default 256,1024,4096)\n"
+				"  --cpu-only         Only time the CPU rasterizer\n"
+				"  --gpu-only         Only time the compute shaders\n"
+				"  --output file      Also write results as JSON (\"-\" for stdout, instead of the table)\n");
+			return 0;
+		}
+		else
+		{
+			fprintf(stderr, "Unrecognized argument \"%s\", use --help\n", s.c_str());
+			return 1;
+		}
+	}
+
+	if( (minDepth < 2) || (maxDepth < minDepth) || (maxDepth > UINT32_MAX) )
+	{
+		fprintf(stderr, "Memory depths must be between 2 and %u samples\n", UINT32_MAX);
+		return 1;
+	}
+
+	vector<size_t> depths;
+	for(size_t depth = minDepth; depth <= maxDepth; depth *= 10)
+		depths.push_back(depth);
+
+	//Set up logging
+	g_log_sinks.push_back(make_unique<ColoredSTDLogSink>(console_verbosity));
+
+	if(!VulkanInit(true))
+		return 1;
+
+	bool ok = true;
+	{
+		RasterizerBenchmark bench(height, iterations, warmup);
+		bench.Run(depths, widths, cpu, gpu);
+
+		if(outpath != "-")
+			bench.PrintTable(stdout);
+		if(!outpath.empty())
+			ok = bench.WriteJSON(outpath);
+	}
+
+	ScopehalStaticCleanup();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Rasterizes many uniform digital waveforms sharing a timebase in one dispatch (see DigitalBusRasterizer)
+
+	Input is bit packed, with wordsPerSample words per sample and one bit per channel. Each channel is written to its
+	own strip of the output, windowWidth x windowHeight pixels, one after another.
+
+	Produces the same image as the digital variant of waveform-compute.glsl: a single pixel at the low or high level
+	per sample, or a full height line for an edge at the left side of the column.
+ */
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_packed
+{
+	uint packed[];
+};
+
+layout(std430, binding=1) restrict writeonly buffer buf_out
+{
+	float outval[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint memDepth;
+	uint offsetSamples;
+	uint windowWidth;
+	uint windowHeight;
+	uint numChannels;
+	uint wordsPerSample;
+	float xoff;
+	float xscale;
+	float sampleBias;
+};
+
+//One thread per pixel column and channel
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	uint col = gl_GlobalInvocationID.x;
+	uint chan = gl_GlobalInvocationID.y;
+	if( (col >= windowWidth) || (chan >= numChannels) )
+		return;
+
+	uint word = chan / 32;
+	uint bit = chan % 32;
+	float fcol = float(col);
+	float fcolEnd = fcol + 1;
+
+	//Count samples at each level, and edges (which cover every row)
+	uint lowHits = 0;
+	uint highHits = 0;
+	uint edgeHits = 0;
+	uint istart = uint(floor(fcol / xscale)) + offsetSamples;
+	for(uint i=istart; i < (memDepth - 1); i++)
+	{
+		float lx = (float(int(i - offsetSamples)) + sampleBias) * xscale + xoff;
+		float rx = lx + xscale;
+		if(lx > fcolEnd)
+			break;
+
+		if(rx >= fcol)
+		{
+			uint v = (packed[i*wordsPerSample + word] >> bit) & 1;
+			uint vnext = (packed[(i+1)*wordsPerSample + word] >> bit) & 1;
+
+			if( (abs(rx - fcol) <= 1) && (v != vnext) )
+				edgeHits ++;
+			else if(v != 0)
+				highHits ++;
+			else
+				lowHits ++;
+		}
+
+		//Check if we're at the end of the pixel
+		if(rx > fcolEnd)
+			break;
+	}
+
+	//Write the column
+	uint base = chan*windowWidth*windowHeight + col;
+	uint top = windowHeight - 1;
+	for(uint y=0; y<windowHeight; y++)
+	{
+		uint hits = edgeHits;
+		if(y == 0)
+			hits += lowHits;
+		if(y == top)
+			hits += highHits;
+		outval[base + y*windowWidth] = float(hits);
+	}
+}
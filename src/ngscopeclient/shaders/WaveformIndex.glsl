@@ -0,0 +1,117 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Finds the first sample of a sparse waveform in each pixel column of the rasterizer
+
+	Equivalent to calling BinarySearchForGequal() for every column, but runs on the GPU so the offsets buffer of
+	GPU-resident waveforms doesn't have to be copied back to the host on every pan/zoom.
+ */
+
+#version 430
+#pragma shader_stage(compute)
+
+//Sample offsets, actually 64-bit little endian signed ints
+layout(std430, binding=0) restrict readonly buffer buf_offsets
+{
+	uint offsets[];
+};
+
+//Target offset for the left edge of each column, actually 64-bit little endian signed ints
+layout(std430, binding=1) restrict readonly buffer buf_targets
+{
+	uint targets[];
+};
+
+//Output index buffer
+layout(std430, binding=2) restrict writeonly buffer buf_xind
+{
+	uint xind[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint len;
+	uint width;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+//Signed 64-bit comparisons without GL_ARB_gpu_shader_int64
+bool LessThan(uint alo, uint ahi, uint blo, uint bhi)
+{
+	if(ahi != bhi)
+		return int(ahi) < int(bhi);
+	return alo < blo;
+}
+
+bool LessThanOrEqual(uint alo, uint ahi, uint blo, uint bhi)
+{
+	if(ahi != bhi)
+		return int(ahi) < int(bhi);
+	return alo <= blo;
+}
+
+void main()
+{
+	uint col = gl_GlobalInvocationID.x;
+	if(col >= width)
+		return;
+
+	uint tlo = targets[col*2];
+	uint thi = targets[col*2 + 1];
+
+	//Clip if out of range
+	if(!LessThan(offsets[0], offsets[1], tlo, thi))
+	{
+		xind[col] = 0;
+		return;
+	}
+	if(LessThan(offsets[(len-1)*2], offsets[(len-1)*2 + 1], tlo, thi))
+	{
+		xind[col] = len;
+		return;
+	}
+
+	//Find the last sample at or before the target
+	uint base = 0;
+	uint n = len;
+	while(n > 1)
+	{
+		uint half_n = n / 2;
+		uint mid = base + half_n;
+		if(LessThanOrEqual(offsets[mid*2], offsets[mid*2 + 1], tlo, thi))
+			base = mid;
+		n -= half_n;
+	}
+
+	//BinarySearchForGequal() brackets the target between two samples, so never returns the last one here
+	xind[col] = min(base, len - 2);
+}
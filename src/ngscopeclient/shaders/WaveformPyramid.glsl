@@ -0,0 +1,97 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Builds one level of a min/max envelope pyramid (see WaveformPyramid)
+ */
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_in
+{
+	float din[];
+};
+
+//Two points per bucket: min and max, in the order they occurred
+layout(std430, binding=1) restrict writeonly buffer buf_out
+{
+	float dout[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint inLen;
+	uint outBuckets;
+	uint groupSize;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	//Large levels are dispatched as a 2D grid since there are more buckets than blocks allowed in one dimension
+	uint bucket = (gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x) + gl_GlobalInvocationID.x;
+	if(bucket >= outBuckets)
+		return;
+
+	uint start = bucket * groupSize;
+	uint end = min(start + groupSize, inLen);
+
+	float vmin = din[start];
+	float vmax = vmin;
+	uint imin = start;
+	uint imax = start;
+	for(uint i=start+1; i<end; i++)
+	{
+		float v = din[i];
+		if(v < vmin)
+		{
+			vmin = v;
+			imin = i;
+		}
+		if(v > vmax)
+		{
+			vmax = v;
+			imax = i;
+		}
+	}
+
+	if(imin <= imax)
+	{
+		dout[bucket*2] = vmin;
+		dout[bucket*2 + 1] = vmax;
+	}
+	else
+	{
+		dout[bucket*2] = vmax;
+		dout[bucket*2 + 1] = vmin;
+	}
+}
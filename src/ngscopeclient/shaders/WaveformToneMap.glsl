@@ -44,6 +44,8 @@ layout(std430, push_constant) uniform constants
 	float channelBlue;
 	uint width;
 	uint height;
+	float alpha;
+	uint offset;
 };
 
 layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
@@ -55,9 +57,10 @@ void main()
 	if(gl_GlobalInvocationID.y >= height)
 		return;
 
-	//Intensity graded grayscale input
-	uint npixel = gl_GlobalInvocationID.y*width + gl_GlobalInvocationID.x;
-	float pixval = pixels[npixel];
+	//Hit counts, scaled by trace alpha for intensity grading
+	//(offset is nonzero if we're one strip of a multi-channel digital bus rasterization)
+	uint npixel = offset + gl_GlobalInvocationID.y*width + gl_GlobalInvocationID.x;
+	float pixval = pixels[npixel] * alpha;
 
 	//Logarithmic shading
 	float y = pow(pixval, 1.0 / 4);
@@ -0,0 +1,155 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Unit test for multi-channel digital rasterization (WaveformDigitalBus.glsl)
+ */
+#ifdef _CATCH2_V3
+#include <catch2/catch_all.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include "../../lib/scopehal/scopehal.h"
+#include "Rendering.h"
+
+using namespace std;
+
+TEST_CASE("Rendering_WaveformDigitalBus")
+{
+	//Create a queue and command buffer
+	shared_ptr<QueueHandle> queue(g_vkQueueManager->GetComputeQueue("Rendering_WaveformDigitalBus.queue"));
+	vk::CommandPoolCreateInfo poolInfo(
+		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		queue->m_family );
+	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
+
+	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
+	vk::raii::CommandBuffer cmdbuf(std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+
+	//More than one word per sample, with the last word partially used
+	const size_t nchans = 40;
+	const size_t wavelen = 1000000;
+	const size_t width = 2048;
+	const size_t height = 21;
+
+	vector<unique_ptr<UniformDigitalWaveform> > wfms;
+	vector<UniformDigitalWaveform*> ptrs;
+	for(size_t i=0; i<nchans; i++)
+	{
+		wfms.push_back(make_unique<UniformDigitalWaveform>());
+		wfms[i]->Resize(wavelen);
+		ptrs.push_back(wfms[i].get());
+	}
+
+	uniform_int_distribution<int> bitdesc(0, 1);
+	uniform_real_distribution<double> zoomdesc(0.0001, 4);
+
+	DigitalBusRasterizer bus;
+	AcceleratorBuffer<float> golden;
+	golden.resize(width * height);
+
+	const size_t niter = 4;
+	for(size_t i=0; i<niter; i++)
+	{
+		SECTION(string("Iteration ") + to_string(i))
+		{
+			LogVerbose("Iteration %zu\n", i);
+			LogIndenter li;
+
+			//Random waveforms. Bump the revision so the bus is repacked
+			for(auto w : ptrs)
+			{
+				w->PrepareForCpuAccess();
+				for(size_t j=0; j<wavelen; j++)
+					w->m_samples[j] = bitdesc(g_rng);
+				w->MarkModifiedFromCpu();
+				w->m_revision ++;
+			}
+
+			//Random zoom and pan, with constants calculated the same way WaveformArea does
+			double pixelsPerX = zoomdesc(g_rng);
+			uniform_int_distribution<int64_t> offdesc(-100, wavelen / 2);
+			int64_t offset = offdesc(g_rng);
+
+			ConfigPushConstants config;
+			config.innerXoff = -offset;
+			config.windowHeight = height;
+			config.windowWidth = width;
+			config.memDepth = wavelen;
+			config.offset_samples = offset - 2;
+			config.alpha = 1;
+			config.xoff = 0;
+			config.xscale = pixelsPerX;
+			config.yoff = 0;
+			config.yscale = height - 1;
+			config.ybase = 0;
+			config.persistScale = 0;
+
+			double start = GetTime();
+			bus.Pack(ptrs);
+			double tpack = GetTime() - start;
+			REQUIRE(bus.GetChannelCount() == nchans);
+
+			start = GetTime();
+			cmdbuf.begin({});
+			auto strip = bus.Rasterize(cmdbuf, config);
+			cmdbuf.end();
+			queue->SubmitAndBlock(cmdbuf);
+			double dt = GetTime() - start;
+			LogVerbose("Pack: %6.2f ms, GPU: %6.2f ms\n", tpack * 1000, dt * 1000);
+			REQUIRE(strip->size() == nchans * width * height);
+			strip->PrepareForCpuAccess();
+
+			//Every strip should match what the single channel rasterizer draws, give or take the occasional
+			//span endpoint moved by GPU multiply-add contraction
+			for(size_t c=0; c<nchans; c++)
+			{
+				WaveformRasterizer::Inputs inputs;
+				inputs.m_digital = reinterpret_cast<const uint8_t*>(ptrs[c]->m_samples.GetCpuPointer());
+
+				golden.PrepareForCpuAccess();
+				for(size_t j=0; j<golden.size(); j++)
+					golden[j] = 0;
+				WaveformRasterizer::Rasterize(
+					config, WaveformRasterizer::VARIANT_DIGITAL, true, inputs, golden.GetCpuPointer());
+
+				size_t mismatches = 0;
+				const float* actual = strip->GetCpuPointer() + c*width*height;
+				for(size_t j=0; j<golden.size(); j++)
+				{
+					if(fabs(golden[j] - actual[j]) > 1e-4f * max(1.0f, fabs(golden[j])))
+						mismatches ++;
+				}
+				REQUIRE(mismatches <= golden.size() / 100);
+			}
+		}
+	}
+}
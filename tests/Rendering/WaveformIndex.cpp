@@ -0,0 +1,171 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Unit test for sparse waveform X axis indexing (WaveformIndex.glsl and its CPU equivalent)
+ */
+#ifdef _CATCH2_V3
+#include <catch2/catch_all.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include "../../lib/scopehal/scopehal.h"
+#include "Rendering.h"
+
+using namespace std;
+
+TEST_CASE("Rendering_WaveformIndex")
+{
+	#ifdef __x86_64__
+	bool reallyHasAvx2 = g_hasAvx2;
+	#endif
+
+	//Create a queue and command buffer
+	shared_ptr<QueueHandle> queue(g_vkQueueManager->GetComputeQueue("Rendering_WaveformIndex.queue"));
+	vk::CommandPoolCreateInfo poolInfo(
+		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		queue->m_family );
+	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
+
+	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
+	vk::raii::CommandBuffer cmdbuf(std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+
+	const size_t wavelen = 1000000;
+	const uint32_t width = 2001;
+
+	AcceleratorBuffer<int64_t> offsets;
+	AcceleratorBuffer<int64_t> targets;
+	AcceleratorBuffer<uint32_t> data_out;
+	AcceleratorBuffer<uint32_t> data_out_golden;
+
+	offsets.resize(wavelen);
+	targets.resize(width);
+	data_out.resize(width);
+	data_out_golden.resize(width);
+
+	uniform_int_distribution<int64_t> gapdesc(1, 100);
+
+	ComputePipeline pipe("shaders/WaveformIndex.spv", 3, sizeof(WaveformIndexArgs));
+
+	const size_t niter = 8;
+	for(size_t i=0; i<niter; i++)
+	{
+		SECTION(string("Iteration ") + to_string(i))
+		{
+			LogVerbose("Iteration %zu\n", i);
+			LogIndenter li;
+
+			//Random sparse waveform, starting at a negative offset to exercise signed comparisons
+			offsets.PrepareForCpuAccess();
+			int64_t t = -5000;
+			for(size_t j=0; j<wavelen; j++)
+			{
+				offsets[j] = t;
+				t += gapdesc(g_rng);
+			}
+			offsets.MarkModifiedFromCpu();
+
+			//Columns spanning a bit more than the whole waveform, so some are out of range at each end
+			targets.PrepareForCpuAccess();
+			double scale = (t + 20000) * 1.0 / width;
+			for(size_t j=0; j<width; j++)
+				targets[j] = floor(j * scale) - 15000;
+			targets.MarkModifiedFromCpu();
+
+			//Baseline with BinarySearchForGequal
+			data_out_golden.PrepareForCpuAccess();
+			double start = GetTime();
+			for(size_t j=0; j<width; j++)
+				data_out_golden[j] = BinarySearchForGequal(offsets.GetCpuPointer(), wavelen, targets[j]);
+			double tbase = GetTime() - start;
+			data_out_golden.MarkModifiedFromCpu();
+			LogVerbose("CPU (baseline): %6.3f ms\n", tbase * 1000);
+
+			//Scalar implementation
+			#ifdef __x86_64__
+				g_hasAvx2 = false;
+			#endif
+			data_out.PrepareForCpuAccess();
+			start = GetTime();
+			WaveformRasterizer::ComputeIndexes(
+				offsets.GetCpuPointer(), wavelen, targets.GetCpuPointer(), data_out.GetCpuPointer(), width);
+			double dt = GetTime() - start;
+			data_out.MarkModifiedFromCpu();
+			LogVerbose("CPU (no AVX)  : %6.3f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
+			for(size_t j=0; j<width; j++)
+				REQUIRE(data_out[j] == data_out_golden[j]);
+
+			#ifdef __x86_64__
+			if(reallyHasAvx2)
+			{
+				g_hasAvx2 = true;
+
+				data_out.PrepareForCpuAccess();
+				start = GetTime();
+				WaveformRasterizer::ComputeIndexes(
+					offsets.GetCpuPointer(), wavelen, targets.GetCpuPointer(), data_out.GetCpuPointer(), width);
+				dt = GetTime() - start;
+				data_out.MarkModifiedFromCpu();
+
+				LogVerbose("CPU (AVX2)    : %6.3f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
+				for(size_t j=0; j<width; j++)
+					REQUIRE(data_out[j] == data_out_golden[j]);
+			}
+			#endif
+
+			//Vulkan implementation
+			data_out.PrepareForGpuAccess();
+			offsets.PrepareForGpuAccess();
+			targets.PrepareForGpuAccess();
+
+			start = GetTime();
+			cmdbuf.begin({});
+			pipe.BindBufferNonblocking(0, offsets, cmdbuf);
+			pipe.BindBufferNonblocking(1, targets, cmdbuf);
+			pipe.BindBufferNonblocking(2, data_out, cmdbuf, true);
+			WaveformIndexArgs args(wavelen, width);
+			pipe.Dispatch(cmdbuf, args, GetComputeBlockCount(width, 64));
+			cmdbuf.end();
+			queue->SubmitAndBlock(cmdbuf);
+			dt = GetTime() - start;
+			data_out.MarkModifiedFromGpu();
+
+			data_out.PrepareForCpuAccess();
+			LogVerbose("GPU           : %6.3f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
+			for(size_t j=0; j<width; j++)
+				REQUIRE(data_out[j] == data_out_golden[j]);
+		}
+	}
+
+	#ifdef __x86_64__
+		g_hasAvx2 = reallyHasAvx2;
+	#endif
+}
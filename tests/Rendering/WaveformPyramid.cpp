@@ -0,0 +1,143 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Unit test for min/max envelope pyramid generation (WaveformPyramid.glsl and its CPU equivalent)
+ */
+#ifdef _CATCH2_V3
+#include <catch2/catch_all.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include "../../lib/scopehal/scopehal.h"
+#include "Rendering.h"
+
+using namespace std;
+
+/**
+	@brief Exposes the number of levels built so far
+ */
+class TestWaveformPyramid : public WaveformPyramid
+{
+public:
+	size_t GetLevelCount()
+	{ return m_levels.size(); }
+};
+
+TEST_CASE("Rendering_WaveformPyramid")
+{
+	//Create a queue and command buffer
+	shared_ptr<QueueHandle> queue(g_vkQueueManager->GetComputeQueue("Rendering_WaveformPyramid.queue"));
+	vk::CommandPoolCreateInfo poolInfo(
+		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		queue->m_family );
+	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
+
+	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
+	vk::raii::CommandBuffer cmdbuf(std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+
+	//Not a multiple of any block size, so the last bucket of each level is partial
+	const size_t wavelen = 10000019;
+	const size_t level = 3;
+	const int64_t step = WaveformPyramid::GetLevelStep(level);
+
+	UniformAnalogWaveform wfm;
+	wfm.Resize(wavelen);
+	uniform_real_distribution<float> noise(-1, 1);
+
+	TestWaveformPyramid cpuPyramid;
+	TestWaveformPyramid gpuPyramid;
+
+	const size_t niter = 4;
+	for(size_t i=0; i<niter; i++)
+	{
+		SECTION(string("Iteration ") + to_string(i))
+		{
+			LogVerbose("Iteration %zu\n", i);
+			LogIndenter li;
+
+			//Random waveform. Bump the revision so cached levels from the last iteration are discarded
+			wfm.PrepareForCpuAccess();
+			for(size_t j=0; j<wavelen; j++)
+				wfm.m_samples[j] = noise(g_rng);
+			wfm.MarkModifiedFromCpu();
+			wfm.m_revision ++;
+
+			//Golden envelope straight from the raw samples
+			size_t buckets = (wavelen + step*2 - 1) / (step*2);
+			vector<float> golden(buckets * 2);
+			double start = GetTime();
+			for(size_t b=0; b<buckets; b++)
+			{
+				size_t first = b * step * 2;
+				size_t last = min(first + step*2, wavelen);
+				size_t imin = first;
+				size_t imax = first;
+				for(size_t j=first; j<last; j++)
+				{
+					if(wfm.m_samples[j] < wfm.m_samples[imin])
+						imin = j;
+					if(wfm.m_samples[j] > wfm.m_samples[imax])
+						imax = j;
+				}
+				golden[b*2] = wfm.m_samples[min(imin, imax)];
+				golden[b*2 + 1] = wfm.m_samples[max(imin, imax)];
+			}
+			double tbase = GetTime() - start;
+			LogVerbose("CPU (baseline): %6.3f ms\n", tbase * 1000);
+
+			//CPU pyramid
+			start = GetTime();
+			auto& cpuLevel = cpuPyramid.GetLevel(&wfm, level, true, cmdbuf);
+			double dt = GetTime() - start;
+			LogVerbose("CPU           : %6.3f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
+			REQUIRE(cpuPyramid.GetLevelCount() == level);
+			REQUIRE(cpuLevel.size() == golden.size());
+			cpuLevel.PrepareForCpuAccess();
+			for(size_t j=0; j<golden.size(); j++)
+				REQUIRE(cpuLevel[j] == golden[j]);
+
+			//GPU pyramid
+			wfm.PrepareForGpuAccess();
+			start = GetTime();
+			cmdbuf.begin({});
+			auto& gpuLevel = gpuPyramid.GetLevel(&wfm, level, false, cmdbuf);
+			cmdbuf.end();
+			queue->SubmitAndBlock(cmdbuf);
+			dt = GetTime() - start;
+			LogVerbose("GPU           : %6.3f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
+			REQUIRE(gpuLevel.size() == golden.size());
+			gpuLevel.PrepareForCpuAccess();
+			for(size_t j=0; j<golden.size(); j++)
+				REQUIRE(gpuLevel[j] == golden[j]);
+		}
+	}
+}
@@ -0,0 +1,287 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2025 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Unit test for the CPU waveform rasterizer, validated against waveform-compute.glsl
+ */
+#ifdef _CATCH2_V3
+#include <catch2/catch_all.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include "../../lib/scopehal/scopehal.h"
+#include "Rendering.h"
+
+using namespace std;
+
+/**
+	@brief Counts pixels that differ between two rasterized waveforms
+ */
+static size_t CountMismatches(AcceleratorBuffer<float>& a, AcceleratorBuffer<float>& b)
+{
+	size_t count = 0;
+	for(size_t i=0; i<a.size(); i++)
+	{
+		if(fabs(a[i] - b[i]) > 1e-4f * max(1.0f, fabs(a[i])))
+			count ++;
+	}
+	return count;
+}
+
+TEST_CASE("Rendering_WaveformRasterizer")
+{
+	#ifdef __x86_64__
+	bool reallyHasAvx2 = g_hasAvx2;
+	#endif
+
+	//Create a queue and command buffer
+	shared_ptr<QueueHandle> queue(g_vkQueueManager->GetComputeQueue("Rendering_WaveformRasterizer.queue"));
+	vk::CommandPoolCreateInfo poolInfo(
+		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		queue->m_family );
+	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
+
+	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
+	vk::raii::CommandBuffer cmdbuf(std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+
+	const size_t wavelen = 100000;
+	const uint32_t width = 512;
+	const uint32_t height = 256;
+
+	AcceleratorBuffer<float> analog;
+	AcceleratorBuffer<uint8_t> digital;
+	AcceleratorBuffer<int64_t> offsets;
+	AcceleratorBuffer<int64_t> durations;
+	AcceleratorBuffer<uint32_t> indexes;
+	AcceleratorBuffer<float> prev;
+	AcceleratorBuffer<float> data_out;
+	AcceleratorBuffer<float> data_out_golden;
+
+	analog.resize(wavelen);
+	digital.resize(wavelen);
+	offsets.resize(wavelen);
+	durations.resize(wavelen);
+	indexes.resize(width);
+	prev.resize(width * height);
+	data_out.resize(width * height);
+	data_out_golden.resize(width * height);
+
+	uniform_real_distribution<float> voltdesc(-1, 1);
+	uniform_int_distribution<int> bitdesc(0, 1);
+	uniform_int_distribution<int64_t> gapdesc(1, 4);
+	uniform_real_distribution<float> zoomdesc(0.005, 4);
+	uniform_real_distribution<float> intensitydesc(0, 1);
+
+	//Variants to test, named as in the shader build
+	struct TestVariant
+	{
+		string name;
+		WaveformRasterizer::Variant variant;
+		bool dense;
+	};
+	vector<TestVariant> variants =
+	{
+		{ "analog.dense",			WaveformRasterizer::VARIANT_ANALOG,				true },
+		{ "analog.zerohold.dense",	WaveformRasterizer::VARIANT_ANALOG_ZEROHOLD,	true },
+		{ "digital.dense",			WaveformRasterizer::VARIANT_DIGITAL,			true },
+		{ "histogram.dense",		WaveformRasterizer::VARIANT_HISTOGRAM,			true },
+		{ "analog",					WaveformRasterizer::VARIANT_ANALOG,				false },
+		{ "analog.zerohold",		WaveformRasterizer::VARIANT_ANALOG_ZEROHOLD,	false },
+		{ "digital",				WaveformRasterizer::VARIANT_DIGITAL,			false }
+	};
+
+	for(auto& v : variants)
+	{
+		SECTION(v.name)
+		{
+			LogVerbose("Variant %s\n", v.name.c_str());
+			LogIndenter li;
+
+			//Load the matching shader variant
+			string base = "shaders/waveform-compute.";
+			string fname = v.name;
+			if(g_hasShaderInt64)
+			{
+				auto pos = fname.find(".dense");
+				if(pos == string::npos)
+					fname += ".int64";
+				else
+					fname.insert(pos, ".int64");
+			}
+			size_t nbindings = 2;
+			if(!v.dense)
+				nbindings = (v.variant == WaveformRasterizer::VARIANT_ANALOG_ZEROHOLD) ? 5 : 4;
+			ComputePipeline pipe(base + fname + ".spv", nbindings, sizeof(ConfigPushConstants));
+
+			const size_t niter = 4;
+			for(size_t i=0; i<niter; i++)
+			{
+				//Generate a random waveform
+				analog.PrepareForCpuAccess();
+				digital.PrepareForCpuAccess();
+				offsets.PrepareForCpuAccess();
+				durations.PrepareForCpuAccess();
+				int64_t t = 0;
+				for(size_t j=0; j<wavelen; j++)
+				{
+					analog[j] = voltdesc(g_rng);
+					digital[j] = bitdesc(g_rng);
+
+					int64_t gap = v.dense ? 1 : gapdesc(g_rng);
+					offsets[j] = t;
+					durations[j] = gap;
+					t += gap;
+				}
+				analog.MarkModifiedFromCpu();
+				digital.MarkModifiedFromCpu();
+				offsets.MarkModifiedFromCpu();
+				durations.MarkModifiedFromCpu();
+
+				//Pick a random zoom and pan, and calculate constants the same way WaveformArea does
+				double pixelsPerX = zoomdesc(g_rng);
+				uniform_int_distribution<int64_t> offdesc(-100, t / 2);
+				int64_t offset = offdesc(g_rng);
+
+				ConfigPushConstants config;
+				config.innerXoff = -offset;
+				config.windowHeight = height;
+				config.windowWidth = width;
+				config.memDepth = wavelen;
+				config.offset_samples = offset - 2;
+				config.alpha = 0.1;
+				config.xoff = 0;
+				config.xscale = pixelsPerX;
+				if(v.variant == WaveformRasterizer::VARIANT_DIGITAL)
+				{
+					config.yoff = 0;
+					config.yscale = 20;
+					config.ybase = 0;
+				}
+				else
+				{
+					config.yoff = 0.1;
+					config.yscale = height * 0.4;
+					config.ybase = height * 0.5;
+				}
+
+				//Every other iteration, test persistence
+				config.persistScale = (i & 1) ? 0.75 : 0;
+				prev.PrepareForCpuAccess();
+				for(size_t j=0; j<prev.size(); j++)
+					prev[j] = intensitydesc(g_rng);
+				prev.MarkModifiedFromCpu();
+
+				if(!v.dense)
+				{
+					indexes.PrepareForCpuAccess();
+					for(size_t j=0; j<width; j++)
+					{
+						int64_t target = floor(j / pixelsPerX) + offset;
+						indexes[j] = BinarySearchForGequal(offsets.GetCpuPointer(), wavelen, target);
+					}
+					indexes.MarkModifiedFromCpu();
+				}
+
+				WaveformRasterizer::Inputs inputs;
+				inputs.m_analog = analog.GetCpuPointer();
+				inputs.m_digital = digital.GetCpuPointer();
+				inputs.m_offsets = offsets.GetCpuPointer();
+				inputs.m_indexes = indexes.GetCpuPointer();
+				inputs.m_durations = durations.GetCpuPointer();
+
+				//Baseline with scalar CPU implementation
+				#ifdef __x86_64__
+					g_hasAvx2 = false;
+				#endif
+				data_out_golden.CopyFrom(prev);
+				data_out_golden.PrepareForCpuAccess();
+				double start = GetTime();
+				WaveformRasterizer::Rasterize(config, v.variant, v.dense, inputs, data_out_golden.GetCpuPointer());
+				double tbase = GetTime() - start;
+				data_out_golden.MarkModifiedFromCpu();
+				LogVerbose("CPU (no AVX)  : %6.2f ms\n", tbase * 1000);
+
+				//AVX2 must match exactly
+				#ifdef __x86_64__
+				if(reallyHasAvx2)
+				{
+					g_hasAvx2 = true;
+
+					data_out.CopyFrom(prev);
+					data_out.PrepareForCpuAccess();
+					start = GetTime();
+					WaveformRasterizer::Rasterize(config, v.variant, v.dense, inputs, data_out.GetCpuPointer());
+					double dt = GetTime() - start;
+					data_out.MarkModifiedFromCpu();
+
+					LogVerbose("CPU (AVX2)    : %6.2f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
+					REQUIRE(CountMismatches(data_out_golden, data_out) == 0);
+				}
+				#endif
+
+				//Vulkan implementation.
+				//GPUs may contract multiply-adds, which can move a span endpoint by a pixel now and then,
+				//so allow a small fraction of pixels to differ
+				data_out.CopyFrom(prev);
+				start = GetTime();
+				cmdbuf.begin({});
+				pipe.BindBufferNonblocking(0, data_out, cmdbuf);
+				if(v.variant == WaveformRasterizer::VARIANT_DIGITAL)
+					pipe.BindBufferNonblocking(1, digital, cmdbuf);
+				else
+					pipe.BindBufferNonblocking(1, analog, cmdbuf);
+				if(!v.dense)
+				{
+					pipe.BindBufferNonblocking(2, offsets, cmdbuf);
+					pipe.BindBufferNonblocking(3, indexes, cmdbuf);
+					if(v.variant == WaveformRasterizer::VARIANT_ANALOG_ZEROHOLD)
+						pipe.BindBufferNonblocking(4, durations, cmdbuf);
+				}
+				pipe.Dispatch(cmdbuf, config, width, 1, 1);
+				cmdbuf.end();
+				queue->SubmitAndBlock(cmdbuf);
+				double dt = GetTime() - start;
+				data_out.MarkModifiedFromGpu();
+
+				data_out.PrepareForCpuAccess();
+				data_out_golden.PrepareForCpuAccess();
+				size_t mismatches = CountMismatches(data_out_golden, data_out);
+				LogVerbose("GPU           : %6.2f ms, %.2fx speedup, %zu pixels differ\n",
+					dt * 1000, tbase / dt, mismatches);
+				REQUIRE(mismatches <= data_out.size() / 100);
+			}
+		}
+	}
+
+	#ifdef __x86_64__
+		g_hasAvx2 = reallyHasAvx2;
+	#endif
+}